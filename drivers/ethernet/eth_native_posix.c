@@ -39,15 +39,29 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 #define NET_BUF_TIMEOUT K_MSEC(100)
 
+/* Idle polls at the short interval before the RX thread slows down */
+#define ETH_RX_BUSY_POLLS 50
+
 #if defined(CONFIG_NET_VLAN)
 #define ETH_HDR_LEN sizeof(struct net_eth_vlan_hdr)
 #else
 #define ETH_HDR_LEN sizeof(struct net_eth_hdr)
 #endif
 
+#define ETH_FRAME_LEN (NET_ETH_MTU + ETH_HDR_LEN)
+
+/* Enough to read a full frame into the fragments of a network packet */
+#if defined(CONFIG_NET_BUF_FIXED_DATA_SIZE)
+#define ETH_IOV_MAX \
+	MAX(ceiling_fraction(ETH_FRAME_LEN, CONFIG_NET_BUF_DATA_SIZE), 4)
+#else
+#define ETH_IOV_MAX 4
+#endif
+
 struct eth_context {
-	uint8_t recv[NET_ETH_MTU + ETH_HDR_LEN];
-	uint8_t send[NET_ETH_MTU + ETH_HDR_LEN];
+	uint8_t send[ETH_FRAME_LEN];
+	struct iovec rx_iov[ETH_IOV_MAX];
+	struct iovec tx_iov[ETH_IOV_MAX];
 	uint8_t mac_addr[6];
 	struct net_linkaddr ll_addr;
 	struct net_if *iface;
@@ -182,18 +196,28 @@ static int eth_send(const struct device *dev, struct net_pkt *pkt)
 {
 	struct eth_context *ctx = dev->data;
 	int count = net_pkt_get_len(pkt);
+	int iovcnt;
 	int ret;
 
-	ret = net_pkt_read(pkt, ctx->send, count);
-	if (ret) {
-		return ret;
+	/* Write the fragments as they are, unless there are too many */
+	net_pkt_cursor_init(pkt);
+	iovcnt = net_pkt_get_iovec(pkt, ctx->tx_iov, ETH_IOV_MAX);
+	if (iovcnt < 0) {
+		ret = net_pkt_read(pkt, ctx->send, count);
+		if (ret) {
+			return ret;
+		}
+
+		ctx->tx_iov[0].iov_base = ctx->send;
+		ctx->tx_iov[0].iov_len = count;
+		iovcnt = 1;
 	}
 
 	update_gptp(net_pkt_iface(pkt), pkt, true);
 
 	LOG_DBG("Send pkt %p len %d", pkt, count);
 
-	ret = eth_write_data(ctx->dev_fd, ctx->send, count);
+	ret = eth_writev_data(ctx->dev_fd, ctx->tx_iov, iovcnt);
 	if (ret < 0) {
 		LOG_DBG("Cannot send pkt %p (%d)", pkt, ret);
 	}
@@ -234,137 +258,123 @@ static inline struct net_if *get_iface(struct eth_context *ctx,
 #endif
 }
 
-#if defined(CONFIG_NET_VLAN)
-static struct net_pkt *prepare_vlan_pkt(struct eth_context *ctx,
-					int count, uint16_t *vlan_tag, int *status)
+/* Read a frame directly into the buffer of a network packet. The packet
+ * is only allocated once the RX thread was woken up, so that no full
+ * sized packet is kept out of the RX pool between the bursts.
+ */
+static struct net_pkt *read_frame(struct eth_context *ctx, int *status)
 {
-	struct net_eth_vlan_hdr *hdr = (struct net_eth_vlan_hdr *)ctx->recv;
+	struct net_buf *buf;
 	struct net_pkt *pkt;
-	uint8_t pos;
+	int iovcnt = 0;
+	ssize_t count;
 
-	if (IS_ENABLED(CONFIG_ETH_NATIVE_POSIX_VLAN_TAG_STRIP)) {
-		count -= NET_ETH_VLAN_HDR_SIZE;
-	}
-
-	pkt = net_pkt_rx_alloc_with_buffer(ctx->iface, count,
+	pkt = net_pkt_rx_alloc_with_buffer(ctx->iface, ETH_FRAME_LEN,
 					   AF_UNSPEC, 0, NET_BUF_TIMEOUT);
 	if (!pkt) {
 		*status = -ENOMEM;
 		return NULL;
 	}
 
-	net_pkt_set_vlan_tci(pkt, ntohs(hdr->vlan.tci));
-	*vlan_tag = net_pkt_vlan_tag(pkt);
-
-	pos = 0;
-
-	if (IS_ENABLED(CONFIG_ETH_NATIVE_POSIX_VLAN_TAG_STRIP)) {
-		if (net_pkt_write(pkt, ctx->recv,
-				  2 * sizeof(struct net_eth_addr))) {
-			goto error;
-		}
+	for (buf = pkt->buffer; buf && iovcnt < ETH_IOV_MAX;
+	     buf = buf->frags) {
+		ctx->rx_iov[iovcnt].iov_base = net_buf_tail(buf);
+		ctx->rx_iov[iovcnt].iov_len = net_buf_tailroom(buf);
+		iovcnt++;
+	}
 
-		pos = (2 * sizeof(struct net_eth_addr)) + NET_ETH_VLAN_HDR_SIZE;
-		count -= (2 * sizeof(struct net_eth_addr));
+	count = eth_readv_data(ctx->dev_fd, ctx->rx_iov, iovcnt);
+	if (count <= 0) {
+		/* The end of the burst */
+		net_pkt_unref(pkt);
+		*status = -EAGAIN;
+		return NULL;
 	}
 
-	if (net_pkt_write(pkt, ctx->recv + pos, count)) {
-		goto error;
+	for (buf = pkt->buffer; buf; buf = buf->frags) {
+		size_t len = MIN(count, net_buf_tailroom(buf));
+
+		net_buf_add(buf, len);
+		count -= len;
 	}
 
-#if CONFIG_NET_TC_RX_COUNT > 1
-	{
-		enum net_priority prio;
+	net_pkt_trim_buffer(pkt);
 
-		prio = net_vlan2priority(net_pkt_vlan_priority(pkt));
-		net_pkt_set_priority(pkt, prio);
+	if (!pkt->buffer || pkt->buffer->len < ETH_HDR_LEN) {
+		net_pkt_unref(pkt);
+		*status = -EINVAL;
+		return NULL;
 	}
-#endif
 
 	*status = 0;
 
-	LOG_DBG("Recv pkt %p len %d", pkt, count);
+	LOG_DBG("Recv pkt %p len %zd", pkt, net_pkt_get_len(pkt));
 
 	return pkt;
-
-error:
-	net_pkt_unref(pkt);
-	*status = -ENOBUFS;
-	return NULL;
 }
-#endif
 
-static struct net_pkt *prepare_non_vlan_pkt(struct eth_context *ctx,
-					    int count, int *status)
+#if defined(CONFIG_NET_VLAN)
+static uint16_t prepare_vlan_pkt(struct net_pkt *pkt)
 {
-	struct net_pkt *pkt;
+	struct net_eth_vlan_hdr *hdr =
+		(struct net_eth_vlan_hdr *)pkt->buffer->data;
 
-	pkt = net_pkt_rx_alloc_with_buffer(ctx->iface, count,
-					   AF_UNSPEC, 0, NET_BUF_TIMEOUT);
-	if (!pkt) {
-		*status = -ENOMEM;
-		return NULL;
+	if (ntohs(hdr->type) != NET_ETH_PTYPE_VLAN) {
+		net_pkt_set_vlan_tci(pkt, 0);
+		return NET_VLAN_TAG_UNSPEC;
 	}
 
-	if (net_pkt_write(pkt, ctx->recv, count)) {
-		net_pkt_unref(pkt);
-		*status = -ENOBUFS;
-		return NULL;
+	net_pkt_set_vlan_tci(pkt, ntohs(hdr->vlan.tci));
+
+	if (IS_ENABLED(CONFIG_ETH_NATIVE_POSIX_VLAN_TAG_STRIP)) {
+		/* Move the addresses over the tag */
+		memmove(pkt->buffer->data + NET_ETH_VLAN_HDR_SIZE,
+			pkt->buffer->data, 2 * sizeof(struct net_eth_addr));
+		net_buf_pull(pkt->buffer, NET_ETH_VLAN_HDR_SIZE);
 	}
 
-	*status = 0;
+#if CONFIG_NET_TC_RX_COUNT > 1
+	{
+		enum net_priority prio;
 
-	LOG_DBG("Recv pkt %p len %d", pkt, count);
+		prio = net_vlan2priority(net_pkt_vlan_priority(pkt));
+		net_pkt_set_priority(pkt, prio);
+	}
+#endif
 
-	return pkt;
+	return net_pkt_vlan_tag(pkt);
 }
+#endif
 
-static int read_data(struct eth_context *ctx, int fd)
+static int read_data(struct eth_context *ctx)
 {
 	uint16_t vlan_tag = NET_VLAN_TAG_UNSPEC;
 	struct net_if *iface;
-	struct net_pkt *pkt = NULL;
+	struct net_pkt *pkt;
 	int status;
-	int count;
+	int i;
 
-	count = eth_read_data(fd, ctx->recv, sizeof(ctx->recv));
-	if (count <= 0) {
-		return 0;
-	}
-
-#if defined(CONFIG_NET_VLAN)
-	{
-		struct net_eth_hdr *hdr = (struct net_eth_hdr *)(ctx->recv);
-
-		if (ntohs(hdr->type) == NET_ETH_PTYPE_VLAN) {
-			pkt = prepare_vlan_pkt(ctx, count, &vlan_tag, &status);
-			if (!pkt) {
-				return status;
-			}
-		} else {
-			pkt = prepare_non_vlan_pkt(ctx, count, &status);
-			if (!pkt) {
-				return status;
+	for (i = 0; i < CONFIG_ETH_NATIVE_POSIX_RX_BATCH; i++) {
+		pkt = read_frame(ctx, &status);
+		if (!pkt) {
+			if (status == -EINVAL) {
+				continue;
 			}
 
-			net_pkt_set_vlan_tci(pkt, 0);
-		}
-	}
-#else
-	{
-		pkt = prepare_non_vlan_pkt(ctx, count, &status);
-		if (!pkt) {
 			return status;
 		}
-	}
+
+#if defined(CONFIG_NET_VLAN)
+		vlan_tag = prepare_vlan_pkt(pkt);
 #endif
 
-	iface = get_iface(ctx, vlan_tag);
+		iface = get_iface(ctx, vlan_tag);
 
-	update_gptp(iface, pkt, false);
+		update_gptp(iface, pkt, false);
 
-	if (net_recv_data(iface, pkt) < 0) {
-		net_pkt_unref(pkt);
+		if (net_recv_data(iface, pkt) < 0) {
+			net_pkt_unref(pkt);
+		}
 	}
 
 	return 0;
@@ -372,17 +382,22 @@ static int read_data(struct eth_context *ctx, int fd)
 
 static void eth_rx(struct eth_context *ctx)
 {
+	int idle = 0;
+
 	LOG_DBG("Starting ZETH RX thread");
 
 	while (1) {
 		if (net_if_is_up(ctx->iface)) {
 			while (!eth_wait_data(ctx->dev_fd)) {
-				read_data(ctx, ctx->dev_fd);
+				read_data(ctx);
 				k_yield();
+				idle = 0;
 			}
 		}
 
-		if (IS_ENABLED(CONFIG_NET_GPTP)) {
+		/* Keep polling often for a while after the last frame */
+		if (IS_ENABLED(CONFIG_NET_GPTP) || idle < ETH_RX_BUSY_POLLS) {
+			idle++;
 			k_sleep(K_MSEC(1));
 		} else {
 			k_sleep(K_MSEC(50));
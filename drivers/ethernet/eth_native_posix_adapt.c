@@ -23,6 +23,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <net/if.h>
 #include <time.h>
 #include <arch/posix/posix_trace.h>
@@ -77,6 +78,13 @@ int eth_iface_create(const char *if_name, bool tun_only)
 	}
 #endif
 
+	/* The RX thread drains the device until it would block */
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) < 0) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+
 	return fd;
 }
 
@@ -175,6 +183,16 @@ ssize_t eth_write_data(int fd, void *buf, size_t buf_len)
 	return write(fd, buf, buf_len);
 }
 
+ssize_t eth_readv_data(int fd, const struct iovec *iov, int iovcnt)
+{
+	return readv(fd, iov, iovcnt);
+}
+
+ssize_t eth_writev_data(int fd, const struct iovec *iov, int iovcnt)
+{
+	return writev(fd, iov, iovcnt);
+}
+
 #if defined(CONFIG_NET_GPTP)
 int eth_clock_gettime(struct net_ptp_time *time)
 {
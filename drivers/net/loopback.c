@@ -36,11 +36,66 @@ static void loopback_init(struct net_if *iface)
 	/* RFC 7042, s.2.1.1. address to use in documentation */
 	net_if_set_link_addr(iface, "\x00\x00\x5e\x00\x53\xff", 6,
 			     NET_LINK_DUMMY);
+
+	if (IS_ENABLED(CONFIG_NET_LOOPBACK_SKIP_CHECKSUM)) {
+		net_if_flag_set(iface, NET_IF_NO_CHECKSUM);
+	}
+}
+
+/* Free TX packets below which the loopback stops handing them to RX */
+#define LOOPBACK_TX_RESERVE(slab) ((slab)->num_blocks / 4U)
+
+static struct net_pkt *loopback_rx_copy(struct net_pkt *pkt)
+{
+	struct net_pkt *rx_pkt;
+	size_t len = net_pkt_get_len(pkt);
+
+	rx_pkt = net_pkt_rx_alloc_with_buffer(net_pkt_iface(pkt), len,
+					      AF_UNSPEC, 0, K_MSEC(100));
+	if (!rx_pkt) {
+		return NULL;
+	}
+
+	net_pkt_cursor_init(pkt);
+	if (net_pkt_copy(rx_pkt, pkt, len)) {
+		net_pkt_unref(rx_pkt);
+		return NULL;
+	}
+
+	net_pkt_cursor_init(rx_pkt);
+
+	return rx_pkt;
+}
+
+static struct net_pkt *loopback_rx_pkt(struct net_pkt *pkt)
+{
+	/* If the sender holds the only reference, nobody can see the packet
+	 * change, so the receiver gets a reference to it instead of a copy.
+	 * The sender still drops its own reference after the send.
+	 */
+	if (IS_ENABLED(CONFIG_NET_LOOPBACK_ZERO_COPY) &&
+	    atomic_get(&pkt->atomic_ref) == 1) {
+		/* The packet stays in the TX pool until it is read, so a
+		 * receiver that does not read could exhaust the pool. Once
+		 * it runs low, the data is copied to an RX packet instead.
+		 */
+		if (k_mem_slab_num_free_get(pkt->slab) <
+		    LOOPBACK_TX_RESERVE(pkt->slab)) {
+			return loopback_rx_copy(pkt);
+		}
+
+		net_pkt_set_eof(pkt, false);
+		net_pkt_set_chksum_done(pkt, false);
+
+		return net_pkt_ref(pkt);
+	}
+
+	return net_pkt_clone(pkt, K_MSEC(100));
 }
 
 static int loopback_send(const struct device *dev, struct net_pkt *pkt)
 {
-	struct net_pkt *cloned;
+	struct net_pkt *rx_pkt;
 	int res;
 
 	ARG_UNUSED(dev);
@@ -75,15 +130,16 @@ static int loopback_send(const struct device *dev, struct net_pkt *pkt)
 	 * must be dropped. This is very much needed for TCP packets where
 	 * the packet is reference counted in various stages of sending.
 	 */
-	cloned = net_pkt_clone(pkt, K_MSEC(100));
-	if (!cloned) {
+	rx_pkt = loopback_rx_pkt(pkt);
+	if (!rx_pkt) {
 		res = -ENOMEM;
 		goto out;
 	}
 
-	res = net_recv_data(net_pkt_iface(cloned), cloned);
+	res = net_recv_data(net_pkt_iface(rx_pkt), rx_pkt);
 	if (res < 0) {
 		LOG_ERR("Data receive failed.");
+		net_pkt_unref(rx_pkt);
 	}
 
 out:
@@ -193,6 +193,80 @@ static inline int net_capture_send(const struct device *dev,
 #endif
 }
 
+/**
+ * @brief Capture statistics of the file backend.
+ */
+struct net_capture_file_stats {
+	/** Packets stored in the capture rings */
+	uint32_t captured;
+	/** Packets dropped because a capture ring was full */
+	uint32_t dropped;
+	/** Bytes written to the capture file */
+	size_t written;
+};
+
+/**
+ * @brief Start capturing the packets of a network interface to a local
+ *        pcapng file.
+ *
+ * @details The packets are copied, truncated to the snapshot length, to
+ * a lock-free ring of the CPU they are sent or received on. A background
+ * thread writes them to the file. The packets that do not fit in a ring
+ * are dropped and counted.
+ *
+ * @param iface Network interface to capture
+ * @param path Path of the file to create, an existing file is replaced
+ * @param snaplen Maximum number of bytes stored per packet, 0 stores up to
+ *        CONFIG_NET_CAPTURE_FILE_SNAPLEN bytes.
+ *
+ * @return 0 if ok, -EALREADY if a file capture is already running,
+ *         <0 on other errors.
+ */
+#if defined(CONFIG_NET_CAPTURE_FILE)
+int net_capture_file_start(struct net_if *iface, const char *path,
+			   uint32_t snaplen);
+#else
+static inline int net_capture_file_start(struct net_if *iface,
+					 const char *path, uint32_t snaplen)
+{
+	ARG_UNUSED(iface);
+	ARG_UNUSED(path);
+	ARG_UNUSED(snaplen);
+
+	return -ENOTSUP;
+}
+#endif
+
+/**
+ * @brief Stop the file capture, after writing the pending packets.
+ *
+ * @return 0 if ok, -EALREADY if no file capture is running, <0 if writing
+ *         the file failed.
+ */
+#if defined(CONFIG_NET_CAPTURE_FILE)
+int net_capture_file_stop(void);
+#else
+static inline int net_capture_file_stop(void)
+{
+	return -ENOTSUP;
+}
+#endif
+
+/**
+ * @brief Get the statistics of the current or last file capture.
+ *
+ * @param stats Statistics to fill
+ */
+#if defined(CONFIG_NET_CAPTURE_FILE)
+void net_capture_file_get_stats(struct net_capture_file_stats *stats);
+#else
+static inline void net_capture_file_get_stats(
+					struct net_capture_file_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+}
+#endif
+
 /** @cond INTERNAL_HIDDEN */
 
 /**
@@ -212,6 +286,17 @@ static inline void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt)
 }
 #endif
 
+#if defined(CONFIG_NET_CAPTURE_FILE)
+void net_capture_file_pkt(struct net_if *iface, struct net_pkt *pkt);
+#else
+static inline void net_capture_file_pkt(struct net_if *iface,
+					struct net_pkt *pkt)
+{
+	ARG_UNUSED(iface);
+	ARG_UNUSED(pkt);
+}
+#endif
+
 struct net_capture_info {
 	const struct device *capture_dev;
 	struct net_if *capture_iface;
@@ -73,6 +73,9 @@ enum coap_method {
 	COAP_METHOD_POST = 2,
 	COAP_METHOD_PUT = 3,
 	COAP_METHOD_DELETE = 4,
+	COAP_METHOD_FETCH = 5,
+	COAP_METHOD_PATCH = 6,
+	COAP_METHOD_IPATCH = 7,
 };
 
 #define COAP_REQUEST_MASK 0x07
@@ -260,6 +263,9 @@ typedef int (*coap_reply_t)(const struct coap_packet *response,
  * @brief Represents a request awaiting for an acknowledgment (ACK).
  */
 struct coap_pending {
+#if defined(CONFIG_COAP_ENGINE)
+	sys_snode_t node; /* Retransmission queue of the engine */
+#endif
 	struct sockaddr addr;
 	uint32_t t0;
 	uint32_t timeout;
@@ -650,6 +656,81 @@ int coap_update_from_block(const struct coap_packet *cpkt,
 size_t coap_next_block(const struct coap_packet *cpkt,
 		       struct coap_block_context *ctx);
 
+/**
+ * @typedef coap_block_read_t
+ * @brief Callback providing the data of the current block of a block-wise
+ * transfer.
+ *
+ * @param ctx Block context of the transfer, @a ctx->current is the offset
+ * of the data to provide
+ * @param buf Where to write the data, this points directly into the
+ * packet buffer
+ * @param len Number of bytes to write
+ * @param user_data User data given to coap_append_block_payload()
+ *
+ * @return Number of bytes written or negative in case of error.
+ */
+typedef int (*coap_block_read_t)(const struct coap_block_context *ctx,
+				 uint8_t *buf, uint16_t len, void *user_data);
+
+/**
+ * @typedef coap_block_write_t
+ * @brief Callback consuming the data of a block received in a block-wise
+ * transfer.
+ *
+ * @param ctx Block context of the transfer, @a ctx->current is the offset
+ * of the data received
+ * @param buf Data received, this points directly into the packet buffer
+ * @param len Number of bytes received
+ * @param last True if this is the last block of the transfer
+ * @param user_data User data given to coap_deliver_block_payload()
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+typedef int (*coap_block_write_t)(const struct coap_block_context *ctx,
+				  const uint8_t *buf, uint16_t len, bool last,
+				  void *user_data);
+
+/**
+ * @brief Append the current block of a block-wise transfer to the packet.
+ *
+ * The Block1 option is appended to requests, and the Block2 option to
+ * responses, followed by the payload marker and the payload, which is
+ * read with @a read directly into the packet buffer. The first block
+ * also carries the Size1 or Size2 option. As the payload comes last,
+ * any other option has to be appended before calling this function.
+ *
+ * @param cpkt Packet to be updated
+ * @param ctx Block context of the transfer, the total size has to be known
+ * @param read Callback providing the data of the block
+ * @param user_data User data passed to @a read
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_append_block_payload(struct coap_packet *cpkt,
+			      struct coap_block_context *ctx,
+			      coap_block_read_t read, void *user_data);
+
+/**
+ * @brief Pass the block carried by a packet to a callback.
+ *
+ * The block is described by the Block1 option of requests and the Block2
+ * option of responses. @a ctx is updated from the packet options, as with
+ * coap_update_from_block(), before @a write is called with the payload.
+ * A packet without block option is delivered as the only block.
+ *
+ * @param cpkt Packet carrying the block
+ * @param ctx Block context of the transfer
+ * @param write Callback consuming the data of the block
+ * @param user_data User data passed to @a write
+ *
+ * @return 1 if more blocks follow, 0 for the last block, negative in case
+ * of error.
+ */
+int coap_deliver_block_payload(const struct coap_packet *cpkt,
+			       struct coap_block_context *ctx,
+			       coap_block_write_t write, void *user_data);
+
 /**
  * @brief Indicates that the remote device referenced by @a addr, with
  * @a request, wants to observe a resource.
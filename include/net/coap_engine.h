@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ *
+ * @brief CoAP message engine.
+ *
+ * The engine sends CoAP messages through an application callback, and
+ * owns the retransmission of confirmable messages: all the pending
+ * messages of an engine are kept ordered by expiry, and served by a
+ * single delayed work item. It also sends observer notifications
+ * without building the message once per observer.
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_COAP_ENGINE_H_
+#define ZEPHYR_INCLUDE_NET_COAP_ENGINE_H_
+
+#include <kernel.h>
+#include <net/coap.h>
+
+/**
+ * @addtogroup coap COAP Library
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct coap_engine;
+
+/**
+ * @typedef coap_engine_send_t
+ * @brief Callback sending a CoAP message, e.g. with sendmsg().
+ *
+ * @param engine Engine sending the message
+ * @param iov Parts of the message, to be sent as one datagram
+ * @param iovcnt Number of parts in @a iov
+ * @param addr Destination of the message
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+typedef int (*coap_engine_send_t)(struct coap_engine *engine,
+				  const struct iovec *iov, size_t iovcnt,
+				  const struct sockaddr *addr);
+
+/**
+ * @typedef coap_engine_timeout_t
+ * @brief Callback called when a confirmable message was not acknowledged
+ * after all its retransmissions.
+ *
+ * The engine no longer uses @a pending when this is called. Its data
+ * pointer is left set, so that the message buffer can be released.
+ */
+typedef void (*coap_engine_timeout_t)(struct coap_engine *engine,
+				      struct coap_pending *pending);
+
+/**
+ * @brief CoAP message engine.
+ */
+struct coap_engine {
+	coap_engine_send_t send;
+	coap_engine_timeout_t timeout;
+	void *user_data;
+
+	/* Pending messages, ordered by retransmission time */
+	sys_slist_t pendings;
+	struct k_work_delayable retransmit_work;
+	struct k_mutex lock;
+};
+
+/**
+ * @brief Initialize a CoAP message engine.
+ *
+ * @param engine Engine to be initialized
+ * @param send Callback used to send the messages
+ * @param timeout Callback called when a message was not acknowledged,
+ * can be NULL
+ * @param user_data User data, not used by the engine
+ */
+void coap_engine_init(struct coap_engine *engine, coap_engine_send_t send,
+		      coap_engine_timeout_t timeout, void *user_data);
+
+/**
+ * @brief Send a message.
+ *
+ * Confirmable messages are retransmitted by the engine until
+ * coap_engine_received() is called with their acknowledgment, using
+ * @a pending to track them. Its data is not copied, so @a cpkt data has
+ * to stay valid until then.
+ *
+ * @param engine Engine sending the message
+ * @param cpkt Message to be sent
+ * @param addr Destination of the message
+ * @param pending Unused pending structure, only needed for confirmable
+ * messages
+ *
+ * @return 0 in case of success or negative in case of error.
+ */
+int coap_engine_send(struct coap_engine *engine,
+		     const struct coap_packet *cpkt,
+		     const struct sockaddr *addr,
+		     struct coap_pending *pending);
+
+/**
+ * @brief Stop the retransmission of the message answered by @a response.
+ *
+ * @param engine Engine that sent the message
+ * @param response Acknowledgment, reset or piggybacked response received
+ *
+ * @return The pending structure of the answered message, NULL if none
+ * could be found.
+ */
+struct coap_pending *coap_engine_received(struct coap_engine *engine,
+					  const struct coap_packet *response);
+
+/**
+ * @brief Stop the retransmission of a message.
+ *
+ * @param engine Engine that sent the message
+ * @param pending Pending structure of the message
+ */
+void coap_engine_cancel(struct coap_engine *engine,
+			struct coap_pending *pending);
+
+/**
+ * @brief Stop the retransmission of all the messages of the engine.
+ *
+ * @param engine Engine to be stopped
+ */
+void coap_engine_stop(struct coap_engine *engine);
+
+/**
+ * @brief Send a notification to all the observers of a resource.
+ *
+ * The notification is built once by the caller, with an empty token. For
+ * each observer, only the message ID and token are set in the header, and
+ * the rest of the message is sent from @a cpkt as is. The caller is
+ * responsible for the Observe option value, see coap_resource_notify().
+ *
+ * @param engine Engine sending the notifications
+ * @param resource Resource whose observers are notified
+ * @param cpkt Non-confirmable notification
+ *
+ * @return Number of observers notified or negative in case of error.
+ */
+int coap_engine_notify(struct coap_engine *engine,
+		       struct coap_resource *resource,
+		       const struct coap_packet *cpkt);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_COAP_ENGINE_H_ */
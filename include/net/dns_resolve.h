@@ -240,6 +240,14 @@ struct dns_resolve_context {
 		 * cannot be used to find correct pending query.
 		 */
 		uint16_t query_hash;
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/** Index of the pending query resolving the same name that
+		 * this query is waiting for, or -1 if this query has sent
+		 * its own request.
+		 */
+		int8_t leader;
+#endif
 	} queries[CONFIG_DNS_NUM_CONCUR_QUERIES];
 
 	/** Is this context in use */
@@ -446,6 +454,82 @@ static inline int dns_cancel_addr_info(uint16_t dns_id)
 	return dns_resolve_cancel(dns_resolve_get_default(), dns_id);
 }
 
+/** DNS cache statistics */
+struct dns_cache_stats {
+	/** Queries answered with cached addresses */
+	uint32_t hits;
+	/** Queries answered with a cached failure */
+	uint32_t negative_hits;
+	/** Queries not found in the cache */
+	uint32_t misses;
+	/** Queries that waited for an identical query already in progress */
+	uint32_t coalesced;
+	/** Number of valid entries in the cache */
+	uint32_t entries;
+};
+
+/**
+ * @typedef dns_cache_cb_t
+ * @brief Callback used while iterating over the DNS cache.
+ *
+ * @param name Cached name
+ * @param type Query type of the entry
+ * @param status DNS_EAI_ALLDONE for a positive entry, or the cached error
+ * @param ttl Remaining lifetime of the entry in seconds
+ * @param addr Cached addresses, NULL for a negative entry
+ * @param addr_count Number of cached addresses
+ * @param user_data A valid pointer to user data or NULL
+ */
+typedef void (*dns_cache_cb_t)(const char *name,
+			       enum dns_query_type type,
+			       int status,
+			       uint32_t ttl,
+			       const struct sockaddr *addr,
+			       int addr_count,
+			       void *user_data);
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/**
+ * @brief Get the DNS cache statistics.
+ *
+ * @param stats Where to store the statistics.
+ */
+void dns_cache_stats_get(struct dns_cache_stats *stats);
+
+/**
+ * @brief Remove all entries from the DNS cache.
+ *
+ * @details The statistics counters are cleared too.
+ */
+void dns_cache_flush(void);
+
+/**
+ * @brief Go through all the valid entries in the DNS cache.
+ *
+ * @details The cache is locked while the callback runs, so the callback
+ * must not call other DNS cache functions.
+ *
+ * @param cb User supplied callback function to call.
+ * @param user_data User specified data.
+ */
+void dns_cache_foreach(dns_cache_cb_t cb, void *user_data);
+#else
+static inline void dns_cache_stats_get(struct dns_cache_stats *stats)
+{
+	*stats = (struct dns_cache_stats){ 0 };
+}
+
+static inline void dns_cache_flush(void)
+{
+}
+
+static inline void dns_cache_foreach(dns_cache_cb_t cb, void *user_data)
+{
+	ARG_UNUSED(cb);
+	ARG_UNUSED(user_data);
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 /**
  * @}
  */
@@ -20,6 +20,7 @@
  * @{
  */
 
+#include <errno.h>
 #include <kernel.h>
 #include <net/net_ip.h>
 #include <net/http_parser.h>
@@ -109,6 +110,15 @@ struct http_response {
 	/** Where the body starts */
 	uint8_t *body_start;
 
+	/** Start of the body fragment given to the response callback. It
+	 * points into recv_buf, chunked transfer coding already removed.
+	 * NULL if the callback is not called for body data.
+	 */
+	const uint8_t *body_frag_start;
+
+	/** Length of the body fragment given to the response callback */
+	size_t body_frag_len;
+
 	/** Where the response is stored, this is to be
 	 * provided by the user.
 	 */
@@ -154,6 +164,11 @@ struct http_response {
 	uint8_t cl_present : 1;
 	uint8_t body_found : 1;
 	uint8_t message_complete : 1;
+
+	/** The connection can be used for another request once the
+	 * response is complete.
+	 */
+	uint8_t keep_alive : 1;
 };
 
 /** HTTP client internal data that the application should not touch
@@ -290,6 +305,79 @@ struct http_request {
 int http_client_req(int sock, struct http_request *req,
 		    int32_t timeout, void *user_data);
 
+/**
+ * @brief Send several HTTP requests on a connection before reading the
+ * responses (HTTP/1.1 pipelining). The responses are received in order,
+ * each into the receive buffer and callback of its own request. Only
+ * idempotent requests (GET, HEAD, ...) should be pipelined, and the server
+ * must keep the connection alive for all but the last of them.
+ *
+ * The response of a request was fully received if its
+ * internal.response.message_complete flag is set.
+ *
+ * @param sock Socket id of the connection.
+ * @param reqs HTTP requests to send.
+ * @param count Number of requests.
+ * @param timeout Max timeout to wait for each response, in milliseconds.
+ * @param user_data User specified data that is passed to the callbacks.
+ *
+ * @return <0 if error, >=0 amount of data sent to the server
+ */
+int http_client_req_pipelined(int sock, struct http_request **reqs,
+			      size_t count, int32_t timeout, void *user_data);
+
+#if defined(CONFIG_HTTP_CLIENT_POOL)
+/**
+ * @brief Take a kept-alive connection to a server out of the pool.
+ *
+ * @details Connections which were closed by the server or were idle for
+ * longer than CONFIG_HTTP_CLIENT_POOL_IDLE_TIMEOUT are closed instead of
+ * returned.
+ *
+ * @param host Hostname the connection was made to.
+ * @param port Port the connection was made to, may be NULL.
+ *
+ * @return Connected socket, or -ENOENT if there is none for this server.
+ */
+int http_client_pool_get(const char *host, const char *port);
+
+/**
+ * @brief Keep a connection in the pool, to be reused by a later request
+ * to the same server.
+ *
+ * @details Only connections whose last response was complete and had
+ * keep_alive set should be put in the pool. If the pool is full, the
+ * connection which was idle for the longest time is closed.
+ *
+ * @param sock Connected socket.
+ * @param host Hostname the connection was made to.
+ * @param port Port the connection was made to, may be NULL.
+ *
+ * @return 0 if ok, <0 if error. The socket is not closed on error.
+ */
+int http_client_pool_put(int sock, const char *host, const char *port);
+
+/**
+ * @brief Close all the connections in the pool.
+ */
+void http_client_pool_flush(void);
+#else
+static inline int http_client_pool_get(const char *host, const char *port)
+{
+	return -ENOENT;
+}
+
+static inline int http_client_pool_put(int sock, const char *host,
+				       const char *port)
+{
+	return -ENOTSUP;
+}
+
+static inline void http_client_pool_flush(void)
+{
+}
+#endif /* CONFIG_HTTP_CLIENT_POOL */
+
 #ifdef __cplusplus
 }
 #endif
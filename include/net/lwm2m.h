@@ -428,6 +428,50 @@ int lwm2m_engine_update_observer_min_period(char *pathstr, uint32_t period_s);
  */
 int lwm2m_engine_update_observer_max_period(char *pathstr, uint32_t period_s);
 
+/** LwM2M notification statistics */
+struct lwm2m_notify_stats {
+	/** Value changes matched by an observer, counted per observer */
+	uint32_t events;
+	/** Notifications sent because of a value change */
+	uint32_t triggered;
+	/** Notifications sent because pmax expired */
+	uint32_t periodic;
+	/** Periodic notifications sent early to share an engine wakeup */
+	uint32_t coalesced;
+	/** Notifications which could not be sent */
+	uint32_t failed;
+	/** Longest time from a value change to its notification */
+	uint32_t latency_max_ms;
+	/** Sum of the value change to notification times, over triggered */
+	uint64_t latency_total_ms;
+};
+
+#if defined(CONFIG_LWM2M_NOTIFY_STATS)
+/**
+ * @brief Get the LwM2M notification statistics.
+ *
+ * The average notification latency is latency_total_ms / triggered.
+ *
+ * @param[out] stats Where to store the statistics.
+ */
+void lwm2m_engine_get_notify_stats(struct lwm2m_notify_stats *stats);
+
+/**
+ * @brief Clear the LwM2M notification statistics.
+ */
+void lwm2m_engine_reset_notify_stats(void);
+#else
+static inline void lwm2m_engine_get_notify_stats(
+					struct lwm2m_notify_stats *stats)
+{
+	*stats = (struct lwm2m_notify_stats){ 0 };
+}
+
+static inline void lwm2m_engine_reset_notify_stats(void)
+{
+}
+#endif /* CONFIG_LWM2M_NOTIFY_STATS */
+
 /**
  * @brief Create an LwM2M object instance.
  *
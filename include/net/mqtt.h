@@ -435,6 +435,28 @@ struct mqtt_transport {
 #endif
 };
 
+#if CONFIG_MQTT_INFLIGHT_COUNT > 0
+/** @brief Internal. Published QoS 1 or QoS 2 message waiting for the
+ *         broker to acknowledge it.
+ */
+struct mqtt_inflight {
+	/** Internal. Message as given to @ref mqtt_publish. Topic and payload
+	 *  are referenced, not copied.
+	 */
+	struct mqtt_publish_param param;
+
+	/** Internal. Wall clock value (in milliseconds) of the last time the
+	 *  message, or its release, was sent.
+	 */
+	uint32_t sent_time;
+
+	/** Internal. Packet type expected from the broker, 0 when the entry
+	 *  is free.
+	 */
+	uint8_t expected;
+};
+#endif
+
 /** @brief MQTT internal state. */
 struct mqtt_internal {
 	/** Internal. Mutex to protect access to the client instance. */
@@ -453,6 +475,14 @@ struct mqtt_internal {
 
 	/** Internal. Remaining payload length to read. */
 	uint32_t remaining_payload;
+
+#if CONFIG_MQTT_INFLIGHT_COUNT > 0
+	/** Internal. Published messages not acknowledged yet. */
+	struct mqtt_inflight inflight[CONFIG_MQTT_INFLIGHT_COUNT];
+
+	/** Internal. Number of used entries in the inflight table. */
+	uint8_t inflight_count;
+#endif
 };
 
 /**
@@ -587,11 +617,51 @@ int mqtt_connect(struct mqtt_client *client);
  * @param[in] param Parameters to be used for the publish message.
  *                  Shall not be NULL.
  *
+ * @note With @option{CONFIG_MQTT_INFLIGHT_COUNT} set, QoS 1 and QoS 2
+ *       messages are kept by the library until the broker acknowledges
+ *       them, and are retransmitted when needed. The topic and payload
+ *       of such a message shall stay valid until @ref MQTT_EVT_PUBACK or
+ *       @ref MQTT_EVT_PUBCOMP is received for it. The library sends the
+ *       PUBREL of tracked QoS 2 messages on its own.
+ *
  * @return 0 or a negative error code (errno.h) indicating reason of failure.
+ *         -EAGAIN if the inflight window is full.
  */
 int mqtt_publish(struct mqtt_client *client,
 		 const struct mqtt_publish_param *param);
 
+/**
+ * @brief API to publish several messages with a single transport write.
+ *
+ * The fixed and variable headers of the messages are encoded back to back
+ * in the TX buffer, and sent together with the payloads in one message of
+ * at most @option{CONFIG_MQTT_PUBLISH_BATCH_SIZE} publishes. The same rules
+ * as for @ref mqtt_publish apply to each message.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ * @param[in] params Array of publish message parameters. Shall not be NULL.
+ * @param[in] count Number of elements in @p params.
+ *
+ * @return Number of messages published, which can be less than @p count
+ *         if the inflight window got full, or a negative error code
+ *         (errno.h) indicating reason of failure.
+ */
+int mqtt_publish_batch(struct mqtt_client *client,
+		       const struct mqtt_publish_param *params,
+		       size_t count);
+
+/**
+ * @brief Get the number of published messages not acknowledged yet.
+ *
+ * @param[in] client Client instance for which the procedure is requested.
+ *                   Shall not be NULL.
+ *
+ * @return Number of QoS 1 and QoS 2 messages waiting for the broker, or
+ *         -ENOTSUP if @option{CONFIG_MQTT_INFLIGHT_COUNT} is 0.
+ */
+int mqtt_inflight_count(struct mqtt_client *client);
+
 /**
  * @brief API used by client to send acknowledgment on receiving QoS1 publish
  *        message. Should be called on reception of @ref MQTT_EVT_PUBLISH with
@@ -718,6 +788,9 @@ int mqtt_abort(struct mqtt_client *client);
  *        makes it possible to respect the Keep Alive time agreed with the
  *        broker on connection. @ref mqtt_connect for details on Keep Alive
  *        time.
+ * @note  With @option{CONFIG_MQTT_INFLIGHT_RETRANSMIT_TIMEOUT} set, this
+ *        function also retransmits the published messages that were not
+ *        acknowledged in time.
  *
  * @return 0 or a negative error code (errno.h) indicating reason of failure.
  */
@@ -68,6 +68,9 @@ enum net_context_state {
 /* Context is bound to a specific interface */
 #define NET_CONTEXT_BOUND_TO_IFACE BIT(11)
 
+/* The receive callback copies the packet out and does not keep it */
+#define NET_CONTEXT_RX_COPY BIT(12)
+
 struct net_context;
 
 /**
@@ -281,6 +284,13 @@ __net_socket struct net_context {
 		/** Mutex used by condition variable */
 		struct k_mutex *lock;
 	} cond;
+
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+	/** Advanced whenever input is queued, so that edge-triggered epoll
+	 * can tell new data from data it already reported.
+	 */
+	atomic_t recv_gen;
+#endif /* CONFIG_NET_SOCKETS_EPOLL */
 #endif /* CONFIG_NET_SOCKETS */
 
 #if defined(CONFIG_NET_OFFLOAD)
@@ -315,6 +325,11 @@ __net_socket struct net_context {
 #endif
 	} options;
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+	/** Traffic statistics of this network context */
+	struct net_stats_context stats;
+#endif
+
 	/** Protocol (UDP, TCP or IEEE 802.3 protocol value) */
 	uint16_t proto;
 
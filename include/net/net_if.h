@@ -193,6 +193,20 @@ enum net_if_flag {
 	/** Interface supports IPv6 */
 	NET_IF_IPV6,
 
+	/** Large TCP packets are split into segments when sent by L2
+	 * (CONFIG_NET_TCP_GSO)
+	 */
+	NET_IF_GSO,
+
+	/** Received TCP segments are coalesced (CONFIG_NET_TCP_GRO) */
+	NET_IF_GRO,
+
+	/** Checksums are neither calculated for the packets sent nor
+	 * verified for the packets received on the interface, as they never
+	 * leave the device (CONFIG_NET_LOOPBACK_SKIP_CHECKSUM)
+	 */
+	NET_IF_NO_CHECKSUM,
+
 /** @cond INTERNAL_HIDDEN */
 	/* Total number of flags - must be at the end of the enum */
 	NET_IF_NUM_FLAGS
@@ -411,6 +425,61 @@ struct net_traffic_class {
 	k_thread_stack_t *stack;
 };
 
+/**
+ * @brief Tx scheduler statistics of a traffic class.
+ *
+ * Only available with CONFIG_NET_TC_TX_SCHED_DRR.
+ */
+struct net_tc_tx_sched_stats {
+	/** Number of packets currently queued */
+	uint32_t queued;
+
+	/** Highest number of packets queued at the same time */
+	uint32_t max_queued;
+
+	/** Number of packets passed to the network interface */
+	uint32_t sent_pkts;
+
+	/** Number of bytes passed to the network interface */
+	uint64_t sent_bytes;
+
+	/** Number of packets dropped because the queue was full */
+	uint32_t dropped;
+
+	/** Number of times the class had to wait for its rate limit */
+	uint32_t throttled;
+};
+
+/**
+ * @brief Limit the rate at which a Tx traffic class is sent.
+ *
+ * The rate is enforced by a token bucket. A packet is sent when the bucket
+ * is not empty, and its length is then taken from the bucket, so packets
+ * larger than the burst size are sent too.
+ *
+ * Only available with CONFIG_NET_TC_TX_SCHED_DRR.
+ *
+ * @param tc Traffic class
+ * @param rate Rate in bytes per second, 0 removes the limit
+ * @param burst Size of the token bucket in bytes
+ *
+ * @return 0 on success, -EINVAL if the traffic class does not exist.
+ */
+int net_tc_tx_set_rate(uint8_t tc, uint32_t rate, uint32_t burst);
+
+/**
+ * @brief Get the Tx scheduler statistics of a traffic class.
+ *
+ * Only available with CONFIG_NET_TC_TX_SCHED_DRR.
+ *
+ * @param tc Traffic class
+ * @param stats Filled with the statistics
+ *
+ * @return 0 on success, -EINVAL if the traffic class does not exist.
+ */
+int net_tc_tx_get_sched_stats(uint8_t tc,
+			      struct net_tc_tx_sched_stats *stats);
+
 /**
  * @brief Network Interface Device structure
  *
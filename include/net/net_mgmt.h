@@ -217,6 +217,9 @@ void net_mgmt_del_event_callback(struct net_mgmt_event_callback *cb);
  *
  * Note: info and length are disabled if CONFIG_NET_MGMT_EVENT_INFO
  *       is not defined.
+ *
+ * This can be called from an ISR. If the event queue is full, the event
+ * is dropped.
  */
 #ifdef CONFIG_NET_MGMT_EVENT
 void net_mgmt_event_notify_with_info(uint32_t mgmt_event, struct net_if *iface,
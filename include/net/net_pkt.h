@@ -121,6 +121,18 @@ struct net_pkt {
 	uint64_t txtime;
 #endif /* CONFIG_NET_PKT_TXTIME */
 
+#if defined(CONFIG_NET_RX_STEERING)
+	/** Flow hash used to select the RX queue, 0 if not yet known */
+	uint32_t rx_hash;
+#endif /* CONFIG_NET_RX_STEERING */
+
+#if defined(CONFIG_NET_TCP_GSO)
+	/** Segment payload size if this is a large TCP packet which is
+	 * to be split when sent, 0 otherwise.
+	 */
+	uint16_t gso_size;
+#endif /* CONFIG_NET_TCP_GSO */
+
 	/** Reference counter */
 	atomic_t atomic_ref;
 
@@ -184,6 +196,10 @@ struct net_pkt {
 	uint8_t captured : 1; /* Set to 1 if this packet is already being
 			       * captured
 			       */
+	uint8_t chksum_done : 1; /* Set to 1 if the upper layer checksum was
+				  * already filled in, so it must not be
+				  * computed again when finalizing.
+				  */
 
 	union {
 		/* IPv6 hop limit or IPv4 ttl for this network packet.
@@ -340,6 +356,17 @@ static inline void net_pkt_set_captured(struct net_pkt *pkt, bool is_captured)
 	pkt->captured = is_captured;
 }
 
+static inline bool net_pkt_is_chksum_done(struct net_pkt *pkt)
+{
+	return !!(pkt->chksum_done);
+}
+
+static inline void net_pkt_set_chksum_done(struct net_pkt *pkt,
+					   bool is_chksum_done)
+{
+	pkt->chksum_done = is_chksum_done;
+}
+
 static inline uint8_t net_pkt_ip_hdr_len(struct net_pkt *pkt)
 {
 	return pkt->ip_hdr_len;
@@ -857,6 +884,67 @@ static inline void net_pkt_set_txtime(struct net_pkt *pkt, uint64_t txtime)
 }
 #endif /* CONFIG_NET_PKT_TXTIME */
 
+#if defined(CONFIG_NET_RX_STEERING)
+static inline uint32_t net_pkt_rx_hash(struct net_pkt *pkt)
+{
+	return pkt->rx_hash;
+}
+
+/**
+ * @brief Set the flow hash of a received packet
+ *
+ * Drivers for devices computing a receive side scaling hash in hardware
+ * can pass it here before calling net_recv_data(), so that the stack does
+ * not need to parse the headers to select the RX queue. Packets with the
+ * same hash are always handled by the same RX thread, in order.
+ *
+ * @param pkt Network packet
+ * @param hash Flow hash, 0 means that the stack computes it
+ */
+static inline void net_pkt_set_rx_hash(struct net_pkt *pkt, uint32_t hash)
+{
+	pkt->rx_hash = hash;
+}
+#else
+static inline uint32_t net_pkt_rx_hash(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+
+static inline void net_pkt_set_rx_hash(struct net_pkt *pkt, uint32_t hash)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(hash);
+}
+#endif /* CONFIG_NET_RX_STEERING */
+
+#if defined(CONFIG_NET_TCP_GSO)
+static inline uint16_t net_pkt_gso_size(struct net_pkt *pkt)
+{
+	return pkt->gso_size;
+}
+
+static inline void net_pkt_set_gso_size(struct net_pkt *pkt, uint16_t size)
+{
+	pkt->gso_size = size;
+}
+#else
+static inline uint16_t net_pkt_gso_size(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return 0;
+}
+
+static inline void net_pkt_set_gso_size(struct net_pkt *pkt, uint16_t size)
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(size);
+}
+#endif /* CONFIG_NET_TCP_GSO */
+
 #if defined(CONFIG_NET_PKT_TXTIME_STATS_DETAIL) || \
 	defined(CONFIG_NET_PKT_RXTIME_STATS_DETAIL)
 static inline uint32_t *net_pkt_stats_tick(struct net_pkt *pkt)
@@ -2002,6 +2090,22 @@ bool net_pkt_is_contiguous(struct net_pkt *pkt, size_t size);
  */
 size_t net_pkt_get_contiguous_len(struct net_pkt *pkt);
 
+/**
+ * @brief Describe the data of a network packet with an I/O vector
+ *
+ * @details Maps the data from the current cursor position to the end of
+ *          the packet, one entry per fragment, without copying it. This
+ *          lets a driver hand the fragments over to scatter-gather DMA or
+ *          to vectored I/O. The cursor is not moved.
+ *
+ * @param pkt    Network packet.
+ * @param iov    I/O vector to fill.
+ * @param iovcnt Number of entries in @p iov.
+ *
+ * @return the number of entries filled, -E2BIG if @p iovcnt is too small.
+ */
+int net_pkt_get_iovec(struct net_pkt *pkt, struct iovec *iov, int iovcnt);
+
 struct net_pkt_data_access {
 #if !defined(CONFIG_NET_HEADERS_ALWAYS_CONTIGUOUS)
 	void *data;
@@ -16,6 +16,7 @@
 
 #include <zephyr/types.h>
 #include <net/net_core.h>
+#include <net/net_ip.h>
 #include <net/net_mgmt.h>
 
 #ifdef __cplusplus
@@ -286,6 +287,50 @@ struct net_stats_pm {
 };
 
 
+/**
+ * @brief Network context statistics
+ *
+ * Only available with CONFIG_NET_STATISTICS_CONTEXT.
+ */
+struct net_stats_context {
+	/** Amount of application data sent and received */
+	struct net_stats_bytes bytes;
+
+	/** Number of packets, or of TCP segments, sent and received */
+	struct net_stats_pkts pkts;
+
+	/**
+	 * Number of packets dropped, either received while nobody was
+	 * reading them or not sent because of an error.
+	 */
+	net_stats_t drop;
+
+	/** Amount of TCP data retransmitted */
+	net_stats_t resent;
+};
+
+/**
+ * @brief Statistics of one network context with its addresses
+ *
+ * Returned by the NET_REQUEST_STATS_GET_CONTEXT_TOP request.
+ */
+struct net_stats_context_entry {
+	/** Local address and port, family is AF_UNSPEC if unused */
+	struct sockaddr local;
+
+	/** Remote address and port, if connected */
+	struct sockaddr remote;
+
+	/** IP protocol of the context */
+	uint16_t proto;
+
+	/** Index of the network interface last used, 0 if none */
+	uint8_t iface;
+
+	/** Statistics of the context */
+	struct net_stats_context stats;
+};
+
 /**
  * @brief All network statistics in one struct.
  */
@@ -493,7 +538,8 @@ enum net_request_stats_cmd {
 	NET_REQUEST_STATS_CMD_GET_TCP,
 	NET_REQUEST_STATS_CMD_GET_ETHERNET,
 	NET_REQUEST_STATS_CMD_GET_PPP,
-	NET_REQUEST_STATS_CMD_GET_PM
+	NET_REQUEST_STATS_CMD_GET_PM,
+	NET_REQUEST_STATS_CMD_GET_CONTEXT_TOP
 };
 
 #define NET_REQUEST_STATS_GET_ALL				\
@@ -572,6 +618,20 @@ NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_ETHERNET);
 NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_PPP);
 #endif /* CONFIG_NET_STATISTICS_PPP */
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+/**
+ * Get the network contexts that sent and received the most data. The
+ * request data is an array of struct net_stats_context_entry, filled in
+ * decreasing order of sent and received bytes. The entries left over have
+ * an AF_UNSPEC local address. If an interface is given, only the contexts
+ * which last used it are considered.
+ */
+#define NET_REQUEST_STATS_GET_CONTEXT_TOP			\
+	(_NET_STATS_BASE | NET_REQUEST_STATS_CMD_GET_CONTEXT_TOP)
+
+NET_MGMT_DEFINE_REQUEST_HANDLER(NET_REQUEST_STATS_GET_CONTEXT_TOP);
+#endif /* CONFIG_NET_STATISTICS_CONTEXT */
+
 #endif /* CONFIG_NET_STATISTICS_USER_API */
 
 #if defined(CONFIG_NET_STATISTICS_POWER_MANAGEMENT)
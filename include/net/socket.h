@@ -27,6 +27,7 @@
 #include <net/net_ip.h>
 #include <net/dns_resolve.h>
 #include <net/socket_select.h>
+#include <net/socket_epoll.h>
 #include <stdlib.h>
 
 #ifdef __cplusplus
@@ -145,8 +146,53 @@ struct zsock_pollfd {
  */
 #define TLS_CERT_NOCOPY	       10
 
+/** Socket option to enable or disable the TLS client session cache for the
+ *  socket. It accepts and returns an integer, TLS_SESSION_CACHE_DISABLED or
+ *  TLS_SESSION_CACHE_ENABLED. When enabled, the session established by
+ *  connect() is stored, and resumed by the next connection to the same
+ *  peer (same hostname and port, or same address and port if no hostname
+ *  was set). Enabled by default if
+ *  CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT is not 0.
+ */
+#define TLS_SESSION_CACHE 11
+
+/** Write-only socket option to remove all the stored TLS sessions, on the
+ *  client and on the server side. The option value is ignored.
+ */
+#define TLS_SESSION_CACHE_PURGE 12
+
+/** Read-only socket option to read the statistics of the TLS handshakes
+ *  done on all the sockets of the system. It returns a
+ *  struct tls_handshake_stats.
+ */
+#define TLS_HANDSHAKE_STATS 13
+
 /** @} */
 
+/* Valid values for TLS_SESSION_CACHE option */
+#define TLS_SESSION_CACHE_DISABLED 0 /**< No TLS session caching. */
+#define TLS_SESSION_CACHE_ENABLED 1  /**< TLS session caching enabled. */
+
+/** Value of the TLS_HANDSHAKE_STATS option */
+struct tls_handshake_stats {
+	/** Number of successful handshakes */
+	uint32_t count;
+
+	/** Number of successful client handshakes which resumed a stored
+	 *  session
+	 */
+	uint32_t resumed;
+
+	/** Number of failed handshakes */
+	uint32_t failed;
+
+	/** Sum of the durations of the successful handshakes (ms) */
+	uint32_t total_time;
+
+	/** Longest successful handshake (ms) */
+	uint32_t max_time;
+};
+
 /* Valid values for TLS_PEER_VERIFY option */
 #define TLS_PEER_VERIFY_NONE 0     /**< Peer verification disabled. */
 #define TLS_PEER_VERIFY_OPTIONAL 1 /**< Peer verification optional. */
@@ -880,6 +926,84 @@ struct ifreq {
 /** sockopt: Enable SOCKS5 for Socket */
 #define SO_SOCKS5 60
 
+/** sockopt: Packet socket level */
+#define SOL_PACKET 263
+
+/* Socket options for SOL_PACKET level */
+/** sockopt: Receive the frames in a ring shared with the application */
+#define PACKET_RX_RING 5
+/** sockopt: Get and reset the RX ring statistics */
+#define PACKET_STATISTICS 6
+
+/** RX ring frame status: the frame can be written by the stack */
+#define TP_STATUS_KERNEL 0
+/** RX ring frame status: the frame holds a packet for the application */
+#define TP_STATUS_USER BIT(0)
+/** RX ring frame status: packets were dropped before this one */
+#define TP_STATUS_LOSING BIT(2)
+
+/**
+ * @brief Packet socket RX ring, set with the PACKET_RX_RING option.
+ *
+ * There is no mmap(). A supervisor thread can provide the memory of the
+ * ring, otherwise tp_ring is NULL and the stack takes the ring from its own
+ * memory, see CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE. Such a ring is added
+ * to the memory domain of a user mode thread setting it until the socket
+ * is closed, and its address is read back with the PACKET_RX_RING option
+ * of getsockopt(). User mode threads cannot provide the memory, they get
+ * EPERM. Once set, the received frames are only written to the ring, not
+ * queued for recv(). Setting the ring of a socket again, or removing it,
+ * is not supported.
+ */
+struct tpacket_req {
+	/** Memory of the ring, tp_frame_size * tp_frame_nr bytes, or NULL */
+	void *tp_ring;
+	/** Size of a frame, multiple of TPACKET_ALIGNMENT */
+	unsigned int tp_frame_size;
+	/** Number of frames in the ring */
+	unsigned int tp_frame_nr;
+};
+
+/**
+ * @brief Header at the start of each frame of a packet socket RX ring.
+ *
+ * The stack fills the frames in order, and sets tp_status to
+ * TP_STATUS_USER last. The application reads the frames in the same
+ * order, and gives each one back by setting tp_status to
+ * TP_STATUS_KERNEL.
+ */
+struct tpacket_hdr {
+	/** TP_STATUS_* flags */
+	uint32_t tp_status;
+	/** Length of the packet */
+	uint32_t tp_len;
+	/** Length of the packet stored in the frame */
+	uint32_t tp_snaplen;
+	/** Offset of the packet from the start of the frame */
+	uint16_t tp_mac;
+	/** Index of the receiving interface */
+	uint16_t tp_ifindex;
+	/** Receive time, seconds */
+	uint32_t tp_sec;
+	/** Receive time, nanoseconds */
+	uint32_t tp_nsec;
+};
+
+/** Alignment of the RX ring frames */
+#define TPACKET_ALIGNMENT 16
+/** Align a length to TPACKET_ALIGNMENT */
+#define TPACKET_ALIGN(x) ROUND_UP(x, TPACKET_ALIGNMENT)
+/** Length of the frame header, the packet follows it */
+#define TPACKET_HDRLEN TPACKET_ALIGN(sizeof(struct tpacket_hdr))
+
+/** RX ring statistics, read with the PACKET_STATISTICS option */
+struct tpacket_stats {
+	/** Packets received, dropped ones included */
+	unsigned int tp_packets;
+	/** Packets dropped as the ring was full */
+	unsigned int tp_drops;
+};
+
 /** @cond INTERNAL_HIDDEN */
 /**
  * @brief Registration information for a given BSD socket family.
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ZEPHYR_INCLUDE_NET_SOCKET_EPOLL_H_
+#define ZEPHYR_INCLUDE_NET_SOCKET_EPOLL_H_
+
+/**
+ * @brief BSD Sockets compatible API
+ * @defgroup bsd_sockets BSD Sockets compatible API
+ * @ingroup networking
+ * @{
+ */
+
+#include <zephyr/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ZSOCK_EPOLL* values are compatible with Linux */
+/** zsock_epoll: Descriptor is readable */
+#define ZSOCK_EPOLLIN 0x001
+/** zsock_epoll: Compatibility value, ignored */
+#define ZSOCK_EPOLLPRI 0x002
+/** zsock_epoll: Descriptor is writable */
+#define ZSOCK_EPOLLOUT 0x004
+/** zsock_epoll: Error condition (output value only) */
+#define ZSOCK_EPOLLERR 0x008
+/** zsock_epoll: Closed connection (output value only) */
+#define ZSOCK_EPOLLHUP 0x010
+/** zsock_epoll: Report the descriptor once, until re-armed by EPOLL_CTL_MOD */
+#define ZSOCK_EPOLLONESHOT (1U << 30)
+/** zsock_epoll: Edge-triggered notification */
+#define ZSOCK_EPOLLET (1U << 31)
+
+/** zsock_epoll_ctl: Add a descriptor to the interest list */
+#define ZSOCK_EPOLL_CTL_ADD 1
+/** zsock_epoll_ctl: Remove a descriptor from the interest list */
+#define ZSOCK_EPOLL_CTL_DEL 2
+/** zsock_epoll_ctl: Change the settings of a registered descriptor */
+#define ZSOCK_EPOLL_CTL_MOD 3
+
+/** User data associated with a descriptor in the interest list */
+typedef union zsock_epoll_data {
+	void *ptr;
+	int fd;
+	uint32_t u32;
+	uint64_t u64;
+} zsock_epoll_data_t;
+
+/** Interest list entry / readiness report */
+struct zsock_epoll_event {
+	/** Requested (for zsock_epoll_ctl) or reported (for zsock_epoll_wait)
+	 *  ZSOCK_EPOLL* event mask.
+	 */
+	uint32_t events;
+	/** User data, returned unchanged by zsock_epoll_wait */
+	zsock_epoll_data_t data;
+};
+
+/**
+ * @brief Create a socket readiness notification instance
+ *
+ * @details
+ * @rst
+ * Unlike :c:func:`zsock_poll()`, which is given the full set of sockets on
+ * every call, an epoll instance keeps a persistent interest list. Only the
+ * descriptors which became ready since the previous call are re-armed, so
+ * the cost of :c:func:`zsock_epoll_wait()` does not depend on the number of
+ * idle sockets being watched. The returned descriptor must be closed with
+ * :c:func:`zsock_close()`.
+ * This function is also exposed as ``epoll_create()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ *
+ * @param size Ignored, must be greater than zero (as in Linux).
+ *
+ * @return Epoll descriptor, or -1 with errno set.
+ */
+int zsock_epoll_create(int size);
+
+/**
+ * @brief Add, modify or remove an entry in the interest list
+ *
+ * @details
+ * @rst
+ * Descriptors are level-triggered by default. With ``ZSOCK_EPOLLET``, a
+ * descriptor is reported when it becomes ready and then again only when new
+ * input is queued on it, so the application is expected to read until
+ * ``EAGAIN``. Input arriving on a reported but not yet drained descriptor
+ * while :c:func:`zsock_epoll_wait()` is blocked is reported by the next
+ * call. Descriptors which cannot track new input (other than native network
+ * sockets) are reported on every call while they stay ready.
+ * Descriptors should be removed with ``ZSOCK_EPOLL_CTL_DEL`` before they are
+ * closed.
+ * This function is also exposed as ``epoll_ctl()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ *
+ * @param epfd Epoll descriptor returned by zsock_epoll_create()
+ * @param op One of ZSOCK_EPOLL_CTL_ADD, ZSOCK_EPOLL_CTL_MOD or
+ *        ZSOCK_EPOLL_CTL_DEL
+ * @param fd Socket descriptor to operate on
+ * @param event Requested events and user data, ignored for
+ *        ZSOCK_EPOLL_CTL_DEL
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+int zsock_epoll_ctl(int epfd, int op, int fd,
+		    struct zsock_epoll_event *event);
+
+/**
+ * @brief Wait for events on the interest list
+ *
+ * @details
+ * @rst
+ * This function is also exposed as ``epoll_wait()``
+ * if :option:`CONFIG_NET_SOCKETS_POSIX_NAMES` is defined.
+ * @endrst
+ *
+ * @param epfd Epoll descriptor returned by zsock_epoll_create()
+ * @param events Array to fill with ready descriptors
+ * @param maxevents Number of elements in @p events
+ * @param timeout Timeout in milliseconds, -1 to wait forever
+ *
+ * @return Number of ready descriptors (0 on timeout), or -1 with errno set.
+ */
+int zsock_epoll_wait(int epfd, struct zsock_epoll_event *events,
+		     int maxevents, int timeout);
+
+#ifdef CONFIG_NET_SOCKETS_POSIX_NAMES
+
+#define epoll_data_t zsock_epoll_data_t
+#define epoll_event zsock_epoll_event
+
+#define EPOLLIN ZSOCK_EPOLLIN
+#define EPOLLPRI ZSOCK_EPOLLPRI
+#define EPOLLOUT ZSOCK_EPOLLOUT
+#define EPOLLERR ZSOCK_EPOLLERR
+#define EPOLLHUP ZSOCK_EPOLLHUP
+#define EPOLLONESHOT ZSOCK_EPOLLONESHOT
+#define EPOLLET ZSOCK_EPOLLET
+
+#define EPOLL_CTL_ADD ZSOCK_EPOLL_CTL_ADD
+#define EPOLL_CTL_DEL ZSOCK_EPOLL_CTL_DEL
+#define EPOLL_CTL_MOD ZSOCK_EPOLL_CTL_MOD
+
+static inline int epoll_create(int size)
+{
+	return zsock_epoll_create(size);
+}
+
+static inline int epoll_ctl(int epfd, int op, int fd,
+			    struct zsock_epoll_event *event)
+{
+	return zsock_epoll_ctl(epfd, op, fd, event);
+}
+
+static inline int epoll_wait(int epfd, struct zsock_epoll_event *events,
+			     int maxevents, int timeout)
+{
+	return zsock_epoll_wait(epfd, events, maxevents, timeout);
+}
+
+#endif /* CONFIG_NET_SOCKETS_POSIX_NAMES */
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_NET_SOCKET_EPOLL_H_ */
@@ -151,11 +151,41 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		       enum websocket_opcode opcode, bool mask, bool final,
 		       int32_t timeout);
 
+/**
+ * @brief Send websocket msg to peer, gathering the payload from several
+ * buffers.
+ *
+ * @details The function will automatically add websocket header to the
+ * message. Unmasked data is given to the socket as is, masked data is
+ * masked while it is copied, a chunk of CONFIG_WEBSOCKET_MASK_BUF_LEN bytes
+ * at a time, so the payload is never copied to a temporary buffer as a
+ * whole.
+ *
+ * @param ws_sock Websocket id returned by websocket_connect().
+ * @param iov Buffers containing the websocket data to send.
+ * @param iovcnt Number of buffers.
+ * @param opcode Operation code (text, binary, ping, pong or close)
+ * @param mask Mask the data, see RFC 6455 for details
+ * @param final Is this final message for this message send, see
+ *        websocket_send_msg().
+ * @param timeout How long to try to send the message. The value is in
+ *        milliseconds. Value SYS_FOREVER_MS means to wait forever. Once part
+ *        of the message is sent, the rest of it is always waited for.
+ *
+ * @return <0 if error, >=0 amount of bytes sent
+ */
+int websocket_send_msg_iov(int ws_sock, const struct iovec *iov, int iovcnt,
+			   enum websocket_opcode opcode, bool mask, bool final,
+			   int32_t timeout);
+
 /**
  * @brief Receive websocket msg from peer.
  *
  * @details The function will automatically remove websocket header from the
- * message.
+ * message. Large or fragmented messages can be read in parts as they
+ * arrive. The message type is returned with each part, for a continuation
+ * frame it contains the data type of the first fragment, and
+ * WEBSOCKET_FLAG_FINAL is set for the last frame of the message.
  *
  * @param ws_sock Websocket id returned by websocket_connect().
  * @param buf Buffer where websocket data is read.
@@ -300,6 +300,10 @@
 #define MBEDTLS_SSL_ALPN
 #endif
 
+#if defined(CONFIG_MBEDTLS_SSL_CACHE_C)
+#define MBEDTLS_SSL_CACHE_C
+#endif
+
 #if defined(CONFIG_MBEDTLS_CIPHER)
 #define MBEDTLS_CIPHER_C
 #endif
@@ -238,6 +238,13 @@ static bool start_http_client(void)
 
 	hints.ai_socktype = SOCK_STREAM;
 
+	hb_context.sock = http_client_pool_get(CONFIG_HAWKBIT_SERVER,
+					       CONFIG_HAWKBIT_PORT);
+	if (hb_context.sock >= 0) {
+		LOG_DBG("Reusing connection to the server");
+		return true;
+	}
+
 	while (resolve_attempts--) {
 		ret = getaddrinfo(CONFIG_HAWKBIT_SERVER, CONFIG_HAWKBIT_PORT,
 				  &hints, &addr);
@@ -287,6 +294,7 @@ static bool start_http_client(void)
 
 err_sock:
 	close(hb_context.sock);
+	hb_context.sock = -1;
 err:
 	freeaddrinfo(addr);
 	return false;
@@ -294,9 +302,25 @@ err:
 
 static void cleanup_connection(void)
 {
+	struct http_response *rsp = &hb_context.http_req.internal.response;
+
+	if (hb_context.sock < 0) {
+		return;
+	}
+
+	/* Keep the connection for the next probe if the server allows it */
+	if (rsp->message_complete && rsp->keep_alive &&
+	    http_client_pool_put(hb_context.sock, CONFIG_HAWKBIT_SERVER,
+				 CONFIG_HAWKBIT_PORT) == 0) {
+		hb_context.sock = -1;
+		return;
+	}
+
 	if (close(hb_context.sock) < 0) {
 		LOG_ERR("Could not close the socket");
 	}
+
+	hb_context.sock = -1;
 }
 
 static int hawkbit_time2sec(const char *s)
@@ -662,50 +686,61 @@ static int enum_for_http_req_string(char *userdata)
 	return 0;
 }
 
+/* Append the body fragment of a JSON response to the response buffer */
+static int response_json_append(struct http_response *rsp, size_t *body_len)
+{
+	static size_t response_buffer_size = RESPONSE_BUFFER_SIZE;
+	uint8_t *rsp_tmp;
+
+	if (rsp->body_frag_start == NULL) {
+		return 0;
+	}
+
+	/* Keep room for the terminating null character */
+	while (*body_len + rsp->body_frag_len >= response_buffer_size) {
+		response_buffer_size <<= 1;
+		rsp_tmp = realloc(hb_context.response_data,
+				  response_buffer_size);
+		if (rsp_tmp == NULL) {
+			LOG_ERR("Failed to realloc memory");
+			return -ENOMEM;
+		}
+
+		hb_context.response_data = rsp_tmp;
+	}
+
+	memcpy(hb_context.response_data + *body_len, rsp->body_frag_start,
+	       rsp->body_frag_len);
+	*body_len += rsp->body_frag_len;
+
+	return 0;
+}
+
 static void response_cb(struct http_response *rsp,
 			enum http_final_call final_data,
 			void *userdata)
 {
 	static size_t body_len;
 	int ret, type, downloaded;
-	uint8_t *body_data = NULL, *rsp_tmp = NULL;
-	static size_t response_buffer_size = RESPONSE_BUFFER_SIZE;
 
 	type = enum_for_http_req_string(userdata);
 
 	switch (type) {
 	case HAWKBIT_PROBE:
 		if (hb_context.dl.http_content_size == 0) {
-			body_data = rsp->body_start;
-			body_len = strlen(rsp->recv_buf);
-			body_len -= (rsp->body_start - rsp->recv_buf);
-			strncpy(hb_context.response_data, body_data, body_len);
+			/* a new response, drop what is left of the last one */
 			hb_context.dl.http_content_size = rsp->content_length;
+			body_len = 0;
 		}
 
-		if ((body_data == NULL) && (final_data == HTTP_DATA_MORE)) {
-			body_data = rsp->recv_buf;
-			body_len = body_len + (rsp->data_len);
-			if (body_len > response_buffer_size) {
-				response_buffer_size <<= 1;
-				rsp_tmp = realloc(hb_context.response_data,
-						  response_buffer_size);
-				if (rsp_tmp == NULL) {
-					LOG_ERR("Failed to realloc memory");
-					hb_context.code_status =
-						HAWKBIT_METADATA_ERROR;
-					cleanup_connection();
-					break;
-				}
-
-				hb_context.response_data = rsp_tmp;
-			}
-
-			strncat(hb_context.response_data, body_data,
-					rsp->data_len);
+		if (response_json_append(rsp, &body_len) < 0) {
+			hb_context.code_status = HAWKBIT_METADATA_ERROR;
+			cleanup_connection();
+			body_len = 0;
+			break;
 		}
 
-		if (final_data == HTTP_DATA_FINAL) {
+		if (final_data == HTTP_DATA_FINAL && rsp->message_complete) {
 			if (hb_context.dl.http_content_size != body_len) {
 				LOG_ERR("HTTP response len mismatch");
 				hb_context.code_status =
@@ -739,36 +774,19 @@ static void response_cb(struct http_response *rsp,
 
 	case HAWKBIT_PROBE_DEPLOYMENT_BASE:
 		if (hb_context.dl.http_content_size == 0) {
-			body_data = rsp->body_start;
-			body_len = strlen(rsp->recv_buf);
-			body_len -= (rsp->body_start - rsp->recv_buf);
-			strncpy(hb_context.response_data, body_data, body_len);
+			/* a new response, drop what is left of the last one */
 			hb_context.dl.http_content_size = rsp->content_length;
+			body_len = 0;
 		}
 
-		if ((body_data == NULL) && (final_data == HTTP_DATA_MORE)) {
-			body_data = rsp->recv_buf;
-			body_len = body_len + (rsp->data_len);
-			if (body_len > response_buffer_size) {
-				response_buffer_size <<= 1;
-				rsp_tmp = realloc(hb_context.response_data,
-						  response_buffer_size);
-				if (rsp_tmp == NULL) {
-					LOG_ERR("Failed to relloc memory");
-					hb_context.code_status =
-						HAWKBIT_METADATA_ERROR;
-					cleanup_connection();
-					break;
-				}
-
-				hb_context.response_data = rsp_tmp;
-			}
-
-			strncat(hb_context.response_data, body_data,
-				rsp->data_len);
+		if (response_json_append(rsp, &body_len) < 0) {
+			hb_context.code_status = HAWKBIT_METADATA_ERROR;
+			cleanup_connection();
+			body_len = 0;
+			break;
 		}
 
-		if (final_data == HTTP_DATA_FINAL) {
+		if (final_data == HTTP_DATA_FINAL && rsp->message_complete) {
 			if (hb_context.dl.http_content_size != body_len) {
 				LOG_ERR("HTTP response len mismatch");
 				hb_context.code_status =
@@ -793,21 +811,16 @@ static void response_cb(struct http_response *rsp,
 
 	case HAWKBIT_DOWNLOAD:
 		if (hb_context.dl.http_content_size == 0) {
-			body_data = rsp->body_start;
-			body_len = rsp->data_len;
-			body_len -= (rsp->body_start - rsp->recv_buf);
 			hb_context.dl.http_content_size = rsp->content_length;
 		}
 
-		if ((rsp->body_found == 1) && (body_data == NULL)) {
-			body_data = rsp->recv_buf;
-			body_len = rsp->data_len;
-		}
-
-		if (body_data != NULL) {
+		/* Fragments are written as they arrive, the flash buffer
+		 * is flushed once the whole image was received.
+		 */
+		if (rsp->body_frag_start != NULL || rsp->message_complete) {
 			ret = flash_img_buffered_write(&hb_context.flash_ctx,
-				body_data, body_len,
-				final_data == HTTP_DATA_FINAL);
+				rsp->body_frag_start, rsp->body_frag_len,
+				rsp->message_complete);
 			if (ret < 0) {
 				LOG_ERR("flash write error");
 				hb_context.code_status = HAWKBIT_DOWNLOAD_ERROR;
@@ -826,7 +839,7 @@ static void response_cb(struct http_response *rsp,
 				hb_context.dl.download_progress);
 		}
 
-		if (final_data == HTTP_DATA_FINAL) {
+		if (final_data == HTTP_DATA_FINAL && rsp->message_complete) {
 			k_sem_give(&hb_context.semaphore);
 		}
 
@@ -1020,6 +1033,7 @@ enum hawkbit_response hawkbit_probe(void)
 	     firmware_version[BOOT_IMG_VER_STRLEN_MAX] = { 0 };
 
 	memset(&hb_context, 0, sizeof(hb_context));
+	hb_context.sock = -1;
 	hb_context.response_data = malloc(RESPONSE_BUFFER_SIZE);
 	k_sem_init(&hb_context.semaphore, 0, 1);
 
@@ -59,6 +59,145 @@ static const uint8_t da_inline_size_table[] = {
 	16, 8, 2, 0, 0, 8, 2, 0, 16, 6, 4, 1, 6
 	};
 
+#if defined(CONFIG_NET_6LO_COMPRESS_CACHE)
+/* The compression of the addresses only depends on the addresses, so the
+ * result is kept per flow and copied to the next packets of the flow.
+ */
+struct compress_cache_lladdr {
+	/* The 6lo link layer addresses are at most EUI-64 */
+	uint8_t addr[8];
+	uint8_t len;
+	uint8_t type;
+};
+
+struct compress_cache_key {
+	struct net_if *iface;
+	struct in6_addr src;
+	struct in6_addr dst;
+	struct compress_cache_lladdr lladdr_src;
+	struct compress_cache_lladdr lladdr_dst;
+};
+
+struct compress_cache_entry {
+	struct compress_cache_key key;
+	/* The CID, SAC, SAM, M, DAC and DAM bits of the IPHC header */
+	uint16_t iphc;
+	uint8_t cid;
+	uint8_t inline_len;
+	/* Inlined source address, followed by the destination address */
+	uint8_t inline_data[32];
+};
+
+static struct compress_cache_entry
+compress_cache[CONFIG_NET_6LO_COMPRESS_CACHE_SIZE];
+static uint8_t compress_cache_next;
+static struct k_spinlock compress_cache_lock;
+
+#define COMPRESS_CACHE_IPHC_MASK (NET_6LO_IPHC_CID_MASK | \
+				  NET_6LO_IPHC_SA_MASK | \
+				  NET_6LO_IPHC_DA_MASK)
+
+static bool compress_cache_lladdr_set(struct compress_cache_lladdr *stored,
+				      struct net_linkaddr *lladdr)
+{
+	if (!lladdr->addr || lladdr->len > sizeof(stored->addr)) {
+		return false;
+	}
+
+	stored->type = lladdr->type;
+	stored->len = lladdr->len;
+	memcpy(stored->addr, lladdr->addr, lladdr->len);
+
+	return true;
+}
+
+/* The key is zeroed first, so that keys can be compared as a whole */
+static bool compress_cache_key_set(struct compress_cache_key *key,
+				   struct net_pkt *pkt,
+				   struct net_ipv6_hdr *ipv6)
+{
+	memset(key, 0, sizeof(*key));
+
+	key->iface = net_pkt_iface(pkt);
+	net_ipaddr_copy(&key->src, &ipv6->src);
+	net_ipaddr_copy(&key->dst, &ipv6->dst);
+
+	return compress_cache_lladdr_set(&key->lladdr_src,
+					 net_pkt_lladdr_src(pkt)) &&
+		compress_cache_lladdr_set(&key->lladdr_dst,
+					  net_pkt_lladdr_dst(pkt));
+}
+
+/* Returns the position of the compressed addresses copied in front of
+ * inline_ptr, or NULL if the flow is not known.
+ */
+static uint8_t *compress_cache_get(struct compress_cache_key *key,
+				   uint8_t *inline_ptr, uint16_t *iphc,
+				   uint8_t *cid)
+{
+	k_spinlock_key_t lock_key;
+	uint8_t *ptr = NULL;
+	int i;
+
+	lock_key = k_spin_lock(&compress_cache_lock);
+
+	for (i = 0; i < ARRAY_SIZE(compress_cache); i++) {
+		struct compress_cache_entry *entry = &compress_cache[i];
+
+		if (memcmp(&entry->key, key, sizeof(*key))) {
+			continue;
+		}
+
+		ptr = inline_ptr - entry->inline_len;
+		memcpy(ptr, entry->inline_data, entry->inline_len);
+
+		*iphc |= entry->iphc;
+		*cid = entry->cid;
+		break;
+	}
+
+	k_spin_unlock(&compress_cache_lock, lock_key);
+
+	return ptr;
+}
+
+static void compress_cache_add(struct compress_cache_key *key,
+			       uint8_t *inline_ptr, uint8_t inline_len,
+			       uint16_t iphc, uint8_t cid)
+{
+	struct compress_cache_entry *entry;
+	k_spinlock_key_t lock_key;
+
+	lock_key = k_spin_lock(&compress_cache_lock);
+
+	entry = &compress_cache[compress_cache_next];
+	compress_cache_next = (compress_cache_next + 1) %
+		ARRAY_SIZE(compress_cache);
+
+	memcpy(&entry->key, key, sizeof(*key));
+	entry->iphc = iphc & COMPRESS_CACHE_IPHC_MASK;
+	entry->cid = cid;
+	entry->inline_len = inline_len;
+	memcpy(entry->inline_data, inline_ptr, inline_len);
+
+	k_spin_unlock(&compress_cache_lock, lock_key);
+}
+
+#if defined(CONFIG_NET_6LO_CONTEXT)
+/* Called when the contexts change */
+static void compress_cache_flush(void)
+{
+	k_spinlock_key_t lock_key;
+
+	lock_key = k_spin_lock(&compress_cache_lock);
+	memset(compress_cache, 0, sizeof(compress_cache));
+	k_spin_unlock(&compress_cache_lock, lock_key);
+}
+#endif
+#else
+#define compress_cache_flush(...)
+#endif /* CONFIG_NET_6LO_COMPRESS_CACHE */
+
 static int get_udp_nhc_inlined_size(uint8_t nhc)
 {
 	int size = 0;
@@ -178,6 +317,9 @@ void net_6lo_set_context(struct net_if *iface,
 	int unused = -1;
 	uint8_t i;
 
+	/* The cached compression may depend on the previous contexts */
+	compress_cache_flush();
+
 	/* If the context information already exists, update or remove
 	 * as per data.
 	 */
@@ -723,12 +865,17 @@ static inline int compress_IPHC_header(struct net_pkt *pkt)
 #if defined(CONFIG_NET_6LO_CONTEXT)
 	struct net_6lo_context *src_ctx = NULL;
 	struct net_6lo_context *dst_ctx = NULL;
+#endif
+#if defined(CONFIG_NET_6LO_COMPRESS_CACHE)
+	struct compress_cache_key flow;
+	uint8_t *addr_pos = NULL;
 #endif
 	uint8_t compressed = 0;
 	uint16_t iphc = (NET_6LO_DISPATCH_IPHC << 8);
 	struct net_ipv6_hdr *ipv6 = NET_IPV6_HDR(pkt);
 	struct net_udp_hdr *udp;
 	uint8_t *inline_pos;
+	uint8_t cid = 0;
 
 	if (pkt->frags->len < NET_IPV6H_LEN) {
 		NET_ERR("Invalid length %d, min %d",
@@ -752,6 +899,21 @@ static inline int compress_IPHC_header(struct net_pkt *pkt)
 		inline_pos = compress_nh_udp(udp, inline_pos, false);
 	}
 
+#if defined(CONFIG_NET_6LO_COMPRESS_CACHE)
+	/* The addresses are still intact, the UDP header is compressed
+	 * after them.
+	 */
+	if (compress_cache_key_set(&flow, pkt, ipv6)) {
+		addr_pos = compress_cache_get(&flow, inline_pos, &iphc, &cid);
+		if (addr_pos) {
+			inline_pos = addr_pos;
+			goto addr_end;
+		}
+
+		addr_pos = inline_pos;
+	}
+#endif
+
 	if (net_6lo_ll_prefix_padded_with_zeros(&ipv6->dst)) {
 		inline_pos = compress_da(ipv6, pkt, inline_pos, &iphc);
 		goto da_end;
@@ -800,24 +962,32 @@ da_end:
 	inline_pos = set_sa_inline(ipv6, inline_pos, &iphc);
 sa_end:
 
+#if defined(CONFIG_NET_6LO_CONTEXT)
+	if (src_ctx) {
+		cid = src_ctx->cid << 4;
+	}
+
+	if (dst_ctx) {
+		cid |= dst_ctx->cid & 0x0F;
+	}
+#endif
+
+#if defined(CONFIG_NET_6LO_COMPRESS_CACHE)
+	if (addr_pos) {
+		compress_cache_add(&flow, inline_pos, addr_pos - inline_pos,
+				   iphc, cid);
+	}
+
+addr_end:
+#endif
 	inline_pos = compress_hoplimit(ipv6, inline_pos, &iphc);
 	inline_pos = compress_nh(ipv6, inline_pos, &iphc);
 	inline_pos = compress_tfl(ipv6, inline_pos, &iphc);
 
-#if defined(CONFIG_NET_6LO_CONTEXT)
 	if (iphc & NET_6LO_IPHC_CID_1) {
 		inline_pos -= sizeof(uint8_t);
-		*inline_pos = 0;
-
-		if (src_ctx) {
-			*inline_pos = src_ctx->cid << 4;
-		}
-
-		if (dst_ctx) {
-			*inline_pos |= dst_ctx->cid & 0x0F;
-		}
+		*inline_pos = cid;
 	}
-#endif
 
 	inline_pos -= sizeof(iphc);
 	iphc = htons(iphc);
@@ -1308,6 +1478,33 @@ static inline void uncompress_cid(struct net_pkt *pkt, uint8_t cid,
 }
 #endif
 
+static bool lladdr_in_range(struct net_linkaddr *lladdr, uint8_t *start,
+			    uint8_t *end)
+{
+	return lladdr->addr && lladdr->addr < end &&
+		lladdr->addr + lladdr->len > start;
+}
+
+/* The headers can be uncompressed in front of the compressed ones without
+ * moving the payload, if there is room there. The link layer addresses
+ * often point to the L2 header in that room, it must be kept.
+ */
+static bool uncompress_in_headroom(struct net_pkt *pkt, size_t diff)
+{
+	uint8_t *start;
+
+	if (net_buf_headroom(pkt->buffer) < diff) {
+		return false;
+	}
+
+	start = pkt->buffer->data - diff;
+
+	return !lladdr_in_range(net_pkt_lladdr_src(pkt), start,
+				pkt->buffer->data) &&
+		!lladdr_in_range(net_pkt_lladdr_dst(pkt), start,
+				 pkt->buffer->data);
+}
+
 static bool uncompress_IPHC_header(struct net_pkt *pkt)
 {
 	struct net_udp_hdr *udp = NULL;
@@ -1353,7 +1550,12 @@ static bool uncompress_IPHC_header(struct net_pkt *pkt)
 		return false;
 	}
 
-	if (net_buf_tailroom(pkt->buffer) >= diff) {
+	if (uncompress_in_headroom(pkt, diff)) {
+		NET_DBG("Enough headroom. Uncompress inplace");
+		frag = pkt->buffer;
+		net_buf_push(frag, diff);
+		cursor = frag->data + diff;
+	} else if (net_buf_tailroom(pkt->buffer) >= diff) {
 		NET_DBG("Enough tailroom. Uncompress inplace");
 		frag = pkt->buffer;
 		net_buf_add(frag, diff);
@@ -525,7 +525,16 @@ static enum net_verdict conn_raw_socket(struct net_pkt *pkt,
 		NET_DBG("[%p] raw match found cb %p ud %p", conn,
 			conn->cb, conn->user_data);
 
-		raw_pkt = net_pkt_clone(pkt, CLONE_TIMEOUT);
+		if (conn->context &&
+		    (conn->context->flags & NET_CONTEXT_RX_COPY)) {
+			/* The packet is copied out before the callback
+			 * returns, so the original one can be given.
+			 */
+			raw_pkt = net_pkt_ref(pkt);
+		} else {
+			raw_pkt = net_pkt_clone(pkt, CLONE_TIMEOUT);
+		}
+
 		if (!raw_pkt) {
 			net_stats_update_per_proto_drop(pkt_iface, proto);
 			NET_WARN("pkt cloning failed, pkt %p dropped", pkt);
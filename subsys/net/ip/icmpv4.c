@@ -54,6 +54,10 @@ int net_icmpv4_finalize(struct net_pkt *pkt)
 					      struct net_icmp_hdr);
 	struct net_icmp_hdr *icmp_hdr;
 
+	if (net_pkt_is_chksum_done(pkt)) {
+		return 0;
+	}
+
 	if (IS_ENABLED(CONFIG_NET_IPV4_HDR_OPTIONS)) {
 		if (net_pkt_skip(pkt, net_pkt_ipv4_opts_len(pkt))) {
 			return -ENOBUFS;
@@ -412,6 +416,7 @@ static enum net_verdict icmpv4_handle_echo_request(struct net_pkt *pkt,
 					   struct net_icmp_hdr *icmp_hdr)
 {
 	struct net_pkt *reply = NULL;
+	struct net_icmp_hdr reply_hdr;
 	const struct in_addr *src;
 	int16_t payload_len;
 
@@ -464,11 +469,22 @@ static enum net_verdict icmpv4_handle_echo_request(struct net_pkt *pkt,
 		}
 	}
 
-	if (icmpv4_create(reply, NET_ICMPV4_ECHO_REPLY, 0) ||
+	/* The reply only differs from the request by its type, so update the
+	 * checksum of the request instead of summing the payload again.
+	 */
+	reply_hdr.type = NET_ICMPV4_ECHO_REPLY;
+	reply_hdr.code = 0U;
+	reply_hdr.chksum = net_chksum_update_u16(
+		icmp_hdr->chksum,
+		htons(icmp_hdr->type << 8 | icmp_hdr->code),
+		htons(NET_ICMPV4_ECHO_REPLY << 8));
+
+	if (net_pkt_write(reply, &reply_hdr, sizeof(reply_hdr)) ||
 	    net_pkt_copy(reply, pkt, payload_len)) {
 		goto drop;
 	}
 
+	net_pkt_set_chksum_done(reply, true);
 	net_pkt_cursor_init(reply);
 	net_ipv4_finalize(reply, IPPROTO_ICMP);
 
@@ -675,7 +691,8 @@ enum net_verdict net_icmpv4_input(struct net_pkt *pkt,
 		return NET_DROP;
 	}
 
-	if (net_calc_chksum_icmpv4(pkt) != 0U) {
+	if (net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+	    net_calc_chksum_icmpv4(pkt) != 0U) {
 		NET_DBG("DROP: Invalid checksum");
 		goto drop;
 	}
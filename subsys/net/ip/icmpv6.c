@@ -74,6 +74,10 @@ int net_icmpv6_finalize(struct net_pkt *pkt)
 					      struct net_icmp_hdr);
 	struct net_icmp_hdr *icmp_hdr;
 
+	if (net_pkt_is_chksum_done(pkt)) {
+		return 0;
+	}
+
 	icmp_hdr = (struct net_icmp_hdr *)net_pkt_get_data(pkt, &icmp_access);
 	if (!icmp_hdr) {
 		return -ENOBUFS;
@@ -108,11 +112,10 @@ enum net_verdict icmpv6_handle_echo_request(struct net_pkt *pkt,
 					    struct net_icmp_hdr *icmp_hdr)
 {
 	struct net_pkt *reply = NULL;
+	struct net_icmp_hdr reply_hdr;
 	const struct in6_addr *src;
 	int16_t payload_len;
 
-	ARG_UNUSED(icmp_hdr);
-
 	NET_DBG("Received Echo Request from %s to %s",
 		log_strdup(net_sprint_ipv6_addr(&ip_hdr->src)),
 		log_strdup(net_sprint_ipv6_addr(&ip_hdr->dst)));
@@ -151,12 +154,29 @@ enum net_verdict icmpv6_handle_echo_request(struct net_pkt *pkt,
 		goto drop;
 	}
 
-	if (net_icmpv6_create(reply, NET_ICMPV6_ECHO_REPLY, 0) ||
+	/* The reply carries the same payload, only the type and the pseudo
+	 * header addresses change: the request source becomes the destination
+	 * and the destination is replaced by our source address. So update
+	 * the checksum of the request instead of summing the payload again.
+	 */
+	reply_hdr.type = NET_ICMPV6_ECHO_REPLY;
+	reply_hdr.code = 0U;
+	reply_hdr.chksum = net_chksum_update_u16(
+		icmp_hdr->chksum,
+		htons(icmp_hdr->type << 8 | icmp_hdr->code),
+		htons(NET_ICMPV6_ECHO_REPLY << 8));
+	reply_hdr.chksum = net_chksum_update(reply_hdr.chksum,
+					     ip_hdr->dst.s6_addr,
+					     src->s6_addr,
+					     sizeof(struct in6_addr));
+
+	if (net_pkt_write(reply, &reply_hdr, sizeof(reply_hdr)) ||
 	    net_pkt_copy(reply, pkt, payload_len)) {
 		NET_DBG("DROP: wrong buffer");
 		goto drop;
 	}
 
+	net_pkt_set_chksum_done(reply, true);
 	net_pkt_cursor_init(reply);
 	net_ipv6_finalize(reply, IPPROTO_ICMPV6);
 
@@ -414,7 +434,8 @@ enum net_verdict net_icmpv6_input(struct net_pkt *pkt,
 		return NET_DROP;
 	}
 
-	if (net_calc_chksum_icmpv6(pkt) != 0U) {
+	if (net_if_need_calc_rx_checksum(net_pkt_iface(pkt)) &&
+	    net_calc_chksum_icmpv6(pkt) != 0U) {
 		NET_DBG("DROP: invalid checksum");
 		goto drop;
 	}
@@ -649,6 +649,10 @@ enum net_verdict net_ipv6_input(struct net_pkt *pkt, bool is_loopback)
 		return verdict;
 	}
 
+	if (nexthdr == IPPROTO_TCP && net_tcp_gro_receive(pkt)) {
+		return NET_OK;
+	}
+
 	ip.ipv6 = hdr;
 
 	verdict = net_conn_input(pkt, &ip, nexthdr, &proto_hdr);
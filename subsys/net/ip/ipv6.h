@@ -400,17 +400,33 @@ struct net_ipv6_reassembly {
 	/** IPv6 destination address of the fragment */
 	struct in6_addr dst;
 
-	/**
-	 * Timeout for cancelling the reassembly. The timer is used
-	 * also to detect if this reassembly slot is used or not.
-	 */
+	/** Timeout for cancelling the reassembly. */
 	struct k_work_delayable timer;
 
-	/** Pointers to pending fragments */
+	/** Link in the reassembly hash table */
+	sys_snode_t node;
+
+	/**
+	 * Pointers to pending fragments, sorted by fragment offset. Only the
+	 * fragment at offset 0 keeps its IPv6 and fragment headers, they are
+	 * stripped from the other ones when received.
+	 */
 	struct net_pkt *pkt[NET_IPV6_FRAGMENTS_MAX_PKT];
 
 	/** IPv6 fragment identification */
 	uint32_t id;
+
+	/** Fragment payload bytes received so far */
+	uint16_t len;
+
+	/** Payload length of the packet, 0 until the last fragment arrives */
+	uint16_t total_len;
+
+	/** Number of fragments in pkt */
+	uint8_t count;
+
+	/** Is this reassembly slot used or not */
+	bool in_use;
 };
 
 /**
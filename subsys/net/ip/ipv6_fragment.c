@@ -40,12 +40,20 @@ LOG_MODULE_DECLARE(net_ipv6, CONFIG_NET_IPV6_LOG_LEVEL);
 
 #define FRAG_BUF_WAIT K_MSEC(10) /* how long to max wait for a buffer */
 
+#define REASSEMBLY_HASH_SIZE CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT
+
 static void reassembly_timeout(struct k_work *work);
 static bool reassembly_init_done;
 
 static struct net_ipv6_reassembly
 reassembly[CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT];
 
+/* Pending reassemblies hashed by fragment id and source address */
+static sys_slist_t reassembly_hash[REASSEMBLY_HASH_SIZE];
+
+/* The timeout work and the RX path both modify the reassembly table */
+static K_MUTEX_DEFINE(reassembly_lock);
+
 int net_ipv6_find_last_ext_hdr(struct net_pkt *pkt, uint16_t *next_hdr_off,
 			       uint16_t *last_hdr_off)
 {
@@ -121,86 +129,102 @@ fail:
 	return -EINVAL;
 }
 
+static inline uint32_t reassembly_key(uint32_t id,
+				      const struct in6_addr *src)
+{
+	uint32_t key = id ^ UNALIGNED_GET(&src->s6_addr32[0]) ^
+		       UNALIGNED_GET(&src->s6_addr32[1]) ^
+		       UNALIGNED_GET(&src->s6_addr32[2]) ^
+		       UNALIGNED_GET(&src->s6_addr32[3]);
+
+	return ((key * 0x9e3779b1U) >> 16) % REASSEMBLY_HASH_SIZE;
+}
+
 static struct net_ipv6_reassembly *reassembly_get(uint32_t id,
 						  struct in6_addr *src,
 						  struct in6_addr *dst)
 {
-	int i, avail = -1;
+	sys_slist_t *bucket = &reassembly_hash[reassembly_key(id, src)];
+	struct net_ipv6_reassembly *reass;
+	int i, avail = -1, src_count = 0;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(bucket, reass, node) {
+		if (reass->id == id &&
+		    net_ipv6_addr_cmp(src, &reass->src) &&
+		    net_ipv6_addr_cmp(dst, &reass->dst)) {
+			return reass;
+		}
+	}
 
+	/* A new reassembly, make sure a single source cannot use up all
+	 * the slots.
+	 */
 	for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-		if (k_work_delayable_remaining_get(&reassembly[i].timer) &&
-		    reassembly[i].id == id &&
-		    net_ipv6_addr_cmp(src, &reassembly[i].src) &&
-		    net_ipv6_addr_cmp(dst, &reassembly[i].dst)) {
-			return &reassembly[i];
-		}
+		if (!reassembly[i].in_use) {
+			if (avail < 0) {
+				avail = i;
+			}
 
-		if (k_work_delayable_remaining_get(&reassembly[i].timer)) {
 			continue;
 		}
 
-		if (avail < 0) {
-			avail = i;
+		if (net_ipv6_addr_cmp(src, &reassembly[i].src)) {
+			src_count++;
 		}
 	}
 
-	if (avail < 0) {
+	if (avail < 0 || src_count >= CONFIG_NET_IPV6_FRAGMENT_MAX_PER_SRC) {
 		return NULL;
 	}
 
-	k_work_reschedule(&reassembly[avail].timer, IPV6_REASSEMBLY_TIMEOUT);
+	reass = &reassembly[avail];
 
-	net_ipaddr_copy(&reassembly[avail].src, src);
-	net_ipaddr_copy(&reassembly[avail].dst, dst);
+	k_work_reschedule(&reass->timer, IPV6_REASSEMBLY_TIMEOUT);
 
-	reassembly[avail].id = id;
+	net_ipaddr_copy(&reass->src, src);
+	net_ipaddr_copy(&reass->dst, dst);
 
-	return &reassembly[avail];
-}
-
-static bool reassembly_cancel(uint32_t id,
-			      struct in6_addr *src,
-			      struct in6_addr *dst)
-{
-	int i, j;
+	reass->id = id;
+	reass->len = 0U;
+	reass->total_len = 0U;
+	reass->count = 0U;
+	reass->in_use = true;
 
-	NET_DBG("Cancel 0x%x", id);
+	sys_slist_prepend(bucket, &reass->node);
 
-	for (i = 0; i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-		int32_t remaining;
+	return reass;
+}
 
-		if (reassembly[i].id != id ||
-		    !net_ipv6_addr_cmp(src, &reassembly[i].src) ||
-		    !net_ipv6_addr_cmp(dst, &reassembly[i].dst)) {
-			continue;
-		}
+static void reassembly_cancel(struct net_ipv6_reassembly *reass)
+{
+	int32_t remaining;
+	int i;
 
-		remaining = k_ticks_to_ms_ceil32(
-			k_work_delayable_remaining_get(&reassembly[i].timer));
-		k_work_cancel_delayable(&reassembly[i].timer);
+	NET_DBG("Cancel 0x%x", reass->id);
 
-		NET_DBG("IPv6 reassembly id 0x%x remaining %d ms",
-			reassembly[i].id, remaining);
+	remaining = k_ticks_to_ms_ceil32(
+		k_work_delayable_remaining_get(&reass->timer));
+	k_work_cancel_delayable(&reass->timer);
 
-		reassembly[i].id = 0U;
+	NET_DBG("IPv6 reassembly id 0x%x remaining %d ms",
+		reass->id, remaining);
 
-		for (j = 0; j < NET_IPV6_FRAGMENTS_MAX_PKT; j++) {
-			if (!reassembly[i].pkt[j]) {
-				continue;
-			}
+	sys_slist_find_and_remove(
+		&reassembly_hash[reassembly_key(reass->id, &reass->src)],
+		&reass->node);
 
-			NET_DBG("[%d] IPv6 reassembly pkt %p %zd bytes data",
-				j, reassembly[i].pkt[j],
-				net_pkt_get_len(reassembly[i].pkt[j]));
+	reass->id = 0U;
+	reass->in_use = false;
 
-			net_pkt_unref(reassembly[i].pkt[j]);
-			reassembly[i].pkt[j] = NULL;
-		}
+	for (i = 0; i < reass->count; i++) {
+		NET_DBG("[%d] IPv6 reassembly pkt %p %zd bytes data",
+			i, reass->pkt[i], net_pkt_get_len(reass->pkt[i]));
 
-		return true;
+		net_pkt_unref(reass->pkt[i]);
+		reass->pkt[i] = NULL;
 	}
 
-	return false;
+	reass->count = 0U;
 }
 
 static void reassembly_info(char *str, struct net_ipv6_reassembly *reass)
@@ -217,9 +241,19 @@ static void reassembly_timeout(struct k_work *work)
 	struct net_ipv6_reassembly *reass =
 		CONTAINER_OF(work, struct net_ipv6_reassembly, timer);
 
-	reassembly_info("Reassembly cancelled", reass);
+	k_mutex_lock(&reassembly_lock, K_FOREVER);
+
+	/* The slot might have been completed, or even reused, after the
+	 * timer expired but before this work got to run.
+	 */
+	if (reass->in_use &&
+	    !k_work_delayable_remaining_get(&reass->timer)) {
+		reassembly_info("Reassembly cancelled", reass);
+
+		reassembly_cancel(reass);
+	}
 
-	reassembly_cancel(reass->id, &reass->src, &reass->dst);
+	k_mutex_unlock(&reassembly_lock);
 }
 
 static void reassemble_packet(struct net_ipv6_reassembly *reass)
@@ -236,37 +270,17 @@ static void reassemble_packet(struct net_ipv6_reassembly *reass)
 	uint8_t next_hdr;
 	int i, len;
 
-	k_work_cancel_delayable(&reass->timer);
-
 	NET_ASSERT(reass->pkt[0]);
 
 	last = net_buf_frag_last(reass->pkt[0]->buffer);
 
 	/* We start from 2nd packet which is then appended to
-	 * the first one.
+	 * the first one. The headers of the other fragments were
+	 * already removed when they were received.
 	 */
-	for (i = 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		int removed_len;
-
+	for (i = 1; i < reass->count; i++) {
 		pkt = reass->pkt[i];
 
-		net_pkt_cursor_init(pkt);
-
-		/* Get rid of IPv6 and fragment header which are at
-		 * the beginning of the fragment.
-		 */
-		removed_len = net_pkt_ipv6_fragment_start(pkt) +
-			      sizeof(struct net_ipv6_frag_hdr);
-
-		NET_DBG("Removing %d bytes from start of pkt %p",
-			removed_len, pkt->buffer);
-
-		if (net_pkt_pull(pkt, removed_len)) {
-			NET_ERR("Failed to pull headers");
-			reassembly_cancel(reass->id, &reass->src, &reass->dst);
-			return;
-		}
-
 		/* Attach the data to previous pkt */
 		last->frags = pkt->buffer;
 		last = net_buf_frag_last(pkt->buffer);
@@ -279,6 +293,9 @@ static void reassemble_packet(struct net_ipv6_reassembly *reass)
 
 	pkt = reass->pkt[0];
 	reass->pkt[0] = NULL;
+	reass->count = 0U;
+
+	reassembly_cancel(reass);
 
 	/* Next we need to strip away the fragment header from the first packet
 	 * and set the various pointers and values in packet.
@@ -351,76 +368,63 @@ void net_ipv6_frag_foreach(net_ipv6_frag_cb_t cb, void *user_data)
 {
 	int i;
 
+	k_mutex_lock(&reassembly_lock, K_FOREVER);
+
 	for (i = 0; reassembly_init_done &&
 		     i < CONFIG_NET_IPV6_FRAGMENT_MAX_COUNT; i++) {
-		if (!k_work_delayable_remaining_get(&reassembly[i].timer)) {
+		if (!reassembly[i].in_use) {
 			continue;
 		}
 
 		cb(&reassembly[i], user_data);
 	}
+
+	k_mutex_unlock(&reassembly_lock);
 }
 
-/* Verify that we have all the fragments received and in correct order.
- */
-static bool fragment_verify(struct net_ipv6_reassembly *reass)
+static inline uint16_t fragment_len(struct net_pkt *pkt)
 {
-	uint16_t offset;
-	int i, prev_len;
-
-	prev_len = net_pkt_get_len(reass->pkt[0]);
-	offset = net_pkt_ipv6_fragment_offset(reass->pkt[0]);
-
-	NET_DBG("pkt %p offset %u", reass->pkt[0], offset);
-
-	if (offset != 0U) {
-		return false;
-	}
-
-	for (i = 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		offset = net_pkt_ipv6_fragment_offset(reass->pkt[i]);
+	size_t len = net_pkt_get_len(pkt);
 
-		NET_DBG("pkt %p offset %u prev_len %d", reass->pkt[i],
-			offset, prev_len);
-
-		if (prev_len < offset) {
-			/* Something wrong with the offset value */
-			return false;
-		}
-
-		prev_len = net_pkt_get_len(reass->pkt[i]);
+	/* Only the first fragment still has its headers */
+	if (net_pkt_ipv6_fragment_offset(pkt) == 0U) {
+		len -= net_pkt_ipv6_fragment_start(pkt) +
+		       sizeof(struct net_ipv6_frag_hdr);
 	}
 
-	return true;
+	return len;
 }
 
-static int shift_packets(struct net_ipv6_reassembly *reass, int pos)
+/* Find the position of a fragment in the reassembly, -1 if it overlaps
+ * with fragments received earlier.
+ */
+static int fragment_find_pos(struct net_ipv6_reassembly *reass,
+			     uint16_t offset, uint16_t len)
 {
-	int i;
-
-	for (i = pos + 1; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (!reass->pkt[i]) {
-			NET_DBG("Moving [%d] %p (offset 0x%x) to [%d]",
-				pos, reass->pkt[pos],
-				net_pkt_ipv6_fragment_offset(reass->pkt[pos]),
-				i);
-
-			/* Do we have enough space in packet array to make
-			 * the move?
-			 */
-			if (((i - pos) + 1) >
-			    (NET_IPV6_FRAGMENTS_MAX_PKT - i)) {
-				return -ENOMEM;
-			}
+	int lo = 0, hi = reass->count;
 
-			memmove(&reass->pkt[i], &reass->pkt[pos],
-				sizeof(void *) * (i - pos));
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
 
-			return 0;
+		if (net_pkt_ipv6_fragment_offset(reass->pkt[mid]) < offset) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
 	}
 
-	return -EINVAL;
+	if (lo > 0 &&
+	    net_pkt_ipv6_fragment_offset(reass->pkt[lo - 1]) +
+	    fragment_len(reass->pkt[lo - 1]) > offset) {
+		return -1;
+	}
+
+	if (lo < reass->count &&
+	    offset + len > net_pkt_ipv6_fragment_offset(reass->pkt[lo])) {
+		return -1;
+	}
+
+	return lo;
 }
 
 enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
@@ -428,8 +432,11 @@ enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
 					      uint8_t nexthdr)
 {
 	struct net_ipv6_reassembly *reass = NULL;
+	uint32_t end, last_end;
+	uint16_t offset;
 	uint16_t flag;
-	bool found;
+	size_t hdr_len;
+	size_t len;
 	uint8_t more;
 	uint32_t id;
 	int i;
@@ -454,74 +461,104 @@ enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
 	if (net_pkt_skip(pkt, 1) || /* reserved */
 	    net_pkt_read_be16(pkt, &flag) ||
 	    net_pkt_read_be32(pkt, &id)) {
-		goto drop;
-	}
-
-	reass = reassembly_get(id, &hdr->src, &hdr->dst);
-	if (!reass) {
-		NET_DBG("Cannot get reassembly slot, dropping pkt %p", pkt);
-		goto drop;
+		return NET_DROP;
 	}
 
 	more = flag & 0x01;
-	net_pkt_set_ipv6_fragment_offset(pkt, flag & 0xfff8);
+	offset = flag & 0xfff8;
+	net_pkt_set_ipv6_fragment_offset(pkt, offset);
 
-	if (!reass->pkt[0]) {
-		NET_DBG("Storing pkt %p to slot %d offset %d",
-			pkt, 0, net_pkt_ipv6_fragment_offset(pkt));
-		reass->pkt[0] = pkt;
+	hdr_len = net_pkt_ipv6_fragment_start(pkt) +
+		  sizeof(struct net_ipv6_frag_hdr);
+	len = net_pkt_get_len(pkt);
+	if (len <= hdr_len) {
+		return NET_DROP;
+	}
 
-		reassembly_info("Reassembly 1st pkt", reass);
+	len -= hdr_len;
+	end = offset + len;
 
-		/* Wait for more fragments to receive. */
-		goto accept;
+	if (more && len % 8) {
+		/* Fragment length is not multiple of 8, discard
+		 * the packet and send parameter problem error.
+		 */
+		net_icmpv6_send_error(pkt, NET_ICMPV6_PARAM_PROBLEM,
+				      NET_ICMPV6_PARAM_PROB_OPTION, 0);
+		return NET_DROP;
 	}
 
-	/* The fragments might come in wrong order so place them
-	 * in reassembly chain in correct order.
-	 */
-	for (i = 0, found = false; i < NET_IPV6_FRAGMENTS_MAX_PKT; i++) {
-		if (reass->pkt[i]) {
-			if (net_pkt_ipv6_fragment_offset(reass->pkt[i]) <
-			    net_pkt_ipv6_fragment_offset(pkt)) {
-				continue;
-			}
-
-			/* Make room for this fragment. If there is no room,
-			 * then it will discard the whole reassembly.
-			 */
-			if (shift_packets(reass, i)) {
-				break;
-			}
-		}
+	if (end > UINT16_MAX) {
+		NET_DBG("Fragment 0x%x ends beyond max packet size", id);
+		return NET_DROP;
+	}
 
-		NET_DBG("Storing pkt %p to slot %d offset %d",
-			pkt, i, net_pkt_ipv6_fragment_offset(pkt));
-		reass->pkt[i] = pkt;
-		found = true;
+	k_mutex_lock(&reassembly_lock, K_FOREVER);
 
-		break;
+	reass = reassembly_get(id, &hdr->src, &hdr->dst);
+	if (!reass) {
+		NET_DBG("Cannot get reassembly slot, dropping pkt %p", pkt);
+		goto unlock;
 	}
 
-	if (!found) {
+	if (reass->count == NET_IPV6_FRAGMENTS_MAX_PKT) {
 		/* We could not add this fragment into our saved fragment
 		 * list. We must discard the whole packet at this point.
 		 */
 		NET_DBG("No slots available for 0x%x", reass->id);
-		net_pkt_unref(pkt);
 		goto drop;
 	}
 
-	if (more) {
-		if (net_pkt_get_len(pkt) % 8) {
-			/* Fragment length is not multiple of 8, discard
-			 * the packet and send parameter problem error.
-			 */
-			net_icmpv6_send_error(pkt, NET_ICMPV6_PARAM_PROBLEM,
-					      NET_ICMPV6_PARAM_PROB_OPTION, 0);
+	if (reass->count) {
+		last_end = net_pkt_ipv6_fragment_offset(
+					reass->pkt[reass->count - 1]) +
+			   fragment_len(reass->pkt[reass->count - 1]);
+	} else {
+		last_end = 0U;
+	}
+
+	if ((reass->total_len && (!more || end > reass->total_len)) ||
+	    (!more && last_end > end)) {
+		NET_DBG("Invalid length for fragment of 0x%x", reass->id);
+		goto drop;
+	}
+
+	/* Overlapping fragments cause the whole packet to be silently
+	 * discarded (RFC 5722).
+	 */
+	i = fragment_find_pos(reass, offset, len);
+	if (i < 0) {
+		NET_DBG("Overlapping fragment for 0x%x", reass->id);
+		goto drop;
+	}
+
+	if (offset != 0U) {
+		/* Get rid of IPv6 and fragment header which are at the
+		 * beginning of the fragment, so that the fragment can be
+		 * appended to the first one as is when all of them are there.
+		 */
+		net_pkt_cursor_init(pkt);
+
+		if (net_pkt_pull(pkt, hdr_len)) {
+			NET_ERR("Failed to pull headers");
 			goto drop;
 		}
+	}
+
+	NET_DBG("Storing pkt %p to slot %d offset %d",
+		pkt, i, net_pkt_ipv6_fragment_offset(pkt));
+
+	memmove(&reass->pkt[i + 1], &reass->pkt[i],
+		sizeof(void *) * (reass->count - i));
+
+	reass->pkt[i] = pkt;
+	reass->count++;
+	reass->len += len;
 
+	if (!more) {
+		reass->total_len = end;
+	}
+
+	if (!reass->total_len || reass->len < reass->total_len) {
 		reassembly_info("Reassembly nth pkt", reass);
 
 		NET_DBG("More fragments to be received");
@@ -530,31 +567,21 @@ enum net_verdict net_ipv6_handle_fragment_hdr(struct net_pkt *pkt,
 
 	reassembly_info("Reassembly last pkt", reass);
 
-	if (!fragment_verify(reass)) {
-		NET_DBG("Reassembled IPv6 verify failed, dropping id %u",
-			reass->id);
-
-		/* Let the caller release the already inserted pkt */
-		if (i < NET_IPV6_FRAGMENTS_MAX_PKT) {
-			reass->pkt[i] = NULL;
-		}
-
-		net_pkt_unref(pkt);
-		goto drop;
-	}
-
-	/* The last fragment received, reassemble the packet */
+	/* All the fragments are there as they cover the whole packet without
+	 * overlapping, reassemble the packet.
+	 */
 	reassemble_packet(reass);
 
 accept:
+	k_mutex_unlock(&reassembly_lock);
+
 	return NET_OK;
 
 drop:
-	if (reass) {
-		if (reassembly_cancel(reass->id, &reass->src, &reass->dst)) {
-			return NET_OK;
-		}
-	}
+	reassembly_cancel(reass);
+
+unlock:
+	k_mutex_unlock(&reassembly_lock);
 
 	return NET_DROP;
 }
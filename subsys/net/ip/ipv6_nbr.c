@@ -122,6 +122,57 @@ static inline struct net_nbr *get_nbr(int idx)
 	return &net_neighbor_pool[idx].nbr;
 }
 
+/* Hash index of the neighbor cache keyed by IPv6 address, so that the per
+ * packet neighbor lookup does not need to scan the whole table. Chains hold
+ * neighbor index + 1, zero terminates a chain.
+ */
+#define NBR_HASH_SIZE CONFIG_NET_IPV6_MAX_NEIGHBORS
+
+static uint8_t nbr_hash[NBR_HASH_SIZE];
+static uint8_t nbr_hash_next[CONFIG_NET_IPV6_MAX_NEIGHBORS];
+
+static inline int nbr_index(struct net_nbr *nbr)
+{
+	/* The neighbor is the first member of its pool entry */
+	return (__typeof__(&net_neighbor_pool[0]))nbr - net_neighbor_pool;
+}
+
+static inline uint32_t nbr_hash_key(const struct in6_addr *addr)
+{
+	uint32_t key = UNALIGNED_GET(&addr->s6_addr32[0]) ^
+		       UNALIGNED_GET(&addr->s6_addr32[1]) ^
+		       UNALIGNED_GET(&addr->s6_addr32[2]) ^
+		       UNALIGNED_GET(&addr->s6_addr32[3]);
+
+	return ((key * 0x9e3779b1U) >> 16) % NBR_HASH_SIZE;
+}
+
+static void nbr_hash_add(struct net_nbr *nbr)
+{
+	uint32_t key = nbr_hash_key(&net_ipv6_nbr_data(nbr)->addr);
+	int idx = nbr_index(nbr);
+
+	nbr_hash_next[idx] = nbr_hash[key];
+	nbr_hash[key] = idx + 1;
+}
+
+static void nbr_hash_del(struct net_nbr *nbr)
+{
+	uint32_t key = nbr_hash_key(&net_ipv6_nbr_data(nbr)->addr);
+	uint8_t *link = &nbr_hash[key];
+	int idx = nbr_index(nbr);
+
+	while (*link) {
+		if (*link == idx + 1) {
+			*link = nbr_hash_next[idx];
+			nbr_hash_next[idx] = 0U;
+			return;
+		}
+
+		link = &nbr_hash_next[*link - 1];
+	}
+}
+
 static inline struct net_nbr *get_nbr_from_data(struct net_ipv6_nbr_data *data)
 {
 	int i;
@@ -259,10 +310,10 @@ static struct net_nbr *nbr_lookup(struct net_nbr_table *table,
 				  struct net_if *iface,
 				  const struct in6_addr *addr)
 {
-	int i;
+	uint8_t i;
 
-	for (i = 0; i < CONFIG_NET_IPV6_MAX_NEIGHBORS; i++) {
-		struct net_nbr *nbr = get_nbr(i);
+	for (i = nbr_hash[nbr_hash_key(addr)]; i; i = nbr_hash_next[i - 1]) {
+		struct net_nbr *nbr = get_nbr(i - 1);
 
 		if (!nbr->ref) {
 			continue;
@@ -408,6 +459,7 @@ static void nbr_init(struct net_nbr *nbr, struct net_if *iface,
 	nbr->iface = iface;
 
 	net_ipaddr_copy(&net_ipv6_nbr_data(nbr)->addr, addr);
+	nbr_hash_add(nbr);
 	ipv6_nbr_set_state(nbr, state);
 	net_ipv6_nbr_data(nbr)->is_router = is_router;
 	net_ipv6_nbr_data(nbr)->pending = NULL;
@@ -653,7 +705,7 @@ void net_neighbor_data_remove(struct net_nbr *nbr)
 {
 	NET_DBG("Neighbor %p removed", nbr);
 
-	return;
+	nbr_hash_del(nbr);
 }
 
 void net_neighbor_table_clear(struct net_nbr_table *table)
@@ -789,7 +841,7 @@ enum net_verdict net_ipv6_prepare_for_send(struct net_pkt *pkt)
 	/* If we have already fragmented the packet, the fragment id will
 	 * contain a proper value and we can skip other checks.
 	 */
-	if (net_pkt_ipv6_fragment_id(pkt) == 0U) {
+	if (net_pkt_ipv6_fragment_id(pkt) == 0U && !net_pkt_gso_size(pkt)) {
 		uint16_t mtu = net_if_get_mtu(net_pkt_iface(pkt));
 		size_t pkt_len = net_pkt_get_len(pkt);
 
@@ -1720,8 +1720,15 @@ static int context_sendto(struct net_context *context,
 		goto fail;
 	}
 
+	/* TCP counts the data when it sends the segments */
+	if (IS_ENABLED(CONFIG_NET_STATISTICS_CONTEXT) &&
+	    net_context_get_ip_proto(context) != IPPROTO_TCP) {
+		net_stats_update_context_sent(context, len, 1);
+	}
+
 	return len;
 fail:
+	net_stats_update_context_drop(context);
 	net_pkt_unref(pkt);
 
 	return ret;
@@ -1831,6 +1838,7 @@ enum net_verdict net_context_packet_received(struct net_conn *conn,
 	 * the packet.
 	 */
 	if (!context->recv_cb) {
+		net_stats_update_context_drop(context);
 		goto unlock;
 	}
 
@@ -1839,6 +1847,8 @@ enum net_verdict net_context_packet_received(struct net_conn *conn,
 					  net_pkt_remaining_data(pkt));
 	}
 
+	net_stats_update_context_recv(context, net_pkt_remaining_data(pkt));
+
 #if defined(CONFIG_NET_CONTEXT_SYNC_RECV)
 	k_sem_give(&context->recv_data_wait);
 #endif /* CONFIG_NET_CONTEXT_SYNC_RECV */
@@ -42,6 +42,7 @@ LOG_MODULE_REGISTER(net_core, CONFIG_NET_CORE_LOG_LEVEL);
 #include "ipv6.h"
 
 #include "icmpv4.h"
+#include "ipv4.h"
 
 #include "dhcpv4.h"
 
@@ -328,6 +329,27 @@ int net_send_data(struct net_pkt *pkt)
 		 * to RX processing.
 		 */
 		NET_DBG("Loopback pkt %p back to us", pkt);
+
+		/* A large TCP packet is not segmented when looped back but
+		 * its checksum is still to be computed.
+		 */
+		if (IS_ENABLED(CONFIG_NET_TCP_GSO) && net_pkt_gso_size(pkt)) {
+			net_pkt_set_gso_size(pkt, 0);
+
+			if (IS_ENABLED(CONFIG_NET_IPV4) &&
+			    net_pkt_family(pkt) == AF_INET) {
+				status = net_ipv4_finalize(pkt, IPPROTO_TCP);
+			} else {
+				status = net_ipv6_finalize(pkt, IPPROTO_TCP);
+			}
+
+			if (status < 0) {
+				return status;
+			}
+
+			net_pkt_cursor_init(pkt);
+		}
+
 		processing_data(pkt, true);
 		return 0;
 	}
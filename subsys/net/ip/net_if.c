@@ -24,6 +24,7 @@ LOG_MODULE_REGISTER(net_if, CONFIG_NET_IF_LOG_LEVEL);
 #include "net_private.h"
 #include "ipv6.h"
 #include "ipv4_autoconf_internal.h"
+#include "tcp_internal.h"
 
 #include "net_stats.h"
 
@@ -77,6 +78,15 @@ static struct {
 	struct net_if_ipv6 ipv6;
 	struct net_if *iface;
 } ipv6_addresses[CONFIG_NET_IF_MAX_IPV6_COUNT];
+
+#define IPV6_ADDR_SLOTS (CONFIG_NET_IF_MAX_IPV6_COUNT * NET_IF_MAX_IPV6_ADDR)
+
+/* Hash index of the unicast addresses of all the interfaces, so that
+ * net_if_ipv6_addr_lookup() does not need to scan every interface. Chains
+ * hold address slot + 1, zero terminates a chain.
+ */
+static uint16_t ipv6_addr_hash[IPV6_ADDR_SLOTS];
+static uint16_t ipv6_addr_next[IPV6_ADDR_SLOTS];
 #endif /* CONFIG_NET_IPV6 */
 
 #if defined(CONFIG_NET_NATIVE_IPV4)
@@ -84,8 +94,44 @@ static struct {
 	struct net_if_ipv4 ipv4;
 	struct net_if *iface;
 } ipv4_addresses[CONFIG_NET_IF_MAX_IPV4_COUNT];
+
+#define IPV4_ADDR_SLOTS (CONFIG_NET_IF_MAX_IPV4_COUNT * NET_IF_MAX_IPV4_ADDR)
+
+/* Same as ipv6_addr_hash, for net_if_ipv4_addr_lookup() */
+static uint16_t ipv4_addr_hash[IPV4_ADDR_SLOTS];
+static uint16_t ipv4_addr_next[IPV4_ADDR_SLOTS];
 #endif /* CONFIG_NET_IPV4 */
 
+#if defined(CONFIG_NET_NATIVE_IPV4) || defined(CONFIG_NET_NATIVE_IPV6)
+static inline uint32_t addr_hash_key(uint32_t key, int size)
+{
+	return ((key * 0x9e3779b1U) >> 16) % size;
+}
+
+static void addr_hash_add(uint16_t *hash, uint16_t *next, uint32_t key,
+			  int slot)
+{
+	next[slot] = hash[key];
+	hash[key] = slot + 1;
+}
+
+static void addr_hash_del(uint16_t *hash, uint16_t *next, uint32_t key,
+			  int slot)
+{
+	uint16_t *link = &hash[key];
+
+	while (*link) {
+		if (*link == slot + 1) {
+			*link = next[slot];
+			next[slot] = 0U;
+			return;
+		}
+
+		link = &next[*link - 1];
+	}
+}
+#endif
+
 /* We keep track of the link callbacks in this list.
  */
 static sys_slist_t link_callbacks;
@@ -257,7 +303,11 @@ static bool net_if_tx(struct net_if *iface, struct net_pkt *pkt)
 			}
 		}
 
-		status = net_if_l2(iface)->send(iface, pkt);
+		if (IS_ENABLED(CONFIG_NET_TCP_GSO) && net_pkt_gso_size(pkt)) {
+			status = net_tcp_gso_send(pkt, net_if_l2(iface)->send);
+		} else {
+			status = net_if_l2(iface)->send(iface, pkt);
+		}
 
 		if (IS_ENABLED(CONFIG_NET_PKT_TXTIME_STATS)) {
 			uint32_t end_tick = k_cycle_get_32();
@@ -412,6 +462,12 @@ static inline void init_iface(struct net_if *iface)
 #endif
 #if defined(CONFIG_NET_NATIVE_IPV6)
 	net_if_flag_set(iface, NET_IF_IPV6);
+#endif
+#if defined(CONFIG_NET_TCP_GSO)
+	net_if_flag_set(iface, NET_IF_GSO);
+#endif
+#if defined(CONFIG_NET_TCP_GRO)
+	net_if_flag_set(iface, NET_IF_GRO);
 #endif
 	net_virtual_init(iface);
 
@@ -1374,43 +1430,76 @@ static inline void iface_ipv6_nd_init(void)
 #define iface_ipv6_nd_init(...)
 #endif /* CONFIG_NET_IPV6_ND */
 
+static int ipv6_addr_slot(struct net_if_addr *ifaddr)
+{
+	int idx = ((uint8_t *)ifaddr - (uint8_t *)ipv6_addresses) /
+		  sizeof(ipv6_addresses[0]);
+
+	return idx * NET_IF_MAX_IPV6_ADDR +
+	       (ifaddr - ipv6_addresses[idx].ipv6.unicast);
+}
+
+static inline uint32_t ipv6_addr_key(const struct in6_addr *addr)
+{
+	return addr_hash_key(UNALIGNED_GET(&addr->s6_addr32[0]) ^
+			     UNALIGNED_GET(&addr->s6_addr32[1]) ^
+			     UNALIGNED_GET(&addr->s6_addr32[2]) ^
+			     UNALIGNED_GET(&addr->s6_addr32[3]),
+			     IPV6_ADDR_SLOTS);
+}
+
+static void ipv6_addr_hash_add(struct net_if_addr *ifaddr)
+{
+	addr_hash_add(ipv6_addr_hash, ipv6_addr_next,
+		      ipv6_addr_key(&ifaddr->address.in6_addr),
+		      ipv6_addr_slot(ifaddr));
+}
+
+static void ipv6_addr_hash_del(struct net_if_addr *ifaddr)
+{
+	addr_hash_del(ipv6_addr_hash, ipv6_addr_next,
+		      ipv6_addr_key(&ifaddr->address.in6_addr),
+		      ipv6_addr_slot(ifaddr));
+}
+
 struct net_if_addr *net_if_ipv6_addr_lookup(const struct in6_addr *addr,
 					    struct net_if **ret)
 {
 	struct net_if_addr *ifaddr = NULL;
+	struct net_if *found = NULL;
+	uint16_t slot;
 
 	k_mutex_lock(&lock, K_FOREVER);
 
-	Z_STRUCT_SECTION_FOREACH(net_if, iface) {
-		struct net_if_ipv6 *ipv6 = iface->config.ip.ipv6;
-		int i;
+	for (slot = ipv6_addr_hash[ipv6_addr_key(addr)]; slot;
+	     slot = ipv6_addr_next[slot - 1]) {
+		int idx = (slot - 1) / NET_IF_MAX_IPV6_ADDR;
+		struct net_if *iface = ipv6_addresses[idx].iface;
+		struct net_if_addr *cur;
 
-		if (!ipv6) {
+		cur = &ipv6_addresses[idx].ipv6.unicast[(slot - 1) %
+							NET_IF_MAX_IPV6_ADDR];
+
+		if (!iface || !net_ipv6_addr_cmp(addr,
+						 &cur->address.in6_addr)) {
 			continue;
 		}
 
-		for (i = 0; i < NET_IF_MAX_IPV6_ADDR; i++) {
-			if (!ipv6->unicast[i].is_used ||
-			    ipv6->unicast[i].address.family != AF_INET6) {
-				continue;
-			}
-
-			if (net_ipv6_is_prefix(
-				    addr->s6_addr,
-				    ipv6->unicast[i].address.in6_addr.s6_addr,
-				    128)) {
+		/* Same address on several interfaces, return the first
+		 * interface like a scan of the interface list would.
+		 */
+		if (found && found < iface) {
+			continue;
+		}
 
-				if (ret) {
-					*ret = iface;
-				}
+		found = iface;
+		ifaddr = cur;
+	}
 
-				ifaddr = &ipv6->unicast[i];
-				goto out;
-			}
-		}
+	if (ifaddr && ret) {
+		*ret = found;
 	}
 
-out:
 	k_mutex_unlock(&lock);
 
 	return ifaddr;
@@ -1591,6 +1680,7 @@ static inline void net_if_addr_init(struct net_if_addr *ifaddr,
 	ifaddr->address.family = AF_INET6;
 	ifaddr->addr_type = addr_type;
 	net_ipaddr_copy(&ifaddr->address.in6_addr, addr);
+	ipv6_addr_hash_add(ifaddr);
 
 	/* FIXME - set the mcast addr for this node */
 
@@ -1716,6 +1806,7 @@ bool net_if_ipv6_addr_rm(struct net_if *iface, const struct in6_addr *addr)
 		}
 
 		ipv6->unicast[i].is_used = false;
+		ipv6_addr_hash_del(&ipv6->unicast[i]);
 
 		net_ipv6_addr_create_solicited_node(addr, &maddr);
 
@@ -3237,41 +3328,70 @@ out:
 	return src;
 }
 
+static int ipv4_addr_slot(struct net_if_addr *ifaddr)
+{
+	int idx = ((uint8_t *)ifaddr - (uint8_t *)ipv4_addresses) /
+		  sizeof(ipv4_addresses[0]);
+
+	return idx * NET_IF_MAX_IPV4_ADDR +
+	       (ifaddr - ipv4_addresses[idx].ipv4.unicast);
+}
+
+static inline uint32_t ipv4_addr_key(uint32_t addr)
+{
+	return addr_hash_key(addr, IPV4_ADDR_SLOTS);
+}
+
+static void ipv4_addr_hash_add(struct net_if_addr *ifaddr)
+{
+	addr_hash_add(ipv4_addr_hash, ipv4_addr_next,
+		      ipv4_addr_key(ifaddr->address.in_addr.s_addr),
+		      ipv4_addr_slot(ifaddr));
+}
+
+static void ipv4_addr_hash_del(struct net_if_addr *ifaddr)
+{
+	addr_hash_del(ipv4_addr_hash, ipv4_addr_next,
+		      ipv4_addr_key(ifaddr->address.in_addr.s_addr),
+		      ipv4_addr_slot(ifaddr));
+}
+
 struct net_if_addr *net_if_ipv4_addr_lookup(const struct in_addr *addr,
 					    struct net_if **ret)
 {
+	uint32_t s_addr = UNALIGNED_GET(&addr->s4_addr32[0]);
 	struct net_if_addr *ifaddr = NULL;
+	struct net_if *found = NULL;
+	uint16_t slot;
 
 	k_mutex_lock(&lock, K_FOREVER);
 
-	Z_STRUCT_SECTION_FOREACH(net_if, iface) {
-		struct net_if_ipv4 *ipv4 = iface->config.ip.ipv4;
-		int i;
+	for (slot = ipv4_addr_hash[ipv4_addr_key(s_addr)]; slot;
+	     slot = ipv4_addr_next[slot - 1]) {
+		int idx = (slot - 1) / NET_IF_MAX_IPV4_ADDR;
+		struct net_if *iface = ipv4_addresses[idx].iface;
+		struct net_if_addr *cur;
+
+		cur = &ipv4_addresses[idx].ipv4.unicast[(slot - 1) %
+							NET_IF_MAX_IPV4_ADDR];
 
-		if (!ipv4) {
+		if (!iface || cur->address.in_addr.s_addr != s_addr) {
 			continue;
 		}
 
-		for (i = 0; i < NET_IF_MAX_IPV4_ADDR; i++) {
-			if (!ipv4->unicast[i].is_used ||
-			    ipv4->unicast[i].address.family != AF_INET) {
-				continue;
-			}
-
-			if (UNALIGNED_GET(&addr->s4_addr32[0]) ==
-			    ipv4->unicast[i].address.in_addr.s_addr) {
+		/* See net_if_ipv6_addr_lookup() */
+		if (found && found < iface) {
+			continue;
+		}
 
-				if (ret) {
-					*ret = iface;
-				}
+		found = iface;
+		ifaddr = cur;
+	}
 
-				ifaddr = &ipv4->unicast[i];
-				goto out;
-			}
-		}
+	if (ifaddr && ret) {
+		*ret = found;
 	}
 
-out:
 	k_mutex_unlock(&lock);
 
 	return ifaddr;
@@ -3466,11 +3586,17 @@ struct net_if_addr *net_if_ipv4_addr_add(struct net_if *iface,
 	}
 
 	if (ifaddr) {
+		if (ifaddr->is_used) {
+			/* Overriding an existing address */
+			ipv4_addr_hash_del(ifaddr);
+		}
+
 		ifaddr->is_used = true;
 		ifaddr->address.family = AF_INET;
 		ifaddr->address.in_addr.s4_addr32[0] =
 						addr->s4_addr32[0];
 		ifaddr->addr_type = addr_type;
+		ipv4_addr_hash_add(ifaddr);
 
 		/* Caller has to take care of timers and their expiry */
 		if (vlifetime) {
@@ -3525,6 +3651,7 @@ bool net_if_ipv4_addr_rm(struct net_if *iface, const struct in_addr *addr)
 		}
 
 		ipv4->unicast[i].is_used = false;
+		ipv4_addr_hash_del(&ipv4->unicast[i]);
 
 		NET_DBG("[%d] interface %p address %s removed",
 			i, iface, log_strdup(net_sprint_ipv4_addr(addr)));
@@ -3914,6 +4041,10 @@ void net_if_call_link_cb(struct net_if *iface, struct net_linkaddr *lladdr,
 
 static bool need_calc_checksum(struct net_if *iface, enum ethernet_hw_caps caps)
 {
+	if (net_if_flag_is_set(iface, NET_IF_NO_CHECKSUM)) {
+		return false;
+	}
+
 #if defined(CONFIG_NET_L2_ETHERNET)
 	if (net_if_l2(iface) != &NET_L2_GET_NAME(ETHERNET)) {
 		return true;
@@ -19,6 +19,10 @@ LOG_MODULE_REGISTER(net_mgmt, CONFIG_NET_MGMT_EVENT_LOG_LEVEL);
 #include "net_private.h"
 
 struct mgmt_event_entry {
+	/* Position of the ring the entry can be written at, or position + 1
+	 * once it is written and can be read.
+	 */
+	atomic_t seq;
 	uint32_t event;
 	struct net_if *iface;
 
@@ -33,98 +37,135 @@ struct mgmt_event_wait {
 	struct net_if *iface;
 };
 
-static K_SEM_DEFINE(network_event, 0, K_SEM_MAX_LIMIT);
+/* The ring positions wrap at a multiple of the queue size, so that the
+ * entry of a position does not change when wrapping.
+ */
+#define MGMT_EVENT_POS_WRAP (CONFIG_NET_MGMT_EVENT_QUEUE_SIZE << 16)
+
+/* With a single entry, a published entry would look free to the next
+ * producer, which would overwrite it before it is delivered.
+ */
+BUILD_ASSERT(CONFIG_NET_MGMT_EVENT_QUEUE_SIZE >= 2,
+	     "The event queue needs at least two entries");
+
+/* The callbacks are kept in lists indexed by the layer and layer code of
+ * their event mask, as an event only matches the callbacks of its own
+ * layer and layer code.
+ */
+#define MGMT_EVENT_CB_BUCKETS 16
+
+static K_SEM_DEFINE(network_event, 0, 1);
 static K_SEM_DEFINE(net_mgmt_lock, 1, 1);
 
 K_KERNEL_STACK_DEFINE(mgmt_stack, CONFIG_NET_MGMT_EVENT_STACK_SIZE);
 static struct k_thread mgmt_thread_data;
 static struct mgmt_event_entry events[CONFIG_NET_MGMT_EVENT_QUEUE_SIZE];
 static uint32_t global_event_mask;
-static sys_slist_t event_callbacks = SYS_SLIST_STATIC_INIT(&event_callbacks);
-static int16_t in_event;
-static int16_t out_event;
+static sys_slist_t event_callbacks[MGMT_EVENT_CB_BUCKETS];
+static atomic_t in_event;
+static uint32_t out_event;
+
+static inline int32_t mgmt_pos_diff(uint32_t a, uint32_t b)
+{
+	int32_t diff = (a + MGMT_EVENT_POS_WRAP - b) % MGMT_EVENT_POS_WRAP;
+
+	if (diff > MGMT_EVENT_POS_WRAP / 2) {
+		diff -= MGMT_EVENT_POS_WRAP;
+	}
+
+	return diff;
+}
+
+static inline uint32_t mgmt_pos_add(uint32_t pos, uint32_t n)
+{
+	return (pos + n) % MGMT_EVENT_POS_WRAP;
+}
+
+static inline sys_slist_t *mgmt_event_callbacks(uint32_t event_mask)
+{
+	uint32_t key = NET_MGMT_GET_LAYER(event_mask) << 11 |
+		       NET_MGMT_GET_LAYER_CODE(event_mask);
 
-static inline void mgmt_push_event(uint32_t mgmt_event, struct net_if *iface,
+	return &event_callbacks[(key ^ key >> 4 ^ key >> 8) %
+				MGMT_EVENT_CB_BUCKETS];
+}
+
+/* Called from any context, including ISRs. Several notifiers can push at
+ * the same time: each one claims a position by moving in_event forward,
+ * then publishes the entry through its sequence once written. When the
+ * queue is full, the new event is dropped.
+ */
+static inline bool mgmt_push_event(uint32_t mgmt_event, struct net_if *iface,
 				   const void *info, size_t length)
 {
-	int16_t i_idx;
+	struct mgmt_event_entry *entry;
+	uint32_t i_idx;
+	int32_t diff;
 
 #ifndef CONFIG_NET_MGMT_EVENT_INFO
 	ARG_UNUSED(info);
 	ARG_UNUSED(length);
+#else
+	if (info && length > NET_EVENT_INFO_MAX_SIZE) {
+		NET_ERR("Event info length %zu > max size %zu",
+			length, NET_EVENT_INFO_MAX_SIZE);
+
+		return false;
+	}
 #endif /* CONFIG_NET_MGMT_EVENT_INFO */
 
-	k_sem_take(&net_mgmt_lock, K_FOREVER);
+	do {
+		i_idx = atomic_get(&in_event);
+		entry = &events[i_idx % CONFIG_NET_MGMT_EVENT_QUEUE_SIZE];
 
-	i_idx = in_event + 1;
-	if (i_idx == CONFIG_NET_MGMT_EVENT_QUEUE_SIZE) {
-		i_idx = 0;
-	}
+		diff = mgmt_pos_diff(atomic_get(&entry->seq), i_idx);
+		if (diff < 0) {
+			NET_DBG("Event queue full, dropping event 0x%08x",
+				mgmt_event);
+			return false;
+		}
+	} while (diff > 0 ||
+		 !atomic_cas(&in_event, i_idx, mgmt_pos_add(i_idx, 1)));
 
 #ifdef CONFIG_NET_MGMT_EVENT_INFO
 	if (info && length) {
-		if (length <= NET_EVENT_INFO_MAX_SIZE) {
-			memcpy(events[i_idx].info, info, length);
-			events[i_idx].info_length = length;
-		} else {
-			NET_ERR("Event info length %zu > max size %zu",
-				length, NET_EVENT_INFO_MAX_SIZE);
-			k_sem_give(&net_mgmt_lock);
-
-			return;
-		}
+		memcpy(entry->info, info, length);
+		entry->info_length = length;
 	} else {
-		events[i_idx].info_length = 0;
+		entry->info_length = 0;
 	}
 #endif /* CONFIG_NET_MGMT_EVENT_INFO */
 
-	events[i_idx].event = mgmt_event;
-	events[i_idx].iface = iface;
-
-	if (i_idx == out_event) {
-		uint16_t o_idx = out_event + 1;
-
-		if (o_idx == CONFIG_NET_MGMT_EVENT_QUEUE_SIZE) {
-			o_idx = 0U;
-		}
-
-		if (events[o_idx].event) {
-			out_event = o_idx;
-		}
-	} else if (out_event < 0) {
-		out_event = i_idx;
-	}
+	entry->event = mgmt_event;
+	entry->iface = iface;
 
-	in_event = i_idx;
+	atomic_set(&entry->seq, mgmt_pos_add(i_idx, 1));
 
-	k_sem_give(&net_mgmt_lock);
+	return true;
 }
 
+/* Only called from the net_mgmt thread */
 static inline struct mgmt_event_entry *mgmt_pop_event(void)
 {
-	int16_t o_idx;
+	struct mgmt_event_entry *entry =
+		&events[out_event % CONFIG_NET_MGMT_EVENT_QUEUE_SIZE];
 
-	if (out_event < 0 || !events[out_event].event) {
+	if (atomic_get(&entry->seq) != mgmt_pos_add(out_event, 1)) {
 		return NULL;
 	}
 
-	o_idx = out_event;
-	out_event++;
-
-	if (o_idx == in_event) {
-		in_event = -1;
-		out_event = -1;
-	} else if (out_event == CONFIG_NET_MGMT_EVENT_QUEUE_SIZE) {
-		out_event = 0;
-	}
-
-	return &events[o_idx];
+	return entry;
 }
 
 static inline void mgmt_clean_event(struct mgmt_event_entry *mgmt_event)
 {
 	mgmt_event->event = 0U;
 	mgmt_event->iface = NULL;
+
+	/* Give the entry back to the notifiers, for the next lap */
+	atomic_set(&mgmt_event->seq,
+		   mgmt_pos_add(out_event, CONFIG_NET_MGMT_EVENT_QUEUE_SIZE));
+	out_event = mgmt_pos_add(out_event, 1);
 }
 
 static inline void mgmt_add_event_mask(uint32_t event_mask)
@@ -134,12 +175,15 @@ static inline void mgmt_add_event_mask(uint32_t event_mask)
 
 static inline void mgmt_rebuild_global_event_mask(void)
 {
-	struct net_mgmt_event_callback *cb, *tmp;
+	struct net_mgmt_event_callback *cb;
+	int i;
 
 	global_event_mask = 0U;
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&event_callbacks, cb, tmp, node) {
-		mgmt_add_event_mask(cb->event_mask);
+	for (i = 0; i < MGMT_EVENT_CB_BUCKETS; i++) {
+		SYS_SLIST_FOR_EACH_CONTAINER(&event_callbacks[i], cb, node) {
+			mgmt_add_event_mask(cb->event_mask);
+		}
 	}
 }
 
@@ -158,6 +202,7 @@ static inline bool mgmt_is_event_handled(uint32_t mgmt_event)
 
 static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 {
+	sys_slist_t *callbacks = mgmt_event_callbacks(mgmt_event->event);
 	sys_snode_t *prev = NULL;
 	struct net_mgmt_event_callback *cb, *tmp;
 
@@ -166,7 +211,7 @@ static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 		NET_MGMT_GET_LAYER_CODE(mgmt_event->event),
 		NET_MGMT_GET_COMMAND(mgmt_event->event));
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&event_callbacks, cb, tmp, node) {
+	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(callbacks, cb, tmp, node) {
 		if (!(NET_MGMT_GET_LAYER(mgmt_event->event) ==
 		      NET_MGMT_GET_LAYER(cb->event_mask)) ||
 		    !(NET_MGMT_GET_LAYER_CODE(mgmt_event->event) ==
@@ -175,6 +220,7 @@ static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 		     NET_MGMT_GET_COMMAND(cb->event_mask) &&
 		     !(NET_MGMT_GET_COMMAND(mgmt_event->event) &
 		       NET_MGMT_GET_COMMAND(cb->event_mask)))) {
+			prev = &cb->node;
 			continue;
 		}
 
@@ -195,6 +241,7 @@ static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 
 			if (sync_data->iface &&
 			    sync_data->iface != mgmt_event->iface) {
+				prev = &cb->node;
 				continue;
 			}
 
@@ -203,7 +250,7 @@ static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 			cb->raised_event = mgmt_event->event;
 			sync_data->iface = mgmt_event->iface;
 
-			sys_slist_remove(&event_callbacks, prev, &cb->node);
+			sys_slist_remove(callbacks, prev, &cb->node);
 
 			k_sem_give(cb->sync_call);
 		} else {
@@ -223,6 +270,7 @@ static inline void mgmt_run_callbacks(struct mgmt_event_entry *mgmt_event)
 static void mgmt_thread(void)
 {
 	struct mgmt_event_entry *mgmt_event;
+	int count;
 
 	while (1) {
 		k_sem_take(&network_event, K_FOREVER);
@@ -230,27 +278,29 @@ static void mgmt_thread(void)
 
 		NET_DBG("Handling events, forwarding it relevantly");
 
-		mgmt_event = mgmt_pop_event();
-		if (!mgmt_event) {
-			/* System is over-loaded?
-			 * At this point we have most probably notified
-			 * more events than we could handle
-			 */
-			NET_DBG("Some event got probably lost (%u)",
-				k_sem_count_get(&network_event));
+		/* Deliver the queued events in one go. An event notified
+		 * meanwhile gives the semaphore again, so at worst the next
+		 * wake up finds an empty queue.
+		 */
+		for (count = 0; count < CONFIG_NET_MGMT_EVENT_QUEUE_SIZE;
+		     count++) {
+			mgmt_event = mgmt_pop_event();
+			if (!mgmt_event) {
+				break;
+			}
 
-			k_sem_init(&network_event, 0, K_SEM_MAX_LIMIT);
-			k_sem_give(&net_mgmt_lock);
+			mgmt_run_callbacks(mgmt_event);
 
-			continue;
+			mgmt_clean_event(mgmt_event);
 		}
 
-		mgmt_run_callbacks(mgmt_event);
-
-		mgmt_clean_event(mgmt_event);
-
 		k_sem_give(&net_mgmt_lock);
 
+		if (count == CONFIG_NET_MGMT_EVENT_QUEUE_SIZE) {
+			/* Let the others run before the next batch */
+			k_sem_give(&network_event);
+		}
+
 		k_yield();
 	}
 }
@@ -282,6 +332,10 @@ static int mgmt_event_wait_call(struct net_if *iface,
 
 	ret = k_sem_take(sync.sync_call, timeout);
 	if (ret == -EAGAIN) {
+		/* The callback lives on this stack, it must not stay in the
+		 * table once the wait is over.
+		 */
+		net_mgmt_del_event_callback(&sync);
 		ret = -ETIMEDOUT;
 	} else {
 		if (!ret) {
@@ -314,7 +368,7 @@ void net_mgmt_add_event_callback(struct net_mgmt_event_callback *cb)
 
 	k_sem_take(&net_mgmt_lock, K_FOREVER);
 
-	sys_slist_prepend(&event_callbacks, &cb->node);
+	sys_slist_prepend(mgmt_event_callbacks(cb->event_mask), &cb->node);
 
 	mgmt_add_event_mask(cb->event_mask);
 
@@ -327,7 +381,8 @@ void net_mgmt_del_event_callback(struct net_mgmt_event_callback *cb)
 
 	k_sem_take(&net_mgmt_lock, K_FOREVER);
 
-	sys_slist_find_and_remove(&event_callbacks, &cb->node);
+	sys_slist_find_and_remove(mgmt_event_callbacks(cb->event_mask),
+				  &cb->node);
 
 	mgmt_rebuild_global_event_mask();
 
@@ -343,8 +398,9 @@ void net_mgmt_event_notify_with_info(uint32_t mgmt_event, struct net_if *iface,
 			NET_MGMT_GET_LAYER_CODE(mgmt_event),
 			NET_MGMT_GET_COMMAND(mgmt_event));
 
-		mgmt_push_event(mgmt_event, iface, info, length);
-		k_sem_give(&network_event);
+		if (mgmt_push_event(mgmt_event, iface, info, length)) {
+			k_sem_give(&network_event);
+		}
 	}
 }
 
@@ -377,12 +433,22 @@ int net_mgmt_event_wait_on_iface(struct net_if *iface,
 
 void net_mgmt_event_init(void)
 {
-	in_event = -1;
-	out_event = -1;
+	int i;
+
+	atomic_set(&in_event, 0);
+	out_event = 0U;
 
 	(void)memset(events, 0, CONFIG_NET_MGMT_EVENT_QUEUE_SIZE *
 			sizeof(struct mgmt_event_entry));
 
+	for (i = 0; i < CONFIG_NET_MGMT_EVENT_QUEUE_SIZE; i++) {
+		atomic_set(&events[i].seq, i);
+	}
+
+	for (i = 0; i < MGMT_EVENT_CB_BUCKETS; i++) {
+		sys_slist_init(&event_callbacks[i]);
+	}
+
 #if IS_ENABLED(CONFIG_NET_TC_THREAD_COOPERATIVE)
 /* Lowest priority cooperative thread */
 #define THREAD_PRIORITY K_PRIO_COOP(CONFIG_NUM_COOP_PRIORITIES - 1)
@@ -93,6 +93,11 @@ LOG_MODULE_REGISTER(net_pkt, CONFIG_NET_PKT_LOG_LEVEL);
 #error "Too small net_buf fragment size"
 #endif
 
+#if defined(CONFIG_NET_PKT_L2_HEADROOM)
+/* Fits the Ethernet header, and keeps the IP header 32 bits aligned */
+#define L2_HEADROOM ROUND_UP(NET_ETH_MAX_HDR_SIZE, 4)
+#endif
+
 #if CONFIG_NET_PKT_RX_COUNT <= 0
 #error "Minimum value for CONFIG_NET_PKT_RX_COUNT is 1"
 #endif
@@ -984,6 +989,12 @@ static size_t pkt_buffer_length(struct net_pkt *pkt,
 		}
 	}
 
+	/* A TCP GSO packet is segmented to the MTU before L2 */
+	if (IS_ENABLED(CONFIG_NET_TCP_GSO) && net_pkt_gso_size(pkt) &&
+	    proto == IPPROTO_TCP) {
+		max_len = MAX(max_len, existing + size);
+	}
+
 	max_len -= existing;
 
 	return MIN(size, max_len);
@@ -1106,6 +1117,7 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 	uint64_t end = sys_clock_timeout_end_calc(timeout);
 	struct net_buf_pool *pool = NULL;
 	size_t alloc_len = 0;
+	size_t headroom = 0;
 	size_t hdr_len = 0;
 	struct net_buf *buf;
 
@@ -1153,10 +1165,18 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 		}
 	}
 
+#if defined(CONFIG_NET_PKT_L2_HEADROOM)
+	if (hdr_len && !pkt->buffer && net_pkt_iface(pkt) &&
+	    net_if_l2(net_pkt_iface(pkt)) == &NET_L2_GET_NAME(ETHERNET)) {
+		headroom = L2_HEADROOM;
+	}
+#endif
+
 #if NET_LOG_LEVEL >= LOG_LEVEL_DBG
-	buf = pkt_alloc_buffer(pool, alloc_len, timeout, caller, line);
+	buf = pkt_alloc_buffer(pool, alloc_len + headroom, timeout,
+			       caller, line);
 #else
-	buf = pkt_alloc_buffer(pool, alloc_len, timeout);
+	buf = pkt_alloc_buffer(pool, alloc_len + headroom, timeout);
 #endif
 
 	if (!buf) {
@@ -1169,6 +1189,10 @@ int net_pkt_alloc_buffer(struct net_pkt *pkt,
 		return -ENOMEM;
 	}
 
+	if (headroom) {
+		net_buf_reserve(buf, headroom);
+	}
+
 	net_pkt_append_buffer(pkt, buf);
 
 	return 0;
@@ -1545,6 +1569,45 @@ static void pkt_cursor_update(struct net_pkt *pkt,
 	}
 }
 
+/* Handles the operations that stay within the cursor's buffer, which is
+ * the common case for headers, without going through the fragment walk.
+ */
+static inline bool pkt_cursor_operate_contiguous(struct net_pkt *pkt,
+						 void *data, size_t length,
+						 bool copy, bool write)
+{
+	struct net_pkt_cursor *c_op = &pkt->cursor;
+	bool append;
+	size_t end;
+
+	if (!c_op->buf || !c_op->pos) {
+		return false;
+	}
+
+	append = write && !net_pkt_is_being_overwritten(pkt);
+	end = append ? net_buf_max_len(c_op->buf) : c_op->buf->len;
+
+	/* Reaching the end of the buffer moves the cursor to the next one */
+	if ((c_op->pos - c_op->buf->data) + length >= end) {
+		return false;
+	}
+
+	if (copy) {
+		memcpy(write ? c_op->pos : data, write ? data : c_op->pos,
+		       length);
+	} else if (data) {
+		memset(c_op->pos, *(int *)data, length);
+	}
+
+	if (append) {
+		net_buf_add(c_op->buf, length);
+	}
+
+	c_op->pos += length;
+
+	return true;
+}
+
 /* Internal function that does all operation (skip/read/write/memset) */
 static int net_pkt_cursor_operate(struct net_pkt *pkt,
 				  void *data, size_t length,
@@ -1553,6 +1616,10 @@ static int net_pkt_cursor_operate(struct net_pkt *pkt,
 	/* We use such variable to avoid lengthy lines */
 	struct net_pkt_cursor *c_op = &pkt->cursor;
 
+	if (pkt_cursor_operate_contiguous(pkt, data, length, copy, write)) {
+		return 0;
+	}
+
 	while (c_op->buf && length) {
 		size_t d_len, len;
 
@@ -1739,6 +1806,8 @@ static void clone_pkt_attributes(struct net_pkt *pkt, struct net_pkt *clone_pkt)
 	net_pkt_set_priority(clone_pkt, net_pkt_priority(pkt));
 	net_pkt_set_orig_iface(clone_pkt, net_pkt_orig_iface(pkt));
 	net_pkt_set_captured(clone_pkt, net_pkt_is_captured(pkt));
+	net_pkt_set_rx_hash(clone_pkt, net_pkt_rx_hash(pkt));
+	net_pkt_set_gso_size(clone_pkt, net_pkt_gso_size(pkt));
 
 	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
 		net_pkt_set_ipv4_ttl(clone_pkt, net_pkt_ipv4_ttl(pkt));
@@ -1970,6 +2039,35 @@ bool net_pkt_is_contiguous(struct net_pkt *pkt, size_t size)
 	return len >= size;
 }
 
+int net_pkt_get_iovec(struct net_pkt *pkt, struct iovec *iov, int iovcnt)
+{
+	struct net_buf *buf = pkt->cursor.buf;
+	uint8_t *pos = pkt->cursor.pos;
+	int count = 0;
+
+	if (!buf || !pos) {
+		return 0;
+	}
+
+	for (; buf; buf = buf->frags, pos = buf ? buf->data : NULL) {
+		size_t len = buf->len - (pos - buf->data);
+
+		if (!len) {
+			continue;
+		}
+
+		if (count == iovcnt) {
+			return -E2BIG;
+		}
+
+		iov[count].iov_base = pos;
+		iov[count].iov_len = len;
+		count++;
+	}
+
+	return count;
+}
+
 size_t net_pkt_get_contiguous_len(struct net_pkt *pkt)
 {
 	pkt_cursor_advance(pkt, !net_pkt_is_being_overwritten(pkt));
@@ -1978,7 +2076,7 @@ size_t net_pkt_get_contiguous_len(struct net_pkt *pkt)
 		size_t len;
 
 		len = net_pkt_is_being_overwritten(pkt) ?
-			pkt->cursor.buf->len : pkt->cursor.buf->size;
+			pkt->cursor.buf->len : net_buf_max_len(pkt->cursor.buf);
 		len -= pkt->cursor.pos - pkt->cursor.buf->data;
 		return len;
 	}
@@ -1989,6 +2087,19 @@ size_t net_pkt_get_contiguous_len(struct net_pkt *pkt)
 void *net_pkt_get_data(struct net_pkt *pkt,
 		       struct net_pkt_data_access *access)
 {
+	struct net_pkt_cursor *cursor = &pkt->cursor;
+
+	/* Most headers lie within the cursor's buffer */
+	if (cursor->buf && cursor->pos &&
+	    (cursor->pos - cursor->buf->data) + access->size <
+	    (net_pkt_is_being_overwritten(pkt) ? cursor->buf->len :
+	     net_buf_max_len(cursor->buf))) {
+#if !defined(CONFIG_NET_HEADERS_ALWAYS_CONTIGUOUS)
+		access->data = cursor->pos;
+#endif
+		return cursor->pos;
+	}
+
 	if (IS_ENABLED(CONFIG_NET_HEADERS_ALWAYS_CONTIGUOUS)) {
 		if (!net_pkt_is_contiguous(pkt, access->size)) {
 			return NULL;
@@ -90,6 +90,14 @@ static inline enum net_verdict net_ipv6_input(struct net_pkt *pkt,
 #endif
 extern bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt);
 extern void net_tc_submit_to_rx_queue(uint8_t tc, struct net_pkt *pkt);
+#if defined(CONFIG_NET_RX_STEERING)
+/* Hash of the addresses and TCP/UDP ports of a received packet, never 0 */
+extern uint32_t net_rx_flow_hash(struct net_pkt *pkt);
+#endif
+#if defined(CONFIG_NET_TCP_GRO)
+/* Is the current thread one of the RX queue handlers */
+extern bool net_tc_rx_thread_is_current(void);
+#endif
 extern enum net_verdict net_promisc_mode_input(struct net_pkt *pkt);
 
 char *net_sprint_addr(sa_family_t af, const void *addr);
@@ -203,6 +211,49 @@ static inline uint16_t net_calc_chksum_tcp(struct net_pkt *pkt)
 	return net_calc_chksum(pkt, IPPROTO_TCP);
 }
 
+/**
+ * @brief Update a checksum after a 16-bit word of the covered data changed
+ *
+ * Incremental update as described in RFC 1624, so that rewriting a header
+ * field does not require summing the whole packet again. All the values are
+ * in network byte order, as found in the packet.
+ *
+ * @param chksum Checksum field value before the change
+ * @param old_val Previous value of the changed word
+ * @param new_val New value of the changed word
+ *
+ * @return Updated checksum field value
+ */
+static inline uint16_t net_chksum_update_u16(uint16_t chksum,
+					     uint16_t old_val,
+					     uint16_t new_val)
+{
+	uint32_t sum;
+
+	sum = (uint16_t)~chksum + (uint16_t)~old_val + new_val;
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return ~sum;
+}
+
+/**
+ * @brief Update a checksum after a range of the covered data changed
+ *
+ * Same as net_chksum_update_u16() for a longer field, e.g. an IP address
+ * in the pseudo header. The field must start at an even offset from the
+ * beginning of the checksummed data.
+ *
+ * @param chksum Checksum field value before the change
+ * @param old_data Previous content of the field
+ * @param new_data New content of the field
+ * @param len Length of the field
+ *
+ * @return Updated checksum field value
+ */
+uint16_t net_chksum_update(uint16_t chksum, const uint8_t *old_data,
+			   const uint8_t *new_data, size_t len);
+
 static inline char *net_sprint_ll_addr(const uint8_t *ll, uint8_t ll_len)
 {
 	static char buf[sizeof("xx:xx:xx:xx:xx:xx:xx:xx")];
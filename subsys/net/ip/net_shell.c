@@ -1992,6 +1992,74 @@ static int cmd_net_capture_disable(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+static int cmd_net_capture_file(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+#if defined(CONFIG_NET_CAPTURE_FILE)
+	uint32_t snaplen = 0;
+	struct net_if *iface;
+	int ret, if_index;
+
+	if (argc < 3) {
+		PR_WARNING("Interface index or file path is missing.\n");
+		return -ENOEXEC;
+	}
+
+	if_index = atoi(argv[1]);
+	iface = net_if_get_by_index(if_index);
+	if (iface == NULL) {
+		PR_WARNING("No such interface with index %d\n", if_index);
+		return -ENOEXEC;
+	}
+
+	if (argc > 3) {
+		snaplen = atoi(argv[3]);
+	}
+
+	ret = net_capture_file_start(iface, argv[2], snaplen);
+	if (ret < 0) {
+		PR_WARNING("Capture %s failed (%d)\n", "start", ret);
+		return -ENOEXEC;
+	}
+#else
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	PR_INFO("Set %s to enable %s support.\n",
+		"CONFIG_NET_CAPTURE_FILE", "network packet capture to a file");
+#endif
+
+	return 0;
+}
+
+static int cmd_net_capture_stop(const struct shell *shell, size_t argc,
+				char *argv[])
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+#if defined(CONFIG_NET_CAPTURE_FILE)
+	struct net_capture_file_stats stats;
+	int ret;
+
+	ret = net_capture_file_stop();
+
+	net_capture_file_get_stats(&stats);
+	PR("Captured %u packets, dropped %u, wrote %zu bytes\n",
+	   stats.captured, stats.dropped, stats.written);
+
+	if (ret < 0) {
+		PR_WARNING("Capture %s failed (%d)\n", "stop", ret);
+		return -ENOEXEC;
+	}
+#else
+	PR_INFO("Set %s to enable %s support.\n",
+		"CONFIG_NET_CAPTURE_FILE", "network packet capture to a file");
+#endif
+
+	return 0;
+}
+
 static int cmd_net_conn(const struct shell *shell, size_t argc, char *argv[])
 {
 	ARG_UNUSED(argc);
@@ -2181,6 +2249,75 @@ static void print_dns_info(const struct shell *shell,
 }
 #endif
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+static void dns_cache_cb(const char *name, enum dns_query_type type,
+			 int status, uint32_t ttl,
+			 const struct sockaddr *addr, int addr_count,
+			 void *user_data)
+{
+	const struct shell *shell = user_data;
+	int i;
+
+	PR("\t%s %s ttl %u", name,
+	   type == DNS_QUERY_TYPE_AAAA ? "AAAA" : "A", ttl);
+
+	if (status != DNS_EAI_ALLDONE) {
+		PR(" failed (%d)\n", status);
+		return;
+	}
+
+	for (i = 0; i < addr_count; i++) {
+		if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		    addr[i].sa_family == AF_INET) {
+			PR(" %s", net_sprint_ipv4_addr(
+				   &net_sin(&addr[i])->sin_addr));
+		} else if (IS_ENABLED(CONFIG_NET_IPV6) &&
+			   addr[i].sa_family == AF_INET6) {
+			PR(" %s", net_sprint_ipv6_addr(
+				   &net_sin6(&addr[i])->sin6_addr));
+		}
+	}
+
+	PR("\n");
+}
+#endif
+
+static int cmd_net_dns_cache(const struct shell *shell, size_t argc,
+			     char *argv[])
+{
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct dns_cache_stats stats;
+
+	if (argv[1]) {
+		if (strcmp(argv[1], "flush") != 0) {
+			PR_WARNING("Unknown option \"%s\"\n", argv[1]);
+			return -ENOEXEC;
+		}
+
+		dns_cache_flush();
+		PR("DNS cache flushed.\n");
+		return 0;
+	}
+
+	dns_cache_stats_get(&stats);
+
+	PR("DNS cache entries %u/%d\n", stats.entries,
+	   CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES);
+	PR("Hits %u negative %u misses %u coalesced %u\n", stats.hits,
+	   stats.negative_hits, stats.misses, stats.coalesced);
+
+	dns_cache_foreach(dns_cache_cb, (void *)shell);
+#else
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	PR_INFO("Set %s to enable %s support.\n", "CONFIG_DNS_RESOLVER_CACHE",
+		"DNS cache");
+#endif
+
+	return 0;
+}
+
 static int cmd_net_dns_cancel(const struct shell *shell, size_t argc,
 			      char *argv[])
 {
@@ -4527,6 +4664,95 @@ static int cmd_net_stats_iface(const struct shell *shell, size_t argc,
 	return 0;
 }
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+#define STATS_TOP_DEFAULT 5
+#define STATS_TOP_MAX 8
+
+static void get_sockaddr_str(const struct sockaddr *addr, char *buf, int len)
+{
+#if defined(CONFIG_NET_IPV6)
+	if (addr->sa_family == AF_INET6) {
+		snprintk(buf, len, "[%s]:%u",
+			 net_sprint_ipv6_addr(&net_sin6(addr)->sin6_addr),
+			 ntohs(net_sin6(addr)->sin6_port));
+		return;
+	}
+#endif
+#if defined(CONFIG_NET_IPV4)
+	if (addr->sa_family == AF_INET) {
+		snprintk(buf, len, "%s:%d",
+			 net_sprint_ipv4_addr(&net_sin(addr)->sin_addr),
+			 ntohs(net_sin(addr)->sin_port));
+		return;
+	}
+#endif
+	snprintk(buf, len, "-");
+}
+#endif /* CONFIG_NET_STATISTICS_CONTEXT */
+
+static int cmd_net_stats_top(const struct shell *shell, size_t argc,
+			     char *argv[])
+{
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+#if defined(CONFIG_NET_IPV6) && !defined(CONFIG_NET_IPV4)
+#define ADDR_LEN NET_IPV6_ADDR_LEN
+#elif defined(CONFIG_NET_IPV4) && !defined(CONFIG_NET_IPV6)
+#define ADDR_LEN NET_IPV4_ADDR_LEN
+#else
+#define ADDR_LEN NET_IPV6_ADDR_LEN
+#endif
+	struct net_stats_context_entry top[STATS_TOP_MAX];
+	/* +7 for []:port */
+	char addr_local[ADDR_LEN + 7];
+	char addr_remote[ADDR_LEN + 7];
+	int count = STATS_TOP_DEFAULT;
+	char *endptr;
+	int i;
+
+	if (argv[1]) {
+		count = strtol(argv[1], &endptr, 10);
+		if (*endptr != '\0' || count < 1 || count > STATS_TOP_MAX) {
+			PR_WARNING("Invalid count %s, max %d\n", argv[1],
+				   STATS_TOP_MAX);
+			return -ENOEXEC;
+		}
+	}
+
+	count = net_stats_context_top(NULL, top, count);
+	if (count == 0) {
+		PR("No traffic\n");
+		return 0;
+	}
+
+	PR("     Proto Iface            Local           Remote"
+	   "       Sent   Received  Pkts tx/rx  Drop  Resent\n");
+
+	for (i = 0; i < count; i++) {
+		get_sockaddr_str(&top[i].local, addr_local,
+				 sizeof(addr_local));
+		get_sockaddr_str(&top[i].remote, addr_remote,
+				 sizeof(addr_remote));
+
+		PR("[%2d] %s   %d     %16s %16s %10u %10u %5u/%-5u %5u %7u\n",
+		   i + 1,
+		   top[i].proto == IPPROTO_TCP ? "TCP" :
+		   (top[i].proto == IPPROTO_UDP ? "UDP" : "   "),
+		   top[i].iface, addr_local, addr_remote,
+		   top[i].stats.bytes.sent, top[i].stats.bytes.received,
+		   top[i].stats.pkts.tx, top[i].stats.pkts.rx,
+		   top[i].stats.drop, top[i].stats.resent);
+	}
+#else
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+
+	PR_INFO("Set %s to enable %s support.\n",
+		"CONFIG_NET_STATISTICS_CONTEXT", "per context statistics");
+#endif
+
+	return 0;
+}
+
 static int cmd_net_stats(const struct shell *shell, size_t argc, char *argv[])
 {
 #if defined(CONFIG_NET_STATISTICS)
@@ -5680,10 +5906,19 @@ SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_capture,
 		  cmd_net_capture_enable),
 	SHELL_CMD(disable, NULL, "Disable network packet capture.",
 		  cmd_net_capture_disable),
+	SHELL_CMD(file, NULL, "Capture a network interface to a pcapng file.\n"
+		  "'net capture file <interface index> <path> [snaplen]'",
+		  cmd_net_capture_file),
+	SHELL_CMD(stop, NULL, "Stop the network packet capture to a file.",
+		  cmd_net_capture_stop),
 	SHELL_SUBCMD_SET_END
 );
 
 SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_dns,
+	SHELL_CMD(cache, NULL,
+		  "'net dns cache [flush]' shows the cached names and the "
+		  "cache statistics, or empties the cache.",
+		  cmd_net_dns_cache),
 	SHELL_CMD(cancel, NULL, "Cancel all pending requests.",
 		  cmd_net_dns_cancel),
 	SHELL_CMD(query, NULL,
@@ -5933,6 +6168,10 @@ SHELL_STATIC_SUBCMD_SET_CREATE(net_cmd_stats,
 		  "'net stats <index>' shows network statistics for "
 		  "one specific network interface.",
 		  cmd_net_stats_iface),
+	SHELL_CMD(top, NULL,
+		  "'net stats top [count]' shows the network contexts that "
+		  "sent and received the most data.",
+		  cmd_net_stats_top),
 	SHELL_SUBCMD_SET_END
 );
 
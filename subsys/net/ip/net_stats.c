@@ -232,6 +232,99 @@ void net_print_statistics(void)
 
 #endif /* CONFIG_NET_STATISTICS_PERIODIC_OUTPUT */
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+struct context_top {
+	struct net_if *iface;
+	struct net_stats_context_entry *top;
+	int count;
+	int used;
+};
+
+static uint64_t context_total(const struct net_stats_context *stats)
+{
+	return (uint64_t)stats->bytes.sent + stats->bytes.received;
+}
+
+static void context_entry_fill(struct net_stats_context_entry *entry,
+			       struct net_context *context)
+{
+	memset(entry, 0, sizeof(*entry));
+
+	entry->local.sa_family = context->local.family;
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && context->local.family == AF_INET6) {
+		net_sin6(&entry->local)->sin6_port =
+			net_sin6_ptr(&context->local)->sin6_port;
+
+		if (net_sin6_ptr(&context->local)->sin6_addr) {
+			net_ipaddr_copy(&net_sin6(&entry->local)->sin6_addr,
+				     net_sin6_ptr(&context->local)->sin6_addr);
+		}
+	} else if (IS_ENABLED(CONFIG_NET_IPV4) &&
+		   context->local.family == AF_INET) {
+		net_sin(&entry->local)->sin_port =
+			net_sin_ptr(&context->local)->sin_port;
+
+		if (net_sin_ptr(&context->local)->sin_addr) {
+			net_ipaddr_copy(&net_sin(&entry->local)->sin_addr,
+					net_sin_ptr(&context->local)->sin_addr);
+		}
+	}
+
+	memcpy(&entry->remote, &context->remote, sizeof(entry->remote));
+
+	entry->proto = net_context_get_ip_proto(context);
+	entry->iface = context->iface;
+	entry->stats = context->stats;
+}
+
+static void context_top_cb(struct net_context *context, void *user_data)
+{
+	struct context_top *data = user_data;
+	uint64_t total = context_total(&context->stats);
+	int i;
+
+	if (data->iface && net_context_get_iface(context) != data->iface) {
+		return;
+	}
+
+	if (total == 0 && context->stats.drop == 0) {
+		return;
+	}
+
+	/* Insertion sort, the list is short. The last entry falls off when
+	 * the list is full.
+	 */
+	for (i = data->used;
+	     i > 0 && context_total(&data->top[i - 1].stats) < total; i--) {
+		if (i < data->count) {
+			data->top[i] = data->top[i - 1];
+		}
+	}
+
+	if (i < data->count) {
+		context_entry_fill(&data->top[i], context);
+		data->used = MIN(data->used + 1, data->count);
+	}
+}
+
+int net_stats_context_top(struct net_if *iface,
+			  struct net_stats_context_entry *top, int count)
+{
+	struct context_top data = {
+		.iface = iface,
+		.top = top,
+		.count = count,
+	};
+
+	memset(top, 0, count * sizeof(*top));
+
+	net_context_foreach(context_top_cb, &data);
+
+	return data.used;
+}
+#endif /* CONFIG_NET_STATISTICS_CONTEXT */
+
 #if defined(CONFIG_NET_STATISTICS_USER_API)
 
 static int net_stats_get(uint32_t mgmt_request, struct net_if *iface,
@@ -361,6 +454,27 @@ NET_MGMT_REGISTER_REQUEST_HANDLER(NET_REQUEST_STATS_GET_PM,
 				  net_stats_get);
 #endif
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+static int net_stats_get_context_top(uint32_t mgmt_request,
+				     struct net_if *iface,
+				     void *data, size_t len)
+{
+	size_t count = len / sizeof(struct net_stats_context_entry);
+
+	if (count == 0 ||
+	    len != count * sizeof(struct net_stats_context_entry)) {
+		return -EINVAL;
+	}
+
+	(void)net_stats_context_top(iface, data, count);
+
+	return 0;
+}
+
+NET_MGMT_REGISTER_REQUEST_HANDLER(NET_REQUEST_STATS_GET_CONTEXT_TOP,
+				  net_stats_get_context_top);
+#endif
+
 #endif /* CONFIG_NET_STATISTICS_USER_API */
 
 void net_stats_reset(struct net_if *iface)
@@ -619,6 +619,50 @@ static inline void net_stats_add_suspend_end_time(struct net_if *iface,
 #define net_stats_add_suspend_end_time(iface, time)
 #endif
 
+#if defined(CONFIG_NET_STATISTICS_CONTEXT)
+#include <net/net_context.h>
+
+/* Like the other statistics, the context counters are updated without
+ * locking to keep the data path cheap, so a reader may see them torn.
+ */
+static inline void net_stats_update_context_sent(struct net_context *context,
+						 uint32_t bytes, uint32_t pkts)
+{
+	context->stats.bytes.sent += bytes;
+	context->stats.pkts.tx += pkts;
+}
+
+static inline void net_stats_update_context_recv(struct net_context *context,
+						 uint32_t bytes)
+{
+	context->stats.bytes.received += bytes;
+	context->stats.pkts.rx++;
+}
+
+static inline void net_stats_update_context_drop(struct net_context *context)
+{
+	context->stats.drop++;
+}
+
+static inline void net_stats_update_context_resent(struct net_context *context,
+						   uint32_t bytes)
+{
+	context->stats.resent += bytes;
+}
+
+/* Fill top with the count contexts that sent and received the most data,
+ * only considering the ones last using iface if it is set. Return the
+ * number of entries filled, the others are cleared.
+ */
+int net_stats_context_top(struct net_if *iface,
+			  struct net_stats_context_entry *top, int count);
+#else
+#define net_stats_update_context_sent(context, bytes, pkts)
+#define net_stats_update_context_recv(context, bytes)
+#define net_stats_update_context_drop(context)
+#define net_stats_update_context_resent(context, bytes)
+#endif /* CONFIG_NET_STATISTICS_CONTEXT */
+
 #if defined(CONFIG_NET_STATISTICS_PERIODIC_OUTPUT) \
 	&& defined(CONFIG_NET_NATIVE)
 /* A simple periodic statistic printer, used only in net core */
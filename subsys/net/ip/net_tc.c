@@ -13,23 +13,48 @@ LOG_MODULE_REGISTER(net_tc, CONFIG_NET_TC_LOG_LEVEL);
 #include <net/net_core.h>
 #include <net/net_pkt.h>
 #include <net/net_stats.h>
+#include <net/ethernet.h>
 
 #include "net_private.h"
 #include "net_stats.h"
 #include "net_tc_mapping.h"
+#include "tcp_internal.h"
 
 /* Template for thread name. The "xx" is either "TX" denoting transmit thread,
  * or "RX" denoting receive thread. The "q[y]" denotes the traffic class queue
  * where y indicates the traffic class id. The value of y can be from 0 to 7.
+ * With RX steering, the RX threads are named "rx_q[y.z]" where z is the
+ * flow queue within the traffic class.
  */
-#define MAX_NAME_LEN sizeof("xx_q[y]")
+#define MAX_NAME_LEN sizeof("xx_q[y.z]")
+
+/* Number of RX queues (and threads) for each traffic class */
+#if defined(CONFIG_NET_RX_STEERING)
+#define NET_TC_RX_QUEUES CONFIG_NET_RX_STEERING_QUEUES
+#else
+#define NET_TC_RX_QUEUES 1
+#endif
+
+#define NET_TC_RX_THREADS (NET_TC_RX_COUNT * NET_TC_RX_QUEUES)
+
+/* With the deficit round-robin scheduler, one thread serves all the TX
+ * queues. The highest TX_SCHED_STRICT_COUNT classes are served with strict
+ * priority, the others in round-robin.
+ */
+#if defined(CONFIG_NET_TC_TX_SCHED_DRR)
+#define NET_TC_TX_THREADS 1
+#define TX_SCHED_STRICT_COUNT CONFIG_NET_TC_TX_DRR_STRICT_COUNT
+#define TX_SCHED_DRR_COUNT (NET_TC_TX_COUNT - TX_SCHED_STRICT_COUNT)
+#else
+#define NET_TC_TX_THREADS NET_TC_TX_COUNT
+#endif
 
 /* Stacks for TX work queue */
-K_KERNEL_STACK_ARRAY_DEFINE(tx_stack, NET_TC_TX_COUNT,
+K_KERNEL_STACK_ARRAY_DEFINE(tx_stack, NET_TC_TX_THREADS,
 			    CONFIG_NET_TX_STACK_SIZE);
 
 /* Stacks for RX work queue */
-K_KERNEL_STACK_ARRAY_DEFINE(rx_stack, NET_TC_RX_COUNT,
+K_KERNEL_STACK_ARRAY_DEFINE(rx_stack, NET_TC_RX_THREADS,
 			    CONFIG_NET_RX_STACK_SIZE);
 
 #if NET_TC_TX_COUNT > 0
@@ -37,7 +62,10 @@ static struct net_traffic_class tx_classes[NET_TC_TX_COUNT];
 #endif
 
 #if NET_TC_RX_COUNT > 0
-static struct net_traffic_class rx_classes[NET_TC_RX_COUNT];
+/* The queues of traffic class tc are rx_classes[tc * NET_TC_RX_QUEUES] to
+ * rx_classes[(tc + 1) * NET_TC_RX_QUEUES - 1].
+ */
+static struct net_traffic_class rx_classes[NET_TC_RX_THREADS];
 #endif
 
 #if NET_TC_RX_COUNT > 0 || NET_TC_TX_COUNT > 0
@@ -47,12 +75,80 @@ static void submit_to_queue(struct k_fifo *queue, struct net_pkt *pkt)
 }
 #endif
 
+#if defined(CONFIG_NET_TC_TX_SCHED_DRR)
+struct tx_sched_class {
+	/* Token bucket, in bytes multiplied by the tick rate so that no
+	 * fraction of a byte is lost when it is refilled.
+	 */
+	int64_t credit;
+	int64_t max_credit;
+	int64_t last_refill;
+	uint32_t rate;
+	bool is_throttled;
+
+	/* Bytes that the class may still send in this round */
+	uint32_t deficit;
+
+	atomic_t queued;
+	atomic_t max_queued;
+	atomic_t dropped;
+	uint32_t sent_pkts;
+	uint64_t sent_bytes;
+	uint32_t throttled;
+};
+
+static struct tx_sched_class tx_sched[NET_TC_TX_COUNT];
+
+/* Protects the token buckets and the sent statistics */
+static struct k_spinlock tx_sched_lock;
+
+static K_SEM_DEFINE(tx_sched_wake, 0, 1);
+
+#if TX_SCHED_DRR_COUNT > 0
+/* Round-robin position, only used by the TX thread */
+static uint8_t drr_tc;
+static bool drr_visited;
+#endif
+
+static bool tx_sched_submit(uint8_t tc, struct net_pkt *pkt)
+{
+	struct tx_sched_class *cls = &tx_sched[tc];
+	atomic_val_t queued, max;
+
+	queued = atomic_inc(&cls->queued) + 1;
+
+	if (CONFIG_NET_TC_TX_DRR_QUEUE_LEN > 0 &&
+	    queued > CONFIG_NET_TC_TX_DRR_QUEUE_LEN) {
+		atomic_dec(&cls->queued);
+		atomic_inc(&cls->dropped);
+
+		NET_DBG("TC %d queue full, dropping pkt %p", tc, pkt);
+
+		net_pkt_unref(pkt);
+		return false;
+	}
+
+	do {
+		max = atomic_get(&cls->max_queued);
+	} while (queued > max && !atomic_cas(&cls->max_queued, max, queued));
+
+	submit_to_queue(&tx_classes[tc].fifo, pkt);
+	k_sem_give(&tx_sched_wake);
+
+	return true;
+}
+#endif
+
 bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt)
 {
 #if NET_TC_TX_COUNT > 0
 	net_pkt_set_tx_stats_tick(pkt, k_cycle_get_32());
 
+#if defined(CONFIG_NET_TC_TX_SCHED_DRR)
+	return tx_sched_submit(tc, pkt);
+#else
 	submit_to_queue(&tx_classes[tc].fifo, pkt);
+#endif
 #else
 	ARG_UNUSED(tc);
 	ARG_UNUSED(pkt);
@@ -60,12 +156,163 @@ bool net_tc_submit_to_tx_queue(uint8_t tc, struct net_pkt *pkt)
 	return true;
 }
 
+#if defined(CONFIG_NET_RX_STEERING)
+static inline uint32_t flow_hash_add(uint32_t hash, uint32_t value)
+{
+	hash = (hash ^ value) * 0x9e3779b1U;
+
+	return hash ^ (hash >> 15);
+}
+
+static uint32_t flow_hash_add_buf(uint32_t hash, const uint8_t *buf,
+				  size_t len)
+{
+	for (; len >= sizeof(uint32_t); len -= sizeof(uint32_t)) {
+		hash = flow_hash_add(hash, UNALIGNED_GET((uint32_t *)buf));
+		buf += sizeof(uint32_t);
+	}
+
+	return hash;
+}
+
+static uint16_t flow_l3_type(struct net_pkt *pkt)
+{
+	uint16_t type;
+	uint8_t vtc;
+
+#if defined(CONFIG_NET_L2_ETHERNET)
+	/* Reassembled IPv6 packets are fed back without link layer header */
+	if (net_if_l2(net_pkt_iface(pkt)) == &NET_L2_GET_NAME(ETHERNET) &&
+	    !net_pkt_ipv6_fragment_start(pkt)) {
+		if (net_pkt_skip(pkt, 2 * sizeof(struct net_eth_addr)) ||
+		    net_pkt_read_be16(pkt, &type)) {
+			return 0;
+		}
+
+		if (type == NET_ETH_PTYPE_VLAN &&
+		    (net_pkt_skip(pkt, sizeof(uint16_t)) ||
+		     net_pkt_read_be16(pkt, &type))) {
+			return 0;
+		}
+
+		return type;
+	}
+#endif
+
+	/* Other link layers deliver plain IP packets to the stack, or are
+	 * not parsed here.
+	 */
+	if (net_pkt_read_u8(pkt, &vtc)) {
+		return 0;
+	}
+
+	net_pkt_cursor_init(pkt);
+
+	switch (vtc & 0xf0) {
+	case 0x40:
+		type = NET_ETH_PTYPE_IP;
+		break;
+	case 0x60:
+		type = NET_ETH_PTYPE_IPV6;
+		break;
+	default:
+		type = 0;
+		break;
+	}
+
+	return type;
+}
+
+uint32_t net_rx_flow_hash(struct net_pkt *pkt)
+{
+	union {
+		struct net_ipv4_hdr ipv4;
+		struct net_ipv6_hdr ipv6;
+	} hdr;
+	uint32_t hash = 0U;
+	uint32_t ports;
+	uint8_t proto;
+
+	net_pkt_cursor_init(pkt);
+
+	switch (flow_l3_type(pkt)) {
+	case NET_ETH_PTYPE_IP:
+		if (net_pkt_read(pkt, &hdr.ipv4, sizeof(hdr.ipv4))) {
+			goto out;
+		}
+
+		hash = flow_hash_add_buf(hash, (uint8_t *)&hdr.ipv4.src,
+					 2 * sizeof(struct in_addr));
+		proto = hdr.ipv4.proto;
+
+		/* Only the first fragment has the ports, so hash all the
+		 * fragments on the addresses only to keep them together.
+		 */
+		if ((hdr.ipv4.offset[0] & 0x3f) || hdr.ipv4.offset[1] ||
+		    net_pkt_skip(pkt, ((hdr.ipv4.vhl & 0x0f) * 4U) -
+				 sizeof(hdr.ipv4))) {
+			goto out;
+		}
+
+		break;
+	case NET_ETH_PTYPE_IPV6:
+		if (net_pkt_read(pkt, &hdr.ipv6, sizeof(hdr.ipv6))) {
+			goto out;
+		}
+
+		hash = flow_hash_add_buf(hash, (uint8_t *)&hdr.ipv6.src,
+					 2 * sizeof(struct in6_addr));
+		hash = flow_hash_add(hash, ((hdr.ipv6.tcflow & 0x0f) << 16) |
+				     hdr.ipv6.flow);
+
+		/* Extension headers are not walked, such packets (and
+		 * fragments) are hashed on the addresses only.
+		 */
+		proto = hdr.ipv6.nexthdr;
+		break;
+	default:
+		goto out;
+	}
+
+	hash = flow_hash_add(hash, proto);
+
+	if ((proto == IPPROTO_UDP || proto == IPPROTO_TCP) &&
+	    !net_pkt_read(pkt, &ports, sizeof(ports))) {
+		hash = flow_hash_add(hash, ports);
+	}
+
+out:
+	net_pkt_cursor_init(pkt);
+
+	/* 0 means no hash */
+	return hash ? hash : 1U;
+}
+
+static uint8_t rx_flow_queue(struct net_pkt *pkt)
+{
+	uint32_t hash = net_pkt_rx_hash(pkt);
+
+	if (!hash) {
+		hash = net_rx_flow_hash(pkt);
+		net_pkt_set_rx_hash(pkt, hash);
+	}
+
+	return hash % NET_TC_RX_QUEUES;
+}
+#endif /* CONFIG_NET_RX_STEERING */
+
 void net_tc_submit_to_rx_queue(uint8_t tc, struct net_pkt *pkt)
 {
 #if NET_TC_RX_COUNT > 0
+	int queue = tc * NET_TC_RX_QUEUES;
+
+#if defined(CONFIG_NET_RX_STEERING)
+	queue += rx_flow_queue(pkt);
+#endif
+
 	net_pkt_set_rx_stats_tick(pkt, k_cycle_get_32());
 
-	submit_to_queue(&rx_classes[tc].fifo, pkt);
+	submit_to_queue(&rx_classes[queue].fifo, pkt);
 #else
 	ARG_UNUSED(tc);
 	ARG_UNUSED(pkt);
@@ -248,11 +495,26 @@ static void tc_rx_handler(struct k_fifo *fifo)
 		}
 
 		net_process_rx_packet(pkt);
+
+		if (IS_ENABLED(CONFIG_NET_TCP_GRO)) {
+			net_tcp_gro_flush(k_fifo_is_empty(fifo));
+		}
 	}
 }
+
+#if defined(CONFIG_NET_TCP_GRO)
+bool net_tc_rx_thread_is_current(void)
+{
+	k_tid_t thread = k_current_get();
+
+	return thread >= &rx_classes[0].handler &&
+		thread <= &rx_classes[NET_TC_RX_THREADS - 1].handler;
+}
+#endif
 #endif
 
 #if NET_TC_TX_COUNT > 0
+#if !defined(CONFIG_NET_TC_TX_SCHED_DRR)
 static void tc_tx_handler(struct k_fifo *fifo)
 {
 	struct net_pkt *pkt;
@@ -266,6 +528,248 @@ static void tc_tx_handler(struct k_fifo *fifo)
 		net_process_tx_packet(pkt);
 	}
 }
+#else
+/* Refill the token bucket of the class and tell if it is not empty. If it
+ * is, the ticks until it is not are stored in wait when that is sooner.
+ */
+static bool tx_sched_may_send(struct tx_sched_class *cls, int64_t *wait)
+{
+	k_spinlock_key_t key;
+	int64_t now, ticks;
+	bool ret = true;
+
+	key = k_spin_lock(&tx_sched_lock);
+
+	if (cls->rate == 0) {
+		goto out;
+	}
+
+	now = k_uptime_ticks();
+	cls->credit = MIN(cls->credit + (now - cls->last_refill) * cls->rate,
+			  cls->max_credit);
+	cls->last_refill = now;
+
+	if (cls->credit > 0) {
+		cls->is_throttled = false;
+		goto out;
+	}
+
+	if (!cls->is_throttled) {
+		cls->is_throttled = true;
+		cls->throttled++;
+	}
+
+	ticks = -cls->credit / cls->rate + 1;
+	*wait = MIN(*wait, ticks);
+	ret = false;
+
+out:
+	k_spin_unlock(&tx_sched_lock, key);
+
+	return ret;
+}
+
+static struct net_pkt *tx_sched_dequeue(uint8_t tc, size_t len)
+{
+	struct tx_sched_class *cls = &tx_sched[tc];
+	k_spinlock_key_t key;
+
+	key = k_spin_lock(&tx_sched_lock);
+
+	if (cls->rate) {
+		cls->credit -= (int64_t)len * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	}
+
+	cls->sent_pkts++;
+	cls->sent_bytes += len;
+
+	k_spin_unlock(&tx_sched_lock, key);
+
+	atomic_dec(&cls->queued);
+
+	return k_fifo_get(&tx_classes[tc].fifo, K_NO_WAIT);
+}
+
+/* Pick the next packet to send. If there is none, timeout is set to how
+ * long to wait for a rate limited class.
+ */
+static struct net_pkt *tx_sched_next(k_timeout_t *timeout)
+{
+	int64_t wait = INT64_MAX;
+	struct net_pkt *pkt;
+	int tc;
+#if TX_SCHED_DRR_COUNT > 0
+	bool eligible = false;
+	int visits = 0;
+#endif
+
+	/* Only this thread takes packets from the queues, so the head of a
+	 * queue stays there until it is dequeued below.
+	 */
+	for (tc = NET_TC_TX_COUNT - 1; tc >= TX_SCHED_DRR_COUNT; tc--) {
+		pkt = k_fifo_peek_head(&tx_classes[tc].fifo);
+		if (pkt && tx_sched_may_send(&tx_sched[tc], &wait)) {
+			return tx_sched_dequeue(tc, net_pkt_get_len(pkt));
+		}
+	}
+
+#if TX_SCHED_DRR_COUNT > 0
+	while (true) {
+		struct tx_sched_class *cls = &tx_sched[drr_tc];
+		size_t len;
+
+		pkt = k_fifo_peek_head(&tx_classes[drr_tc].fifo);
+		if (!pkt) {
+			/* An idle class does not keep its deficit */
+			cls->deficit = 0;
+		} else if (tx_sched_may_send(cls, &wait)) {
+			eligible = true;
+
+			if (!drr_visited) {
+				cls->deficit += CONFIG_NET_TC_TX_DRR_QUANTUM *
+						(drr_tc + 1);
+				drr_visited = true;
+			}
+
+			len = net_pkt_get_len(pkt);
+			if (len <= cls->deficit) {
+				cls->deficit -= len;
+				return tx_sched_dequeue(drr_tc, len);
+			}
+		}
+
+		drr_tc = (drr_tc + 1) % TX_SCHED_DRR_COUNT;
+		drr_visited = false;
+
+		/* Stop after a full round where no class could send */
+		if (++visits == TX_SCHED_DRR_COUNT) {
+			if (!eligible) {
+				break;
+			}
+
+			eligible = false;
+			visits = 0;
+		}
+	}
+#endif
+
+	*timeout = wait == INT64_MAX ? K_FOREVER : K_TICKS(wait);
+
+	return NULL;
+}
+
+static void tc_tx_sched_handler(void)
+{
+	k_timeout_t timeout = K_FOREVER;
+	struct net_pkt *pkt;
+
+	while (1) {
+		pkt = tx_sched_next(&timeout);
+		if (pkt == NULL) {
+			(void)k_sem_take(&tx_sched_wake, timeout);
+			continue;
+		}
+
+		net_process_tx_packet(pkt);
+	}
+}
+
+static void tx_sched_init(void)
+{
+	uint8_t thread_priority;
+	int priority, i;
+	k_tid_t tid;
+
+	for (i = 0; i < NET_TC_TX_COUNT; i++) {
+		k_fifo_init(&tx_classes[i].fifo);
+	}
+
+	/* Run at the priority of the highest class, so that control
+	 * traffic is not delayed by the application threads.
+	 */
+	thread_priority = tx_tc2thread(NET_TC_TX_COUNT - 1);
+
+	priority = IS_ENABLED(CONFIG_NET_TC_THREAD_COOPERATIVE) ?
+		K_PRIO_COOP(thread_priority) :
+		K_PRIO_PREEMPT(thread_priority);
+
+	NET_DBG("Starting TX scheduler %p stack size %zd prio %d %s(%d)",
+		&tx_classes[0].handler, K_KERNEL_STACK_SIZEOF(tx_stack[0]),
+		thread_priority,
+		IS_ENABLED(CONFIG_NET_TC_THREAD_COOPERATIVE) ?
+						"coop" : "preempt",
+		priority);
+
+	tid = k_thread_create(&tx_classes[0].handler, tx_stack[0],
+			      K_KERNEL_STACK_SIZEOF(tx_stack[0]),
+			      (k_thread_entry_t)tc_tx_sched_handler,
+			      NULL, NULL, NULL, priority, 0, K_FOREVER);
+	if (!tid) {
+		NET_ERR("Cannot create TX scheduler thread");
+		return;
+	}
+
+	if (IS_ENABLED(CONFIG_THREAD_NAME)) {
+		k_thread_name_set(tid, "tx_sched");
+	}
+
+	k_thread_start(tid);
+}
+
+int net_tc_tx_set_rate(uint8_t tc, uint32_t rate, uint32_t burst)
+{
+	struct tx_sched_class *cls;
+	k_spinlock_key_t key;
+
+	if (tc >= NET_TC_TX_COUNT || (rate && burst == 0)) {
+		return -EINVAL;
+	}
+
+	cls = &tx_sched[tc];
+
+	key = k_spin_lock(&tx_sched_lock);
+
+	cls->rate = rate;
+	cls->max_credit = (int64_t)burst * CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+	cls->credit = cls->max_credit;
+	cls->last_refill = k_uptime_ticks();
+	cls->is_throttled = false;
+
+	k_spin_unlock(&tx_sched_lock, key);
+
+	/* The scheduler may be waiting for the previous rate */
+	k_sem_give(&tx_sched_wake);
+
+	return 0;
+}
+
+int net_tc_tx_get_sched_stats(uint8_t tc,
+			      struct net_tc_tx_sched_stats *stats)
+{
+	struct tx_sched_class *cls;
+	k_spinlock_key_t key;
+
+	if (tc >= NET_TC_TX_COUNT) {
+		return -EINVAL;
+	}
+
+	cls = &tx_sched[tc];
+
+	stats->queued = atomic_get(&cls->queued);
+	stats->max_queued = atomic_get(&cls->max_queued);
+	stats->dropped = atomic_get(&cls->dropped);
+
+	key = k_spin_lock(&tx_sched_lock);
+
+	stats->sent_pkts = cls->sent_pkts;
+	stats->sent_bytes = cls->sent_bytes;
+	stats->throttled = cls->throttled;
+
+	k_spin_unlock(&tx_sched_lock, key);
+
+	return 0;
+}
+#endif /* CONFIG_NET_TC_TX_SCHED_DRR */
 #endif
 
 /* Create a fifo for each traffic class we are using. All the network
@@ -277,7 +781,9 @@ void net_tc_tx_init(void)
 	NET_DBG("No %s thread created", "TX");
 	return;
 #else
+#if !defined(CONFIG_NET_TC_TX_SCHED_DRR)
 	int i;
+#endif
 
 	BUILD_ASSERT(NET_TC_TX_COUNT >= 0);
 
@@ -285,6 +791,9 @@ void net_tc_tx_init(void)
 	net_if_foreach(net_tc_tx_stats_priority_setup, NULL);
 #endif
 
+#if defined(CONFIG_NET_TC_TX_SCHED_DRR)
+	tx_sched_init();
+#else
 	for (i = 0; i < NET_TC_TX_COUNT; i++) {
 		uint8_t thread_priority;
 		int priority;
@@ -326,6 +835,7 @@ void net_tc_tx_init(void)
 
 		k_thread_start(tid);
 	}
+#endif /* CONFIG_NET_TC_TX_SCHED_DRR */
 #endif
 }
 
@@ -343,12 +853,12 @@ void net_tc_rx_init(void)
 	net_if_foreach(net_tc_rx_stats_priority_setup, NULL);
 #endif
 
-	for (i = 0; i < NET_TC_RX_COUNT; i++) {
+	for (i = 0; i < NET_TC_RX_THREADS; i++) {
 		uint8_t thread_priority;
 		int priority;
 		k_tid_t tid;
 
-		thread_priority = rx_tc2thread(i);
+		thread_priority = rx_tc2thread(i / NET_TC_RX_QUEUES);
 
 		priority = IS_ENABLED(CONFIG_NET_TC_THREAD_COOPERATIVE) ?
 			K_PRIO_COOP(thread_priority) :
@@ -378,10 +888,24 @@ void net_tc_rx_init(void)
 		if (IS_ENABLED(CONFIG_THREAD_NAME)) {
 			char name[MAX_NAME_LEN];
 
-			snprintk(name, sizeof(name), "rx_q[%d]", i);
+			if (NET_TC_RX_QUEUES > 1) {
+				snprintk(name, sizeof(name), "rx_q[%d.%d]",
+					 i / NET_TC_RX_QUEUES,
+					 i % NET_TC_RX_QUEUES);
+			} else {
+				snprintk(name, sizeof(name), "rx_q[%d]", i);
+			}
+
 			k_thread_name_set(tid, name);
 		}
 
+#if defined(CONFIG_NET_RX_STEERING) && defined(CONFIG_SCHED_CPU_MASK)
+		/* Spread the queues of each traffic class over the CPUs */
+		k_thread_cpu_mask_clear(tid);
+		k_thread_cpu_mask_enable(tid, (i % NET_TC_RX_QUEUES) %
+					 CONFIG_MP_NUM_CPUS);
+#endif
+
 		k_thread_start(tid);
 	}
 #endif
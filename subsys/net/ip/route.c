@@ -36,7 +36,7 @@ LOG_MODULE_REGISTER(net_route, CONFIG_NET_ROUTE_LOG_LEVEL);
 /* We keep track of the routes in a separate list so that we can remove
  * the oldest routes (at tail) if needed.
  */
-static sys_slist_t routes;
+static sys_dlist_t routes = SYS_DLIST_STATIC_INIT(&routes);
 
 static void net_route_nexthop_remove(struct net_nbr *nbr)
 {
@@ -250,39 +250,351 @@ static int nbr_nexthop_put(struct net_nbr *nbr)
 			route->iface);					\
 	} } while (0)
 
-/* Route was accessed, so place it in front of the routes list */
-static inline void update_route_access(struct net_route_entry *route)
+/*
+ * The routes are also kept in a path compressed binary trie keyed by the
+ * prefix bits. There is one node for every distinct prefix, plus a glue
+ * node wherever two prefixes diverge, so the trie never needs more than
+ * 2 * CONFIG_NET_MAX_ROUTES - 1 nodes. A lookup only visits the nodes whose
+ * prefix matches the destination, instead of comparing every route.
+ */
+struct route_lpm_node {
+	struct route_lpm_node *parent;
+	struct route_lpm_node *child[2];
+
+	/* Routes having exactly this prefix, NULL for a glue node */
+	struct net_route_entry *routes;
+
+	struct in6_addr prefix;
+	uint8_t prefix_len;
+	bool in_use;
+};
+
+static struct route_lpm_node lpm_nodes[2 * CONFIG_NET_MAX_ROUTES];
+static struct route_lpm_node *lpm_root;
+
+static inline uint8_t lpm_bit(const struct in6_addr *addr, uint8_t pos)
 {
-	sys_slist_find_and_remove(&routes, &route->node);
-	sys_slist_prepend(&routes, &route->node);
+	return (addr->s6_addr[pos / 8U] >> (7 - pos % 8U)) & 1U;
 }
 
-struct net_route_entry *net_route_lookup(struct net_if *iface,
-					 struct in6_addr *dst)
+/* Number of leading bits which are the same in both addresses */
+static uint8_t lpm_common_len(const struct in6_addr *addr1,
+			      const struct in6_addr *addr2,
+			      uint8_t max_len)
 {
-	struct net_route_entry *route, *found = NULL;
-	uint8_t longest_match = 0U;
+	uint8_t len = 0U;
+	uint8_t diff;
 	int i;
 
-	for (i = 0; i < CONFIG_NET_MAX_ROUTES && longest_match < 128; i++) {
-		struct net_nbr *nbr = get_nbr(i);
+	for (i = 0; i < sizeof(struct in6_addr) && len < max_len; i++) {
+		diff = addr1->s6_addr[i] ^ addr2->s6_addr[i];
+		if (diff) {
+			while (!(diff & 0x80)) {
+				diff <<= 1;
+				len++;
+			}
 
-		if (!nbr->ref) {
-			continue;
+			break;
 		}
 
-		if (iface && nbr->iface != iface) {
+		len += 8U;
+	}
+
+	return MIN(len, max_len);
+}
+
+static struct route_lpm_node *lpm_node_alloc(const struct in6_addr *addr,
+					     uint8_t prefix_len)
+{
+	struct route_lpm_node *node;
+	uint8_t len = prefix_len;
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(lpm_nodes); i++) {
+		node = &lpm_nodes[i];
+
+		if (node->in_use) {
 			continue;
 		}
 
-		route = net_route_data(nbr);
+		memset(node, 0, sizeof(*node));
+		node->in_use = true;
+		node->prefix_len = prefix_len;
 
-		if (route->prefix_len >= longest_match &&
-		    net_ipv6_is_prefix(dst->s6_addr,
-				       route->addr.s6_addr,
-				       route->prefix_len)) {
-			found = route;
-			longest_match = route->prefix_len;
+		/* Only keep the prefix bits */
+		for (j = 0; j < sizeof(struct in6_addr) && len; j++) {
+			if (len >= 8U) {
+				node->prefix.s6_addr[j] = addr->s6_addr[j];
+				len -= 8U;
+			} else {
+				node->prefix.s6_addr[j] = addr->s6_addr[j] &
+					(uint8_t)(0xff00 >> len);
+				len = 0U;
+			}
+		}
+
+		return node;
+	}
+
+	return NULL;
+}
+
+/* Replace the old child of parent (or the root) with the new one */
+static void lpm_link(struct route_lpm_node *parent,
+		     struct route_lpm_node *old,
+		     struct route_lpm_node *new)
+{
+	if (!parent) {
+		lpm_root = new;
+	} else {
+		parent->child[parent->child[1] == old] = new;
+	}
+
+	if (new) {
+		new->parent = parent;
+	}
+}
+
+static struct route_lpm_node *lpm_find(const struct in6_addr *addr,
+				       uint8_t prefix_len)
+{
+	struct route_lpm_node *node = lpm_root;
+
+	while (node && node->prefix_len <= prefix_len &&
+	       net_ipv6_is_prefix(addr->s6_addr, node->prefix.s6_addr,
+				  node->prefix_len)) {
+		if (node->prefix_len == prefix_len) {
+			return node;
+		}
+
+		node = node->child[lpm_bit(addr, node->prefix_len)];
+	}
+
+	return NULL;
+}
+
+static struct route_lpm_node *lpm_insert(const struct in6_addr *addr,
+					 uint8_t prefix_len)
+{
+	struct route_lpm_node *parent = NULL;
+	struct route_lpm_node *node = lpm_root;
+	struct route_lpm_node *new, *glue;
+	uint8_t common = 0U;
+
+	while (node) {
+		common = lpm_common_len(&node->prefix, addr,
+					MIN(node->prefix_len, prefix_len));
+		if (common < node->prefix_len) {
+			break;
+		}
+
+		if (node->prefix_len == prefix_len) {
+			return node;
+		}
+
+		parent = node;
+		node = node->child[lpm_bit(addr, node->prefix_len)];
+	}
+
+	new = lpm_node_alloc(addr, prefix_len);
+	if (!new) {
+		return NULL;
+	}
+
+	if (!node) {
+		/* Free slot below the longest matching prefix */
+		if (parent) {
+			parent->child[lpm_bit(addr, parent->prefix_len)] = new;
+		} else {
+			lpm_root = new;
+		}
+
+		new->parent = parent;
+
+		return new;
+	}
+
+	if (common == prefix_len) {
+		/* The new prefix is a prefix of the node */
+		lpm_link(parent, node, new);
+		new->child[lpm_bit(&node->prefix, prefix_len)] = node;
+		node->parent = new;
+
+		return new;
+	}
+
+	/* The prefixes diverge after common bits */
+	glue = lpm_node_alloc(addr, common);
+	if (!glue) {
+		new->in_use = false;
+		return NULL;
+	}
+
+	lpm_link(parent, node, glue);
+	glue->child[lpm_bit(addr, common)] = new;
+	glue->child[lpm_bit(&node->prefix, common)] = node;
+	new->parent = glue;
+	node->parent = glue;
+
+	return new;
+}
+
+/* Remove the nodes which are not needed anymore, starting from node */
+static void lpm_prune(struct route_lpm_node *node)
+{
+	struct route_lpm_node *parent, *child;
+
+	while (node && !node->routes) {
+		if (node->child[0] && node->child[1]) {
+			/* Still needed as a glue node */
+			return;
+		}
+
+		child = node->child[0] ? node->child[0] : node->child[1];
+		parent = node->parent;
+
+		lpm_link(parent, node, child);
+		node->in_use = false;
+
+		node = parent;
+	}
+}
+
+static struct net_route_entry *lpm_lookup(struct net_if *iface,
+					  const struct in6_addr *dst)
+{
+	struct route_lpm_node *node = lpm_root;
+	struct net_route_entry *route, *found = NULL;
+
+	while (node && net_ipv6_is_prefix(dst->s6_addr, node->prefix.s6_addr,
+					  node->prefix_len)) {
+		for (route = node->routes; route; route = route->lpm_next) {
+			if (!iface || route->iface == iface) {
+				found = route;
+				break;
+			}
+		}
+
+		if (node->prefix_len == 128U) {
+			break;
+		}
+
+		node = node->child[lpm_bit(dst, node->prefix_len)];
+	}
+
+	return found;
+}
+
+#if CONFIG_NET_ROUTE_LOOKUP_CACHE_SIZE > 0
+/* Recent lookups, keyed by interface and destination */
+struct route_cache_entry {
+	struct net_if *iface;
+	struct net_route_entry *route;
+	struct in6_addr dst;
+};
+
+static struct route_cache_entry route_cache[CONFIG_NET_ROUTE_LOOKUP_CACHE_SIZE];
+
+static struct route_cache_entry *route_cache_slot(struct net_if *iface,
+						  const struct in6_addr *dst)
+{
+	uint32_t hash = dst->s6_addr32[3] ^ POINTER_TO_UINT(iface);
+
+	hash ^= hash >> 16;
+	hash ^= hash >> 8;
+
+	return &route_cache[hash % CONFIG_NET_ROUTE_LOOKUP_CACHE_SIZE];
+}
+
+static struct net_route_entry *route_cache_get(struct net_if *iface,
+					       const struct in6_addr *dst)
+{
+	struct route_cache_entry *entry = route_cache_slot(iface, dst);
+
+	if (entry->route && entry->iface == iface &&
+	    net_ipv6_addr_cmp(&entry->dst, dst)) {
+		return entry->route;
+	}
+
+	return NULL;
+}
+
+static void route_cache_put(struct net_if *iface, const struct in6_addr *dst,
+			    struct net_route_entry *route)
+{
+	struct route_cache_entry *entry = route_cache_slot(iface, dst);
+
+	entry->iface = iface;
+	entry->route = route;
+	net_ipaddr_copy(&entry->dst, dst);
+}
+
+static void route_cache_flush(void)
+{
+	memset(route_cache, 0, sizeof(route_cache));
+}
+#else
+#define route_cache_get(iface, dst) NULL
+#define route_cache_put(iface, dst, route)
+#define route_cache_flush()
+#endif /* CONFIG_NET_ROUTE_LOOKUP_CACHE_SIZE > 0 */
+
+static int route_lpm_add(struct net_route_entry *route)
+{
+	struct route_lpm_node *node;
+
+	node = lpm_insert(&route->addr, route->prefix_len);
+	if (!node) {
+		return -ENOMEM;
+	}
+
+	route->lpm_next = node->routes;
+	node->routes = route;
+
+	route_cache_flush();
+
+	return 0;
+}
+
+static void route_lpm_del(struct net_route_entry *route)
+{
+	struct net_route_entry **prev;
+	struct route_lpm_node *node;
+
+	node = lpm_find(&route->addr, route->prefix_len);
+	if (!node) {
+		return;
+	}
+
+	for (prev = &node->routes; *prev; prev = &(*prev)->lpm_next) {
+		if (*prev == route) {
+			*prev = route->lpm_next;
+			break;
+		}
+	}
+
+	lpm_prune(node);
+
+	route_cache_flush();
+}
+
+/* Route was accessed, so place it in front of the routes list */
+static inline void update_route_access(struct net_route_entry *route)
+{
+	sys_dlist_remove(&route->node);
+	sys_dlist_prepend(&routes, &route->node);
+}
+
+struct net_route_entry *net_route_lookup(struct net_if *iface,
+					 struct in6_addr *dst)
+{
+	struct net_route_entry *found;
+
+	found = route_cache_get(iface, dst);
+	if (!found) {
+		found = lpm_lookup(iface, dst);
+		if (found) {
+			route_cache_put(iface, dst, found);
 		}
 	}
 
@@ -317,6 +629,11 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 		return NULL;
 	}
 
+	if (prefix_len > 128) {
+		NET_DBG("Invalid prefix length %d", prefix_len);
+		return NULL;
+	}
+
 	nbr_nexthop = net_ipv6_nbr_lookup(iface, nexthop);
 	if (!nbr_nexthop) {
 		NET_DBG("No such neighbor %s found",
@@ -353,9 +670,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	nbr = nbr_new(iface, addr, prefix_len);
 	if (!nbr) {
 		/* Remove the oldest route and try again */
-		sys_snode_t *last = sys_slist_peek_tail(&routes);
-
-		sys_slist_find_and_remove(&routes, last);
+		sys_dnode_t *last = sys_dlist_peek_tail(&routes);
 
 		route = CONTAINER_OF(last,
 				     struct net_route_entry,
@@ -393,6 +708,7 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	tmp = get_nexthop_route();
 	if (!tmp) {
 		NET_ERR("No nexthop route available!");
+		nbr_free(nbr);
 		return NULL;
 	}
 
@@ -401,7 +717,14 @@ struct net_route_entry *net_route_add(struct net_if *iface,
 	route = net_route_data(nbr);
 	route->iface = iface;
 
-	sys_slist_prepend(&routes, &route->node);
+	if (route_lpm_add(route) < 0) {
+		NET_ERR("No route lookup node available!");
+		net_nbr_unref(tmp);
+		nbr_free(nbr);
+		return NULL;
+	}
+
+	sys_dlist_prepend(&routes, &route->node);
 
 	tmp = nbr_nexthop_get(iface, nexthop);
 
@@ -454,7 +777,11 @@ int net_route_del(struct net_route_entry *route)
 	net_mgmt_event_notify(NET_EVENT_IPV6_ROUTE_DEL, route->iface);
 #endif
 
-	sys_slist_find_and_remove(&routes, &route->node);
+	if (sys_dnode_is_linked(&route->node)) {
+		sys_dlist_remove(&route->node);
+	}
+
+	route_lpm_del(route);
 
 	nbr = net_route_get_nbr(route);
 	if (!nbr) {
@@ -464,11 +791,13 @@ int net_route_del(struct net_route_entry *route)
 	net_route_info("Deleted", route, &route->addr);
 
 	SYS_SLIST_FOR_EACH_CONTAINER(&route->nexthop, nexthop_route, node) {
-		if (!nexthop_route->nbr) {
-			continue;
+		if (nexthop_route->nbr) {
+			nbr_nexthop_put(nexthop_route->nbr);
 		}
 
-		nbr_nexthop_put(nexthop_route->nbr);
+		/* Give the entry back to the nexthop pool */
+		net_nbr_unref(CONTAINER_OF((uint8_t *)nexthop_route,
+					   struct net_nbr, __nbr));
 	}
 
 	nbr_free(nbr);
@@ -15,6 +15,7 @@
 
 #include <kernel.h>
 #include <sys/slist.h>
+#include <sys/dlist.h>
 
 #include <net/net_ip.h>
 
@@ -46,7 +47,7 @@ struct net_route_entry {
 	 * we can remove it if we run out of available routes.
 	 * The oldest one is the last entry in the list.
 	 */
-	sys_snode_t node;
+	sys_dnode_t node;
 
 	/** List of neighbors that the routes go through. */
 	sys_slist_t nexthop;
@@ -57,6 +58,9 @@ struct net_route_entry {
 	/** IPv6 address/prefix of the route. */
 	struct in6_addr addr;
 
+	/** Next route with the same prefix, on another interface. */
+	struct net_route_entry *lpm_next;
+
 	/** IPv6 address/prefix length. */
 	uint8_t prefix_len;
 };
@@ -714,6 +714,7 @@ static int tcp_data_get(struct tcp *conn, struct net_pkt *pkt, size_t *len)
 		struct net_pkt *up = tcp_pkt_clone(pkt);
 
 		if (!up) {
+			net_stats_update_context_drop(conn->context);
 			ret = -ENOBUFS;
 			goto out;
 		}
@@ -815,6 +816,8 @@ static int tcp_out_ext(struct tcp *conn, uint8_t flags, struct net_pkt *data,
 		/* Append the data buffer to the pkt */
 		net_pkt_append_buffer(pkt, data->buffer);
 		data->buffer = NULL;
+
+		net_pkt_set_gso_size(pkt, net_pkt_gso_size(data));
 	}
 
 	ret = ip_header_add(conn, pkt);
@@ -915,18 +918,67 @@ static int tcp_unsent_len(struct tcp *conn)
 	return unsent_len;
 }
 
+#if defined(CONFIG_NET_TCP_GSO)
+/* Allocate the data of a large packet without waiting, the data is only
+ * limited by the number of free buffers and not by the MTU.
+ */
+static struct net_pkt *tcp_gso_pkt_alloc(struct tcp *conn, size_t len,
+					 uint16_t gso_size)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_on_iface(conn->iface, K_NO_WAIT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	net_pkt_set_family(pkt, net_context_get_family(conn->context));
+	net_pkt_set_gso_size(pkt, gso_size);
+
+	if (net_pkt_alloc_buffer(pkt, len, IPPROTO_TCP, K_NO_WAIT) < 0) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	tp_pkt_alloc(pkt, tp_basename(__FILE__), __LINE__);
+
+	return pkt;
+}
+#endif
+
 static int tcp_send_data(struct tcp *conn)
 {
 	int ret = 0;
 	int pos, len;
-	struct net_pkt *pkt;
+	struct net_pkt *pkt = NULL;
+	int mss = conn_mss(conn);
+	int max_len = mss;
+
+#if defined(CONFIG_NET_TCP_GSO)
+	if (net_if_flag_is_set(conn->iface, NET_IF_GSO)) {
+		max_len = mss * CONFIG_NET_TCP_GSO_MAX_SEGS;
+	}
+#endif
 
 	pos = conn->unacked_len;
 	len = MIN3(conn->send_data_total - conn->unacked_len,
 		   conn->send_win - conn->unacked_len,
-		   conn_mss(conn));
+		   max_len);
+
+#if defined(CONFIG_NET_TCP_GSO)
+	if (len > mss) {
+		pkt = tcp_gso_pkt_alloc(conn, len, mss);
+		if (!pkt) {
+			/* Not enough free buffers, send one segment */
+			len = mss;
+		}
+	}
+#endif
+
+	if (!pkt) {
+		pkt = tcp_pkt_alloc(conn, len);
+	}
 
-	pkt = tcp_pkt_alloc(conn, len);
 	if (!pkt) {
 		NET_ERR("conn: %p packet allocation failed, len=%d", conn, len);
 		ret = -ENOBUFS;
@@ -947,9 +999,15 @@ static int tcp_send_data(struct tcp *conn)
 		if (conn->data_mode == TCP_DATA_MODE_RESEND) {
 			net_stats_update_tcp_resent(conn->iface, len);
 			net_stats_update_tcp_seg_rexmit(conn->iface);
+			net_stats_update_context_resent(conn->context, len);
 		} else {
 			net_stats_update_tcp_sent(conn->iface, len);
-			net_stats_update_tcp_seg_sent(conn->iface);
+			net_stats_update_context_sent(conn->context, len,
+						      ceiling_fraction(len, mss));
+
+			for (; len > 0; len -= mss) {
+				net_stats_update_tcp_seg_sent(conn->iface);
+			}
 		}
 	}
 
@@ -1457,6 +1515,11 @@ static struct tcp *tcp_conn_new(struct net_pkt *pkt)
 		goto err;
 	}
 
+	/* The bind above picks a free port as the listener owns the local
+	 * one, set the real local port so that the context can be identified.
+	 */
+	net_sin_ptr(&context->local)->sin_port = conn->src.sin.sin_port;
+
 	if (!(IS_ENABLED(CONFIG_NET_TEST_PROTOCOL) ||
 	      IS_ENABLED(CONFIG_NET_TEST))) {
 		conn->seq = tcp_init_isn(&local_addr, &context->remote);
@@ -2383,13 +2446,381 @@ int net_tcp_finalize(struct net_pkt *pkt)
 
 	tcp_hdr->chksum = 0U;
 
-	if (net_if_need_calc_tx_checksum(net_pkt_iface(pkt))) {
+	/* The checksum of a large packet is computed for each segment */
+	if (net_if_need_calc_tx_checksum(net_pkt_iface(pkt)) &&
+	    !net_pkt_gso_size(pkt)) {
 		tcp_hdr->chksum = net_calc_chksum_tcp(pkt);
 	}
 
 	return net_pkt_set_data(pkt, &tcp_access);
 }
 
+#if defined(CONFIG_NET_TCP_GSO)
+static struct net_pkt *tcp_gso_segment(struct net_pkt *pkt, size_t hdr_len,
+				       struct net_pkt_cursor *data,
+				       size_t offset, size_t len, bool last)
+{
+	struct net_pkt *seg;
+	struct tcphdr *th;
+	uint8_t flags;
+
+	seg = net_pkt_alloc_with_buffer(net_pkt_iface(pkt), hdr_len + len,
+					AF_UNSPEC, 0, TCP_PKT_ALLOC_TIMEOUT);
+	if (!seg) {
+		return NULL;
+	}
+
+	net_pkt_set_family(seg, net_pkt_family(pkt));
+	net_pkt_set_ip_hdr_len(seg, net_pkt_ip_hdr_len(pkt));
+	net_pkt_set_priority(seg, net_pkt_priority(pkt));
+	net_pkt_set_vlan_tag(seg, net_pkt_vlan_tag(pkt));
+	memcpy(&seg->lladdr_src, &pkt->lladdr_src, sizeof(seg->lladdr_src));
+	memcpy(&seg->lladdr_dst, &pkt->lladdr_dst, sizeof(seg->lladdr_dst));
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
+		net_pkt_set_ipv4_opts_len(seg, net_pkt_ipv4_opts_len(pkt));
+	} else {
+		net_pkt_set_ipv6_ext_len(seg, net_pkt_ipv6_ext_len(pkt));
+	}
+
+	/* Headers, then the next chunk of the payload */
+	net_pkt_cursor_init(pkt);
+
+	if (net_pkt_copy(seg, pkt, hdr_len)) {
+		goto fail;
+	}
+
+	net_pkt_cursor_restore(pkt, data);
+
+	if (net_pkt_copy(seg, pkt, len)) {
+		goto fail;
+	}
+
+	net_pkt_cursor_backup(pkt, data);
+
+	th = th_get(seg);
+	if (!th) {
+		goto fail;
+	}
+
+	UNALIGNED_PUT(htonl(th_seq(th) + offset), &th->th_seq);
+
+	if (!last) {
+		flags = th_flags(th) & ~(PSH | FIN);
+		UNALIGNED_PUT(flags, &th->th_flags);
+	}
+
+	if (tcp_finalize_pkt(seg) < 0) {
+		goto fail;
+	}
+
+	return seg;
+
+fail:
+	net_pkt_unref(seg);
+	return NULL;
+}
+
+int net_tcp_gso_send(struct net_pkt *pkt,
+		     int (*send)(struct net_if *iface, struct net_pkt *pkt))
+{
+	size_t seg_size = net_pkt_gso_size(pkt);
+	struct net_pkt_cursor data;
+	size_t hdr_len, data_len;
+	size_t offset = 0;
+	struct tcphdr *th;
+	int ret = -EINVAL;
+	int total = 0;
+
+	th = th_get(pkt);
+	if (!th) {
+		return -ENOBUFS;
+	}
+
+	hdr_len = net_pkt_ip_hdr_len(pkt) + net_pkt_ip_opts_len(pkt) +
+		th_off(th) * 4U;
+	data_len = net_pkt_get_len(pkt) - hdr_len;
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+	net_pkt_skip(pkt, hdr_len);
+	net_pkt_cursor_backup(pkt, &data);
+
+	while (offset < data_len) {
+		size_t len = MIN(seg_size, data_len - offset);
+		struct net_pkt *seg;
+
+		seg = tcp_gso_segment(pkt, hdr_len, &data, offset, len,
+				      offset + len == data_len);
+		if (!seg) {
+			ret = -ENOBUFS;
+			goto out;
+		}
+
+		ret = send(net_pkt_iface(pkt), seg);
+		if (ret < 0) {
+			net_pkt_unref(seg);
+			goto out;
+		}
+
+		total += ret;
+		offset += len;
+	}
+
+out:
+	/* If some segments were sent, the rest is resent by TCP as if it
+	 * was lost on the way. Otherwise the caller drops the packet.
+	 */
+	if (offset == 0U) {
+		return ret;
+	}
+
+	net_pkt_unref(pkt);
+
+	return total;
+}
+#endif /* CONFIG_NET_TCP_GSO */
+
+#if defined(CONFIG_NET_TCP_GRO)
+struct tcp_gro {
+	/* Segments merged so far, NULL if the slot is free */
+	struct net_pkt *pkt;
+	/* RX thread which merges and flushes this flow */
+	k_tid_t owner;
+	union tcp_endpoint src;
+	union tcp_endpoint dst;
+	/* Sequence number of the next in-order segment */
+	uint32_t seq;
+	uint32_t ack;
+	uint32_t held_at;
+	uint16_t win;
+	uint8_t segs;
+};
+
+static struct tcp_gro tcp_gro_flows[CONFIG_NET_TCP_GRO_FLOWS];
+static struct k_spinlock tcp_gro_lock;
+
+static void tcp_gro_deliver(struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(tcp_access, struct net_tcp_hdr);
+	union net_proto_header proto_hdr;
+	union net_ip_header ip;
+
+	if (IS_ENABLED(CONFIG_NET_IPV4) && net_pkt_family(pkt) == AF_INET) {
+		ip.ipv4 = NET_IPV4_HDR(pkt);
+	} else {
+		ip.ipv6 = NET_IPV6_HDR(pkt);
+	}
+
+	/* Same state as after net_tcp_input() */
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	if (net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) +
+			 net_pkt_ip_opts_len(pkt))) {
+		goto drop;
+	}
+
+	proto_hdr.tcp = (struct net_tcp_hdr *)net_pkt_get_data(pkt,
+								&tcp_access);
+	if (!proto_hdr.tcp || net_pkt_set_data(pkt, &tcp_access)) {
+		goto drop;
+	}
+
+	if (net_conn_input(pkt, &ip, IPPROTO_TCP, &proto_hdr) != NET_DROP) {
+		return;
+	}
+
+drop:
+	net_pkt_unref(pkt);
+}
+
+/* Append the payload of pkt to the segments held in gro */
+static void tcp_gro_merge(struct tcp_gro *gro, struct net_pkt *pkt,
+			  size_t hdr_len, uint8_t flags)
+{
+	struct net_pkt *head = gro->pkt;
+	size_t len;
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+	net_pkt_pull(pkt, hdr_len);
+
+	net_pkt_append_buffer(head, pkt->buffer);
+	pkt->buffer = NULL;
+	net_pkt_unref(pkt);
+
+	len = net_pkt_get_len(head);
+
+#if defined(CONFIG_NET_IPV4)
+	if (net_pkt_family(head) == AF_INET) {
+		NET_IPV4_HDR(head)->len = htons(len);
+		NET_IPV4_HDR(head)->chksum = 0U;
+		NET_IPV4_HDR(head)->chksum = net_calc_chksum_ipv4(head);
+	} else
+#endif
+	{
+		NET_IPV6_HDR(head)->len = htons(len - NET_IPV6H_LEN);
+	}
+
+	if (flags & PSH) {
+		struct tcphdr *th = th_get(head);
+
+		if (th) {
+			UNALIGNED_PUT(th_flags(th) | PSH, &th->th_flags);
+		}
+	}
+}
+
+bool net_tcp_gro_receive(struct net_pkt *pkt)
+{
+	struct net_pkt *flush = NULL;
+	struct tcp_gro *gro = NULL;
+	union tcp_endpoint src, dst;
+	bool consumed = false;
+	k_tid_t owner = k_current_get();
+	struct net_pkt_cursor backup;
+	size_t hdr_len, data_len;
+	struct tcphdr *th;
+	k_spinlock_key_t key;
+	bool mergeable;
+	uint8_t flags;
+	uint32_t seq;
+	int i;
+
+	/* Only the RX queue threads flush the held segments */
+	if (!net_if_flag_is_set(net_pkt_iface(pkt), NET_IF_GRO) ||
+	    !net_tc_rx_thread_is_current()) {
+		return false;
+	}
+
+	net_pkt_cursor_backup(pkt, &backup);
+
+	th = th_get(pkt);
+	if (!th || tcp_endpoint_set(&src, pkt, TCP_EP_SRC) ||
+	    tcp_endpoint_set(&dst, pkt, TCP_EP_DST)) {
+		net_pkt_cursor_restore(pkt, &backup);
+		return false;
+	}
+
+	flags = th_flags(th);
+	seq = th_seq(th);
+	hdr_len = net_pkt_ip_hdr_len(pkt) + net_pkt_ip_opts_len(pkt) +
+		th_off(th) * 4U;
+	data_len = net_pkt_get_len(pkt) - hdr_len;
+
+	/* Plain data segments only, segments with TCP options are not
+	 * merged as the options may differ.
+	 */
+	mergeable = (flags & ~PSH) == ACK && th_off(th) == 5U &&
+		net_pkt_ip_opts_len(pkt) == 0U && data_len > 0U;
+
+	key = k_spin_lock(&tcp_gro_lock);
+
+	for (i = 0; i < ARRAY_SIZE(tcp_gro_flows); i++) {
+		if (tcp_gro_flows[i].pkt && tcp_gro_flows[i].owner == owner &&
+		    !memcmp(&tcp_gro_flows[i].src, &src,
+			    tcp_endpoint_len(src.sa.sa_family)) &&
+		    !memcmp(&tcp_gro_flows[i].dst, &dst,
+			    tcp_endpoint_len(dst.sa.sa_family))) {
+			gro = &tcp_gro_flows[i];
+			break;
+		}
+	}
+
+	if (gro) {
+		if (mergeable && seq == gro->seq && th_ack(th) == gro->ack &&
+		    th_win(th) == gro->win &&
+		    net_pkt_get_len(gro->pkt) + data_len <= UINT16_MAX) {
+			tcp_gro_merge(gro, pkt, hdr_len, flags);
+			consumed = true;
+
+			gro->seq += data_len;
+
+			if (!(flags & PSH) &&
+			    ++gro->segs < CONFIG_NET_TCP_GRO_MAX_SEGS) {
+				goto out;
+			}
+		}
+
+		/* Anything else for this flow must come after the segments
+		 * held so far.
+		 */
+		flush = gro->pkt;
+		gro->pkt = NULL;
+
+		if (consumed) {
+			goto out;
+		}
+	}
+
+	if (!mergeable || (flags & PSH)) {
+		goto out;
+	}
+
+	for (i = 0; !gro && i < ARRAY_SIZE(tcp_gro_flows); i++) {
+		if (!tcp_gro_flows[i].pkt) {
+			gro = &tcp_gro_flows[i];
+		}
+	}
+
+	if (gro) {
+		gro->pkt = pkt;
+		gro->owner = owner;
+		gro->src = src;
+		gro->dst = dst;
+		gro->seq = seq + data_len;
+		gro->ack = th_ack(th);
+		gro->win = th_win(th);
+		gro->segs = 1U;
+		gro->held_at = k_uptime_get_32();
+		consumed = true;
+	}
+
+out:
+	k_spin_unlock(&tcp_gro_lock, key);
+
+	if (flush) {
+		tcp_gro_deliver(flush);
+	}
+
+	if (!consumed) {
+		/* Back to where net_tcp_input() left it */
+		net_pkt_cursor_restore(pkt, &backup);
+	}
+
+	return consumed;
+}
+
+void net_tcp_gro_flush(bool all)
+{
+	k_tid_t owner = k_current_get();
+	uint32_t now = k_uptime_get_32();
+	struct net_pkt *pkt;
+	k_spinlock_key_t key;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tcp_gro_flows); i++) {
+		key = k_spin_lock(&tcp_gro_lock);
+
+		pkt = tcp_gro_flows[i].pkt;
+
+		if (pkt && tcp_gro_flows[i].owner == owner &&
+		    (all || now != tcp_gro_flows[i].held_at)) {
+			tcp_gro_flows[i].pkt = NULL;
+		} else {
+			pkt = NULL;
+		}
+
+		k_spin_unlock(&tcp_gro_lock, key);
+
+		if (pkt) {
+			tcp_gro_deliver(pkt);
+		}
+	}
+}
+#endif /* CONFIG_NET_TCP_GRO */
+
 struct net_tcp_hdr *net_tcp_input(struct net_pkt *pkt,
 				  struct net_pkt_data_access *tcp_access)
 {
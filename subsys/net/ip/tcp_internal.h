@@ -272,6 +272,73 @@ static inline int net_tcp_finalize(struct net_pkt *pkt)
 }
 #endif
 
+/**
+ * @brief Split a large TCP packet into segments and send them
+ *
+ * @details The packet was built by TCP with a payload of several MSS
+ * (see net_pkt_gso_size()). Each segment gets a copy of the headers with
+ * the sequence number, length and checksum updated.
+ *
+ * @param pkt Network packet, unreferenced if any segment was sent
+ * @param send L2 send function called for each segment
+ *
+ * @return Number of bytes sent, negative errno if nothing was sent.
+ */
+#if defined(CONFIG_NET_TCP_GSO)
+int net_tcp_gso_send(struct net_pkt *pkt,
+		     int (*send)(struct net_if *iface, struct net_pkt *pkt));
+#else
+static inline int net_tcp_gso_send(struct net_pkt *pkt,
+				   int (*send)(struct net_if *iface,
+					       struct net_pkt *pkt))
+{
+	ARG_UNUSED(pkt);
+	ARG_UNUSED(send);
+
+	return -ENOTSUP;
+}
+#endif
+
+/**
+ * @brief Hold or merge a received TCP segment
+ *
+ * @details Called for a validated TCP packet before it is given to the
+ * connection. In-order data segments of the same connection are merged
+ * and handed over as one packet when the RX queue becomes empty, when a
+ * segment which cannot be merged arrives, or after
+ * CONFIG_NET_TCP_GRO_MAX_SEGS segments.
+ *
+ * @param pkt Network packet
+ *
+ * @return True if the packet was consumed, false if it is to be
+ * processed as usual.
+ */
+#if defined(CONFIG_NET_TCP_GRO)
+bool net_tcp_gro_receive(struct net_pkt *pkt);
+#else
+static inline bool net_tcp_gro_receive(struct net_pkt *pkt)
+{
+	ARG_UNUSED(pkt);
+
+	return false;
+}
+#endif
+
+/**
+ * @brief Hand over the segments held by the current RX thread
+ *
+ * @param all Flush everything if true, otherwise only the segments which
+ * have been held for a while.
+ */
+#if defined(CONFIG_NET_TCP_GRO)
+void net_tcp_gro_flush(bool all);
+#else
+static inline void net_tcp_gro_flush(bool all)
+{
+	ARG_UNUSED(all);
+}
+#endif
+
 /**
  * @brief Get pointer to TCP header in net_pkt
  *
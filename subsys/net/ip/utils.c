@@ -487,32 +487,85 @@ int z_vrfy_net_addr_pton(sa_family_t family, const char *src,
 #include <syscalls/net_addr_pton_mrsh.c>
 #endif /* CONFIG_USERSPACE */
 
+static inline uint16_t chksum_add(uint16_t sum, uint16_t val)
+{
+	sum += val;
+	if (sum < val) {
+		sum++;
+	}
+
+	return sum;
+}
+
+/* Sum the data as native endian words. The one's complement sum does not
+ * depend on the byte order, so the result is only swapped once at the end
+ * instead of byte swapping every 16-bit word.
+ */
 static uint16_t calc_chksum(uint16_t sum, const uint8_t *data, size_t len)
 {
-	const uint8_t *end;
+	uint64_t acc = 0U;
+	bool odd = false;
 	uint16_t tmp;
 
-	end = data + len - 1;
+	if (!len) {
+		return sum;
+	}
 
-	while (data < end) {
-		tmp = (data[0] << 8) + data[1];
-		sum += tmp;
-		if (sum < tmp) {
-			sum++;
-		}
+	/* Starting at an odd address shifts every byte to the other half of
+	 * the 16-bit words, which swaps the bytes of the final sum.
+	 */
+	if ((uintptr_t)data & 1U) {
+		((uint8_t *)&tmp)[0] = 0U;
+		((uint8_t *)&tmp)[1] = *data++;
+		acc += tmp;
+		odd = true;
+		len--;
+	}
 
+	if (((uintptr_t)data & 2U) && len >= 2U) {
+		acc += *(const uint16_t *)data;
 		data += 2;
+		len -= 2U;
 	}
 
-	if (data == end) {
-		tmp = data[0] << 8;
-		sum += tmp;
-		if (sum < tmp) {
-			sum++;
-		}
+	while (len >= 16U) {
+		acc += ((const uint32_t *)data)[0];
+		acc += ((const uint32_t *)data)[1];
+		acc += ((const uint32_t *)data)[2];
+		acc += ((const uint32_t *)data)[3];
+		data += 16;
+		len -= 16U;
 	}
 
-	return sum;
+	while (len >= 4U) {
+		acc += *(const uint32_t *)data;
+		data += 4;
+		len -= 4U;
+	}
+
+	if (len >= 2U) {
+		acc += *(const uint16_t *)data;
+		data += 2;
+		len -= 2U;
+	}
+
+	if (len) {
+		((uint8_t *)&tmp)[0] = *data;
+		((uint8_t *)&tmp)[1] = 0U;
+		acc += tmp;
+	}
+
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffffffff) + (acc >> 32);
+	acc = (acc & 0xffff) + (acc >> 16);
+	acc = (acc & 0xffff) + (acc >> 16);
+
+	tmp = acc;
+	if (odd) {
+		tmp = __bswap_16(tmp);
+	}
+
+	return chksum_add(sum, ntohs(tmp));
 }
 
 static inline uint16_t pkt_calc_chksum(struct net_pkt *pkt, uint16_t sum)
@@ -537,11 +590,7 @@ static inline uint16_t pkt_calc_chksum(struct net_pkt *pkt, uint16_t sum)
 		cur->pos = cur->buf->data;
 
 		if (len % 2) {
-			sum += *cur->pos;
-			if (sum < *cur->pos) {
-				sum++;
-			}
-
+			sum = chksum_add(sum, *cur->pos);
 			cur->pos++;
 			len = cur->buf->len - 1;
 		} else {
@@ -627,6 +676,19 @@ uint16_t net_calc_chksum_igmp(uint8_t *data, size_t len)
 }
 #endif /* CONFIG_NET_IPV4_IGMP */
 
+uint16_t net_chksum_update(uint16_t chksum, const uint8_t *old_data,
+			   const uint8_t *new_data, size_t len)
+{
+	uint16_t sum;
+
+	/* RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m') */
+	sum = ~ntohs(chksum);
+	sum = chksum_add(sum, ~calc_chksum(0U, old_data, len));
+	sum = calc_chksum(sum, new_data, len);
+
+	return htons(~sum);
+}
+
 #if defined(CONFIG_NET_IPV6) || defined(CONFIG_NET_IPV4)
 static bool convert_port(const char *buf, uint16_t *port)
 {
@@ -478,18 +478,41 @@ static void set_vlan_priority(struct ethernet_context *ctx,
 
 static struct net_buf *ethernet_fill_header(struct ethernet_context *ctx,
 					    struct net_pkt *pkt,
-					    uint32_t ptype)
+					    uint32_t ptype,
+					    size_t *pushed)
 {
 	struct net_buf *hdr_frag;
 	struct net_eth_hdr *hdr;
+	size_t hdr_len;
+	bool vlan;
 
-	hdr_frag = net_pkt_get_frag(pkt, NET_BUF_TIMEOUT);
-	if (!hdr_frag) {
-		return NULL;
+	vlan = IS_ENABLED(CONFIG_NET_VLAN) &&
+	       net_eth_is_vlan_enabled(ctx, net_pkt_iface(pkt));
+	hdr_len = vlan ? sizeof(struct net_eth_vlan_hdr) :
+			 sizeof(struct net_eth_hdr);
+
+	/* Use the room left in front of the IP header when the packet was
+	 * allocated, if any, so that the headers stay contiguous. A buffer
+	 * shared with a clone is left untouched.
+	 */
+	if (IS_ENABLED(CONFIG_NET_PKT_L2_HEADROOM) && pkt->buffer &&
+	    pkt->buffer->ref == 1 &&
+	    net_buf_headroom(pkt->buffer) >= hdr_len) {
+		hdr_frag = pkt->buffer;
+		net_buf_push(hdr_frag, hdr_len);
+		*pushed = hdr_len;
+	} else {
+		hdr_frag = net_pkt_get_frag(pkt, NET_BUF_TIMEOUT);
+		if (!hdr_frag) {
+			return NULL;
+		}
+
+		net_buf_add(hdr_frag, hdr_len);
+		net_pkt_frag_insert(pkt, hdr_frag);
+		*pushed = 0;
 	}
 
-	if (IS_ENABLED(CONFIG_NET_VLAN) &&
-	    net_eth_is_vlan_enabled(ctx, net_pkt_iface(pkt))) {
+	if (vlan) {
 		struct net_eth_vlan_hdr *hdr_vlan;
 
 		hdr_vlan = (struct net_eth_vlan_hdr *)(hdr_frag->data);
@@ -506,11 +529,10 @@ static struct net_buf *ethernet_fill_header(struct ethernet_context *ctx,
 		hdr_vlan->type = ptype;
 		hdr_vlan->vlan.tpid = htons(NET_ETH_PTYPE_VLAN);
 		hdr_vlan->vlan.tci = htons(net_pkt_vlan_tci(pkt));
-		net_buf_add(hdr_frag, sizeof(struct net_eth_vlan_hdr));
 
 		print_vlan_ll_addrs(pkt, ntohs(hdr_vlan->type),
 				    net_pkt_vlan_tci(pkt),
-				    hdr_frag->len,
+				    hdr_len,
 				    &hdr_vlan->src, &hdr_vlan->dst, false);
 	} else {
 		hdr = (struct net_eth_hdr *)(hdr_frag->data);
@@ -525,14 +547,11 @@ static struct net_buf *ethernet_fill_header(struct ethernet_context *ctx,
 		       sizeof(struct net_eth_addr));
 
 		hdr->type = ptype;
-		net_buf_add(hdr_frag, sizeof(struct net_eth_hdr));
 
 		print_ll_addrs(pkt, ntohs(hdr->type),
-			       hdr_frag->len, &hdr->src, &hdr->dst);
+			       hdr_len, &hdr->src, &hdr->dst);
 	}
 
-	net_pkt_frag_insert(pkt, hdr_frag);
-
 	return hdr_frag;
 }
 
@@ -554,10 +573,15 @@ static void ethernet_update_tx_stats(struct net_if *iface, struct net_pkt *pkt)
 #define ethernet_update_tx_stats(...)
 #endif /* CONFIG_NET_STATISTICS_ETHERNET */
 
-static void ethernet_remove_l2_header(struct net_pkt *pkt)
+static void ethernet_remove_l2_header(struct net_pkt *pkt, size_t pushed)
 {
 	struct net_buf *buf;
 
+	if (pushed) {
+		net_buf_pull(pkt->buffer, pushed);
+		return;
+	}
+
 	/* Remove the buffer added in ethernet_fill_header() */
 	buf = pkt->buffer;
 	pkt->buffer = buf->frags;
@@ -570,6 +594,7 @@ static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 {
 	const struct ethernet_api *api = net_if_get_device(iface)->api;
 	struct ethernet_context *ctx = net_if_l2_data(iface);
+	size_t pushed = 0;
 	uint16_t ptype;
 	int ret;
 
@@ -662,7 +687,7 @@ static int ethernet_send(struct net_if *iface, struct net_pkt *pkt)
 
 	/* Then set the ethernet header.
 	 */
-	if (!ethernet_fill_header(ctx, pkt, ptype)) {
+	if (!ethernet_fill_header(ctx, pkt, ptype, &pushed)) {
 		ret = -ENOMEM;
 		goto error;
 	}
@@ -673,14 +698,14 @@ send:
 	ret = net_l2_send(api->send, net_if_get_device(iface), iface, pkt);
 	if (ret != 0) {
 		eth_stats_update_errors_tx(iface);
-		ethernet_remove_l2_header(pkt);
+		ethernet_remove_l2_header(pkt, pushed);
 		goto error;
 	}
 
 	ethernet_update_tx_stats(iface, pkt);
 
 	ret = net_pkt_get_len(pkt);
-	ethernet_remove_l2_header(pkt);
+	ethernet_remove_l2_header(pkt, pushed);
 
 	net_pkt_unref(pkt);
 error:
@@ -122,12 +122,9 @@ static inline void set_pkt_ll_addr(struct net_linkaddr *addr, bool comp,
 #ifdef CONFIG_NET_6LO
 static inline
 enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
-					       struct net_pkt *pkt,
-					       size_t hdr_len)
+					       struct net_pkt *pkt)
 {
 	enum net_verdict verdict = NET_CONTINUE;
-	uint32_t src;
-	uint32_t dst;
 
 	/* Upper IP stack expects the link layer address to be in
 	 * big endian format so we must swap it here.
@@ -144,16 +141,11 @@ enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
 			     net_pkt_lladdr_dst(pkt)->len);
 	}
 
-	/** Uncompress will drop the current fragment. Pkt ll src/dst address
-	 * will then be wrong and must be updated according to the new fragment.
+	/* The ll src/dst addresses point to the L2 header of this frame.
+	 * Uncompress and reassembly keep the buffer of the frame in the
+	 * packet, and uncompress does not overwrite the addresses, so they
+	 * stay valid.
 	 */
-	src = net_pkt_lladdr_src(pkt)->addr ?
-		net_pkt_lladdr_src(pkt)->addr -
-		(net_pkt_data(pkt) - hdr_len) : 0;
-	dst = net_pkt_lladdr_dst(pkt)->addr ?
-		net_pkt_lladdr_dst(pkt)->addr -
-		(net_pkt_data(pkt) - hdr_len) : 0;
-
 #ifdef CONFIG_NET_L2_IEEE802154_FRAGMENT
 	verdict = ieee802154_reassemble(pkt);
 	if (verdict != NET_CONTINUE) {
@@ -166,11 +158,6 @@ enum net_verdict ieee802154_manage_recv_packet(struct net_if *iface,
 		goto out;
 	}
 #endif
-	net_pkt_lladdr_src(pkt)->addr = src ?
-		(net_pkt_data(pkt) - hdr_len) + src : NULL;
-	net_pkt_lladdr_dst(pkt)->addr = dst ?
-		(net_pkt_data(pkt) - hdr_len) + dst : NULL;
-
 	pkt_hexdump(RX_PKT_TITLE, pkt, true);
 out:
 	return verdict;
@@ -226,7 +213,7 @@ static enum net_verdict ieee802154_recv(struct net_if *iface,
 	hdr_len = (uint8_t *)mpdu.payload - net_pkt_data(pkt);
 	net_buf_pull(pkt->buffer, hdr_len);
 
-	return ieee802154_manage_recv_packet(iface, pkt, hdr_len);
+	return ieee802154_manage_recv_packet(iface, pkt);
 
 }
 
@@ -441,8 +441,10 @@ static inline void fragment_remove_headers(struct net_pkt *pkt)
 			hdr_len = NET_6LO_FRAG1_HDR_LEN;
 		}
 
-		memmove(frag->data, frag->data + hdr_len, frag->len - hdr_len);
-		frag->len -= hdr_len;
+		/* The room left in front is then used by 6lo to uncompress
+		 * the headers without moving the data.
+		 */
+		net_buf_pull(frag, hdr_len);
 
 		frag = frag->frags;
 	}
@@ -50,6 +50,11 @@ NET_BUF_POOL_VAR_DEFINE(capture_bufs, CONFIG_NET_CAPTURE_BUF_COUNT,
 
 static sys_slist_t net_capture_devlist;
 
+/* Number of capture devices enabled, lets the packets skip the lock when
+ * nothing is tunnelled.
+ */
+static atomic_t enabled_count;
+
 struct net_capture {
 	sys_snode_t node;
 
@@ -491,6 +496,7 @@ static int capture_enable(const struct device *dev, struct net_if *iface)
 
 	ctx->capture_iface = iface;
 	ctx->is_enabled = true;
+	atomic_inc(&enabled_count);
 
 	net_if_up(ctx->tunnel_iface);
 
@@ -501,6 +507,10 @@ static int capture_disable(const struct device *dev)
 {
 	struct net_capture *ctx = DEV_DATA(dev);
 
+	if (ctx->is_enabled) {
+		atomic_dec(&enabled_count);
+	}
+
 	ctx->capture_iface = NULL;
 	ctx->is_enabled = false;
 
@@ -522,6 +532,12 @@ void net_capture_pkt(struct net_if *iface, struct net_pkt *pkt)
 		return;
 	}
 
+	net_capture_file_pkt(iface, pkt);
+
+	if (!atomic_get(&enabled_count)) {
+		return;
+	}
+
 	k_mutex_lock(&lock, K_FOREVER);
 
 	SYS_SLIST_FOR_EACH_NODE_SAFE(&net_capture_devlist, sn, sns) {
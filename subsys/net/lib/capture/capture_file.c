@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_capture, CONFIG_NET_CAPTURE_LOG_LEVEL);
+
+#include <zephyr.h>
+#include <kernel_structs.h>
+#include <string.h>
+#include <fs/fs.h>
+#include <net/net_if.h>
+#include <net/net_l2.h>
+#include <net/net_pkt.h>
+#include <net/capture.h>
+
+#define RING_SIZE CONFIG_NET_CAPTURE_FILE_RING_SIZE
+#define SNAPLEN_MAX CONFIG_NET_CAPTURE_FILE_SNAPLEN
+
+BUILD_ASSERT((RING_SIZE & (RING_SIZE - 1)) == 0,
+	     "Capture ring size must be a power of two");
+
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_IEEE802_15_4_NOFCS 230
+
+struct pcapng_shb {
+	uint32_t type;
+	uint32_t len;
+	uint32_t magic;
+	uint16_t major;
+	uint16_t minor;
+	int64_t section_len;
+	uint32_t len_trailer;
+} __packed;
+
+struct pcapng_idb {
+	uint32_t type;
+	uint32_t len;
+	uint16_t link_type;
+	uint16_t reserved;
+	uint32_t snaplen;
+	uint32_t len_trailer;
+} __packed;
+
+/* Followed by the packet data padded to 32 bits and the block length */
+struct pcapng_epb {
+	uint32_t type;
+	uint32_t len;
+	uint32_t if_id;
+	uint32_t ts_high;
+	uint32_t ts_low;
+	uint32_t cap_len;
+	uint32_t orig_len;
+} __packed;
+
+/* Record in a capture ring, followed by the captured data. The free part
+ * of a ring is kept zeroed, so that a record is complete once its length
+ * is not 0 anymore. A record without data pads the end of the ring.
+ */
+struct record {
+	atomic_t len;
+	uint32_t cap_len;
+	uint32_t orig_len;
+	uint64_t timestamp;
+};
+
+#define RECORD_ALIGN 8
+
+/* Filled by any thread capturing on its CPU, drained by the capture
+ * thread. head and tail are free running byte counters.
+ */
+struct ring {
+	atomic_t head;
+	atomic_t tail;
+	uint8_t buf[RING_SIZE] __aligned(RECORD_ALIGN);
+};
+
+static struct ring rings[CONFIG_MP_NUM_CPUS];
+
+static struct {
+	struct fs_file_t file;
+	struct net_if *iface;
+	uint32_t snaplen;
+	atomic_t active;
+	/* Threads currently writing to a ring */
+	atomic_t writers;
+	atomic_t captured;
+	atomic_t dropped;
+	size_t written;
+	int error;
+	bool stop;
+} session;
+
+static uint8_t block[sizeof(struct pcapng_epb) + ROUND_UP(SNAPLEN_MAX, 4) +
+		     sizeof(uint32_t)];
+
+static K_MUTEX_DEFINE(lock);
+static K_SEM_DEFINE(drain_sem, 0, 1);
+
+K_KERNEL_STACK_DEFINE(drain_stack, CONFIG_NET_CAPTURE_FILE_STACK_SIZE);
+static struct k_thread drain_thread;
+
+static inline struct ring *current_ring(void)
+{
+#if CONFIG_MP_NUM_CPUS > 1
+	/* Moving to another CPU meanwhile is fine, only contention is */
+	return &rings[arch_curr_cpu()->id];
+#else
+	return &rings[0];
+#endif
+}
+
+static inline size_t ring_used(struct ring *ring)
+{
+	return (unsigned long)atomic_get(&ring->head) -
+		(unsigned long)atomic_get(&ring->tail);
+}
+
+void net_capture_file_pkt(struct net_if *iface, struct net_pkt *pkt)
+{
+	size_t orig_len, cap_len, need, pad, off;
+	struct net_buf *buf;
+	struct record *rec;
+	atomic_val_t head;
+	struct ring *ring;
+	uint8_t *data;
+
+	if (!atomic_get(&session.active)) {
+		return;
+	}
+
+	atomic_inc(&session.writers);
+
+	if (!atomic_get(&session.active) || session.iface != iface) {
+		goto out;
+	}
+
+	orig_len = net_pkt_get_len(pkt);
+	if (orig_len == 0) {
+		goto out;
+	}
+
+	cap_len = MIN(orig_len, session.snaplen);
+	need = ROUND_UP(sizeof(*rec) + cap_len, RECORD_ALIGN);
+	ring = current_ring();
+
+	do {
+		head = atomic_get(&ring->head);
+		off = head & (RING_SIZE - 1);
+		pad = RING_SIZE - off < need ? RING_SIZE - off : 0;
+
+		if ((unsigned long)head - (unsigned long)atomic_get(&ring->tail) +
+		    pad + need > RING_SIZE) {
+			atomic_inc(&session.dropped);
+			goto out;
+		}
+	} while (!atomic_cas(&ring->head, head, head + pad + need));
+
+	if (pad) {
+		/* The end is skipped as is if too short for a record */
+		if (pad >= sizeof(*rec)) {
+			rec = (struct record *)&ring->buf[off];
+			rec->orig_len = 0;
+			atomic_set(&rec->len, pad);
+		}
+
+		off = 0;
+	}
+
+	rec = (struct record *)&ring->buf[off];
+	rec->cap_len = cap_len;
+	rec->orig_len = orig_len;
+	rec->timestamp = k_ticks_to_us_floor64(k_uptime_ticks());
+
+	data = (uint8_t *)(rec + 1);
+
+	for (buf = pkt->buffer; buf && cap_len; buf = buf->frags) {
+		size_t len = MIN(buf->len, cap_len);
+
+		memcpy(data, buf->data, len);
+		data += len;
+		cap_len -= len;
+	}
+
+	atomic_set(&rec->len, need);
+	atomic_inc(&session.captured);
+
+	if (ring_used(ring) > RING_SIZE / 2) {
+		k_sem_give(&drain_sem);
+	}
+
+out:
+	atomic_dec(&session.writers);
+}
+
+static void file_write(const void *data, size_t len)
+{
+	ssize_t ret;
+
+	if (session.error) {
+		return;
+	}
+
+	ret = fs_write(&session.file, data, len);
+	if (ret < 0) {
+		NET_ERR("Cannot write capture file (%d)", (int)ret);
+		session.error = ret;
+		return;
+	}
+
+	if (ret != len) {
+		NET_ERR("Capture file %s", "full");
+		session.error = -ENOSPC;
+		return;
+	}
+
+	session.written += len;
+}
+
+static void write_record(struct record *rec)
+{
+	struct pcapng_epb *epb = (struct pcapng_epb *)block;
+	size_t len = sizeof(*epb) + ROUND_UP(rec->cap_len, 4) +
+		     sizeof(uint32_t);
+
+	epb->type = PCAPNG_BLOCK_EPB;
+	epb->len = len;
+	epb->if_id = 0;
+	epb->ts_high = rec->timestamp >> 32;
+	epb->ts_low = (uint32_t)rec->timestamp;
+	epb->cap_len = rec->cap_len;
+	epb->orig_len = rec->orig_len;
+
+	memcpy(epb + 1, rec + 1, rec->cap_len);
+	memset((uint8_t *)(epb + 1) + rec->cap_len, 0,
+	       ROUND_UP(rec->cap_len, 4) - rec->cap_len);
+	UNALIGNED_PUT(len, (uint32_t *)&block[len - sizeof(uint32_t)]);
+
+	file_write(block, len);
+}
+
+static void drain_ring(struct ring *ring)
+{
+	atomic_val_t tail = atomic_get(&ring->tail);
+
+	while (tail != atomic_get(&ring->head)) {
+		size_t off = tail & (RING_SIZE - 1);
+		struct record *rec;
+		size_t len;
+
+		if (RING_SIZE - off < sizeof(*rec)) {
+			len = RING_SIZE - off;
+		} else {
+			rec = (struct record *)&ring->buf[off];
+
+			len = atomic_get(&rec->len);
+			if (len == 0) {
+				/* Still being written */
+				break;
+			}
+
+			if (rec->orig_len) {
+				write_record(rec);
+			}
+		}
+
+		memset(&ring->buf[off], 0, len);
+
+		tail += len;
+		atomic_set(&ring->tail, tail);
+	}
+}
+
+static void drain(void *p1, void *p2, void *p3)
+{
+	bool stop;
+	int i;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	do {
+		(void)k_sem_take(&drain_sem,
+			K_MSEC(CONFIG_NET_CAPTURE_FILE_FLUSH_INTERVAL));
+
+		stop = session.stop;
+		if (stop) {
+			/* Let the last records be completed */
+			while (atomic_get(&session.writers)) {
+				k_msleep(1);
+			}
+		}
+
+		for (i = 0; i < ARRAY_SIZE(rings); i++) {
+			drain_ring(&rings[i]);
+		}
+
+		if (!session.error) {
+			(void)fs_sync(&session.file);
+		}
+	} while (!stop);
+
+	(void)fs_close(&session.file);
+}
+
+static uint16_t link_type(struct net_if *iface)
+{
+#if defined(CONFIG_NET_L2_ETHERNET)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(ETHERNET)) {
+		return LINKTYPE_ETHERNET;
+	}
+#endif
+#if defined(CONFIG_NET_L2_IEEE802154)
+	if (net_if_l2(iface) == &NET_L2_GET_NAME(IEEE802154)) {
+		return LINKTYPE_IEEE802_15_4_NOFCS;
+	}
+#endif
+
+	/* The packets start with their IP header */
+	return LINKTYPE_RAW;
+}
+
+int net_capture_file_start(struct net_if *iface, const char *path,
+			   uint32_t snaplen)
+{
+	struct pcapng_shb shb = {
+		.type = PCAPNG_BLOCK_SHB,
+		.len = sizeof(shb),
+		.magic = PCAPNG_BYTE_ORDER_MAGIC,
+		.major = 1,
+		.minor = 0,
+		.section_len = -1,
+		.len_trailer = sizeof(shb),
+	};
+	struct pcapng_idb idb = {
+		.type = PCAPNG_BLOCK_IDB,
+		.len = sizeof(idb),
+		.len_trailer = sizeof(idb),
+	};
+	int ret;
+	int i;
+
+	if (iface == NULL || path == NULL || snaplen > SNAPLEN_MAX) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (atomic_get(&session.active)) {
+		ret = -EALREADY;
+		goto out;
+	}
+
+	fs_file_t_init(&session.file);
+
+	(void)fs_unlink(path);
+
+	ret = fs_open(&session.file, path, FS_O_CREATE | FS_O_WRITE);
+	if (ret < 0) {
+		NET_ERR("Cannot open %s (%d)", log_strdup(path), ret);
+		goto out;
+	}
+
+	session.iface = iface;
+	session.snaplen = snaplen ? snaplen : SNAPLEN_MAX;
+	session.written = 0;
+	session.error = 0;
+	session.stop = false;
+	atomic_clear(&session.captured);
+	atomic_clear(&session.dropped);
+
+	idb.link_type = link_type(iface);
+	idb.snaplen = session.snaplen;
+
+	file_write(&shb, sizeof(shb));
+	file_write(&idb, sizeof(idb));
+
+	if (session.error) {
+		ret = session.error;
+		(void)fs_close(&session.file);
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(rings); i++) {
+		atomic_clear(&rings[i].head);
+		atomic_clear(&rings[i].tail);
+	}
+
+	k_sem_reset(&drain_sem);
+
+	k_thread_create(&drain_thread, drain_stack,
+			K_KERNEL_STACK_SIZEOF(drain_stack), drain,
+			NULL, NULL, NULL, K_LOWEST_APPLICATION_THREAD_PRIO,
+			0, K_NO_WAIT);
+	k_thread_name_set(&drain_thread, "net_capture_file");
+
+	atomic_set(&session.active, 1);
+
+out:
+	k_mutex_unlock(&lock);
+
+	return ret;
+}
+
+int net_capture_file_stop(void)
+{
+	int ret;
+
+	k_mutex_lock(&lock, K_FOREVER);
+
+	if (!atomic_cas(&session.active, 1, 0)) {
+		ret = -EALREADY;
+		goto out;
+	}
+
+	session.stop = true;
+	k_sem_give(&drain_sem);
+
+	(void)k_thread_join(&drain_thread, K_FOREVER);
+
+	ret = session.error;
+
+out:
+	k_mutex_unlock(&lock);
+
+	return ret;
+}
+
+void net_capture_file_get_stats(struct net_capture_file_stats *stats)
+{
+	stats->captured = atomic_get(&session.captured);
+	stats->dropped = atomic_get(&session.dropped);
+	stats->written = session.written;
+}
@@ -710,6 +710,9 @@ uint8_t coap_header_get_code(const struct coap_packet *cpkt)
 	case COAP_METHOD_POST:
 	case COAP_METHOD_PUT:
 	case COAP_METHOD_DELETE:
+	case COAP_METHOD_FETCH:
+	case COAP_METHOD_PATCH:
+	case COAP_METHOD_IPATCH:
 
 	/* All the defined response codes */
 	case COAP_RESPONSE_CODE_OK:
@@ -1091,6 +1094,89 @@ size_t coap_next_block(const struct coap_packet *cpkt,
 	return ctx->current;
 }
 
+int coap_append_block_payload(struct coap_packet *cpkt,
+			      struct coap_block_context *ctx,
+			      coap_block_read_t read, void *user_data)
+{
+	uint16_t len = coap_block_size_to_bytes(ctx->block_size);
+	bool request = is_request(cpkt);
+	int r;
+
+	if (ctx->total_size == 0U || ctx->current >= ctx->total_size) {
+		return -EINVAL;
+	}
+
+	len = MIN(len, ctx->total_size - ctx->current);
+
+	if (request) {
+		r = coap_append_block1_option(cpkt, ctx);
+	} else {
+		r = coap_append_block2_option(cpkt, ctx);
+	}
+
+	if (r < 0) {
+		return r;
+	}
+
+	if (ctx->current == 0U) {
+		r = coap_append_option_int(cpkt, request ? COAP_OPTION_SIZE1 :
+					   COAP_OPTION_SIZE2, ctx->total_size);
+		if (r < 0) {
+			return r;
+		}
+	}
+
+	r = coap_packet_append_payload_marker(cpkt);
+	if (r < 0) {
+		return r;
+	}
+
+	if (cpkt->max_len - cpkt->offset < len) {
+		return -ENOMEM;
+	}
+
+	r = read(ctx, cpkt->data + cpkt->offset, len, user_data);
+	if (r < 0) {
+		return r;
+	}
+
+	/* The More flag was already encoded from the total size. */
+	if (r != len) {
+		return -EIO;
+	}
+
+	cpkt->offset += len;
+
+	return 0;
+}
+
+int coap_deliver_block_payload(const struct coap_packet *cpkt,
+			       struct coap_block_context *ctx,
+			       coap_block_write_t write, void *user_data)
+{
+	const uint8_t *payload;
+	uint16_t len;
+	int block;
+	int r;
+
+	block = coap_get_option_int(cpkt, is_request(cpkt) ?
+				    COAP_OPTION_BLOCK1 : COAP_OPTION_BLOCK2);
+
+	r = coap_update_from_block(cpkt, ctx);
+	if (r < 0) {
+		return r;
+	}
+
+	payload = coap_packet_get_payload(cpkt, &len);
+
+	r = write(ctx, payload, len, block < 0 || !GET_MORE(block), user_data);
+	if (r < 0) {
+		return r;
+	}
+
+	return block >= 0 && GET_MORE(block);
+}
+
 int coap_pending_init(struct coap_pending *pending,
 		      const struct coap_packet *request,
 		      const struct sockaddr *addr,
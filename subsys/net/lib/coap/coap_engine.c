@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_coap_engine, CONFIG_COAP_LOG_LEVEL);
+
+#include <errno.h>
+#include <string.h>
+#include <sys/byteorder.h>
+
+#include <net/net_core.h>
+#include <net/coap.h>
+#include <net/coap_engine.h>
+
+#define BASIC_HEADER_SIZE 4
+
+static inline uint32_t pending_expiry(const struct coap_pending *pending)
+{
+	return pending->t0 + pending->timeout;
+}
+
+/* Must be called with engine->lock held. */
+static void pending_insert(struct coap_engine *engine,
+			   struct coap_pending *pending)
+{
+	uint32_t expiry = pending_expiry(pending);
+	struct coap_pending *p, *prev = NULL;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine->pendings, p, node) {
+		if ((int32_t)(pending_expiry(p) - expiry) > 0) {
+			break;
+		}
+
+		prev = p;
+	}
+
+	sys_slist_insert(&engine->pendings, prev ? &prev->node : NULL,
+			 &pending->node);
+}
+
+/* Must be called with engine->lock held. */
+static void retransmit_reschedule(struct coap_engine *engine)
+{
+	struct coap_pending *head;
+	int32_t remaining;
+
+	head = SYS_SLIST_PEEK_HEAD_CONTAINER(&engine->pendings, head, node);
+	if (head == NULL) {
+		(void)k_work_cancel_delayable(&engine->retransmit_work);
+		return;
+	}
+
+	remaining = (int32_t)(pending_expiry(head) - k_uptime_get_32());
+
+	(void)k_work_reschedule(&engine->retransmit_work,
+				K_MSEC(MAX(remaining, 0)));
+}
+
+static int pending_send(struct coap_engine *engine,
+			struct coap_pending *pending)
+{
+	struct iovec iov = {
+		.iov_base = pending->data,
+		.iov_len = pending->len,
+	};
+
+	return engine->send(engine, &iov, 1, &pending->addr);
+}
+
+static void retransmit_handler(struct k_work *work)
+{
+	struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+	struct coap_engine *engine = CONTAINER_OF(dwork, struct coap_engine,
+						  retransmit_work);
+	uint32_t now = k_uptime_get_32();
+	struct coap_pending *p;
+	sys_slist_t expired;
+	sys_snode_t *node;
+
+	sys_slist_init(&expired);
+
+	k_mutex_lock(&engine->lock, K_FOREVER);
+
+	while ((p = SYS_SLIST_PEEK_HEAD_CONTAINER(&engine->pendings, p,
+						  node)) != NULL) {
+		if ((int32_t)(pending_expiry(p) - now) > 0) {
+			break;
+		}
+
+		(void)sys_slist_get_not_empty(&engine->pendings);
+
+		if (!coap_pending_cycle(p)) {
+			NET_DBG("Message id %u not acknowledged", p->id);
+			p->timeout = 0U;
+			sys_slist_append(&expired, &p->node);
+			continue;
+		}
+
+		NET_DBG("Retransmitting message id %u", p->id);
+
+		if (pending_send(engine, p) < 0) {
+			NET_DBG("Retransmission of message id %u failed",
+				p->id);
+		}
+
+		pending_insert(engine, p);
+	}
+
+	retransmit_reschedule(engine);
+
+	k_mutex_unlock(&engine->lock);
+
+	while ((node = sys_slist_get(&expired)) != NULL) {
+		p = CONTAINER_OF(node, struct coap_pending, node);
+
+		if (engine->timeout) {
+			engine->timeout(engine, p);
+		}
+	}
+}
+
+void coap_engine_init(struct coap_engine *engine, coap_engine_send_t send,
+		      coap_engine_timeout_t timeout, void *user_data)
+{
+	engine->send = send;
+	engine->timeout = timeout;
+	engine->user_data = user_data;
+
+	sys_slist_init(&engine->pendings);
+	k_work_init_delayable(&engine->retransmit_work, retransmit_handler);
+	k_mutex_init(&engine->lock);
+}
+
+int coap_engine_send(struct coap_engine *engine,
+		     const struct coap_packet *cpkt,
+		     const struct sockaddr *addr,
+		     struct coap_pending *pending)
+{
+	struct iovec iov = {
+		.iov_base = cpkt->data,
+		.iov_len = cpkt->offset,
+	};
+	int r;
+
+	if (coap_header_get_type(cpkt) != COAP_TYPE_CON) {
+		return engine->send(engine, &iov, 1, addr);
+	}
+
+	if (pending == NULL) {
+		return -EINVAL;
+	}
+
+	if (pending->timeout != 0U) {
+		return -EBUSY;
+	}
+
+	r = coap_pending_init(pending, cpkt, addr,
+			      COAP_DEFAULT_MAX_RETRANSMIT);
+	if (r < 0) {
+		return r;
+	}
+
+	/* Initial transmission, sets the first timeout. */
+	(void)coap_pending_cycle(pending);
+
+	k_mutex_lock(&engine->lock, K_FOREVER);
+
+	r = engine->send(engine, &iov, 1, addr);
+	if (r < 0) {
+		coap_pending_clear(pending);
+		goto out;
+	}
+
+	pending_insert(engine, pending);
+	retransmit_reschedule(engine);
+
+out:
+	k_mutex_unlock(&engine->lock);
+
+	return r;
+}
+
+struct coap_pending *coap_engine_received(struct coap_engine *engine,
+					  const struct coap_packet *response)
+{
+	uint16_t id = coap_header_get_id(response);
+	struct coap_pending *p, *found = NULL;
+	bool head;
+
+	k_mutex_lock(&engine->lock, K_FOREVER);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine->pendings, p, node) {
+		if (p->id == id) {
+			found = p;
+			break;
+		}
+	}
+
+	if (found) {
+		head = sys_slist_peek_head(&engine->pendings) == &found->node;
+
+		sys_slist_find_and_remove(&engine->pendings, &found->node);
+		found->timeout = 0U;
+
+		/* Only the head expiry drives the work item. */
+		if (head) {
+			retransmit_reschedule(engine);
+		}
+	}
+
+	k_mutex_unlock(&engine->lock);
+
+	return found;
+}
+
+void coap_engine_cancel(struct coap_engine *engine,
+			struct coap_pending *pending)
+{
+	k_mutex_lock(&engine->lock, K_FOREVER);
+
+	if (sys_slist_find_and_remove(&engine->pendings, &pending->node)) {
+		retransmit_reschedule(engine);
+	}
+
+	coap_pending_clear(pending);
+
+	k_mutex_unlock(&engine->lock);
+}
+
+void coap_engine_stop(struct coap_engine *engine)
+{
+	struct coap_pending *p;
+	sys_snode_t *node;
+
+	k_mutex_lock(&engine->lock, K_FOREVER);
+
+	while ((node = sys_slist_get(&engine->pendings)) != NULL) {
+		p = CONTAINER_OF(node, struct coap_pending, node);
+		coap_pending_clear(p);
+	}
+
+	(void)k_work_cancel_delayable(&engine->retransmit_work);
+
+	k_mutex_unlock(&engine->lock);
+}
+
+int coap_engine_notify(struct coap_engine *engine,
+		       struct coap_resource *resource,
+		       const struct coap_packet *cpkt)
+{
+	uint8_t hdr[BASIC_HEADER_SIZE + COAP_TOKEN_MAX_LEN];
+	struct coap_observer *o;
+	struct iovec iov[2];
+	int count = 0;
+	int r;
+
+	if (coap_header_get_type(cpkt) == COAP_TYPE_CON ||
+	    cpkt->offset < cpkt->hdr_len) {
+		return -EINVAL;
+	}
+
+	/* Everything after the token is shared by all the notifications. */
+	iov[0].iov_base = hdr;
+	iov[1].iov_base = cpkt->data + cpkt->hdr_len;
+	iov[1].iov_len = cpkt->offset - cpkt->hdr_len;
+
+	memcpy(hdr, cpkt->data, BASIC_HEADER_SIZE);
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&resource->observers, o, list) {
+		hdr[0] = (hdr[0] & 0xF0) | (o->tkl & 0x0F);
+		sys_put_be16(coap_next_id(), &hdr[2]);
+		memcpy(&hdr[BASIC_HEADER_SIZE], o->token, o->tkl);
+
+		iov[0].iov_len = BASIC_HEADER_SIZE + o->tkl;
+
+		r = engine->send(engine, iov, ARRAY_SIZE(iov), &o->addr);
+		if (r < 0) {
+			NET_DBG("Cannot notify observer %p (%d)", o, r);
+			continue;
+		}
+
+		count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,307 @@
+/** @file
+ * @brief DNS answer cache
+ *
+ * Keeps the answers of the DNS resolver for the time allowed by their TTL.
+ */
+
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_dns_resolve, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <kernel.h>
+#include <string.h>
+#include <errno.h>
+
+#include <net/net_ip.h>
+#include <net/dns_resolve.h>
+#include "dns_internal.h"
+
+#define CACHE_NAME_LEN   CONFIG_DNS_RESOLVER_CACHE_NAME_LEN
+#define CACHE_ADDR_COUNT CONFIG_DNS_RESOLVER_CACHE_MAX_ADDRESSES
+
+struct dns_cache_entry {
+	/* Uptime in milliseconds when the entry becomes stale */
+	int64_t expires;
+
+	/* Uptime of the last lookup, the oldest entry is replaced first */
+	int64_t last_used;
+
+	struct sockaddr addr[CACHE_ADDR_COUNT];
+
+	enum dns_query_type type;
+
+	/* DNS_EAI_ALLDONE for a positive entry, the cached error otherwise */
+	int status;
+
+	uint8_t addr_count;
+
+	/* Empty name means an unused entry */
+	char name[CACHE_NAME_LEN + 1];
+};
+
+static struct dns_cache_entry dns_cache[CONFIG_DNS_RESOLVER_CACHE_MAX_ENTRIES];
+static struct dns_cache_stats dns_cache_stats;
+static K_MUTEX_DEFINE(dns_cache_lock);
+
+static inline bool entry_is_valid(struct dns_cache_entry *entry, int64_t now)
+{
+	return entry->name[0] != '\0' && entry->expires > now;
+}
+
+static inline bool name_is_cacheable(const char *name)
+{
+	return name != NULL && name[0] != '\0' &&
+		strlen(name) <= CACHE_NAME_LEN;
+}
+
+/* Must be invoked with cache lock held */
+static struct dns_cache_entry *entry_find(const char *name,
+					  enum dns_query_type type)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		if (dns_cache[i].type == type &&
+		    strcmp(dns_cache[i].name, name) == 0) {
+			return &dns_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Return the entry of the name, or take over an unused or the least
+ * recently used entry for it.
+ *
+ * Must be invoked with cache lock held.
+ */
+static struct dns_cache_entry *entry_get(const char *name,
+					 enum dns_query_type type,
+					 int64_t now)
+{
+	struct dns_cache_entry *entry;
+	int i;
+
+	entry = entry_find(name, type);
+	if (entry) {
+		return entry;
+	}
+
+	entry = &dns_cache[0];
+
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		if (!entry_is_valid(&dns_cache[i], now)) {
+			entry = &dns_cache[i];
+			break;
+		}
+
+		if (dns_cache[i].last_used < entry->last_used) {
+			entry = &dns_cache[i];
+		}
+	}
+
+	strcpy(entry->name, name);
+	entry->type = type;
+
+	return entry;
+}
+
+void dns_cache_add(const char *name, enum dns_query_type type,
+		   const struct dns_addrinfo *info, uint32_t ttl, bool first)
+{
+	struct dns_cache_entry *entry;
+	int64_t now, expires;
+
+	if (!name_is_cacheable(name)) {
+		return;
+	}
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+	expires = now + (int64_t)ttl * MSEC_PER_SEC;
+
+	if (first) {
+		entry = entry_get(name, type, now);
+		entry->status = DNS_EAI_ALLDONE;
+		entry->addr_count = 0U;
+		entry->expires = expires;
+		entry->last_used = now;
+	} else {
+		entry = entry_find(name, type);
+		if (!entry || entry->status != DNS_EAI_ALLDONE) {
+			goto unlock;
+		}
+
+		/* The whole answer is only valid as long as its shortest
+		 * lived record.
+		 */
+		if (expires < entry->expires) {
+			entry->expires = expires;
+		}
+	}
+
+	if (entry->addr_count < CACHE_ADDR_COUNT) {
+		memcpy(&entry->addr[entry->addr_count++], &info->ai_addr,
+		       sizeof(struct sockaddr));
+	}
+
+	NET_DBG("Cached %s type %d ttl %u (%u addresses)", log_strdup(name),
+		type, ttl, entry->addr_count);
+
+unlock:
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void dns_cache_add_negative(const char *name, enum dns_query_type type,
+			    int status)
+{
+	struct dns_cache_entry *entry;
+	int64_t now;
+
+	if (CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL == 0 ||
+	    !name_is_cacheable(name)) {
+		return;
+	}
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	entry = entry_get(name, type, now);
+	entry->status = status;
+	entry->addr_count = 0U;
+	entry->expires = now + (int64_t)CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL *
+		MSEC_PER_SEC;
+	entry->last_used = now;
+
+	NET_DBG("Cached failure %d for %s type %d", status, log_strdup(name),
+		type);
+
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   dns_resolve_cb_t cb, void *user_data)
+{
+	struct sockaddr addr[CACHE_ADDR_COUNT];
+	struct dns_cache_entry *entry;
+	struct dns_addrinfo info;
+	int64_t now;
+	int status, count, i;
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	entry = name_is_cacheable(name) ? entry_find(name, type) : NULL;
+	if (!entry || !entry_is_valid(entry, now)) {
+		dns_cache_stats.misses++;
+		k_mutex_unlock(&dns_cache_lock);
+		return -ENOENT;
+	}
+
+	entry->last_used = now;
+	status = entry->status;
+	count = entry->addr_count;
+	memcpy(addr, entry->addr, count * sizeof(struct sockaddr));
+
+	if (status == DNS_EAI_ALLDONE) {
+		dns_cache_stats.hits++;
+	} else {
+		dns_cache_stats.negative_hits++;
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+
+	/* The callback is called without the lock so that it can start
+	 * new queries.
+	 */
+	for (i = 0; i < count; i++) {
+		memset(&info, 0, sizeof(info));
+		memcpy(&info.ai_addr, &addr[i], sizeof(struct sockaddr));
+		info.ai_family = addr[i].sa_family;
+
+		if (info.ai_family == AF_INET) {
+			info.ai_addrlen = sizeof(struct sockaddr_in);
+		} else {
+			info.ai_addrlen = sizeof(struct sockaddr_in6);
+		}
+
+		cb(DNS_EAI_INPROGRESS, &info, user_data);
+	}
+
+	cb(status, NULL, user_data);
+
+	return 0;
+}
+
+void dns_cache_coalesced(void)
+{
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+	dns_cache_stats.coalesced++;
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void dns_cache_stats_get(struct dns_cache_stats *stats)
+{
+	int64_t now;
+	int i;
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	*stats = dns_cache_stats;
+	stats->entries = 0U;
+
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		if (entry_is_valid(&dns_cache[i], now)) {
+			stats->entries++;
+		}
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void dns_cache_flush(void)
+{
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	memset(dns_cache, 0, sizeof(dns_cache));
+	memset(&dns_cache_stats, 0, sizeof(dns_cache_stats));
+
+	k_mutex_unlock(&dns_cache_lock);
+}
+
+void dns_cache_foreach(dns_cache_cb_t cb, void *user_data)
+{
+	struct dns_cache_entry *entry;
+	int64_t now;
+	int i;
+
+	k_mutex_lock(&dns_cache_lock, K_FOREVER);
+
+	now = k_uptime_get();
+
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		entry = &dns_cache[i];
+
+		if (!entry_is_valid(entry, now)) {
+			continue;
+		}
+
+		cb(entry->name, entry->type, entry->status,
+		   (uint32_t)((entry->expires - now) / MSEC_PER_SEC),
+		   entry->addr_count ? entry->addr : NULL, entry->addr_count,
+		   user_data);
+	}
+
+	k_mutex_unlock(&dns_cache_lock);
+}
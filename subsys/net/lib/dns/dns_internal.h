@@ -18,3 +18,25 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 		     struct net_buf *dns_cname,
 		     uint16_t *query_hash);
 #endif
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Store one address of a positive answer. The first address of an answer
+ * replaces whatever was cached for the name before, the following ones are
+ * appended to it and can only shorten its lifetime.
+ */
+void dns_cache_add(const char *name, enum dns_query_type type,
+		   const struct dns_addrinfo *info, uint32_t ttl, bool first);
+
+/* Remember that the name could not be resolved */
+void dns_cache_add_negative(const char *name, enum dns_query_type type,
+			    int status);
+
+/* Answer the query from the cache by calling the callback. Returns 0 if the
+ * query was answered, -ENOENT if the name is not cached.
+ */
+int dns_cache_find(const char *name, enum dns_query_type type,
+		   dns_resolve_cb_t cb, void *user_data);
+
+/* Account a query that waits for an identical one already in progress */
+void dns_cache_coalesced(void);
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
@@ -84,6 +84,9 @@ static int dns_write(struct dns_resolve_context *ctx,
 		     struct net_buf *dns_qname,
 		     int hop_limit);
 
+/* Must be invoked with context lock held */
+static int dns_send_query(struct dns_resolve_context *ctx, int i);
+
 static bool server_is_mdns(sa_family_t family, struct sockaddr *addr)
 {
 	if (family == AF_INET) {
@@ -398,6 +401,19 @@ static inline int get_cb_slot(struct dns_resolve_context *ctx)
 	return -ENOENT;
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Check if the query in slot i waits for the answer of the query in slot.
+ *
+ * Must be invoked with context lock held.
+ */
+static inline bool is_waiting_for(struct dns_resolve_context *ctx, int i,
+				  int slot)
+{
+	return i != slot && ctx->queries[i].leader == slot &&
+		ctx->queries[i].cb != NULL && ctx->queries[i].query != NULL;
+}
+#endif
+
 /* Invoke the callback associated with a query slot, if still relevant.
  *
  * Must be invoked with context lock held.
@@ -416,6 +432,21 @@ static inline void invoke_query_callback(int status,
 	if (pending_query->query != NULL)  {
 		pending_query->cb(status, info, pending_query->user_data);
 	}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct dns_resolve_context *ctx = pending_query->ctx;
+	int i, slot = pending_query - ctx->queries;
+
+	/* Queries for the same name that wait for this one get the same
+	 * results.
+	 */
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (is_waiting_for(ctx, i, slot)) {
+			ctx->queries[i].cb(status, info,
+					   ctx->queries[i].user_data);
+		}
+	}
+#endif
 }
 
 /* Release a query slot reserved by get_cb_slot().
@@ -426,7 +457,22 @@ static inline void invoke_query_callback(int status,
  */
 static void release_query(struct dns_pending_query *pending_query)
 {
-	int busy = k_work_cancel_delayable(&pending_query->timer);
+	int busy;
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	struct dns_resolve_context *ctx = pending_query->ctx;
+	int i, slot = pending_query - ctx->queries;
+
+	/* The queries waiting for this one are done too */
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (is_waiting_for(ctx, i, slot)) {
+			ctx->queries[i].leader = -1;
+			release_query(&ctx->queries[i]);
+		}
+	}
+#endif
+
+	busy = k_work_cancel_delayable(&pending_query->timer);
 
 	/* If the work item is no longer pending we're done. */
 	if (busy == 0) {
@@ -441,6 +487,15 @@ static void release_query(struct dns_pending_query *pending_query)
 	}
 }
 
+static inline bool is_coalesced(struct dns_pending_query *pending_query)
+{
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	return pending_query->leader >= 0;
+#else
+	return false;
+#endif
+}
+
 /* Must be invoked with context lock held */
 static inline int get_slot_by_id(struct dns_resolve_context *ctx,
 				 uint16_t dns_id,
@@ -449,6 +504,13 @@ static inline int get_slot_by_id(struct dns_resolve_context *ctx,
 	int i;
 
 	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		/* A coalesced query has the same name hash as the query
+		 * it waits for, so it can only be found by its own id.
+		 */
+		if (query_hash != 0 && is_coalesced(&ctx->queries[i])) {
+			continue;
+		}
+
 		if (check_query_active(&ctx->queries[i], false) &&
 		    ctx->queries[i].id == dns_id &&
 		    (query_hash == 0 ||
@@ -571,6 +633,7 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 				goto quit;
 			}
 
+		query_known:
 			if (ctx->queries[*query_idx].query_type ==
 							DNS_QUERY_TYPE_A) {
 				if (net_sin(&info.ai_addr)->sin_family ==
@@ -631,7 +694,12 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 			src = dns_msg->msg + dns_msg->response_position;
 			memcpy(addr, src, address_size);
 
-		query_known:
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+			dns_cache_add(ctx->queries[*query_idx].query,
+				      ctx->queries[*query_idx].query_type,
+				      &info, ttl, items == 0);
+#endif
+
 			invoke_query_callback(DNS_EAI_INPROGRESS, &info,
 					      &ctx->queries[*query_idx]);
 			items++;
@@ -701,6 +769,18 @@ int dns_validate_msg(struct dns_resolve_context *ctx,
 
 	if (items == 0) {
 		ret = DNS_EAI_NODATA;
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+		/* Only cache the answers where the server says that the name
+		 * has no addresses of this type, not its failures.
+		 */
+		if (dns_header_rcode(dns_msg->msg) == DNS_HEADER_NOERROR ||
+		    dns_header_rcode(dns_msg->msg) == DNS_HEADER_NAMEERROR) {
+			dns_cache_add_negative(ctx->queries[*query_idx].query,
+					ctx->queries[*query_idx].query_type,
+					ret);
+		}
+#endif
 	} else {
 		ret = DNS_EAI_ALLDONE;
 	}
@@ -718,7 +798,7 @@ static int dns_read(struct dns_resolve_context *ctx,
 		    uint16_t *query_hash)
 {
 	/* Helper struct to track the dns msg received from the server */
-	struct dns_msg_t dns_msg;
+	struct dns_msg_t dns_msg = { 0 };
 	int data_len;
 	int ret;
 	int query_idx = -1;
@@ -946,6 +1026,42 @@ static int dns_write(struct dns_resolve_context *ctx,
 	return 0;
 }
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* The queries waiting for a cancelled query still want an answer, so the
+ * first of them sends its own request and the others wait for it instead.
+ *
+ * Must be invoked with context lock held.
+ */
+static void dns_promote_coalesced(struct dns_resolve_context *ctx, int slot)
+{
+	int i, leader = -1;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (!is_waiting_for(ctx, i, slot)) {
+			continue;
+		}
+
+		if (leader < 0) {
+			leader = i;
+		}
+
+		ctx->queries[i].leader = (i == leader) ? -1 : leader;
+	}
+
+	if (leader < 0) {
+		return;
+	}
+
+	NET_DBG("[%u] sending query instead of cancelled [%u]", leader, slot);
+
+	if (dns_send_query(ctx, leader) < 0) {
+		invoke_query_callback(DNS_EAI_SYSTEM, NULL,
+				      &ctx->queries[leader]);
+		release_query(&ctx->queries[leader]);
+	}
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 /* Must be invoked with context lock held */
 static void dns_resolve_cancel_slot(struct dns_resolve_context *ctx, int slot)
 {
@@ -994,6 +1110,10 @@ static int dns_resolve_cancel_with_hash(struct dns_resolve_context *ctx,
 		log_strdup(query_name), ctx->queries[i].query_type,
 		query_hash);
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	dns_promote_coalesced(ctx, i);
+#endif
+
 	dns_resolve_cancel_slot(ctx, i);
 
 unlock:
@@ -1089,6 +1209,17 @@ static void query_timeout(struct k_work *work)
 	NET_DBG("Query timeout DNS req %u type %d hash %u", pending_query->id,
 		pending_query->query_type, pending_query->query_hash);
 
+	/* A coalesced query shares the name hash with the query it waits
+	 * for, so it is cancelled directly.
+	 */
+	if (is_coalesced(pending_query) && pending_query->query != NULL &&
+	    pending_query->ctx->state == DNS_RESOLVE_CONTEXT_ACTIVE) {
+		dns_resolve_cancel_slot(pending_query->ctx,
+					pending_query - pending_query->ctx->queries);
+		k_mutex_unlock(&pending_query->ctx->lock);
+		return;
+	}
+
 	/* The resolve cancel will invoke release_query(), but release will
 	 * not be completed because the work item is still pending.  Instead
 	 * the release will be completed when check_query_active() confirms
@@ -1102,6 +1233,140 @@ static void query_timeout(struct k_work *work)
 	k_mutex_unlock(&pending_query->ctx->lock);
 }
 
+static bool is_mdns_query(const char *query)
+{
+	const char *ptr;
+
+	if (!IS_ENABLED(CONFIG_MDNS_RESOLVER)) {
+		return false;
+	}
+
+	ptr = strrchr(query, '.');
+
+	/* Note that we memcmp() the \0 here too */
+	return ptr && !memcmp(ptr, (const void *){ ".local" }, 7);
+}
+
+/* Send the query of a slot to the DNS servers.
+ *
+ * Must be invoked with context lock held.
+ */
+static int dns_send_query(struct dns_resolve_context *ctx, int i)
+{
+	struct net_buf *dns_data = NULL;
+	struct net_buf *dns_qname = NULL;
+	bool mdns_query = is_mdns_query(ctx->queries[i].query);
+	int ret, j = 0;
+	int failure = 0;
+	uint8_t hop_limit;
+
+	dns_data = net_buf_alloc(&dns_msg_pool, ctx->buf_timeout);
+	if (!dns_data) {
+		ret = -ENOMEM;
+		goto quit;
+	}
+
+	dns_qname = net_buf_alloc(&dns_qname_pool, ctx->buf_timeout);
+	if (!dns_qname) {
+		ret = -ENOMEM;
+		goto quit;
+	}
+
+	ret = dns_msg_pack_qname(&dns_qname->len, dns_qname->data,
+				DNS_MAX_NAME_LEN, ctx->queries[i].query);
+	if (ret < 0) {
+		goto quit;
+	}
+
+	for (j = 0; j < SERVER_COUNT; j++) {
+		hop_limit = 0U;
+
+		if (!ctx->servers[j].net_ctx) {
+			continue;
+		}
+
+		/* If mDNS is enabled, then send .local queries only to
+		 * a well known multicast mDNS server address.
+		 */
+		if (IS_ENABLED(CONFIG_MDNS_RESOLVER) && mdns_query &&
+		    !ctx->servers[j].is_mdns) {
+			continue;
+		}
+
+		/* If llmnr is enabled, then all the queries are sent to
+		 * LLMNR multicast address unless it is a mDNS query.
+		 */
+		if (!mdns_query && IS_ENABLED(CONFIG_LLMNR_RESOLVER)) {
+			if (!ctx->servers[j].is_llmnr) {
+				continue;
+			}
+
+			hop_limit = 1U;
+		}
+
+		ret = dns_write(ctx, j, i, dns_data, dns_qname, hop_limit);
+		if (ret < 0) {
+			failure++;
+			continue;
+		}
+
+		/* Do one concurrent query only for each name resolve.
+		 * TODO: Change the i (query index) to do multiple concurrent
+		 *       to each server.
+		 */
+		break;
+	}
+
+	if (failure) {
+		NET_DBG("DNS query failed %d times", failure);
+
+		if (failure == j) {
+			ret = -ENOENT;
+			goto quit;
+		}
+	}
+
+	ret = 0;
+
+quit:
+	if (dns_data) {
+		net_buf_unref(dns_data);
+	}
+
+	if (dns_qname) {
+		net_buf_unref(dns_qname);
+	}
+
+	return ret;
+}
+
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+/* Find a query that has sent a request for the same name as the given slot.
+ *
+ * Must be invoked with context lock held.
+ */
+static int get_slot_by_name(struct dns_resolve_context *ctx, int slot)
+{
+	struct dns_pending_query *pending_query = &ctx->queries[slot];
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		if (i == slot || ctx->queries[i].query == NULL ||
+		    !check_query_active(&ctx->queries[i], false) ||
+		    is_coalesced(&ctx->queries[i])) {
+			continue;
+		}
+
+		if (ctx->queries[i].query_type == pending_query->query_type &&
+		    strcmp(ctx->queries[i].query, pending_query->query) == 0) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+#endif /* CONFIG_DNS_RESOLVER_CACHE */
+
 int dns_resolve_name(struct dns_resolve_context *ctx,
 		     const char *query,
 		     enum dns_query_type type,
@@ -1111,13 +1376,8 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 		     int32_t timeout)
 {
 	k_timeout_t tout;
-	struct net_buf *dns_data = NULL;
-	struct net_buf *dns_qname = NULL;
 	struct sockaddr addr;
-	int ret, i = -1, j = 0;
-	int failure = 0;
-	bool mdns_query = false;
-	uint8_t hop_limit;
+	int ret, i = -1;
 
 	if (!ctx || !query || !cb) {
 		return -EINVAL;
@@ -1179,6 +1439,16 @@ int dns_resolve_name(struct dns_resolve_context *ctx,
 	}
 
 try_resolve:
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	if (dns_cache_find(query, type, cb, user_data) == 0) {
+		if (dns_id) {
+			*dns_id = 0U;
+		}
+
+		return 0;
+	}
+#endif
+
 	k_mutex_lock(&ctx->lock, K_FOREVER);
 
 	if (ctx->state != DNS_RESOLVE_CONTEXT_ACTIVE) {
@@ -1202,39 +1472,13 @@ try_resolve:
 
 	k_work_init_delayable(&ctx->queries[i].timer, query_timeout);
 
-	dns_data = net_buf_alloc(&dns_msg_pool, ctx->buf_timeout);
-	if (!dns_data) {
-		ret = -ENOMEM;
-		goto quit;
-	}
-
-	dns_qname = net_buf_alloc(&dns_qname_pool, ctx->buf_timeout);
-	if (!dns_qname) {
-		ret = -ENOMEM;
-		goto quit;
-	}
-
-	ret = dns_msg_pack_qname(&dns_qname->len, dns_qname->data,
-				DNS_MAX_NAME_LEN, ctx->queries[i].query);
-	if (ret < 0) {
-		goto quit;
-	}
-
-	ctx->queries[i].id = sys_rand32_get();
-
-	/* If mDNS is enabled, then send .local queries only to multicast
-	 * address. For mDNS the id should be set to 0, see RFC 6762 ch. 18.1
+	/* For mDNS the id should be set to 0, see RFC 6762 ch. 18.1
 	 * for details.
 	 */
-	if (IS_ENABLED(CONFIG_MDNS_RESOLVER)) {
-		const char *ptr = strrchr(query, '.');
-
-		/* Note that we memcmp() the \0 here too */
-		if (ptr && !memcmp(ptr, (const void *){ ".local" }, 7)) {
-			mdns_query = true;
-
-			ctx->queries[i].id = 0;
-		}
+	if (is_mdns_query(query)) {
+		ctx->queries[i].id = 0;
+	} else {
+		ctx->queries[i].id = sys_rand32_get();
 	}
 
 	/* Do this immediately after calculating the Id so that the unit
@@ -1246,59 +1490,33 @@ try_resolve:
 		NET_DBG("DNS id will be %u", *dns_id);
 	}
 
-	for (j = 0; j < SERVER_COUNT; j++) {
-		hop_limit = 0U;
-
-		if (!ctx->servers[j].net_ctx) {
-			continue;
-		}
-
-		/* If mDNS is enabled, then send .local queries only to
-		 * a well known multicast mDNS server address.
-		 */
-		if (IS_ENABLED(CONFIG_MDNS_RESOLVER) && mdns_query &&
-		    !ctx->servers[j].is_mdns) {
-			continue;
-		}
-
-		/* If llmnr is enabled, then all the queries are sent to
-		 * LLMNR multicast address unless it is a mDNS query.
-		 */
-		if (!mdns_query && IS_ENABLED(CONFIG_LLMNR_RESOLVER)) {
-			if (!ctx->servers[j].is_llmnr) {
-				continue;
-			}
-
-			hop_limit = 1U;
-		}
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	/* If the same name is already being resolved, wait for its answer
+	 * instead of sending another query.
+	 */
+	ctx->queries[i].leader = get_slot_by_name(ctx, i);
+	if (ctx->queries[i].leader >= 0) {
+		NET_DBG("[%u] waiting for query [%u] of %s", i,
+			ctx->queries[i].leader, log_strdup(query));
 
-		ret = dns_write(ctx, j, i, dns_data, dns_qname, hop_limit);
-		if (ret < 0) {
-			failure++;
-			continue;
+		ret = k_work_reschedule(&ctx->queries[i].timer, tout);
+		if (ret >= 0) {
+			dns_cache_coalesced();
+			ret = 0;
 		}
 
-		/* Do one concurrent query only for each name resolve.
-		 * TODO: Change the i (query index) to do multiple concurrent
-		 *       to each server.
-		 */
-		break;
-	}
-
-	if (failure) {
-		NET_DBG("DNS query failed %d times", failure);
-
-		if (failure == j) {
-			ret = -ENOENT;
-			goto quit;
-		}
+		goto quit;
 	}
+#endif
 
-	ret = 0;
+	ret = dns_send_query(ctx, i);
 
 quit:
 	if (ret < 0) {
 		if (i >= 0) {
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+			ctx->queries[i].leader = -1;
+#endif
 			release_query(&ctx->queries[i]);
 		}
 
@@ -1307,14 +1525,6 @@ quit:
 		}
 	}
 
-	if (dns_data) {
-		net_buf_unref(dns_data);
-	}
-
-	if (dns_qname) {
-		net_buf_unref(dns_qname);
-	}
-
 fail:
 	k_mutex_unlock(&ctx->lock);
 
@@ -1411,6 +1621,11 @@ int dns_resolve_reconfigure(struct dns_resolve_context *ctx,
 
 	err = dns_resolve_init_locked(ctx, servers, servers_sa);
 
+#if defined(CONFIG_DNS_RESOLVER_CACHE)
+	/* The new servers might answer differently */
+	dns_cache_flush();
+#endif
+
 unlock:
 	k_mutex_unlock(&ctx->lock);
 
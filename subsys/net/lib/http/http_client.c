@@ -269,6 +269,9 @@ static int on_body(struct http_parser *parser, const char *at, size_t length)
 		req->internal.response.body_start = (uint8_t *)at;
 	}
 
+	req->internal.response.body_frag_start = (const uint8_t *)at;
+	req->internal.response.body_frag_len = length;
+
 	if (req->internal.response.cb) {
 		if (http_should_keep_alive(parser)) {
 			NET_DBG("Calling callback for partitioned %zd len data",
@@ -291,6 +294,9 @@ static int on_body(struct http_parser *parser, const char *at, size_t length)
 		req->internal.response.body_start = NULL;
 	}
 
+	req->internal.response.body_frag_start = NULL;
+	req->internal.response.body_frag_len = 0;
+
 	return 0;
 }
 
@@ -353,6 +359,12 @@ static int on_message_complete(struct http_parser *parser)
 		http_method_str(req->method));
 
 	req->internal.response.message_complete = 1;
+	req->internal.response.keep_alive = http_should_keep_alive(parser);
+
+	/* Stop parsing here, anything after this message belongs to the
+	 * response of the next request on the connection.
+	 */
+	http_parser_pause(parser, 1);
 
 	if (req->internal.response.cb) {
 		req->internal.response.cb(&req->internal.response,
@@ -408,12 +420,53 @@ static void http_client_init_parser(struct http_parser *parser,
 	settings->on_url = on_url;
 }
 
-static int http_wait_data(int sock, struct http_request *req)
+/* Parse data received at offset of the receive buffer, and if the response
+ * is complete, move the bytes which were not parsed to the start of the
+ * buffer. Returns the number of such bytes.
+ */
+static size_t http_parse_data(struct http_request *req, size_t offset,
+			      size_t len)
+{
+	uint8_t *data = req->internal.response.recv_buf + offset;
+	size_t parsed;
+
+	req->internal.response.data_len += len;
+
+	parsed = http_parser_execute(&req->internal.parser,
+				     &req->internal.parser_settings,
+				     data, len);
+
+	if (!req->internal.response.message_complete || parsed >= len) {
+		return 0;
+	}
+
+	len -= parsed;
+	req->internal.response.data_len -= len;
+	memmove(req->internal.response.recv_buf, data + parsed, len);
+
+	return len;
+}
+
+static int http_wait_data(int sock, struct http_request *req, size_t *pending)
 {
 	int total_received = 0;
 	size_t offset = 0;
 	int received, ret;
 
+	if (*pending > 0) {
+		offset = *pending;
+		total_received = offset;
+
+		*pending = http_parse_data(req, 0, offset);
+		if (req->internal.response.message_complete) {
+			return total_received;
+		}
+
+		if (offset >= req->internal.response.recv_buf_len) {
+			offset = 0;
+		}
+	}
+
 	do {
 		received = recv(sock, req->internal.response.recv_buf + offset,
 				req->internal.response.recv_buf_len - offset,
@@ -429,13 +482,7 @@ static int http_wait_data(int sock, struct http_request *req)
 			ret = -errno;
 			break;
 		} else {
-			req->internal.response.data_len += received;
-
-			(void)http_parser_execute(
-				&req->internal.parser,
-				&req->internal.parser_settings,
-				req->internal.response.recv_buf + offset,
-				received);
+			*pending = http_parse_data(req, offset, received);
 		}
 
 		total_received += received;
@@ -463,17 +510,9 @@ static void http_timeout(struct k_work *work)
 	(void)close(data->sock);
 }
 
-int http_client_req(int sock, struct http_request *req,
-		    int32_t timeout, void *user_data)
+static int http_client_prepare(int sock, struct http_request *req,
+			       int32_t timeout, void *user_data)
 {
-	/* Utilize the network usage by sending data in bigger blocks */
-	char send_buf[MAX_SEND_BUF_LEN];
-	const size_t send_buf_max_len = sizeof(send_buf);
-	size_t send_buf_pos = 0;
-	int total_sent = 0;
-	int ret, total_recv, i;
-	const char *method;
-
 	if (sock < 0 || req == NULL || req->response == NULL ||
 	    req->recv_buf == NULL || req->recv_buf_len == 0) {
 		return -EINVAL;
@@ -489,6 +528,20 @@ int http_client_req(int sock, struct http_request *req,
 	req->internal.sock = sock;
 	req->internal.timeout = SYS_TIMEOUT_MS(timeout);
 
+	return 0;
+}
+
+static int http_send_request(int sock, struct http_request *req,
+			     void *user_data)
+{
+	/* Utilize the network usage by sending data in bigger blocks */
+	char send_buf[MAX_SEND_BUF_LEN];
+	const size_t send_buf_max_len = sizeof(send_buf);
+	size_t send_buf_pos = 0;
+	int total_sent = 0;
+	int ret, i;
+	const char *method;
+
 	method = http_method_str(req->method);
 
 	ret = http_send_data(sock, send_buf, send_buf_max_len, &send_buf_pos,
@@ -649,6 +702,17 @@ int http_client_req(int sock, struct http_request *req,
 
 	NET_DBG("Sent %d bytes", total_sent);
 
+	return total_sent;
+
+out:
+	return ret;
+}
+
+static int http_recv_response(int sock, struct http_request *req,
+			      size_t *pending)
+{
+	int total_recv;
+
 	http_client_init_parser(&req->internal.parser,
 				&req->internal.parser_settings);
 
@@ -659,8 +723,7 @@ int http_client_req(int sock, struct http_request *req,
 					req->internal.timeout);
 	}
 
-	/* Request is sent, now wait data to be received */
-	total_recv = http_wait_data(sock, req);
+	total_recv = http_wait_data(sock, req, pending);
 	if (total_recv < 0) {
 		NET_DBG("Wait data failure (%d)", total_recv);
 	} else {
@@ -672,8 +735,233 @@ int http_client_req(int sock, struct http_request *req,
 		(void)k_work_cancel_delayable(&req->internal.work);
 	}
 
-	return total_sent;
+	return total_recv;
+}
+
+int http_client_req(int sock, struct http_request *req,
+		    int32_t timeout, void *user_data)
+{
+	size_t pending = 0;
+	int ret;
+
+	ret = http_client_prepare(sock, req, timeout, user_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = http_send_request(sock, req, user_data);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* Request is sent, now wait data to be received */
+	(void)http_recv_response(sock, req, &pending);
+	if (pending > 0) {
+		NET_DBG("Dropping %zd bytes after the response", pending);
+	}
 
-out:
 	return ret;
 }
+
+int http_client_req_pipelined(int sock, struct http_request **reqs,
+			      size_t count, int32_t timeout, void *user_data)
+{
+	size_t pending = 0;
+	int total_sent = 0;
+	int ret, i;
+
+	if (reqs == NULL || count == 0) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < count; i++) {
+		ret = http_client_prepare(sock, reqs[i], timeout, user_data);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	/* Send all the requests before waiting for the first response,
+	 * so that the server can answer them back to back.
+	 */
+	for (i = 0; i < count; i++) {
+		ret = http_send_request(sock, reqs[i], user_data);
+		if (ret < 0) {
+			return ret;
+		}
+
+		total_sent += ret;
+	}
+
+	NET_DBG("Pipelined %zd requests", count);
+
+	for (i = 0; i < count; i++) {
+		if (i > 0 && pending > 0) {
+			/* The start of this response was received together
+			 * with the previous one.
+			 */
+			if (pending > reqs[i]->recv_buf_len) {
+				NET_DBG("No room for %zd pending bytes",
+					pending);
+				break;
+			}
+
+			if (reqs[i]->recv_buf != reqs[i - 1]->recv_buf) {
+				memcpy(reqs[i]->recv_buf, reqs[i - 1]->recv_buf,
+				       pending);
+			}
+		}
+
+		ret = http_recv_response(sock, reqs[i], &pending);
+		if (ret < 0 || !reqs[i]->internal.response.message_complete ||
+		    !reqs[i]->internal.response.keep_alive) {
+			break;
+		}
+	}
+
+	return total_sent;
+}
+
+#if defined(CONFIG_HTTP_CLIENT_POOL)
+#define POOL_HOST_MAX_LEN 64
+#define POOL_PORT_MAX_LEN 6
+
+struct http_client_pool_entry {
+	int64_t idle_since;
+	int sock;
+	char host[POOL_HOST_MAX_LEN];
+	char port[POOL_PORT_MAX_LEN];
+};
+
+static struct http_client_pool_entry pool[CONFIG_HTTP_CLIENT_POOL_SIZE] = {
+	[0 ... (CONFIG_HTTP_CLIENT_POOL_SIZE - 1)] = { .sock = -1 },
+};
+static K_MUTEX_DEFINE(pool_lock);
+
+static bool pool_entry_match(struct http_client_pool_entry *entry,
+			     const char *host, const char *port)
+{
+	return entry->sock >= 0 && strcmp(entry->host, host) == 0 &&
+	       strcmp(entry->port, port ? port : "") == 0;
+}
+
+/* An idle connection must not have anything to read: data or EOF means
+ * the server closed it or broke the protocol.
+ */
+static bool pool_entry_alive(struct http_client_pool_entry *entry)
+{
+	struct pollfd fds = {
+		.fd = entry->sock,
+		.events = POLLIN,
+	};
+
+	if (k_uptime_get() - entry->idle_since >
+	    CONFIG_HTTP_CLIENT_POOL_IDLE_TIMEOUT * MSEC_PER_SEC) {
+		NET_DBG("Connection %d idle for too long", entry->sock);
+		return false;
+	}
+
+	if (poll(&fds, 1, 0) != 0) {
+		NET_DBG("Connection %d closed by the server", entry->sock);
+		return false;
+	}
+
+	return true;
+}
+
+static void pool_entry_close(struct http_client_pool_entry *entry)
+{
+	(void)close(entry->sock);
+	entry->sock = -1;
+}
+
+int http_client_pool_get(const char *host, const char *port)
+{
+	int sock = -ENOENT;
+	int i;
+
+	if (host == NULL) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (!pool_entry_match(&pool[i], host, port)) {
+			continue;
+		}
+
+		if (!pool_entry_alive(&pool[i])) {
+			pool_entry_close(&pool[i]);
+			continue;
+		}
+
+		sock = pool[i].sock;
+		pool[i].sock = -1;
+		break;
+	}
+
+	k_mutex_unlock(&pool_lock);
+
+	NET_DBG("Connection to %s: %d", log_strdup(host), sock);
+
+	return sock;
+}
+
+int http_client_pool_put(int sock, const char *host, const char *port)
+{
+	struct http_client_pool_entry *entry = NULL;
+	int i;
+
+	if (sock < 0 || host == NULL) {
+		return -EINVAL;
+	}
+
+	if (strlen(host) >= POOL_HOST_MAX_LEN ||
+	    (port && strlen(port) >= POOL_PORT_MAX_LEN)) {
+		return -ENAMETOOLONG;
+	}
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (pool[i].sock < 0) {
+			entry = &pool[i];
+			break;
+		}
+
+		if (entry == NULL || pool[i].idle_since < entry->idle_since) {
+			entry = &pool[i];
+		}
+	}
+
+	if (entry->sock >= 0) {
+		NET_DBG("Pool full, closing connection %d", entry->sock);
+		pool_entry_close(entry);
+	}
+
+	entry->sock = sock;
+	entry->idle_since = k_uptime_get();
+	strcpy(entry->host, host);
+	strcpy(entry->port, port ? port : "");
+
+	k_mutex_unlock(&pool_lock);
+
+	return 0;
+}
+
+void http_client_pool_flush(void)
+{
+	int i;
+
+	k_mutex_lock(&pool_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (pool[i].sock >= 0) {
+			pool_entry_close(&pool[i]);
+		}
+	}
+
+	k_mutex_unlock(&pool_lock);
+}
+#endif /* CONFIG_HTTP_CLIENT_POOL */
@@ -46,6 +46,12 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 #ifdef CONFIG_LWM2M_RW_JSON_SUPPORT
 #include "lwm2m_rw_json.h"
 #endif
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+#include "lwm2m_rw_senml_cbor.h"
+#endif
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+#include "lwm2m_rw_senml_json.h"
+#endif
 #ifdef CONFIG_LWM2M_RD_CLIENT_SUPPORT
 #include "lwm2m_rd_client.h"
 #endif
@@ -72,16 +78,24 @@ LOG_MODULE_REGISTER(LOG_MODULE_NAME);
 
 struct observe_node {
 	sys_snode_t node;
+	sys_snode_t index_node;
 	struct lwm2m_ctx *ctx;
 	struct lwm2m_obj_path path;
 	uint8_t  token[MAX_TOKEN_LEN];
 	int64_t event_timestamp;
 	int64_t last_timestamp;
+	/* first event not notified yet, 0 if none */
+	int64_t pending_timestamp;
 	uint32_t min_period_sec;
 	uint32_t max_period_sec;
 	uint32_t counter;
 	uint16_t format;
 	uint8_t  tkl;
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	/* paths of a composite observation, which leaves path unused */
+	struct lwm2m_obj_path composite_paths[CONFIG_LWM2M_COMPOSITE_PATH_MAX];
+	uint8_t composite_count;
+#endif
 };
 
 struct notification_attrs {
@@ -96,6 +110,28 @@ struct notification_attrs {
 
 static struct observe_node observe_node_data[CONFIG_LWM2M_ENGINE_MAX_OBSERVER];
 
+/*
+ * Observers hashed by object and instance id, so that a value change only
+ * looks at the observers which can match it. Object level observers use
+ * OBSERVE_INDEX_ANY_INST as instance id. The extra last bucket holds the
+ * observers which cannot be hashed: root level and composite ones.
+ */
+#define OBSERVE_INDEX_BUCKETS	CONFIG_LWM2M_ENGINE_OBSERVE_INDEX_BUCKETS
+#define OBSERVE_INDEX_ANY_INST	UINT16_MAX
+#define OBSERVE_INDEX_WIDE	OBSERVE_INDEX_BUCKETS
+
+static sys_slist_t observe_index[OBSERVE_INDEX_BUCKETS + 1];
+
+/* no observer can be due before this time, INT64_MAX if none is */
+static int64_t notify_next_timestamp;
+
+#if defined(CONFIG_LWM2M_NOTIFY_STATS)
+static struct lwm2m_notify_stats notify_stats;
+#define NOTIFY_STATS_INC(field) (notify_stats.field++)
+#else
+#define NOTIFY_STATS_INC(field)
+#endif
+
 #define MAX_PERIODIC_SERVICE	10
 
 struct service_node {
@@ -344,36 +380,164 @@ static void clear_attrs(void *ref)
 	}
 }
 
-int lwm2m_notify_observer(uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id)
+static inline bool observe_node_is_composite(const struct observe_node *obs)
+{
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	return obs->composite_count > 0U;
+#else
+	return false;
+#endif
+}
+
+static bool observe_path_match(const struct lwm2m_obj_path *path,
+			       uint16_t obj_id, uint16_t obj_inst_id,
+			       uint16_t res_id)
+{
+	return path->obj_id == obj_id &&
+	       path->obj_inst_id == obj_inst_id &&
+	       (path->level < 3 || path->res_id == res_id);
+}
+
+static bool observe_node_match(const struct observe_node *obs,
+			       uint16_t obj_id, uint16_t obj_inst_id,
+			       uint16_t res_id)
+{
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	int i;
+
+	for (i = 0; i < obs->composite_count; i++) {
+		if (observe_path_match(&obs->composite_paths[i], obj_id,
+				       obj_inst_id, res_id)) {
+			return true;
+		}
+	}
+#endif
+
+	return !observe_node_is_composite(obs) &&
+	       observe_path_match(&obs->path, obj_id, obj_inst_id, res_id);
+}
+
+static inline uint8_t observe_index_hash(uint16_t obj_id,
+					 uint16_t obj_inst_id)
+{
+	return (uint8_t)((obj_id * 31U + obj_inst_id) % OBSERVE_INDEX_BUCKETS);
+}
+
+static sys_slist_t *observe_node_bucket(const struct observe_node *obs)
+{
+	if (observe_node_is_composite(obs) ||
+	    obs->path.level == LWM2M_PATH_LEVEL_NONE) {
+		return &observe_index[OBSERVE_INDEX_WIDE];
+	}
+
+	if (obs->path.level == LWM2M_PATH_LEVEL_OBJECT) {
+		return &observe_index[observe_index_hash(
+				obs->path.obj_id, OBSERVE_INDEX_ANY_INST)];
+	}
+
+	return &observe_index[observe_index_hash(obs->path.obj_id,
+						 obs->path.obj_inst_id)];
+}
+
+/* Make sure the engine service looks at the observers by timestamp */
+static inline void notify_due_at(int64_t timestamp)
+{
+	if (timestamp < notify_next_timestamp) {
+		notify_next_timestamp = timestamp;
+	}
+}
+
+static void observe_node_link(struct observe_node *obs)
+{
+	sys_slist_append(&engine_observer_list, &obs->node);
+	sys_slist_append(observe_node_bucket(obs), &obs->index_node);
+
+	if (obs->max_period_sec > 0) {
+		notify_due_at(obs->last_timestamp +
+			      MSEC_PER_SEC * obs->max_period_sec);
+	}
+}
+
+/* Remove obs from the observer list, prev_node is its predecessor there */
+static void observe_node_unlink(struct observe_node *obs,
+				sys_snode_t *prev_node)
+{
+	sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
+	sys_slist_find_and_remove(observe_node_bucket(obs), &obs->index_node);
+	(void)memset(obs, 0, sizeof(*obs));
+}
+
+static int notify_bucket(sys_slist_t *bucket, uint16_t obj_id,
+			 uint16_t obj_inst_id, uint16_t res_id,
+			 int64_t timestamp)
 {
 	struct observe_node *obs;
 	int ret = 0;
 
-	/* look for observers which match our resource */
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		if (obs->path.obj_id == obj_id &&
-		    obs->path.obj_inst_id == obj_inst_id &&
-		    (obs->path.level < 3 ||
-		     obs->path.res_id == res_id)) {
-			/* update the event time for this observer */
-			obs->event_timestamp = k_uptime_get();
-
-			LOG_DBG("NOTIFY EVENT %u/%u/%u",
-				obj_id, obj_inst_id, res_id);
+	SYS_SLIST_FOR_EACH_CONTAINER(bucket, obs, index_node) {
+		if (!observe_node_match(obs, obj_id, obj_inst_id, res_id)) {
+			continue;
+		}
 
-			ret++;
+		/* update the event time for this observer */
+		obs->event_timestamp = timestamp;
+		if (obs->pending_timestamp == 0) {
+			obs->pending_timestamp = timestamp;
 		}
+
+		notify_due_at(obs->last_timestamp +
+			      MSEC_PER_SEC * obs->min_period_sec);
+		NOTIFY_STATS_INC(events);
+
+		LOG_DBG("NOTIFY EVENT %u/%u/%u", obj_id, obj_inst_id, res_id);
+
+		ret++;
 	}
 
 	return ret;
 }
 
+int lwm2m_notify_observer(uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id)
+{
+	int64_t timestamp = k_uptime_get();
+	uint8_t inst_hash, obj_hash;
+	int ret;
+
+	/* look for observers which match our resource */
+	inst_hash = observe_index_hash(obj_id, obj_inst_id);
+	ret = notify_bucket(&observe_index[inst_hash], obj_id, obj_inst_id,
+			    res_id, timestamp);
+
+	obj_hash = observe_index_hash(obj_id, OBSERVE_INDEX_ANY_INST);
+	if (obj_hash != inst_hash) {
+		ret += notify_bucket(&observe_index[obj_hash], obj_id,
+				     obj_inst_id, res_id, timestamp);
+	}
+
+	ret += notify_bucket(&observe_index[OBSERVE_INDEX_WIDE], obj_id,
+			     obj_inst_id, res_id, timestamp);
+
+	return ret;
+}
+
 int lwm2m_notify_observer_path(struct lwm2m_obj_path *path)
 {
 	return lwm2m_notify_observer(path->obj_id, path->obj_inst_id,
 				     path->res_id);
 }
 
+#if defined(CONFIG_LWM2M_NOTIFY_STATS)
+void lwm2m_engine_get_notify_stats(struct lwm2m_notify_stats *stats)
+{
+	*stats = notify_stats;
+}
+
+void lwm2m_engine_reset_notify_stats(void)
+{
+	(void)memset(&notify_stats, 0, sizeof(notify_stats));
+}
+#endif /* CONFIG_LWM2M_NOTIFY_STATS */
+
 static int engine_add_observer(struct lwm2m_message *msg,
 			       const uint8_t *token, uint8_t tkl,
 			       uint16_t format)
@@ -512,8 +676,7 @@ static int engine_add_observer(struct lwm2m_message *msg,
 							       : attrs.pmax;
 	observe_node_data[i].format = format;
 	observe_node_data[i].counter = OBSERVE_COUNTER_START;
-	sys_slist_append(&engine_observer_list,
-			 &observe_node_data[i].node);
+	observe_node_link(&observe_node_data[i]);
 
 	LOG_DBG("OBSERVER ADDED %u/%u/%u(%u) token:'%s' addr:%s",
 		msg->path.obj_id, msg->path.obj_inst_id,
@@ -549,14 +712,77 @@ static int engine_remove_observer(const uint8_t *token, uint8_t tkl)
 		return -ENOENT;
 	}
 
-	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
-	(void)memset(found_obj, 0, sizeof(*found_obj));
+	observe_node_unlink(found_obj, prev_node);
 
 	LOG_DBG("observer '%s' removed", log_strdup(sprint_token(token, tkl)));
 
 	return 0;
 }
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+static int engine_add_composite_observer(struct lwm2m_message *msg,
+					 const uint8_t *token, uint8_t tkl,
+					 uint16_t format,
+					 struct lwm2m_obj_path *paths,
+					 uint8_t path_count)
+{
+	struct observe_node *obs;
+	int i;
+
+	if (!msg || !msg->ctx) {
+		LOG_ERR("valid lwm2m message is required");
+		return -EINVAL;
+	}
+
+	if (!token || (tkl == 0U || tkl > MAX_TOKEN_LEN)) {
+		LOG_ERR("token(%p) and token length(%u) must be valid.",
+			token, tkl);
+		return -EINVAL;
+	}
+
+	/* a repeated request replaces the previous list of paths */
+	(void)engine_remove_observer(token, tkl);
+
+	/* find an unused observer index node */
+	for (i = 0; i < CONFIG_LWM2M_ENGINE_MAX_OBSERVER; i++) {
+		if (!observe_node_data[i].ctx) {
+			break;
+		}
+	}
+
+	/* couldn't find an index */
+	if (i == CONFIG_LWM2M_ENGINE_MAX_OBSERVER) {
+		return -ENOMEM;
+	}
+
+	/* there are no attributes for composite observations */
+	obs = &observe_node_data[i];
+	obs->ctx = msg->ctx;
+	memcpy(obs->composite_paths, paths, path_count * sizeof(*paths));
+	obs->composite_count = path_count;
+	memcpy(obs->token, token, tkl);
+	obs->tkl = tkl;
+	obs->last_timestamp = k_uptime_get();
+	obs->event_timestamp = obs->last_timestamp;
+	obs->min_period_sec = lwm2m_server_get_pmin(msg->ctx->srv_obj_inst);
+	obs->max_period_sec = lwm2m_server_get_pmax(msg->ctx->srv_obj_inst);
+	if (obs->max_period_sec > 0) {
+		obs->max_period_sec = MAX(obs->max_period_sec,
+					  obs->min_period_sec);
+	}
+
+	obs->format = format;
+	obs->counter = OBSERVE_COUNTER_START;
+	observe_node_link(obs);
+
+	LOG_DBG("COMPOSITE OBSERVER ADDED (%u paths) token:'%s' addr:%s",
+		path_count, log_strdup(sprint_token(token, tkl)),
+		log_strdup(lwm2m_sprint_ip_addr(&msg->ctx->remote_addr)));
+
+	return 0;
+}
+#endif /* CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT */
+
 #if defined(CONFIG_LOG)
 char *lwm2m_path_log_strdup(char *buf, struct lwm2m_obj_path *path)
 {
@@ -599,8 +825,7 @@ static int engine_remove_observer_by_path(struct lwm2m_obj_path *path)
 
 	LOG_INF("Removing observer for path %s",
 		lwm2m_path_log_strdup(buf, path));
-	sys_slist_remove(&engine_observer_list, prev_node, &found_obj->node);
-	(void)memset(found_obj, 0, sizeof(*found_obj));
+	observe_node_unlink(found_obj, prev_node);
 
 	return 0;
 }
@@ -614,14 +839,15 @@ static void engine_remove_observer_by_id(uint16_t obj_id, int32_t obj_inst_id)
 	/* remove observer instances accordingly */
 	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(
 			&engine_observer_list, obs, tmp, node) {
-		if (!(obj_id == obs->path.obj_id &&
+		/* composite observers just skip the paths that are gone */
+		if (observe_node_is_composite(obs) ||
+		    !(obj_id == obs->path.obj_id &&
 		      obj_inst_id == obs->path.obj_inst_id)) {
 			prev_node = &obs->node;
 			continue;
 		}
 
-		sys_slist_remove(&engine_observer_list, prev_node, &obs->node);
-		(void)memset(obs, 0, sizeof(*obs));
+		observe_node_unlink(obs, prev_node);
 	}
 }
 
@@ -1214,6 +1440,18 @@ static int select_writer(struct lwm2m_output_context *out, uint16_t accept)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		out->writer = &senml_cbor_writer;
+		break;
+#endif
+
+#ifdef CONFIG_LWM2M_RW_SENML_JSON_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		out->writer = &senml_json_writer;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", accept);
 		return -ENOMSG;
@@ -1245,6 +1483,12 @@ static int select_reader(struct lwm2m_input_context *in, uint16_t format)
 		break;
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		in->reader = &senml_cbor_reader;
+		break;
+#endif
+
 	default:
 		LOG_WRN("Unknown content type %u", format);
 		return -ENOMSG;
@@ -2052,6 +2296,7 @@ int lwm2m_engine_update_observer_min_period(char *pathstr, uint32_t period_s)
 		     observe_node_data[i].path.res_id == path.res_id : true)) {
 
 			observe_node_data[i].min_period_sec = period_s;
+			notify_due_at(0);
 			return 0;
 		}
 	}
@@ -2078,6 +2323,7 @@ int lwm2m_engine_update_observer_max_period(char *pathstr, uint32_t period_s)
 		     observe_node_data[i].path.res_id == path.res_id : true)) {
 
 			observe_node_data[i].max_period_sec = period_s;
+			notify_due_at(0);
 			return 0;
 		}
 	}
@@ -3100,6 +3346,9 @@ static int lwm2m_write_attr_handler(struct lwm2m_engine_obj *obj,
 		(void)memset(&nattrs, 0, sizeof(nattrs));
 	}
 
+	/* the periods changed, let the engine service recompute them */
+	notify_due_at(0);
+
 	return 0;
 }
 
@@ -3179,6 +3428,16 @@ static int do_read_op(struct lwm2m_message *msg, uint16_t content_format)
 		return do_read_op_json(msg, content_format);
 #endif
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_read_op_senml_cbor(msg, content_format);
+#endif
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_read_op_senml_json(msg, content_format);
+#endif
+
 	default:
 		LOG_ERR("Unsupported content-format: %u", content_format);
 		return -ENOMSG;
@@ -3186,26 +3445,24 @@ static int do_read_op(struct lwm2m_message *msg, uint16_t content_format)
 	}
 }
 
-int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
+static struct lwm2m_engine_obj_inst *
+read_op_first_obj_inst(const struct lwm2m_obj_path *path)
 {
-	struct lwm2m_engine_obj_inst *obj_inst = NULL;
-	struct lwm2m_engine_res *res = NULL;
-	struct lwm2m_engine_obj_field *obj_field;
-	struct lwm2m_obj_path temp_path;
-	int ret = 0, index;
-	uint8_t num_read = 0U;
+	if (path->level >= 2U) {
+		return get_engine_obj_inst(path->obj_id, path->obj_inst_id);
+	}
 
-	if (msg->path.level >= 2U) {
-		obj_inst = get_engine_obj_inst(msg->path.obj_id,
-					       msg->path.obj_inst_id);
-	} else if (msg->path.level == 1U) {
+	if (path->level == 1U) {
 		/* find first obj_inst with path's obj_id */
-		obj_inst = next_engine_obj_inst(msg->path.obj_id, -1);
+		return next_engine_obj_inst(path->obj_id, -1);
 	}
 
-	if (!obj_inst) {
-		return -ENOENT;
-	}
+	return NULL;
+}
+
+static int read_op_begin(struct lwm2m_message *msg, uint16_t content_format)
+{
+	int ret;
 
 	/* set output content-format */
 	ret = coap_append_option_int(msg->out.out_cpkt,
@@ -3222,9 +3479,17 @@ int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
 		return ret;
 	}
 
-	/* store original path values so we can change them during processing */
-	memcpy(&temp_path, &msg->path, sizeof(temp_path));
-	engine_put_begin(&msg->out, &msg->path);
+	return 0;
+}
+
+/* Read all the resources below msg->path, starting with obj_inst */
+static int read_op_path(struct lwm2m_message *msg,
+			struct lwm2m_engine_obj_inst *obj_inst,
+			uint8_t *num_read)
+{
+	struct lwm2m_engine_res *res = NULL;
+	struct lwm2m_engine_obj_field *obj_field;
+	int ret = 0, index;
 
 	while (obj_inst) {
 		if (!obj_inst->resources || obj_inst->resource_count == 0U) {
@@ -3275,7 +3540,7 @@ int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
 						LOG_ERR("READ OP: %d", ret);
 					}
 				} else {
-					num_read += 1U;
+					*num_read += 1U;
 				}
 
 				/* end resource formatting */
@@ -3306,6 +3571,32 @@ move_forward:
 		}
 	}
 
+	return ret;
+}
+
+int lwm2m_perform_read_op(struct lwm2m_message *msg, uint16_t content_format)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_obj_path temp_path;
+	int ret;
+	uint8_t num_read = 0U;
+
+	obj_inst = read_op_first_obj_inst(&msg->path);
+	if (!obj_inst) {
+		return -ENOENT;
+	}
+
+	ret = read_op_begin(msg, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* store original path values so we can change them during processing */
+	memcpy(&temp_path, &msg->path, sizeof(temp_path));
+	engine_put_begin(&msg->out, &msg->path);
+
+	ret = read_op_path(msg, obj_inst, &num_read);
+
 	engine_put_end(&msg->out, &msg->path);
 
 	/* restore original path values */
@@ -3319,6 +3610,69 @@ move_forward:
 	return ret;
 }
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+int lwm2m_perform_composite_read_op(struct lwm2m_message *msg,
+				    uint16_t content_format,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_obj_path temp_path;
+	int ret, i;
+	uint8_t num_read = 0U;
+
+	ret = read_op_begin(msg, content_format);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* all the paths go into a single output */
+	memcpy(&temp_path, &msg->path, sizeof(temp_path));
+	engine_put_begin(&msg->out, &msg->path);
+
+	for (i = 0; i < path_count; i++) {
+		/* paths which cannot be read are left out of the result */
+		obj_inst = read_op_first_obj_inst(&paths[i]);
+		if (!obj_inst) {
+			continue;
+		}
+
+		memcpy(&msg->path, &paths[i], sizeof(msg->path));
+		(void)read_op_path(msg, obj_inst, &num_read);
+	}
+
+	engine_put_end(&msg->out, &msg->path);
+
+	/* restore original path values */
+	memcpy(&msg->path, &temp_path, sizeof(temp_path));
+
+	return num_read > 0U ? 0 : -ENOENT;
+}
+
+static int do_composite_read_op(struct lwm2m_message *msg,
+				uint16_t content_format,
+				struct lwm2m_obj_path *paths,
+				uint8_t path_count)
+{
+	switch (content_format) {
+
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_composite_read_op_senml_cbor(msg, paths, path_count);
+
+#if defined(CONFIG_LWM2M_RW_SENML_JSON_SUPPORT)
+	case LWM2M_FORMAT_APP_SENML_JSON:
+		return do_composite_read_op_senml_json(msg, paths, path_count);
+#endif
+
+	default:
+		LOG_ERR("Unsupported composite content-format: %u",
+			content_format);
+		return -ENOMSG;
+
+	}
+}
+#endif /* CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT */
+
 int lwm2m_discover_handler(struct lwm2m_message *msg, bool is_bootstrap)
 {
 	struct lwm2m_engine_obj *obj;
@@ -3568,6 +3922,11 @@ static int do_write_op(struct lwm2m_message *msg,
 		return do_write_op_json(msg);
 #endif
 
+#ifdef CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT
+	case LWM2M_FORMAT_APP_SENML_CBOR:
+		return do_write_op_senml_cbor(msg);
+#endif
+
 	default:
 		LOG_ERR("Unsupported format: %u", format);
 		return -ENOMSG;
@@ -3651,6 +4010,59 @@ static int bootstrap_delete(struct lwm2m_message *msg)
 }
 #endif
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+/* Composite read / observe: a FETCH to the root with a SenML list of paths */
+static int do_composite_request(struct lwm2m_message *msg, uint16_t format,
+				uint16_t accept, int observe,
+				const uint8_t *token, uint8_t tkl)
+{
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_PATH_MAX];
+	int path_count;
+	int r;
+
+	if (format != LWM2M_FORMAT_APP_SENML_CBOR) {
+		return -ENOMSG;
+	}
+
+	path_count = senml_cbor_parse_paths(&msg->in, paths, ARRAY_SIZE(paths));
+	if (path_count == -EFBIG) {
+		return path_count;
+	} else if (path_count <= 0) {
+		LOG_ERR("Invalid composite path list: %d", path_count);
+		return -EBADMSG;
+	}
+
+	if (observe == 0) {
+		if (!msg->token) {
+			LOG_ERR("OBSERVE request missing token");
+			return -EINVAL;
+		}
+
+		r = coap_append_option_int(msg->out.out_cpkt,
+					   COAP_OPTION_OBSERVE,
+					   OBSERVE_COUNTER_START);
+		if (r < 0) {
+			LOG_ERR("OBSERVE option error: %d", r);
+			return r;
+		}
+
+		r = engine_add_composite_observer(msg, token, tkl, accept,
+						  paths, path_count);
+		if (r < 0) {
+			LOG_ERR("add composite OBSERVE error: %d", r);
+			return r;
+		}
+	} else if (observe == 1) {
+		r = engine_remove_observer(token, tkl);
+		if (r < 0) {
+			LOG_ERR("remove observe error: %d", r);
+		}
+	}
+
+	return do_composite_read_op(msg, accept, paths, path_count);
+}
+#endif /* CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT */
+
 static int handle_request(struct coap_packet *request,
 			  struct lwm2m_message *msg)
 {
@@ -3668,6 +4080,7 @@ static int handle_request(struct coap_packet *request,
 	uint16_t payload_len = 0U;
 	bool last_block = false;
 	bool ignore = false;
+	bool composite = false;
 
 	/* set CoAP request / message */
 	msg->in.in_cpkt = request;
@@ -3714,6 +4127,12 @@ static int handle_request(struct coap_packet *request,
 
 			r = -EPERM;
 			goto error;
+#endif
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+		case COAP_METHOD_FETCH:
+			/* composite read / observe, paths are in the payload */
+			composite = true;
+			break;
 #endif
 		default:
 			r = -EPERM;
@@ -3770,7 +4189,8 @@ static int handle_request(struct coap_packet *request,
 		goto error;
 	}
 
-	if (!(msg->ctx->bootstrap_mode && msg->path.level == 0)) {
+	if (!composite &&
+	    !(msg->ctx->bootstrap_mode && msg->path.level == 0)) {
 		/* find registered obj */
 		obj = get_engine_obj(msg->path.obj_id);
 		if (!obj) {
@@ -3833,6 +4253,20 @@ static int handle_request(struct coap_packet *request,
 		msg->code = COAP_RESPONSE_CODE_DELETED;
 		break;
 
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	case COAP_METHOD_FETCH:
+		if (!composite) {
+			r = -EPERM;
+			goto error;
+		}
+
+		msg->operation = LWM2M_OP_READ;
+		observe = coap_get_option_int(msg->in.in_cpkt,
+					      COAP_OPTION_OBSERVE);
+		msg->code = COAP_RESPONSE_CODE_CONTENT;
+		break;
+#endif
+
 	default:
 		break;
 	}
@@ -3917,6 +4351,14 @@ static int handle_request(struct coap_packet *request,
 		switch (msg->operation) {
 
 		case LWM2M_OP_READ:
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+			if (composite) {
+				r = do_composite_request(msg, format, accept,
+							 observe, token, tkl);
+				break;
+			}
+#endif
+
 			if (observe == 0) {
 				/* add new observer */
 				if (msg->token) {
@@ -4020,7 +4462,7 @@ error:
 		msg->code = COAP_RESPONSE_CODE_NOT_FOUND;
 	} else if (r == -EPERM) {
 		msg->code = COAP_RESPONSE_CODE_NOT_ALLOWED;
-	} else if (r == -EEXIST) {
+	} else if (r == -EEXIST || r == -EBADMSG) {
 		msg->code = COAP_RESPONSE_CODE_BAD_REQUEST;
 	} else if (r == -EFAULT) {
 		msg->code = COAP_RESPONSE_CODE_INCOMPLETE;
@@ -4367,7 +4809,7 @@ static int generate_notify_message(struct observe_node *obs,
 
 	obj_inst = get_engine_obj_inst(obs->path.obj_id,
 				       obs->path.obj_inst_id);
-	if (!obj_inst) {
+	if (!obj_inst && !observe_node_is_composite(obs)) {
 		LOG_ERR("unable to get engine obj for %u/%u",
 			obs->path.obj_id,
 			obs->path.obj_inst_id);
@@ -4401,7 +4843,17 @@ static int generate_notify_message(struct observe_node *obs,
 	/* set the output writer */
 	select_writer(&msg->out, obs->format);
 
-	ret = do_read_op(msg, obs->format);
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+	if (observe_node_is_composite(obs)) {
+		ret = do_composite_read_op(msg, obs->format,
+					   obs->composite_paths,
+					   obs->composite_count);
+	} else
+#endif
+	{
+		ret = do_read_op(msg, obs->format);
+	}
+
 	if (ret < 0) {
 		LOG_ERR("error in multi-format read (err:%d)", ret);
 		goto cleanup;
@@ -4427,6 +4879,15 @@ int32_t engine_next_service_timeout_ms(uint32_t max_timeout)
 	uint64_t time_left_ms, timestamp = k_uptime_get();
 	uint32_t timeout = max_timeout;
 
+	/* a notification is due */
+	if (notify_next_timestamp <= timestamp) {
+		return 0;
+	}
+
+	if (notify_next_timestamp - timestamp < timeout) {
+		timeout = notify_next_timestamp - timestamp;
+	}
+
 	SYS_SLIST_FOR_EACH_CONTAINER(&engine_service_list, srv, node) {
 		time_left_ms = srv->last_timestamp + srv->min_call_period;
 
@@ -4484,45 +4945,136 @@ int lwm2m_engine_update_service_period(k_work_handler_t service, uint32_t period
 	return -ENOENT;
 }
 
+static void notify_observer(struct observe_node *obs, int64_t timestamp,
+			    bool manual_trigger)
+{
+	int64_t latency;
+
+	if (manual_trigger) {
+		latency = timestamp - obs->pending_timestamp;
+#if defined(CONFIG_LWM2M_NOTIFY_STATS)
+		notify_stats.latency_total_ms += latency;
+		if (latency > notify_stats.latency_max_ms) {
+			notify_stats.latency_max_ms = latency;
+		}
+#endif
+		LOG_DBG("notify latency %lld ms", (long long)latency);
+	}
+
+	obs->last_timestamp = timestamp;
+	obs->pending_timestamp = 0;
+
+	if (generate_notify_message(obs, manual_trigger) < 0) {
+		NOTIFY_STATS_INC(failed);
+	} else if (manual_trigger) {
+		NOTIFY_STATS_INC(triggered);
+	} else {
+		NOTIFY_STATS_INC(periodic);
+	}
+}
+
+/* Returns true if a notification was sent for obs */
+static bool check_notification(struct observe_node *obs, int64_t timestamp)
+{
+	int64_t pmin_timestamp, pmax_timestamp;
+
+	pmin_timestamp = obs->last_timestamp +
+			 MSEC_PER_SEC * obs->min_period_sec;
+	pmax_timestamp = obs->last_timestamp +
+			 MSEC_PER_SEC * obs->max_period_sec;
+
+	/*
+	 * manual notify requirements:
+	 * - an event is pending (it may have the same timestamp as
+	 *   the last notification)
+	 * - if min_period_sec is set:
+	 *   current timestamp > last_timestamp + min_period_sec
+	 */
+	if (obs->pending_timestamp > 0 &&
+	    (obs->min_period_sec == 0 || timestamp > pmin_timestamp)) {
+		notify_observer(obs, timestamp, true);
+		return true;
+	}
+
+	/*
+	 * automatic time-based notify requirements:
+	 * - if max_period_sec is set:
+	 *   current timestamp > last_timestamp + max_period_sec
+	 */
+	if (obs->max_period_sec > 0 && timestamp > pmax_timestamp) {
+		notify_observer(obs, timestamp, false);
+		return true;
+	}
+
+	/* not due yet, remember when it will be */
+	if (obs->pending_timestamp > 0) {
+		notify_due_at(pmin_timestamp + 1);
+	}
+
+	if (obs->max_period_sec > 0) {
+		notify_due_at(pmax_timestamp + 1);
+	}
+
+	return false;
+}
+
+/*
+ * Send the time-based notifications which would be due within the coalesce
+ * window right away, as the engine just woke up to send other ones. The
+ * minimum period is still honored.
+ */
+static void coalesce_notifications(int64_t timestamp)
+{
+	struct observe_node *obs;
+	int64_t pmin_timestamp, pmax_timestamp;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
+		if (obs->max_period_sec == 0 ||
+		    obs->last_timestamp == timestamp) {
+			continue;
+		}
+
+		pmin_timestamp = obs->last_timestamp +
+				 MSEC_PER_SEC * obs->min_period_sec;
+		pmax_timestamp = obs->last_timestamp +
+				 MSEC_PER_SEC * obs->max_period_sec;
+		if (timestamp <= pmin_timestamp ||
+		    timestamp + CONFIG_LWM2M_NOTIFY_COALESCE_MS <
+		    pmax_timestamp) {
+			continue;
+		}
+
+		NOTIFY_STATS_INC(coalesced);
+		notify_observer(obs, timestamp, false);
+		notify_due_at(timestamp + MSEC_PER_SEC * obs->max_period_sec + 1);
+	}
+}
+
 static int lwm2m_engine_service(void)
 {
 	struct observe_node *obs;
 	struct service_node *srv;
 	int64_t timestamp, service_due_timestamp;
+	bool notified = false;
 
 	/*
-	 * 1. scan the observer list
-	 * 2. For each notify event found, scan the observer list
-	 * 3. For each observer match, generate a NOTIFY message,
+	 * 1. skip the observer list until an observer can be due
+	 * 2. scan the observer list
+	 * 3. For each observer which is due, generate a NOTIFY message,
 	 *    attaching the notify response handler
 	 */
 	timestamp = k_uptime_get();
-	SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs, node) {
-		/*
-		 * manual notify requirements:
-		 * - event_timestamp > last_timestamp
-		 * - if min_period_sec is set:
-		 *   current timestamp > last_timestamp + min_period_sec
-		 */
-		if (obs->event_timestamp > obs->last_timestamp &&
-		    (obs->min_period_sec == 0 ||
-		     timestamp > obs->last_timestamp +
-				MSEC_PER_SEC * obs->min_period_sec)) {
-			obs->last_timestamp = k_uptime_get();
-			generate_notify_message(obs, true);
+	if (timestamp >= notify_next_timestamp) {
+		notify_next_timestamp = INT64_MAX;
 
-		/*
-		 * automatic time-based notify requirements:
-		 * - if max_period_sec is set:
-		 *   current timestamp > last_timestamp + max_period_sec
-		 */
-		} else if (obs->max_period_sec > 0 &&
-			   timestamp > obs->last_timestamp +
-				MSEC_PER_SEC * obs->max_period_sec) {
-			obs->last_timestamp = k_uptime_get();
-			generate_notify_message(obs, false);
+		SYS_SLIST_FOR_EACH_CONTAINER(&engine_observer_list, obs,
+					     node) {
+			notified |= check_notification(obs, timestamp);
 		}
 
+		if (notified && CONFIG_LWM2M_NOTIFY_COALESCE_MS > 0) {
+			coalesce_notifications(timestamp);
+		}
 	}
 
 	timestamp = k_uptime_get();
@@ -4555,9 +5107,7 @@ int lwm2m_engine_context_close(struct lwm2m_ctx *client_ctx)
 	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&engine_observer_list,
 					  obs, tmp, node) {
 		if (obs->ctx == client_ctx) {
-			sys_slist_remove(&engine_observer_list, prev_node,
-					 &obs->node);
-			(void)memset(obs, 0, sizeof(*obs));
+			observe_node_unlink(obs, prev_node);
 		} else {
 			prev_node = &obs->node;
 		}
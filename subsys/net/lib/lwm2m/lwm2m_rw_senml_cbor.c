@@ -0,0 +1,1227 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML CBOR (RFC 8428) reader / writer.
+ *
+ * The writer emits one SenML record per resource (instance) and repeats
+ * the base name only when the object instance changes, which keeps
+ * multi-resource and composite payloads small.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_cbor
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/byteorder.h>
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_buf_writer.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_util.h"
+
+/* SenML labels */
+#define SENML_BN	-2
+#define SENML_N		0
+#define SENML_V		2
+#define SENML_VS	3
+#define SENML_VB	4
+#define SENML_VD	8
+
+/* Text labels are mapped outside of the range of the integer labels */
+#define SENML_VLO	0x10000
+#define SENML_UNKNOWN	0x10001
+
+#define SENML_NAME_LEN	sizeof("/65535/65535/65535/65535")
+
+/* Largest CBOR item head */
+#define CBOR_MAX_HEAD	9
+
+/* Appends the encoded data to a CoAP packet */
+struct cbor_cpkt_writer {
+	struct cbor_encoder_writer enc;
+	struct coap_packet *cpkt;
+};
+
+/* Reads the CBOR data of a CoAP packet, starting at the base offset */
+struct cbor_cpkt_reader {
+	struct cbor_decoder_reader r;
+	struct coap_packet *cpkt;
+	uint16_t base;
+};
+
+struct cbor_out_formatter_data {
+	/* offset of the array head, completed once the pack is written */
+	uint16_t array_offset;
+	uint16_t record_count;
+
+	/* object instance of the current base name */
+	uint16_t bn_obj_id;
+	uint16_t bn_obj_inst_id;
+	bool bn_valid;
+
+	/* flags */
+	uint8_t writer_flags;
+
+	/* record being written */
+	uint16_t record_offset;
+	bool record_bn;
+	struct cbor_cpkt_writer writer;
+	CborEncoder encoder;
+	CborEncoder map;
+};
+
+struct cbor_in_formatter_data {
+	struct cbor_cpkt_reader reader;
+	CborParser parser;
+	CborValue pack;
+	CborValue records;
+
+	/* value of the current record, 0 if there is none */
+	uint16_t value_offset;
+
+	/* the base name applies to all the records that follow it */
+	char base_name[SENML_NAME_LEN];
+	char name[SENML_NAME_LEN];
+};
+
+static int cbor_cpkt_write(struct cbor_encoder_writer *writer,
+			   const char *data, int len)
+{
+	struct cbor_cpkt_writer *ccw = (struct cbor_cpkt_writer *)writer;
+
+	if (buf_append(CPKT_BUF_WRITE(ccw->cpkt), (uint8_t *)data, len) < 0) {
+		return CborErrorOutOfMemory;
+	}
+
+	ccw->enc.bytes_written += len;
+	return CborNoError;
+}
+
+static void cbor_cpkt_writer_init(struct cbor_cpkt_writer *ccw,
+				  struct coap_packet *cpkt)
+{
+	ccw->enc.write = cbor_cpkt_write;
+	ccw->enc.bytes_written = 0;
+	ccw->cpkt = cpkt;
+}
+
+static bool cbor_cpkt_in_range(struct cbor_cpkt_reader *ccr, int offset,
+			       size_t len)
+{
+	return offset >= 0 && offset <= (int)ccr->r.message_size - (int)len;
+}
+
+static uint8_t cbor_cpkt_get8(struct cbor_decoder_reader *d, int offset)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, sizeof(uint8_t))) {
+		return UINT8_MAX;
+	}
+
+	return ccr->cpkt->data[ccr->base + offset];
+}
+
+static uint16_t cbor_cpkt_get16(struct cbor_decoder_reader *d, int offset)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, sizeof(uint16_t))) {
+		return UINT16_MAX;
+	}
+
+	return sys_get_be16(&ccr->cpkt->data[ccr->base + offset]);
+}
+
+static uint32_t cbor_cpkt_get32(struct cbor_decoder_reader *d, int offset)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, sizeof(uint32_t))) {
+		return UINT32_MAX;
+	}
+
+	return sys_get_be32(&ccr->cpkt->data[ccr->base + offset]);
+}
+
+static uint64_t cbor_cpkt_get64(struct cbor_decoder_reader *d, int offset)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, sizeof(uint64_t))) {
+		return UINT64_MAX;
+	}
+
+	return sys_get_be64(&ccr->cpkt->data[ccr->base + offset]);
+}
+
+static uintptr_t cbor_cpkt_cmp(struct cbor_decoder_reader *d, char *buf,
+			       int offset, size_t len)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, len)) {
+		return -1;
+	}
+
+	return memcmp(&ccr->cpkt->data[ccr->base + offset], buf, len);
+}
+
+static uintptr_t cbor_cpkt_cpy(struct cbor_decoder_reader *d, char *dst,
+			       int offset, size_t len)
+{
+	struct cbor_cpkt_reader *ccr = (struct cbor_cpkt_reader *)d;
+
+	if (!cbor_cpkt_in_range(ccr, offset, len)) {
+		return -1;
+	}
+
+	return (uintptr_t)memcpy(dst, &ccr->cpkt->data[ccr->base + offset],
+				 len);
+}
+
+static void cbor_cpkt_reader_init(struct cbor_cpkt_reader *ccr,
+				  struct coap_packet *cpkt, uint16_t base)
+{
+	ccr->r.get8 = cbor_cpkt_get8;
+	ccr->r.get16 = cbor_cpkt_get16;
+	ccr->r.get32 = cbor_cpkt_get32;
+	ccr->r.get64 = cbor_cpkt_get64;
+	ccr->r.cmp = cbor_cpkt_cmp;
+	ccr->r.cpy = cbor_cpkt_cpy;
+	ccr->r.message_size = cpkt->max_len > base ? cpkt->max_len - base : 0;
+
+	ccr->cpkt = cpkt;
+	ccr->base = base;
+}
+
+/*
+ * Opens the map of a record and encodes its name, the caller encodes the
+ * value label and the value in fd->map before calling record_end().
+ */
+static CborError record_begin(struct lwm2m_output_context *out,
+			      struct cbor_out_formatter_data *fd,
+			      struct lwm2m_obj_path *path)
+{
+	char buf[sizeof("/65535/65535/")];
+	size_t len;
+	CborError err;
+
+	fd->record_offset = out->out_cpkt->offset;
+	fd->record_bn = !fd->bn_valid || fd->bn_obj_id != path->obj_id ||
+			fd->bn_obj_inst_id != path->obj_inst_id;
+
+	cbor_cpkt_writer_init(&fd->writer, out->out_cpkt);
+	cbor_encoder_init(&fd->encoder, &fd->writer.enc, 0);
+
+	err = cbor_encoder_create_map(&fd->encoder, &fd->map,
+				      fd->record_bn ? 3 : 2);
+
+	if (fd->record_bn) {
+		/* "/<obj>/<inst>/" */
+		len = 0;
+		buf[len++] = '/';
+		len += lwm2m_u64_to_str(path->obj_id, &buf[len]);
+		buf[len++] = '/';
+		len += lwm2m_u64_to_str(path->obj_inst_id, &buf[len]);
+		buf[len++] = '/';
+
+		err |= cbor_encode_int(&fd->map, SENML_BN);
+		err |= cbor_encode_text_string(&fd->map, buf, len);
+	}
+
+	/* "<res>" or "<res>/<res_inst>" */
+	len = lwm2m_u64_to_str(path->res_id, buf);
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		buf[len++] = '/';
+		len += lwm2m_u64_to_str(path->res_inst_id, &buf[len]);
+	}
+
+	err |= cbor_encode_uint(&fd->map, SENML_N);
+	err |= cbor_encode_text_string(&fd->map, buf, len);
+
+	return err;
+}
+
+static size_t record_end(struct lwm2m_output_context *out,
+			 struct cbor_out_formatter_data *fd,
+			 struct lwm2m_obj_path *path, CborError err)
+{
+	err |= cbor_encoder_close_container(&fd->encoder, &fd->map);
+	if (err != CborNoError) {
+		/* drop the partial record, TODO: Generate error? */
+		out->out_cpkt->offset = fd->record_offset;
+		return 0;
+	}
+
+	if (fd->record_bn) {
+		fd->bn_obj_id = path->obj_id;
+		fd->bn_obj_inst_id = path->obj_inst_id;
+		fd->bn_valid = true;
+	}
+
+	fd->record_count++;
+	return fd->writer.enc.bytes_written;
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct cbor_out_formatter_data *fd;
+	CborEncoder array;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	/* the record count is filled in by put_end() */
+	fd->array_offset = out->out_cpkt->offset;
+	fd->record_count = 0U;
+	fd->bn_valid = false;
+
+	cbor_cpkt_writer_init(&fd->writer, out->out_cpkt);
+	cbor_encoder_init(&fd->encoder, &fd->writer.enc, 0);
+	err = cbor_encoder_create_array(&fd->encoder, &array, 0);
+	err |= cbor_encoder_close_container(&fd->encoder, &array);
+	if (err != CborNoError) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	return fd->writer.enc.bytes_written;
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	struct cbor_out_formatter_data *fd;
+	struct cbor_buf_writer writer;
+	uint8_t head[CBOR_MAX_HEAD];
+	CborEncoder encoder, array;
+	size_t len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	/* only the head is needed, the records are already in the packet */
+	cbor_buf_writer_init(&writer, head, sizeof(head));
+	cbor_encoder_init(&encoder, &writer.enc, 0);
+	if (cbor_encoder_create_array(&encoder, &array,
+				      fd->record_count) != CborNoError) {
+		return 0;
+	}
+
+	len = writer.enc.bytes_written;
+	out->out_cpkt->data[fd->array_offset] = head[0];
+	if (len == 1) {
+		return 0;
+	}
+
+	/* more records than fit in the initial byte, widen the head */
+	if (buf_insert(CPKT_BUF_WRITE(out->out_cpkt), fd->array_offset + 1,
+		       &head[1], len - 1) < 0) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	return len - 1;
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct cbor_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	struct cbor_out_formatter_data *fd;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_V);
+	err |= cbor_encode_int(&fd->map, value);
+
+	return record_end(out, fd, path, err);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct cbor_out_formatter_data *fd;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_VS);
+	err |= cbor_encode_text_string(&fd->map, buf, buflen);
+
+	return record_end(out, fd, path, err);
+}
+
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	struct cbor_out_formatter_data *fd;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_VD);
+	err |= cbor_encode_byte_string(&fd->map, (uint8_t *)buf, buflen);
+
+	return record_end(out, fd, path, err);
+}
+
+/*
+ * The fixed point values are converted to their IEEE 754 encoding, which
+ * is handed to the encoder as is so that no floating point math is needed.
+ */
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	struct cbor_out_formatter_data *fd;
+	uint8_t b32[4];
+	uint32_t bits;
+	CborError err;
+	int ret;
+
+	/* integral values are shorter as CBOR integers */
+	if (value->val2 == 0) {
+		return put_s64(out, path, value->val1);
+	}
+
+	ret = lwm2m_f32_to_b32(value, b32, sizeof(b32));
+	if (ret < 0) {
+		LOG_ERR("float32 conversion error: %d", ret);
+		return 0;
+	}
+
+	bits = sys_get_be32(b32);
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_V);
+	err |= cbor_encode_floating_point(&fd->map, CborFloatType, &bits);
+
+	return record_end(out, fd, path, err);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	struct cbor_out_formatter_data *fd;
+	uint8_t b64[8];
+	uint64_t bits;
+	CborError err;
+	int ret;
+
+	if (value->val2 == 0) {
+		return put_s64(out, path, value->val1);
+	}
+
+	ret = lwm2m_f64_to_b64(value, b64, sizeof(b64));
+	if (ret < 0) {
+		LOG_ERR("float64 conversion error: %d", ret);
+		return 0;
+	}
+
+	bits = sys_get_be64(b64);
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_V);
+	err |= cbor_encode_floating_point(&fd->map, CborDoubleType, &bits);
+
+	return record_end(out, fd, path, err);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path, bool value)
+{
+	struct cbor_out_formatter_data *fd;
+	CborError err;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_uint(&fd->map, SENML_VB);
+	err |= cbor_encode_boolean(&fd->map, value);
+
+	return record_end(out, fd, path, err);
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	struct cbor_out_formatter_data *fd;
+	char buf[sizeof("65535:65535")];
+	CborError err;
+	size_t len;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	len = lwm2m_u64_to_str(value->obj_id, buf);
+	buf[len++] = ':';
+	len += lwm2m_u64_to_str(value->obj_inst, &buf[len]);
+
+	err = record_begin(out, fd, path);
+	err |= cbor_encode_text_stringz(&fd->map, "vlo");
+	err |= cbor_encode_text_string(&fd->map, buf, len);
+
+	return record_end(out, fd, path, err);
+}
+
+/* Parses the CBOR item at the current offset of the input */
+static int value_begin(struct lwm2m_input_context *in,
+		       struct cbor_cpkt_reader *reader, CborParser *parser,
+		       CborValue *value)
+{
+	cbor_cpkt_reader_init(reader, in->in_cpkt, in->offset);
+
+	if (cbor_parser_init(&reader->r, 0, parser, value) != CborNoError) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Moves the input past the item, returns the size of the item */
+static size_t value_end(struct lwm2m_input_context *in, CborValue *value)
+{
+	if (cbor_value_advance(value) != CborNoError) {
+		return 0;
+	}
+
+	in->offset += value->offset;
+	return value->offset;
+}
+
+static int cbor_get_text(CborValue *value, char *buf, size_t buflen)
+{
+	size_t len = buflen - 1;
+
+	if (!cbor_value_is_text_string(value) ||
+	    cbor_value_copy_text_string(value, buf, &len, NULL) !=
+	    CborNoError) {
+		return -EINVAL;
+	}
+
+	buf[len] = '\0';
+	return len;
+}
+
+/* Returns the label of a record entry and moves to its value */
+static int senml_get_label(CborValue *value, int32_t *label)
+{
+	bool vlo = false;
+	int64_t val;
+
+	*label = SENML_UNKNOWN;
+
+	if (cbor_value_is_integer(value)) {
+		if (cbor_value_get_int64_checked(value, &val) == CborNoError &&
+		    val > -SENML_VLO && val < SENML_VLO) {
+			*label = val;
+		}
+	} else if (cbor_value_is_text_string(value)) {
+		if (cbor_value_text_string_equals(value, "vlo", &vlo) !=
+		    CborNoError) {
+			return -EINVAL;
+		}
+
+		if (vlo) {
+			*label = SENML_VLO;
+		}
+	}
+
+	if (cbor_value_advance(value) != CborNoError ||
+	    cbor_value_at_end(value)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int senml_pack_begin(struct lwm2m_input_context *in,
+			    struct cbor_in_formatter_data *fd)
+{
+	int ret;
+
+	ret = value_begin(in, &fd->reader, &fd->parser, &fd->pack);
+	if (ret < 0) {
+		return ret;
+	}
+
+	if (!cbor_value_is_array(&fd->pack) ||
+	    cbor_value_enter_container(&fd->pack, &fd->records) !=
+	    CborNoError) {
+		LOG_ERR("Not a SenML pack");
+		return -EINVAL;
+	}
+
+	fd->base_name[0] = '\0';
+
+	return 0;
+}
+
+/* Returns 1 if a record was read, 0 at the end of the pack */
+static int senml_next_record(struct lwm2m_input_context *in,
+			     struct cbor_in_formatter_data *fd)
+{
+	CborValue record;
+	int32_t label;
+	int ret;
+
+	if (cbor_value_at_end(&fd->records)) {
+		return 0;
+	}
+
+	if (!cbor_value_is_map(&fd->records) ||
+	    cbor_value_enter_container(&fd->records, &record) != CborNoError) {
+		LOG_ERR("Not a SenML record");
+		return -EINVAL;
+	}
+
+	fd->name[0] = '\0';
+	fd->value_offset = 0U;
+
+	while (!cbor_value_at_end(&record)) {
+		ret = senml_get_label(&record, &label);
+		if (ret < 0) {
+			return ret;
+		}
+
+		switch (label) {
+		case SENML_BN:
+			ret = cbor_get_text(&record, fd->base_name,
+					    sizeof(fd->base_name));
+			break;
+
+		case SENML_N:
+			ret = cbor_get_text(&record, fd->name, sizeof(fd->name));
+			break;
+
+		case SENML_V:
+		case SENML_VS:
+		case SENML_VB:
+		case SENML_VD:
+		case SENML_VLO:
+			fd->value_offset = fd->reader.base + record.offset;
+			break;
+
+		default:
+			break;
+		}
+
+		if (ret < 0 || cbor_value_advance(&record) != CborNoError) {
+			return -EINVAL;
+		}
+	}
+
+	if (cbor_value_leave_container(&fd->records, &record) != CborNoError) {
+		return -EINVAL;
+	}
+
+	return 1;
+}
+
+/* The record name is the concatenation of the base name and the name */
+static int senml_record_path(struct cbor_in_formatter_data *fd,
+			     struct lwm2m_obj_path *path)
+{
+	const char *names[] = { fd->base_name, fd->name };
+	uint16_t *ids[] = { &path->obj_id, &path->obj_inst_id,
+			    &path->res_id, &path->res_inst_id };
+	uint32_t val = 0U;
+	bool digits = false;
+	const char *c;
+	int i;
+
+	(void)memset(path, 0, sizeof(*path));
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		for (c = names[i]; *c != '\0'; c++) {
+			if (*c >= '0' && *c <= '9') {
+				val = val * 10U + (*c - '0');
+				if (val > UINT16_MAX) {
+					return -EINVAL;
+				}
+
+				digits = true;
+				continue;
+			}
+
+			if (*c != '/') {
+				return -EINVAL;
+			}
+
+			if (digits) {
+				if (path->level == ARRAY_SIZE(ids)) {
+					return -EINVAL;
+				}
+
+				*ids[path->level++] = val;
+				val = 0U;
+				digits = false;
+			}
+		}
+	}
+
+	if (digits) {
+		if (path->level == ARRAY_SIZE(ids)) {
+			return -EINVAL;
+		}
+
+		*ids[path->level++] = val;
+	}
+
+	if (path->level == LWM2M_PATH_LEVEL_NONE) {
+		return -EINVAL;
+	}
+
+	return path->level;
+}
+
+static size_t get_s64(struct lwm2m_input_context *in, int64_t *value)
+{
+	struct cbor_cpkt_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	*value = 0;
+	if (value_begin(in, &reader, &parser, &it) < 0 ||
+	    !cbor_value_is_integer(&it) ||
+	    cbor_value_get_int64_checked(&it, value) != CborNoError) {
+		*value = 0;
+		return 0;
+	}
+
+	return value_end(in, &it);
+}
+
+static size_t get_s32(struct lwm2m_input_context *in, int32_t *value)
+{
+	int64_t temp;
+	size_t size;
+
+	size = get_s64(in, &temp);
+	*value = (int32_t)temp;
+
+	return size;
+}
+
+static uint32_t half_to_b32(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	int32_t exp = (half >> 10) & 0x1f;
+	uint32_t mant = half & 0x3ff;
+
+	if (exp == 0) {
+		if (mant == 0U) {
+			return sign;
+		}
+
+		/* subnormal, normalize it for binary32 */
+		exp = 127 - 15 + 1;
+		while (!(mant & 0x400)) {
+			mant <<= 1;
+			exp--;
+		}
+
+		return sign | (exp << 23) | ((mant & 0x3ff) << 13);
+	}
+
+	if (exp == 0x1f) {
+		return sign | 0x7f800000 | (mant << 13);
+	}
+
+	return sign | ((exp + 127 - 15) << 23) | (mant << 13);
+}
+
+/* Any CBOR number, converted to the 64-bit fixed point value */
+static size_t get_number(struct lwm2m_input_context *in,
+			 float64_value_t *value)
+{
+	struct cbor_cpkt_reader reader;
+	float32_value_t f32;
+	CborParser parser;
+	CborValue it;
+	uint16_t half;
+	uint8_t buf[8];
+	uint32_t b32;
+	uint64_t b64;
+	float f;
+	double d;
+	int ret;
+
+	(void)memset(value, 0, sizeof(*value));
+
+	if (value_begin(in, &reader, &parser, &it) < 0) {
+		return 0;
+	}
+
+	if (cbor_value_is_integer(&it)) {
+		if (cbor_value_get_int64_checked(&it, &value->val1) !=
+		    CborNoError) {
+			value->val1 = 0;
+			return 0;
+		}
+
+		return value_end(in, &it);
+	}
+
+	/* the floats are taken as their IEEE 754 encoding */
+	if (cbor_value_is_double(&it)) {
+		cbor_value_get_double(&it, &d);
+		memcpy(&b64, &d, sizeof(b64));
+		sys_put_be64(b64, buf);
+		ret = lwm2m_b64_to_f64(buf, 8, value);
+	} else {
+		if (cbor_value_is_half_float(&it)) {
+			cbor_value_get_half_float(&it, &half);
+			b32 = half_to_b32(half);
+		} else if (cbor_value_is_float(&it)) {
+			cbor_value_get_float(&it, &f);
+			memcpy(&b32, &f, sizeof(b32));
+		} else {
+			return 0;
+		}
+
+		sys_put_be32(b32, buf);
+		ret = lwm2m_b32_to_f32(buf, 4, &f32);
+		value->val1 = f32.val1;
+		value->val2 = (int64_t)f32.val2 *
+			(LWM2M_FLOAT64_DEC_MAX / LWM2M_FLOAT32_DEC_MAX);
+	}
+
+	if (ret < 0) {
+		LOG_ERR("float conversion error: %d", ret);
+		return 0;
+	}
+
+	return value_end(in, &it);
+}
+
+static size_t get_float32fix(struct lwm2m_input_context *in,
+			     float32_value_t *value)
+{
+	float64_value_t f64;
+	size_t size;
+
+	size = get_number(in, &f64);
+	value->val1 = (int32_t)f64.val1;
+	value->val2 = (int32_t)(f64.val2 /
+			(LWM2M_FLOAT64_DEC_MAX / LWM2M_FLOAT32_DEC_MAX));
+
+	return size;
+}
+
+static size_t get_float64fix(struct lwm2m_input_context *in,
+			     float64_value_t *value)
+{
+	return get_number(in, value);
+}
+
+static size_t get_bool(struct lwm2m_input_context *in, bool *value)
+{
+	struct cbor_cpkt_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	*value = false;
+	if (value_begin(in, &reader, &parser, &it) < 0 ||
+	    !cbor_value_is_boolean(&it)) {
+		return 0;
+	}
+
+	cbor_value_get_boolean(&it, value);
+	return value_end(in, &it);
+}
+
+static size_t get_string(struct lwm2m_input_context *in,
+			 uint8_t *buf, size_t buflen)
+{
+	struct cbor_cpkt_reader reader;
+	CborParser parser;
+	CborValue it;
+
+	if (buflen == 0) {
+		return 0;
+	}
+
+	buf[0] = '\0';
+	if (value_begin(in, &reader, &parser, &it) < 0 ||
+	    cbor_get_text(&it, (char *)buf, buflen) < 0) {
+		return 0;
+	}
+
+	return value_end(in, &it);
+}
+
+static size_t get_opaque(struct lwm2m_input_context *in,
+			 uint8_t *value, size_t buflen,
+			 struct lwm2m_opaque_context *opaque,
+			 bool *last_block)
+{
+	struct cbor_cpkt_reader reader;
+	CborParser parser;
+	CborValue it;
+	size_t len;
+
+	/* Get the byte string head only on first read. */
+	if (opaque->remaining == 0) {
+		if (value_begin(in, &reader, &parser, &it) < 0 ||
+		    !cbor_value_is_byte_string(&it) ||
+		    cbor_value_get_string_length(&it, &len) != CborNoError ||
+		    len > UINT16_MAX || value_end(in, &it) == 0) {
+			*last_block = true;
+			return 0;
+		}
+
+		/* the engine reads the content that follows the head */
+		in->offset -= len;
+		opaque->len = len;
+		opaque->remaining = len;
+	}
+
+	return lwm2m_engine_get_opaque_more(in, value, buflen,
+					    opaque, last_block);
+}
+
+static size_t get_objlnk(struct lwm2m_input_context *in,
+			 struct lwm2m_objlnk *value)
+{
+	char buf[sizeof("65535:65535")];
+	struct cbor_cpkt_reader reader;
+	uint32_t val[2] = { 0 };
+	CborParser parser;
+	CborValue it;
+	int i = 0;
+	char *c;
+
+	if (value_begin(in, &reader, &parser, &it) < 0 ||
+	    cbor_get_text(&it, buf, sizeof(buf)) < 0) {
+		return 0;
+	}
+
+	for (c = buf; *c != '\0'; c++) {
+		if (*c == ':' && i == 0) {
+			i++;
+		} else if (*c >= '0' && *c <= '9') {
+			val[i] = val[i] * 10U + (*c - '0');
+		} else {
+			return 0;
+		}
+	}
+
+	if (i != 1 || val[0] > UINT16_MAX || val[1] > UINT16_MAX) {
+		return 0;
+	}
+
+	value->obj_id = val[0];
+	value->obj_inst = val[1];
+
+	return value_end(in, &it);
+}
+
+const struct lwm2m_writer senml_cbor_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+const struct lwm2m_reader senml_cbor_reader = {
+	.get_s32 = get_s32,
+	.get_s64 = get_s64,
+	.get_string = get_string,
+	.get_float32fix = get_float32fix,
+	.get_float64fix = get_float64fix,
+	.get_bool = get_bool,
+	.get_opaque = get_opaque,
+	.get_objlnk = get_objlnk,
+};
+
+int do_read_op_senml_cbor(struct lwm2m_message *msg, int content_format)
+{
+	struct cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_read_op(msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+int do_composite_read_op_senml_cbor(struct lwm2m_message *msg,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct cbor_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_composite_read_op(msg, LWM2M_FORMAT_APP_SENML_CBOR,
+					      paths, path_count);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+int senml_cbor_parse_paths(struct lwm2m_input_context *in,
+			   struct lwm2m_obj_path *paths, uint8_t max_paths)
+{
+	struct cbor_in_formatter_data fd;
+	int count = 0;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+
+	ret = senml_pack_begin(in, &fd);
+	if (ret < 0) {
+		return ret;
+	}
+
+	while ((ret = senml_next_record(in, &fd)) > 0) {
+		if (count == max_paths) {
+			LOG_ERR("Too many paths in the request");
+			return -EFBIG;
+		}
+
+		ret = senml_record_path(&fd, &paths[count]);
+		if (ret < 0) {
+			return ret;
+		}
+
+		count++;
+	}
+
+	return ret < 0 ? ret : count;
+}
+
+/* A record may only address the path given in the request, or below it */
+static bool path_is_within(const struct lwm2m_obj_path *outer,
+			   const struct lwm2m_obj_path *path)
+{
+	if (outer->level >= 1U && outer->obj_id != path->obj_id) {
+		return false;
+	}
+
+	if (outer->level >= 2U && outer->obj_inst_id != path->obj_inst_id) {
+		return false;
+	}
+
+	if (outer->level >= 3U && outer->res_id != path->res_id) {
+		return false;
+	}
+
+	return true;
+}
+
+int do_write_op_senml_cbor(struct lwm2m_message *msg)
+{
+	struct lwm2m_engine_obj_field *obj_field;
+	struct lwm2m_engine_obj_inst *obj_inst;
+	struct lwm2m_engine_res *res;
+	struct lwm2m_engine_res_inst *res_inst;
+	struct cbor_in_formatter_data fd;
+	struct lwm2m_obj_path orig_path;
+	uint8_t created;
+	int ret, index;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_in_user_data(&msg->in, &fd);
+
+	/* store a copy of the original path */
+	memcpy(&orig_path, &msg->path, sizeof(msg->path));
+
+	ret = senml_pack_begin(&msg->in, &fd);
+	if (ret < 0) {
+		goto out;
+	}
+
+	while ((ret = senml_next_record(&msg->in, &fd)) > 0) {
+		/* nothing to write */
+		if (fd.value_offset == 0U) {
+			continue;
+		}
+
+		ret = senml_record_path(&fd, &msg->path);
+		if (ret < LWM2M_PATH_LEVEL_RESOURCE ||
+		    !path_is_within(&orig_path, &msg->path)) {
+			LOG_ERR("Invalid record name %s%s",
+				log_strdup(fd.base_name), log_strdup(fd.name));
+			ret = -EINVAL;
+			break;
+		}
+
+		ret = lwm2m_get_or_create_engine_obj(msg, &obj_inst, &created);
+		if (ret < 0) {
+			break;
+		}
+
+		obj_field = lwm2m_get_engine_obj_field(obj_inst->obj,
+						       msg->path.res_id);
+		if (!obj_field) {
+			ret = -ENOENT;
+			break;
+		}
+
+		if (!LWM2M_HAS_PERM(obj_field, LWM2M_PERM_W)) {
+			ret = -EPERM;
+			break;
+		}
+
+		res = NULL;
+		for (index = 0; index < obj_inst->resource_count; index++) {
+			if (obj_inst->resources[index].res_id ==
+			    msg->path.res_id) {
+				res = &obj_inst->resources[index];
+				break;
+			}
+		}
+
+		if (!res) {
+			ret = -ENOENT;
+			break;
+		}
+
+		res_inst = NULL;
+		for (index = 0; index < res->res_inst_count; index++) {
+			if (res->res_instances[index].res_inst_id ==
+			    msg->path.res_inst_id) {
+				res_inst = &res->res_instances[index];
+				break;
+			}
+		}
+
+		if (!res_inst) {
+			ret = -ENOENT;
+			break;
+		}
+
+		/* the readers decode the value in place */
+		msg->in.offset = fd.value_offset;
+		ret = lwm2m_write_handler(obj_inst, res, res_inst, obj_field,
+					  msg);
+
+		if (ret < 0) {
+			/* return errors on a single write */
+			if (orig_path.level >= 3U) {
+				break;
+			}
+
+			LOG_WRN("Write of %s%s failed: %d",
+				log_strdup(fd.base_name), log_strdup(fd.name),
+				ret);
+		}
+	}
+
+out:
+	engine_clear_in_user_data(&msg->in);
+	memcpy(&msg->path, &orig_path, sizeof(msg->path));
+
+	return ret;
+}
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * SenML JSON (RFC 8428) writer.
+ *
+ * Records are assembled from constant fragments and integer conversions,
+ * so no printf style formatting is done per resource.
+ */
+
+#define LOG_MODULE_NAME net_lwm2m_senml_json
+#define LOG_LEVEL CONFIG_LWM2M_LOG_LEVEL
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(LOG_MODULE_NAME);
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/base64.h>
+
+#include "lwm2m_object.h"
+#include "lwm2m_rw_senml_json.h"
+#include "lwm2m_engine.h"
+#include "lwm2m_util.h"
+
+/* ,{"bn":"/65535/65535/","n":"65535/65535","vlo": */
+#define RECORD_HEAD_MAX		64
+
+/* input bytes per base64 chunk, a multiple of 3 */
+#define BASE64_CHUNK		48
+
+struct senml_json_out_formatter_data {
+	/* object instance of the current base name */
+	uint16_t bn_obj_id;
+	uint16_t bn_obj_inst_id;
+	bool bn_valid;
+
+	/* flags */
+	uint8_t writer_flags;
+};
+
+static size_t append(char *buf, size_t len, const char *str)
+{
+	size_t str_len = strlen(str);
+
+	memcpy(&buf[len], str, str_len);
+	return len + str_len;
+}
+
+static size_t append_int(char *buf, size_t len, int64_t value)
+{
+	if (value < 0) {
+		buf[len++] = '-';
+		return len + lwm2m_u64_to_str(-(uint64_t)value, &buf[len]);
+	}
+
+	return len + lwm2m_u64_to_str(value, &buf[len]);
+}
+
+/* integer part, then the fraction without its trailing zeroes */
+static size_t append_fixed(char *buf, size_t len, int64_t val1, int64_t val2,
+			   int64_t dec_max)
+{
+	uint64_t frac = (val2 < 0) ? -(uint64_t)val2 : val2;
+
+	if (val1 < 0 || val2 < 0) {
+		buf[len++] = '-';
+	}
+
+	len += lwm2m_u64_to_str((val1 < 0) ? -(uint64_t)val1 : val1,
+				&buf[len]);
+	if (frac == 0U) {
+		return len;
+	}
+
+	buf[len++] = '.';
+	for (dec_max /= 10; dec_max > 0 && frac > 0U; dec_max /= 10) {
+		buf[len++] = '0' + frac / dec_max;
+		frac %= dec_max;
+	}
+
+	return len;
+}
+
+static size_t put_raw(struct lwm2m_output_context *out, const char *buf,
+		      size_t len)
+{
+	if (buf_append(CPKT_BUF_WRITE(out->out_cpkt), (uint8_t *)buf,
+		       len) < 0) {
+		/* TODO: Generate error? */
+		return 0;
+	}
+
+	return len;
+}
+
+/* Everything up to the value: [,]{["bn":"/o/i/",]"n":"r[/ri]",<label>: */
+static size_t record_head(struct lwm2m_output_context *out,
+			  struct lwm2m_obj_path *path,
+			  const char *label, char *buf)
+{
+	struct senml_json_out_formatter_data *fd;
+	size_t len = 0;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	if (fd->writer_flags & WRITER_OUTPUT_VALUE) {
+		buf[len++] = ',';
+	}
+
+	buf[len++] = '{';
+
+	if (!fd->bn_valid || fd->bn_obj_id != path->obj_id ||
+	    fd->bn_obj_inst_id != path->obj_inst_id) {
+		len = append(buf, len, "\"bn\":\"/");
+		len = append_int(buf, len, path->obj_id);
+		buf[len++] = '/';
+		len = append_int(buf, len, path->obj_inst_id);
+		len = append(buf, len, "/\",");
+
+		fd->bn_obj_id = path->obj_id;
+		fd->bn_obj_inst_id = path->obj_inst_id;
+		fd->bn_valid = true;
+	}
+
+	len = append(buf, len, "\"n\":\"");
+	len = append_int(buf, len, path->res_id);
+	if (fd->writer_flags & WRITER_RESOURCE_INSTANCE) {
+		buf[len++] = '/';
+		len = append_int(buf, len, path->res_inst_id);
+	}
+
+	len = append(buf, len, "\",");
+	len = append(buf, len, label);
+
+	fd->writer_flags |= WRITER_OUTPUT_VALUE;
+	return len;
+}
+
+/* A record whose value is already formatted */
+static size_t put_record(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 const char *label, const char *value)
+{
+	char buf[RECORD_HEAD_MAX + sizeof("-18446744073709551615.123456789}")];
+	size_t len;
+
+	len = record_head(out, path, label, buf);
+	if (len == 0) {
+		return 0;
+	}
+
+	len = append(buf, len, value);
+	buf[len++] = '}';
+
+	return put_raw(out, buf, len);
+}
+
+static size_t put_begin(struct lwm2m_output_context *out,
+			struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_OUTPUT_VALUE;
+	fd->bn_valid = false;
+
+	return put_raw(out, "[", 1);
+}
+
+static size_t put_end(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path)
+{
+	return put_raw(out, "]", 1);
+}
+
+static size_t put_begin_ri(struct lwm2m_output_context *out,
+			   struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags |= WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_end_ri(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path)
+{
+	struct senml_json_out_formatter_data *fd;
+
+	fd = engine_get_out_user_data(out);
+	if (!fd) {
+		return 0;
+	}
+
+	fd->writer_flags &= ~WRITER_RESOURCE_INSTANCE;
+	return 0;
+}
+
+static size_t put_s64(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int64_t value)
+{
+	char buf[sizeof("-9223372036854775808")];
+
+	buf[append_int(buf, 0, value)] = '\0';
+	return put_record(out, path, "\"v\":", buf);
+}
+
+static size_t put_s32(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int32_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s16(struct lwm2m_output_context *out,
+		      struct lwm2m_obj_path *path, int16_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_s8(struct lwm2m_output_context *out,
+		     struct lwm2m_obj_path *path, int8_t value)
+{
+	return put_s64(out, path, (int64_t)value);
+}
+
+static size_t put_float32fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float32_value_t *value)
+{
+	char buf[sizeof("-2147483648.123456")];
+
+	buf[append_fixed(buf, 0, value->val1, value->val2,
+			 LWM2M_FLOAT32_DEC_MAX)] = '\0';
+	return put_record(out, path, "\"v\":", buf);
+}
+
+static size_t put_float64fix(struct lwm2m_output_context *out,
+			     struct lwm2m_obj_path *path,
+			     float64_value_t *value)
+{
+	char buf[sizeof("-9223372036854775808.123456789")];
+
+	buf[append_fixed(buf, 0, value->val1, value->val2,
+			 LWM2M_FLOAT64_DEC_MAX)] = '\0';
+	return put_record(out, path, "\"v\":", buf);
+}
+
+static size_t put_bool(struct lwm2m_output_context *out,
+		       struct lwm2m_obj_path *path, bool value)
+{
+	return put_record(out, path, "\"vb\":", value ? "true" : "false");
+}
+
+static size_t put_objlnk(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 struct lwm2m_objlnk *value)
+{
+	char buf[sizeof("\"65535:65535\"")];
+	size_t len = 0;
+
+	buf[len++] = '"';
+	len = append_int(buf, len, value->obj_id);
+	buf[len++] = ':';
+	len = append_int(buf, len, value->obj_inst);
+	buf[len++] = '"';
+	buf[len] = '\0';
+
+	return put_record(out, path, "\"vlo\":", buf);
+}
+
+static size_t put_string(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	char head[RECORD_HEAD_MAX + 1];
+	char esc[sizeof("\\u001f")];
+	size_t len, total, start, i;
+
+	len = record_head(out, path, "\"vs\":", head);
+	if (len == 0) {
+		return 0;
+	}
+
+	head[len++] = '"';
+	total = put_raw(out, head, len);
+
+	/* copy unescaped runs in one go */
+	for (i = 0, start = 0; i < buflen; i++) {
+		uint8_t c = buf[i];
+
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		total += put_raw(out, &buf[start], i - start);
+		start = i + 1;
+
+		if (c < 0x20) {
+			len = append(esc, 0, "\\u00");
+			esc[len++] = "0123456789abcdef"[c >> 4];
+			esc[len++] = "0123456789abcdef"[c & 0xf];
+		} else {
+			esc[0] = '\\';
+			esc[1] = c;
+			len = 2;
+		}
+
+		total += put_raw(out, esc, len);
+	}
+
+	total += put_raw(out, &buf[start], buflen - start);
+	total += put_raw(out, "\"}", 2);
+
+	return total;
+}
+
+/* base64url without padding, as required by RFC 8428 for "vd" */
+static size_t put_opaque(struct lwm2m_output_context *out,
+			 struct lwm2m_obj_path *path,
+			 char *buf, size_t buflen)
+{
+	char head[RECORD_HEAD_MAX + 1];
+	uint8_t enc[BASE64_CHUNK / 3 * 4 + 1];
+	size_t len, total, chunk, olen, i;
+
+	len = record_head(out, path, "\"vd\":", head);
+	if (len == 0) {
+		return 0;
+	}
+
+	head[len++] = '"';
+	total = put_raw(out, head, len);
+
+	for (; buflen > 0; buf += chunk, buflen -= chunk) {
+		chunk = MIN(buflen, BASE64_CHUNK);
+		if (base64_encode(enc, sizeof(enc), &olen, (uint8_t *)buf,
+				  chunk) < 0) {
+			return 0;
+		}
+
+		for (i = 0; i < olen; i++) {
+			if (enc[i] == '+') {
+				enc[i] = '-';
+			} else if (enc[i] == '/') {
+				enc[i] = '_';
+			} else if (enc[i] == '=') {
+				olen = i;
+				break;
+			}
+		}
+
+		total += put_raw(out, (char *)enc, olen);
+	}
+
+	total += put_raw(out, "\"}", 2);
+
+	return total;
+}
+
+const struct lwm2m_writer senml_json_writer = {
+	.put_begin = put_begin,
+	.put_end = put_end,
+	.put_begin_ri = put_begin_ri,
+	.put_end_ri = put_end_ri,
+	.put_s8 = put_s8,
+	.put_s16 = put_s16,
+	.put_s32 = put_s32,
+	.put_s64 = put_s64,
+	.put_string = put_string,
+	.put_float32fix = put_float32fix,
+	.put_float64fix = put_float64fix,
+	.put_bool = put_bool,
+	.put_opaque = put_opaque,
+	.put_objlnk = put_objlnk,
+};
+
+int do_read_op_senml_json(struct lwm2m_message *msg, int content_format)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_read_op(msg, content_format);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+/* composite requests are always received in SenML CBOR */
+int do_composite_read_op_senml_json(struct lwm2m_message *msg,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count)
+{
+	struct senml_json_out_formatter_data fd;
+	int ret;
+
+	(void)memset(&fd, 0, sizeof(fd));
+	engine_set_out_user_data(&msg->out, &fd);
+	ret = lwm2m_perform_composite_read_op(msg, LWM2M_FORMAT_APP_SENML_JSON,
+					      paths, path_count);
+	engine_clear_out_user_data(&msg->out);
+
+	return ret;
+}
+#endif /* CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT */
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef LWM2M_RW_SENML_JSON_H_
+#define LWM2M_RW_SENML_JSON_H_
+
+#include "lwm2m_object.h"
+
+extern const struct lwm2m_writer senml_json_writer;
+
+int do_read_op_senml_json(struct lwm2m_message *msg, int content_format);
+#if defined(CONFIG_LWM2M_RW_SENML_CBOR_SUPPORT)
+int do_composite_read_op_senml_json(struct lwm2m_message *msg,
+				    struct lwm2m_obj_path *paths,
+				    uint8_t path_count);
+#endif
+
+#endif /* LWM2M_RW_SENML_JSON_H_ */
@@ -296,3 +296,30 @@ int lwm2m_b64_to_f64(uint8_t *b64, size_t len, float64_value_t *f64)
 
 	return 0;
 }
+
+size_t lwm2m_u64_to_str(uint64_t value, char *buf)
+{
+	char tmp[sizeof("18446744073709551615")];
+	size_t len = 0, i;
+
+	/* avoid 64-bit divisions for the common small values */
+	if (value <= UINT32_MAX) {
+		uint32_t v = (uint32_t)value;
+
+		do {
+			tmp[len++] = '0' + (v % 10U);
+			v /= 10U;
+		} while (v > 0U);
+	} else {
+		do {
+			tmp[len++] = '0' + (value % 10U);
+			value /= 10U;
+		} while (value > 0U);
+	}
+
+	for (i = 0; i < len; i++) {
+		buf[i] = tmp[len - i - 1];
+	}
+
+	return len;
+}
@@ -17,4 +17,7 @@ int lwm2m_f64_to_b64(float64_value_t *f64, uint8_t *b64, size_t len);
 int lwm2m_b32_to_f32(uint8_t *b32, size_t len, float32_value_t *f32);
 int lwm2m_b64_to_f64(uint8_t *b64, size_t len, float64_value_t *f64);
 
+/* print value in decimal, returns the number of digits (no terminator) */
+size_t lwm2m_u64_to_str(uint64_t value, char *buf);
+
 #endif /* LWM2M_UTIL_H_ */
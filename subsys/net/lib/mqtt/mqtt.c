@@ -35,6 +35,250 @@ static void tx_buf_init(struct mqtt_client *client, struct buf_ctx *buf)
 	buf->end = client->tx_buf + client->tx_buf_size;
 }
 
+static void client_disconnect(struct mqtt_client *client, int result,
+			      bool notify);
+
+#if CONFIG_MQTT_INFLIGHT_COUNT > 0
+static struct mqtt_inflight *inflight_find(struct mqtt_client *client,
+					   uint16_t message_id)
+{
+	for (int i = 0; i < CONFIG_MQTT_INFLIGHT_COUNT; i++) {
+		struct mqtt_inflight *entry = &client->internal.inflight[i];
+
+		if (entry->expected != 0U &&
+		    entry->param.message_id == message_id) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+static void inflight_reset(struct mqtt_client *client)
+{
+	memset(client->internal.inflight, 0,
+	       sizeof(client->internal.inflight));
+	client->internal.inflight_count = 0U;
+}
+
+/** @brief Start tracking a message that is about to be published. */
+static int inflight_store(struct mqtt_client *client,
+			  const struct mqtt_publish_param *param)
+{
+	struct mqtt_inflight *entry;
+
+	if (param->message.topic.qos == MQTT_QOS_0_AT_MOST_ONCE) {
+		return 0;
+	}
+
+	/* The application may retransmit a tracked message on its own. */
+	entry = inflight_find(client, param->message_id);
+	if (entry == NULL) {
+		if (client->internal.inflight_count >=
+		    CONFIG_MQTT_INFLIGHT_COUNT) {
+			return -EAGAIN;
+		}
+
+		for (int i = 0; i < CONFIG_MQTT_INFLIGHT_COUNT; i++) {
+			if (client->internal.inflight[i].expected == 0U) {
+				entry = &client->internal.inflight[i];
+				break;
+			}
+		}
+
+		client->internal.inflight_count++;
+	}
+
+	entry->param = *param;
+	entry->expected = (param->message.topic.qos ==
+			   MQTT_QOS_1_AT_LEAST_ONCE) ?
+			  MQTT_PKT_TYPE_PUBACK : MQTT_PKT_TYPE_PUBREC;
+	entry->sent_time = mqtt_sys_tick_in_ms_get();
+
+	return 0;
+}
+
+/** @brief Check if the release of a QoS 2 message was sent already. */
+static bool inflight_released(struct mqtt_client *client,
+			      uint16_t message_id)
+{
+	struct mqtt_inflight *entry = inflight_find(client, message_id);
+
+	return entry != NULL && entry->expected == MQTT_PKT_TYPE_PUBCOMP;
+}
+
+/** @brief Send the next packet of a tracked message, that is the message
+ *         itself with the DUP flag, or its release.
+ */
+static int inflight_send(struct mqtt_client *client,
+			 struct mqtt_inflight *entry)
+{
+	struct buf_ctx packet;
+	int err_code;
+
+	tx_buf_init(client, &packet);
+
+	if (entry->expected == MQTT_PKT_TYPE_PUBCOMP) {
+		const struct mqtt_pubrel_param param = {
+			.message_id = entry->param.message_id,
+		};
+
+		err_code = publish_release_encode(&param, &packet);
+		if (err_code < 0) {
+			return err_code;
+		}
+
+		err_code = mqtt_transport_write(client, packet.cur,
+						packet.end - packet.cur);
+	} else {
+		struct iovec io_vector[2];
+		struct msghdr msg;
+
+		entry->param.dup_flag = 1U;
+
+		err_code = publish_encode(&entry->param, &packet);
+		if (err_code < 0) {
+			return err_code;
+		}
+
+		io_vector[0].iov_base = packet.cur;
+		io_vector[0].iov_len = packet.end - packet.cur;
+		io_vector[1].iov_base = entry->param.message.payload.data;
+		io_vector[1].iov_len = entry->param.message.payload.len;
+
+		memset(&msg, 0, sizeof(msg));
+
+		msg.msg_iov = io_vector;
+		msg.msg_iovlen = ARRAY_SIZE(io_vector);
+
+		err_code = mqtt_transport_write_msg(client, &msg);
+	}
+
+	if (err_code < 0) {
+		return err_code;
+	}
+
+	entry->sent_time = mqtt_sys_tick_in_ms_get();
+	client->internal.last_activity = entry->sent_time;
+
+	return 0;
+}
+
+int mqtt_inflight_ack(struct mqtt_client *client, uint8_t type,
+		      uint16_t message_id)
+{
+	struct mqtt_inflight *entry = inflight_find(client, message_id);
+
+	if (entry == NULL || entry->expected != type) {
+		MQTT_TRC("[CID %p]: Untracked ack 0x%02x, message id 0x%04x",
+			 client, type, message_id);
+		return 0;
+	}
+
+	if (type == MQTT_PKT_TYPE_PUBREC) {
+		entry->expected = MQTT_PKT_TYPE_PUBCOMP;
+
+		return inflight_send(client, entry);
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	client->internal.inflight_count--;
+
+	return 0;
+}
+
+int mqtt_inflight_resend(struct mqtt_client *client)
+{
+	int err_code;
+
+	for (int i = 0; i < CONFIG_MQTT_INFLIGHT_COUNT; i++) {
+		struct mqtt_inflight *entry = &client->internal.inflight[i];
+
+		if (entry->expected == 0U) {
+			continue;
+		}
+
+		err_code = inflight_send(client, entry);
+		if (err_code < 0) {
+			return err_code;
+		}
+	}
+
+	return 0;
+}
+
+/** @brief Retransmit the messages that were not acknowledged in time. */
+static int inflight_retransmit(struct mqtt_client *client)
+{
+	int err_code;
+
+	if (CONFIG_MQTT_INFLIGHT_RETRANSMIT_TIMEOUT == 0 ||
+	    !MQTT_HAS_STATE(client, MQTT_STATE_CONNECTED)) {
+		return 0;
+	}
+
+	for (int i = 0; i < CONFIG_MQTT_INFLIGHT_COUNT; i++) {
+		struct mqtt_inflight *entry = &client->internal.inflight[i];
+
+		if (entry->expected == 0U ||
+		    mqtt_elapsed_time_in_ms_get(entry->sent_time) <
+		    CONFIG_MQTT_INFLIGHT_RETRANSMIT_TIMEOUT) {
+			continue;
+		}
+
+		MQTT_TRC("[CID %p]: Retransmitting message id 0x%04x",
+			 client, entry->param.message_id);
+
+		err_code = inflight_send(client, entry);
+		if (err_code < 0) {
+			client_disconnect(client, err_code, true);
+			return err_code;
+		}
+	}
+
+	return 0;
+}
+
+int mqtt_inflight_count(struct mqtt_client *client)
+{
+	int count;
+
+	NULL_PARAM_CHECK(client);
+
+	mqtt_mutex_lock(client);
+	count = client->internal.inflight_count;
+	mqtt_mutex_unlock(client);
+
+	return count;
+}
+#else
+static inline void inflight_reset(struct mqtt_client *client)
+{
+}
+
+static inline int inflight_store(struct mqtt_client *client,
+				 const struct mqtt_publish_param *param)
+{
+	return 0;
+}
+
+static inline bool inflight_released(struct mqtt_client *client,
+				     uint16_t message_id)
+{
+	return false;
+}
+
+static inline int inflight_retransmit(struct mqtt_client *client)
+{
+	return 0;
+}
+
+int mqtt_inflight_count(struct mqtt_client *client)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_MQTT_INFLIGHT_COUNT > 0 */
+
 void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt)
 {
 	if (client->evt_cb != NULL) {
@@ -83,6 +327,10 @@ static int client_connect(struct mqtt_client *client)
 	tx_buf_init(client, &packet);
 	MQTT_SET_STATE(client, MQTT_STATE_TCP_CONNECTED);
 
+	if (client->clean_session) {
+		inflight_reset(client);
+	}
+
 	err_code = connect_request_encode(client, &packet);
 	if (err_code < 0) {
 		goto error;
@@ -266,6 +514,11 @@ int mqtt_publish(struct mqtt_client *client,
 		goto error;
 	}
 
+	err_code = inflight_store(client, param);
+	if (err_code < 0) {
+		goto error;
+	}
+
 	io_vector[0].iov_base = packet.cur;
 	io_vector[0].iov_len = packet.end - packet.cur;
 	io_vector[1].iov_base = param->message.payload.data;
@@ -287,6 +540,110 @@ error:
 	return err_code;
 }
 
+int mqtt_publish_batch(struct mqtt_client *client,
+		       const struct mqtt_publish_param *params,
+		       size_t count)
+{
+	struct iovec io_vector[2 * CONFIG_MQTT_PUBLISH_BATCH_SIZE];
+	struct buf_ctx packet;
+	struct msghdr msg;
+	size_t published = 0;
+	size_t queued = 0;
+	uint8_t *pos;
+	int err_code;
+
+	NULL_PARAM_CHECK(client);
+	NULL_PARAM_CHECK(params);
+
+	MQTT_TRC("[CID %p]:[State 0x%02x]: >> Message count %zu",
+		 client, client->internal.state, count);
+
+	mqtt_mutex_lock(client);
+
+	tx_buf_init(client, &packet);
+	pos = packet.cur;
+
+	err_code = verify_tx_state(client);
+	if (err_code < 0) {
+		goto error;
+	}
+
+	while (published + queued < count) {
+		const struct mqtt_publish_param *param =
+						&params[published + queued];
+		bool flush;
+
+		packet.cur = pos;
+		packet.end = client->tx_buf + client->tx_buf_size;
+
+		err_code = publish_encode(param, &packet);
+		if (err_code == -ENOMEM && queued > 0) {
+			/* TX buffer is full, send what was encoded so far. */
+			flush = true;
+		} else if (err_code < 0) {
+			break;
+		} else {
+			err_code = inflight_store(client, param);
+			if (err_code < 0) {
+				break;
+			}
+
+			io_vector[2 * queued].iov_base = packet.cur;
+			io_vector[2 * queued].iov_len = packet.end - packet.cur;
+			io_vector[2 * queued + 1].iov_base =
+						param->message.payload.data;
+			io_vector[2 * queued + 1].iov_len =
+						param->message.payload.len;
+
+			pos = packet.end;
+			queued++;
+
+			flush = (queued == CONFIG_MQTT_PUBLISH_BATCH_SIZE) ||
+				(published + queued == count);
+		}
+
+		if (!flush) {
+			continue;
+		}
+
+		memset(&msg, 0, sizeof(msg));
+
+		msg.msg_iov = io_vector;
+		msg.msg_iovlen = 2 * queued;
+
+		err_code = client_write_msg(client, &msg);
+		if (err_code < 0) {
+			queued = 0;
+			break;
+		}
+
+		published += queued;
+		queued = 0;
+		pos = client->tx_buf;
+	}
+
+	/* Send the messages encoded before the window got full. */
+	if (queued > 0) {
+		memset(&msg, 0, sizeof(msg));
+
+		msg.msg_iov = io_vector;
+		msg.msg_iovlen = 2 * queued;
+
+		err_code = client_write_msg(client, &msg);
+		if (err_code == 0) {
+			published += queued;
+		}
+	}
+
+error:
+	MQTT_TRC("[CID %p]:[State 0x%02x]: << published %zu, result %d",
+		 client, client->internal.state, published, err_code);
+
+	mqtt_mutex_unlock(client);
+
+	return (published > 0) ? published : err_code;
+}
+
 int mqtt_publish_qos1_ack(struct mqtt_client *client,
 			  const struct mqtt_puback_param *param)
 {
@@ -382,6 +739,11 @@ int mqtt_publish_qos2_release(struct mqtt_client *client,
 		goto error;
 	}
 
+	/* Release of a tracked message is sent by the library on PUBREC. */
+	if (inflight_released(client, param->message_id)) {
+		goto error;
+	}
+
 	err_code = publish_release_encode(param, &packet);
 	if (err_code < 0) {
 		goto error;
@@ -601,6 +963,12 @@ int mqtt_live(struct mqtt_client *client)
 
 	mqtt_mutex_lock(client);
 
+	err_code = inflight_retransmit(client);
+	if (err_code < 0) {
+		mqtt_mutex_unlock(client);
+		return err_code;
+	}
+
 	elapsed_time = mqtt_elapsed_time_in_ms_get(
 				client->internal.last_activity);
 	if ((client->keepalive > 0) &&
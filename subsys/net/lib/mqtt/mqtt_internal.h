@@ -162,6 +162,42 @@ void event_notify(struct mqtt_client *client, const struct mqtt_evt *evt);
  */
 int mqtt_handle_rx(struct mqtt_client *client);
 
+#if CONFIG_MQTT_INFLIGHT_COUNT > 0
+/**@brief Updates the inflight table on reception of an acknowledgment for
+ *        a published message. Sends PUBREL on reception of PUBREC.
+ *
+ * @param[in] client Identifies the client for which the packet was received.
+ * @param[in] type Type of the packet received, MQTT_PKT_TYPE_PUBACK,
+ *                 MQTT_PKT_TYPE_PUBREC or MQTT_PKT_TYPE_PUBCOMP.
+ * @param[in] message_id Message id of the acknowledged message.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_inflight_ack(struct mqtt_client *client, uint8_t type,
+		      uint16_t message_id);
+
+/**@brief Sends again all the messages of the inflight table, with the
+ *        DUP flag set. Used when the connection is established.
+ *
+ * @param[in] client Identifies the client for which the procedure is
+ *                   requested.
+ *
+ * @return 0 if the procedure is successful, an error code otherwise.
+ */
+int mqtt_inflight_resend(struct mqtt_client *client);
+#else
+static inline int mqtt_inflight_ack(struct mqtt_client *client, uint8_t type,
+				    uint16_t message_id)
+{
+	return 0;
+}
+
+static inline int mqtt_inflight_resend(struct mqtt_client *client)
+{
+	return 0;
+}
+#endif
+
 /**@brief Constructs/encodes Connect packet.
  *
  * @param[in] client Identifies the client for which the procedure is requested.
@@ -59,6 +59,14 @@ __net_socket struct spair {
 	struct k_poll_signal read_signal;
 	/** buffer for @a recv_q recv_q */
 	uint8_t buf[CONFIG_NET_SOCKETPAIR_BUFFER_SIZE];
+#if defined(CONFIG_NET_SOCKETPAIR_HANDOFF)
+	/** buffer of a thread blocked reading the local @a recv_q */
+	void *handoff_buf;
+	/** size of @a handoff_buf */
+	size_t handoff_len;
+	/** bytes written directly to @a handoff_buf */
+	size_t handoff_done;
+#endif
 };
 
 /* forward declaration */
@@ -120,6 +128,87 @@ static inline size_t spair_read_avail(struct spair *spair)
 	return k_pipe_read_avail(&spair->recv_q);
 }
 
+/**
+ * Offer the buffer of a reader about to block on @p spair
+ *
+ * Must be called with the local @ref spair.sem held.
+ */
+static inline void spair_handoff_offer(struct spair *spair, void *buffer,
+				       size_t count)
+{
+#if defined(CONFIG_NET_SOCKETPAIR_HANDOFF)
+#if defined(CONFIG_USERSPACE)
+	/* the writer may not have access to a user mode buffer */
+	if (k_current_get()->base.user_options & K_USER) {
+		return;
+	}
+#endif
+	spair->handoff_buf = buffer;
+	spair->handoff_len = count;
+	spair->handoff_done = 0;
+#endif
+}
+
+/** Determine if data was written directly to the buffer of a reader */
+static inline bool spair_handoff_done(const struct spair *spair)
+{
+#if defined(CONFIG_NET_SOCKETPAIR_HANDOFF)
+	return spair->handoff_done > 0;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Withdraw the buffer offered by the reader of @p spair
+ *
+ * Must be called with the local @ref spair.sem held.
+ *
+ * @return the number of bytes written directly to the buffer
+ */
+static inline size_t spair_handoff_take(struct spair *spair)
+{
+#if defined(CONFIG_NET_SOCKETPAIR_HANDOFF)
+	size_t done = spair->handoff_done;
+
+	spair->handoff_buf = NULL;
+	spair->handoff_done = 0;
+
+	return done;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Write directly to the buffer of a reader blocked on @p remote
+ *
+ * Must be called with the remote @ref spair.sem held. The buffer is only
+ * used while @a recv_q is empty, so that data is received in order.
+ *
+ * @return the number of bytes written, 0 if there is no such reader
+ */
+static inline size_t spair_handoff_put(struct spair *remote,
+				       const void *buffer, size_t count)
+{
+#if defined(CONFIG_NET_SOCKETPAIR_HANDOFF)
+	if (remote->handoff_buf == NULL ||
+	    k_pipe_read_avail(&remote->recv_q) > 0) {
+		return 0;
+	}
+
+	count = MIN(count, remote->handoff_len);
+	memcpy(remote->handoff_buf, buffer, count);
+
+	remote->handoff_buf = NULL;
+	remote->handoff_done = count;
+
+	return count;
+#else
+	return 0;
+#endif
+}
+
 /** Swap two 32-bit integers */
 static inline void swap32(uint32_t *a, uint32_t *b)
 {
@@ -446,6 +535,11 @@ static ssize_t spair_write(void *obj, const void *buffer, size_t count)
 
 	have_remote_sem = true;
 
+	bytes_written = spair_handoff_put(remote, buffer, count);
+	if (bytes_written > 0) {
+		goto signal;
+	}
+
 	avail = spair_write_avail(spair);
 
 	if (avail == 0) {
@@ -459,6 +553,9 @@ static ssize_t spair_write(void *obj, const void *buffer, size_t count)
 
 	if (will_block) {
 
+		/* a signal raised for data read earlier is stale */
+		k_poll_signal_reset(&remote->read_signal);
+
 		for (int signaled = false, result = -1; !signaled;
 			result = -1) {
 
@@ -532,6 +629,7 @@ static ssize_t spair_write(void *obj, const void *buffer, size_t count)
 			 &bytes_written, 1, K_NO_WAIT);
 	__ASSERT(res == 0, "k_pipe_put() failed: %d", res);
 
+signal:
 	res = k_poll_signal_raise(&remote->write_signal, SPAIR_SIG_DATA);
 	__ASSERT(res == 0, "k_poll_signal_raise() failed: %d", res);
 
@@ -644,6 +742,11 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 
 	if (will_block) {
 
+		/* a signal raised for data written earlier is stale */
+		k_poll_signal_reset(&spair->write_signal);
+
+		spair_handoff_offer(spair, buffer, count);
+
 		for (int signaled = false, result = -1; !signaled;
 			result = -1) {
 
@@ -666,6 +769,13 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 
 			have_local_sem = true;
 
+			/* data written directly to the buffer is received
+			 * even if the remote end was closed meanwhile
+			 */
+			if (spair_handoff_done(spair)) {
+				break;
+			}
+
 			k_poll_signal_check(&spair->write_signal, &signaled,
 					    &result);
 			if (!signaled) {
@@ -696,9 +806,12 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 		}
 	}
 
-	res = k_pipe_get(&spair->recv_q, (void *)buffer, count, &bytes_read,
-			 1, K_NO_WAIT);
-	__ASSERT(res == 0, "k_pipe_get() failed: %d", res);
+	bytes_read = spair_handoff_take(spair);
+	if (bytes_read == 0) {
+		res = k_pipe_get(&spair->recv_q, (void *)buffer, count,
+				 &bytes_read, 1, K_NO_WAIT);
+		__ASSERT(res == 0, "k_pipe_get() failed: %d", res);
+	}
 
 	if (is_connected) {
 		res = k_poll_signal_raise(&spair->read_signal, SPAIR_SIG_DATA);
@@ -710,6 +823,7 @@ static ssize_t spair_read(void *obj, void *buffer, size_t count)
 out:
 
 	if (spair != NULL && have_local_sem) {
+		(void)spair_handoff_take(spair);
 		k_sem_give(&spair->sem);
 	}
 
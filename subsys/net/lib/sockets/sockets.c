@@ -332,6 +332,9 @@ static void zsock_accepted_cb(struct net_context *new_ctx,
 		k_fifo_init(&new_ctx->recv_q);
 		k_condvar_init(&new_ctx->cond.recv);
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+		atomic_inc(&parent->recv_gen);
+#endif
 		k_fifo_put(&parent->accept_q, new_ctx);
 	}
 }
@@ -350,6 +353,13 @@ static void zsock_received_cb(struct net_context *ctx,
 	NET_DBG("ctx=%p, pkt=%p, st=%d, user_data=%p", ctx, pkt, status,
 		user_data);
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+	/* Before queueing, so a concurrent epoll sees at worst a spurious
+	 * edge rather than missing one.
+	 */
+	atomic_inc(&ctx->recv_gen);
+#endif
+
 	/* if pkt is NULL, EOF */
 	if (!pkt) {
 		struct net_pkt *last_pkt = k_fifo_peek_tail(&ctx->recv_q);
@@ -617,21 +627,68 @@ static inline int z_vrfy_zsock_accept(int sock, struct sockaddr *addr,
 #define WAIT_BUFS K_MSEC(100)
 #define MAX_WAIT_BUFS K_SECONDS(10)
 
-ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
-			 int flags,
-			 const struct sockaddr *dest_addr, socklen_t addrlen)
+static k_timeout_t send_timeout(struct net_context *ctx, int flags,
+				uint64_t *buf_timeout)
 {
 	k_timeout_t timeout = K_FOREVER;
-	uint64_t buf_timeout = 0;
-	int status;
+
+	*buf_timeout = 0;
 
 	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
 		timeout = K_NO_WAIT;
 	} else {
 		net_context_get_option(ctx, NET_OPT_SNDTIMEO, &timeout, NULL);
-		buf_timeout = sys_clock_timeout_end_calc(MAX_WAIT_BUFS);
+		*buf_timeout = sys_clock_timeout_end_calc(MAX_WAIT_BUFS);
+	}
+
+	return timeout;
+}
+
+/* Returns 0 if a failed send is to be retried, or sets errno and
+ * returns -1.
+ */
+static int send_check_retry(int status, k_timeout_t timeout,
+			    uint64_t buf_timeout)
+{
+	if (((status == -ENOBUFS) || (status == -EAGAIN)) &&
+	    K_TIMEOUT_EQ(timeout, K_FOREVER)) {
+		/* If we cannot get any buffers in reasonable
+		 * amount of time, then do not wait forever as
+		 * there might be some bigger issue.
+		 * If we get -EAGAIN and cannot recover, then
+		 * it means that the sending window is blocked
+		 * and we just cannot send anything.
+		 */
+		int64_t remaining = buf_timeout - sys_clock_tick_get();
+
+		if (remaining <= 0) {
+			if (status == -ENOBUFS) {
+				errno = ENOMEM;
+			} else {
+				errno = ENOBUFS;
+			}
+
+			return -1;
+		}
+
+		k_sleep(WAIT_BUFS);
+		return 0;
 	}
 
+	errno = -status;
+	return -1;
+}
+
+ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
+			 int flags,
+			 const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	k_timeout_t timeout;
+	uint64_t buf_timeout;
+	int status;
+
+	timeout = send_timeout(ctx, flags, &buf_timeout);
+
 	/* Register the callback before sending in order to receive the response
 	 * from the peer.
 	 */
@@ -653,33 +710,11 @@ ssize_t zsock_sendto_ctx(struct net_context *ctx, const void *buf, size_t len,
 		}
 
 		if (status < 0) {
-			if (((status == -ENOBUFS) || (status == -EAGAIN)) &&
-			    K_TIMEOUT_EQ(timeout, K_FOREVER)) {
-				/* If we cannot get any buffers in reasonable
-				 * amount of time, then do not wait forever as
-				 * there might be some bigger issue.
-				 * If we get -EAGAIN and cannot recover, then
-				 * it means that the sending window is blocked
-				 * and we just cannot send anything.
-				 */
-				int64_t remaining = buf_timeout - sys_clock_tick_get();
-
-				if (remaining <= 0) {
-					if (status == -ENOBUFS) {
-						errno = ENOMEM;
-					} else {
-						errno = ENOBUFS;
-					}
-
-					return -1;
-				}
-
-				k_sleep(WAIT_BUFS);
-				continue;
-			} else {
-				errno = -status;
+			if (send_check_retry(status, timeout, buf_timeout)) {
 				return -1;
 			}
+
+			continue;
 		}
 
 		break;
@@ -717,19 +752,24 @@ ssize_t z_vrfy_zsock_sendto(int sock, const void *buf, size_t len, int flags,
 ssize_t zsock_sendmsg_ctx(struct net_context *ctx, const struct msghdr *msg,
 			  int flags)
 {
-	k_timeout_t timeout = K_FOREVER;
+	k_timeout_t timeout;
+	uint64_t buf_timeout;
 	int status;
 
-	if ((flags & ZSOCK_MSG_DONTWAIT) || sock_is_nonblock(ctx)) {
-		timeout = K_NO_WAIT;
-	} else {
-		net_context_get_option(ctx, NET_OPT_SNDTIMEO, &timeout, NULL);
-	}
+	timeout = send_timeout(ctx, flags, &buf_timeout);
 
-	status = net_context_sendmsg(ctx, msg, flags, NULL, timeout, NULL);
-	if (status < 0) {
-		errno = -status;
-		return -1;
+	while (1) {
+		status = net_context_sendmsg(ctx, msg, flags, NULL, timeout,
+					     NULL);
+		if (status < 0) {
+			if (send_check_retry(status, timeout, buf_timeout)) {
+				return -1;
+			}
+
+			continue;
+		}
+
+		break;
 	}
 
 	return status;
@@ -1927,6 +1967,19 @@ int z_vrfy_zsock_setsockopt(int sock, int level, int optname,
 	kernel_optval = z_user_alloc_from_copy((const void *)optval, optlen);
 	Z_OOPS(!kernel_optval);
 
+	/* The stack keeps writing to the ring after the call, when the
+	 * memory might not belong to the thread anymore, so the ring of a
+	 * user mode thread is always taken from the memory of the stack.
+	 */
+	if (IS_ENABLED(CONFIG_NET_SOCKETS_PACKET_RX_RING) &&
+	    level == SOL_PACKET && optname == PACKET_RX_RING &&
+	    optlen == sizeof(struct tpacket_req) &&
+	    ((struct tpacket_req *)kernel_optval)->tp_ring != NULL) {
+		k_free(kernel_optval);
+		errno = EPERM;
+		return -1;
+	}
+
 	ret = z_impl_zsock_setsockopt(sock, level, optname,
 				      kernel_optval, optlen);
 
@@ -2104,6 +2157,18 @@ static int sock_ioctl_vmeth(void *obj, unsigned int request, va_list args)
 		return 0;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_EPOLL)
+	case ZFD_IOCTL_POLL_GENERATION: {
+		struct net_context *ctx = obj;
+		uint32_t *gen;
+
+		gen = va_arg(args, uint32_t *);
+		*gen = (uint32_t)atomic_get(&ctx->recv_gen);
+
+		return 0;
+	}
+#endif
+
 	default:
 		errno = EOPNOTSUPP;
 		return -1;
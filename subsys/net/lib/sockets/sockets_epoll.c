@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief epoll-style socket readiness notification
+ *
+ * An epoll instance keeps the k_poll_event array of its interest list
+ * across zsock_epoll_wait() calls. POLL_PREPARE is issued for a descriptor
+ * when it is added, and afterwards only when it was reported ready, so idle
+ * sockets cost nothing beyond a k_poll() registration per wait.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_sock_epoll, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <kernel.h>
+#include <net/socket.h>
+#include <sys/fdtable.h>
+
+#include "sockets_internal.h"
+
+/* k_poll_event slots reserved per descriptor. A socket implementation
+ * may need more than one event for a single pollfd (e.g. DTLS waiting for
+ * the handshake on top of the underlying socket).
+ */
+#define EPOLL_EVENTS_PER_FD 2
+
+/* Events which are passed down to the POLL_PREPARE/POLL_UPDATE ioctls */
+#define EPOLL_POLL_EVENTS (ZSOCK_EPOLLIN | ZSOCK_EPOLLPRI | ZSOCK_EPOLLOUT)
+
+/* Descriptor needs POLL_PREPARE before it is waited on again */
+#define EPOLL_ENTRY_REARM BIT(0)
+/* POLL_PREPARE reported the descriptor ready without waiting */
+#define EPOLL_ENTRY_READY BIT(1)
+/* Reported edge-triggered descriptor, ignored until the next wait call */
+#define EPOLL_ENTRY_MASKED BIT(2)
+/* EPOLLONESHOT descriptor was reported, ignored until EPOLL_CTL_MOD */
+#define EPOLL_ENTRY_DISABLED BIT(3)
+/* Descriptor cannot tell when new input was queued (no
+ * ZFD_IOCTL_POLL_GENERATION), edge-triggered state is reset on every wait.
+ */
+#define EPOLL_ENTRY_NO_GEN BIT(4)
+
+struct epoll_entry {
+	void *obj;
+	const struct fd_op_vtable *vtable;
+	struct k_mutex *lock;
+	zsock_epoll_data_t data;
+	uint32_t events;
+	/* Conditions already reported for an edge-triggered descriptor */
+	uint32_t reported;
+	/* Input generation of the descriptor when it was last reported */
+	uint32_t gen;
+	int fd;
+	uint8_t flags;
+};
+
+struct epoll_instance {
+	struct k_mutex lock;
+	/* Raised by epoll_ctl() to get the instance from a blocked waiter */
+	struct k_poll_signal ctl_signal;
+	struct epoll_entry entries[CONFIG_NET_SOCKETS_EPOLL_MAX_FDS];
+	/* Slot 0 waits on ctl_signal, followed by EPOLL_EVENTS_PER_FD slots
+	 * for each entry.
+	 */
+	struct k_poll_event poll_events[1 + CONFIG_NET_SOCKETS_EPOLL_MAX_FDS *
+					EPOLL_EVENTS_PER_FD];
+	int count;
+	/* Entry to start the next scan from, so that busy descriptors at the
+	 * start of the interest list cannot starve the others.
+	 */
+	int next;
+	bool in_use;
+};
+
+static struct epoll_instance epoll_instances[
+					CONFIG_NET_SOCKETS_EPOLL_MAX_INSTANCES];
+static K_MUTEX_DEFINE(epoll_lock);
+
+static const struct fd_op_vtable epoll_fd_op_vtable;
+
+static inline struct k_poll_event *entry_events(struct epoll_instance *ep,
+						int idx)
+{
+	return &ep->poll_events[1 + idx * EPOLL_EVENTS_PER_FD];
+}
+
+static void entry_ignore(struct epoll_instance *ep, int idx)
+{
+	struct k_poll_event *pev = entry_events(ep, idx);
+	int i;
+
+	for (i = 0; i < EPOLL_EVENTS_PER_FD; i++, pev++) {
+		pev->type = K_POLL_TYPE_IGNORE;
+		pev->state = K_POLL_STATE_NOT_READY;
+	}
+}
+
+static bool entry_fired(struct epoll_instance *ep, int idx)
+{
+	struct k_poll_event *pev = entry_events(ep, idx);
+	int i;
+
+	for (i = 0; i < EPOLL_EVENTS_PER_FD; i++, pev++) {
+		if (pev->type != K_POLL_TYPE_IGNORE &&
+		    pev->state != K_POLL_STATE_NOT_READY) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int entry_find(struct epoll_instance *ep, int fd)
+{
+	int i;
+
+	for (i = 0; i < ep->count; i++) {
+		if (ep->entries[i].fd == fd) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void entry_remove(struct epoll_instance *ep, int idx)
+{
+	int last = ep->count - 1;
+
+	if (idx != last) {
+		ep->entries[idx] = ep->entries[last];
+		memcpy(entry_events(ep, idx), entry_events(ep, last),
+		       sizeof(struct k_poll_event) * EPOLL_EVENTS_PER_FD);
+	}
+
+	ep->count--;
+
+	if (ep->next >= ep->count) {
+		ep->next = 0;
+	}
+}
+
+/* Let the descriptor fill in its k_poll_event slots. */
+static int entry_arm(struct epoll_instance *ep, int idx)
+{
+	struct epoll_entry *entry = &ep->entries[idx];
+	struct k_poll_event *pev = entry_events(ep, idx);
+	struct k_poll_event *pev_end = pev + EPOLL_EVENTS_PER_FD;
+	struct zsock_pollfd pfd = {
+		.fd = entry->fd,
+		.events = entry->events & EPOLL_POLL_EVENTS,
+	};
+	int ret;
+
+	entry_ignore(ep, idx);
+	entry->flags &= ~(EPOLL_ENTRY_REARM | EPOLL_ENTRY_READY);
+
+	(void)k_mutex_lock(entry->lock, K_FOREVER);
+	ret = z_fdtable_call_ioctl(entry->vtable, entry->obj,
+				   ZFD_IOCTL_POLL_PREPARE, &pfd, &pev, pev_end);
+	k_mutex_unlock(entry->lock);
+
+	if (ret == -EALREADY) {
+		entry->flags |= EPOLL_ENTRY_READY;
+		ret = 0;
+	}
+
+	return ret;
+}
+
+/* Sample the input generation of an edge-triggered descriptor. New input
+ * since the last report starts a new edge even if the descriptor never
+ * looked idle to us (drained and refilled between two waits).
+ */
+static void entry_update_generation(struct epoll_entry *entry)
+{
+	uint32_t gen;
+	int ret;
+
+	if (entry->flags & EPOLL_ENTRY_NO_GEN) {
+		return;
+	}
+
+	(void)k_mutex_lock(entry->lock, K_FOREVER);
+	ret = z_fdtable_call_ioctl(entry->vtable, entry->obj,
+				   ZFD_IOCTL_POLL_GENERATION, &gen);
+	k_mutex_unlock(entry->lock);
+
+	if (ret < 0) {
+		entry->flags |= EPOLL_ENTRY_NO_GEN;
+		entry->reported = 0U;
+	} else if (gen != entry->gen) {
+		entry->gen = gen;
+		entry->reported = 0U;
+	}
+}
+
+/* Translate the k_poll() outcome into ZSOCK_EPOLL* conditions. */
+static int entry_update(struct epoll_instance *ep, int idx, uint32_t *revents)
+{
+	struct epoll_entry *entry = &ep->entries[idx];
+	struct k_poll_event *pev = entry_events(ep, idx);
+	struct zsock_pollfd pfd = {
+		.fd = entry->fd,
+		.events = entry->events & EPOLL_POLL_EVENTS,
+	};
+	int ret;
+
+	entry->flags |= EPOLL_ENTRY_REARM;
+
+	(void)k_mutex_lock(entry->lock, K_FOREVER);
+	ret = z_fdtable_call_ioctl(entry->vtable, entry->obj,
+				   ZFD_IOCTL_POLL_UPDATE, &pfd, &pev);
+	k_mutex_unlock(entry->lock);
+
+	if (ret == -EAGAIN) {
+		/* Event fired but there is nothing for the application yet
+		 * (e.g. TLS record not complete).
+		 */
+		pfd.revents = 0;
+		ret = 0;
+	}
+
+	*revents = (uint16_t)pfd.revents;
+
+	return ret;
+}
+
+/* Drop entries whose descriptor was closed without EPOLL_CTL_DEL. */
+static void epoll_prune(struct epoll_instance *ep)
+{
+	const struct fd_op_vtable *vtable;
+	int i;
+
+	for (i = ep->count - 1; i >= 0; i--) {
+		if (z_get_fd_obj_and_vtable(ep->entries[i].fd, &vtable,
+					    NULL) != ep->entries[i].obj) {
+			NET_DBG("epoll %p: fd %d closed", ep,
+				ep->entries[i].fd);
+			entry_remove(ep, i);
+		}
+	}
+}
+
+static int epoll_collect(struct epoll_instance *ep,
+			 struct zsock_epoll_event *events, int maxevents)
+{
+	int count = ep->count;
+	int start = ep->next;
+	int n = 0;
+	int i, j;
+
+	for (j = 0; j < count; j++) {
+		struct epoll_entry *entry;
+		uint32_t revents;
+		uint32_t report;
+		int ret;
+
+		i = (start + j) % count;
+		entry = &ep->entries[i];
+
+		if (entry->flags & (EPOLL_ENTRY_MASKED | EPOLL_ENTRY_DISABLED)) {
+			continue;
+		}
+
+		if (!(entry->flags & EPOLL_ENTRY_READY) && !entry_fired(ep, i)) {
+			/* Not ready, so the next readiness is a new edge */
+			entry->reported = 0U;
+			continue;
+		}
+
+		if (n == maxevents) {
+			/* No room to report it now, make sure it is checked
+			 * again from scratch on the next call.
+			 */
+			entry->flags |= EPOLL_ENTRY_REARM;
+			continue;
+		}
+
+		if (entry->events & ZSOCK_EPOLLET) {
+			/* Sampled before POLL_UPDATE, so input queued in
+			 * between is at worst reported once more.
+			 */
+			entry_update_generation(entry);
+		}
+
+		ret = entry_update(ep, i, &revents);
+		if (ret < 0) {
+			return ret;
+		}
+
+		report = revents;
+
+		if (entry->events & ZSOCK_EPOLLET) {
+			report &= ~entry->reported;
+			entry->reported = revents;
+		}
+
+		if (report == 0U) {
+			if (revents != 0U) {
+				/* Edge-triggered and still ready: keep it out
+				 * of k_poll() so the wait can block.
+				 */
+				entry->flags |= EPOLL_ENTRY_MASKED;
+				entry_ignore(ep, i);
+			}
+
+			continue;
+		}
+
+		events[n].events = report;
+		events[n].data = entry->data;
+		n++;
+
+		if (entry->events & ZSOCK_EPOLLONESHOT) {
+			entry->flags |= EPOLL_ENTRY_DISABLED;
+			entry_ignore(ep, i);
+		} else if (entry->events & ZSOCK_EPOLLET) {
+			entry->flags |= EPOLL_ENTRY_MASKED;
+			entry_ignore(ep, i);
+		}
+
+		ep->next = (i + 1) % count;
+	}
+
+	return n;
+}
+
+static struct epoll_instance *epoll_get(int epfd)
+{
+	return z_get_fd_obj(epfd, &epoll_fd_op_vtable, EINVAL);
+}
+
+/* Take the instance lock, kicking a blocked zsock_epoll_wait() if needed. */
+static void epoll_lock_instance(struct epoll_instance *ep)
+{
+	if (k_mutex_lock(&ep->lock, K_NO_WAIT) == 0) {
+		return;
+	}
+
+	k_poll_signal_raise(&ep->ctl_signal, 0);
+	(void)k_mutex_lock(&ep->lock, K_FOREVER);
+	k_poll_signal_reset(&ep->ctl_signal);
+}
+
+int zsock_epoll_create(int size)
+{
+	struct epoll_instance *ep = NULL;
+	int fd;
+	int i;
+
+	if (size <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = z_reserve_fd();
+	if (fd < 0) {
+		return -1;
+	}
+
+	(void)k_mutex_lock(&epoll_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(epoll_instances); i++) {
+		if (!epoll_instances[i].in_use) {
+			ep = &epoll_instances[i];
+			ep->in_use = true;
+			break;
+		}
+	}
+
+	k_mutex_unlock(&epoll_lock);
+
+	if (ep == NULL) {
+		z_free_fd(fd);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	k_mutex_init(&ep->lock);
+	k_poll_signal_init(&ep->ctl_signal);
+	k_poll_event_init(&ep->poll_events[0], K_POLL_TYPE_SIGNAL,
+			  K_POLL_MODE_NOTIFY_ONLY, &ep->ctl_signal);
+	ep->count = 0;
+	ep->next = 0;
+
+	z_finalize_fd(fd, ep, &epoll_fd_op_vtable);
+
+	NET_DBG("epoll %p: fd %d", ep, fd);
+
+	return fd;
+}
+
+static int epoll_ctl_add(struct epoll_instance *ep, int fd,
+			 const struct zsock_epoll_event *event)
+{
+	struct epoll_entry *entry;
+	const struct fd_op_vtable *vtable;
+	struct k_mutex *lock;
+	void *obj;
+	int ret;
+
+	if (entry_find(ep, fd) >= 0) {
+		return -EEXIST;
+	}
+
+	if (ep->count == ARRAY_SIZE(ep->entries)) {
+		return -ENOMEM;
+	}
+
+	obj = z_get_fd_obj_and_vtable(fd, &vtable, &lock);
+	if (obj == NULL) {
+		return -EBADF;
+	}
+
+	if (vtable == &epoll_fd_op_vtable) {
+		/* Nested epoll instances are not supported */
+		return -EINVAL;
+	}
+
+	entry = &ep->entries[ep->count];
+	entry->obj = obj;
+	entry->vtable = vtable;
+	entry->lock = lock;
+	entry->data = event->data;
+	entry->events = event->events;
+	entry->reported = 0U;
+	entry->gen = 0U;
+	entry->fd = fd;
+	entry->flags = 0U;
+
+	ret = entry_arm(ep, ep->count);
+	if (ret == -EXDEV) {
+		/* Offloaded sockets have their own poll implementation */
+		return -EPERM;
+	} else if (ret < 0) {
+		return ret;
+	}
+
+	ep->count++;
+
+	return 0;
+}
+
+int zsock_epoll_ctl(int epfd, int op, int fd,
+		    struct zsock_epoll_event *event)
+{
+	struct epoll_instance *ep;
+	struct epoll_entry *entry;
+	int ret = 0;
+	int idx;
+
+	ep = epoll_get(epfd);
+	if (ep == NULL) {
+		return -1;
+	}
+
+	if (fd == epfd) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (op != ZSOCK_EPOLL_CTL_DEL && event == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	epoll_lock_instance(ep);
+
+	switch (op) {
+	case ZSOCK_EPOLL_CTL_ADD:
+		ret = epoll_ctl_add(ep, fd, event);
+		break;
+
+	case ZSOCK_EPOLL_CTL_MOD:
+		idx = entry_find(ep, fd);
+		if (idx < 0) {
+			ret = -ENOENT;
+			break;
+		}
+
+		entry = &ep->entries[idx];
+		entry->data = event->data;
+		entry->events = event->events;
+		entry->reported = 0U;
+		entry->flags = EPOLL_ENTRY_REARM |
+			       (entry->flags & EPOLL_ENTRY_NO_GEN);
+		entry_ignore(ep, idx);
+		break;
+
+	case ZSOCK_EPOLL_CTL_DEL:
+		idx = entry_find(ep, fd);
+		if (idx < 0) {
+			ret = -ENOENT;
+			break;
+		}
+
+		entry_remove(ep, idx);
+		break;
+
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	k_mutex_unlock(&ep->lock);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return 0;
+}
+
+int zsock_epoll_wait(int epfd, struct zsock_epoll_event *events,
+		     int maxevents, int timeout)
+{
+	struct epoll_instance *ep;
+	k_timeout_t poll_timeout;
+	k_timeout_t wait_timeout;
+	uint64_t end;
+	int ret = 0;
+	int i;
+
+	ep = epoll_get(epfd);
+	if (ep == NULL) {
+		return -1;
+	}
+
+	if (maxevents <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (timeout < 0) {
+		wait_timeout = K_FOREVER;
+	} else {
+		wait_timeout = K_MSEC(timeout);
+	}
+
+	end = sys_clock_timeout_end_calc(wait_timeout);
+
+	(void)k_mutex_lock(&ep->lock, K_FOREVER);
+
+	epoll_prune(ep);
+
+	while (true) {
+		poll_timeout = wait_timeout;
+
+		for (i = 0; i < ep->count; i++) {
+			struct epoll_entry *entry = &ep->entries[i];
+
+			if (entry->flags & (EPOLL_ENTRY_MASKED |
+					     EPOLL_ENTRY_DISABLED)) {
+				continue;
+			}
+
+			if (entry->flags & EPOLL_ENTRY_REARM) {
+				ret = entry_arm(ep, i);
+				if (ret < 0) {
+					goto out;
+				}
+			}
+
+			if (entry->flags & EPOLL_ENTRY_READY) {
+				poll_timeout = K_NO_WAIT;
+			}
+		}
+
+		ret = k_poll(ep->poll_events,
+			     1 + ep->count * EPOLL_EVENTS_PER_FD, poll_timeout);
+		/* EAGAIN when timeout expired, EINTR when cancelled */
+		if (ret != 0 && ret != -EAGAIN && ret != -EINTR) {
+			goto out;
+		}
+
+		if (ep->poll_events[0].state != K_POLL_STATE_NOT_READY) {
+			/* epoll_ctl() is waiting for the instance, hand it
+			 * over and pick up the changes afterwards.
+			 */
+			ep->poll_events[0].state = K_POLL_STATE_NOT_READY;
+			k_mutex_unlock(&ep->lock);
+			(void)k_mutex_lock(&ep->lock, K_FOREVER);
+			epoll_prune(ep);
+			ret = 0;
+		} else {
+			ret = epoll_collect(ep, events, maxevents);
+			if (ret != 0) {
+				goto out;
+			}
+		}
+
+		if (K_TIMEOUT_EQ(wait_timeout, K_NO_WAIT)) {
+			break;
+		}
+
+		if (!K_TIMEOUT_EQ(wait_timeout, K_FOREVER)) {
+			int64_t remaining = end - sys_clock_tick_get();
+
+			if (remaining <= 0) {
+				break;
+			}
+
+			wait_timeout = Z_TIMEOUT_TICKS(remaining);
+		}
+	}
+
+out:
+	/* Descriptors masked for this call are checked again on the next */
+	for (i = 0; i < ep->count; i++) {
+		struct epoll_entry *entry = &ep->entries[i];
+
+		if (entry->flags & EPOLL_ENTRY_MASKED) {
+			entry->flags &= ~EPOLL_ENTRY_MASKED;
+			entry->flags |= EPOLL_ENTRY_REARM;
+		}
+
+		if (entry->flags & EPOLL_ENTRY_NO_GEN) {
+			entry->reported = 0U;
+		}
+	}
+
+	k_mutex_unlock(&ep->lock);
+
+	if (ret < 0) {
+		errno = -ret;
+		return -1;
+	}
+
+	return ret;
+}
+
+static ssize_t epoll_read_vmeth(void *obj, void *buffer, size_t count)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t epoll_write_vmeth(void *obj, const void *buffer, size_t count)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static int epoll_ioctl_vmeth(void *obj, unsigned int request, va_list args)
+{
+	switch (request) {
+	case ZFD_IOCTL_SET_LOCK:
+		/* The instance uses its own lock */
+		return 0;
+
+	default:
+		errno = EOPNOTSUPP;
+		return -1;
+	}
+}
+
+static int epoll_close_vmeth(void *obj)
+{
+	struct epoll_instance *ep = obj;
+
+	(void)k_mutex_lock(&epoll_lock, K_FOREVER);
+	ep->count = 0;
+	ep->in_use = false;
+	k_mutex_unlock(&epoll_lock);
+
+	return 0;
+}
+
+static const struct fd_op_vtable epoll_fd_op_vtable = {
+	.read = epoll_read_vmeth,
+	.write = epoll_write_vmeth,
+	.close = epoll_close_vmeth,
+	.ioctl = epoll_ioctl_vmeth,
+};
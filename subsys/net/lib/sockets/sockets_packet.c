@@ -75,6 +75,409 @@ static int zpacket_socket(int family, int type, int proto)
 	return fd;
 }
 
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+struct packet_rx_ring {
+	struct net_context *ctx;
+	uint8_t *frames;
+	unsigned int frame_size;
+	unsigned int frame_nr;
+	/* Next frame to write */
+	unsigned int head;
+	/* Packets were dropped since the last written frame */
+	bool losing;
+	struct tpacket_stats stats;
+	struct k_poll_signal signal;
+#if defined(CONFIG_USERSPACE)
+	/* Memory domain the stack owned ring was added to, if any */
+	struct k_mem_domain *domain;
+	struct k_mem_partition part;
+#endif
+};
+
+static struct packet_rx_ring rx_rings[CONFIG_NET_SOCKETS_PACKET_RX_RING_COUNT];
+static K_MUTEX_DEFINE(rx_rings_lock);
+
+#if CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE > 0
+BUILD_ASSERT((CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE &
+	      (CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE - 1)) == 0,
+	     "The ring size must be a power of two");
+
+/* The rings owned by the stack, one per entry of rx_rings. Each one is
+ * aligned on its size so that it can be mapped as a memory partition.
+ */
+static uint8_t rx_rings_mem[CONFIG_NET_SOCKETS_PACKET_RX_RING_COUNT]
+			   [CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE]
+	__aligned(CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE);
+#endif
+
+static struct packet_rx_ring *rx_ring_find(struct net_context *ctx)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(rx_rings); i++) {
+		if (rx_rings[i].ctx == ctx) {
+			return &rx_rings[i];
+		}
+	}
+
+	return NULL;
+}
+
+static inline struct tpacket_hdr *rx_ring_frame(struct packet_rx_ring *ring,
+						unsigned int idx)
+{
+	return (struct tpacket_hdr *)(ring->frames + idx * ring->frame_size);
+}
+
+/* The status is shared with the application, read and write it with
+ * barriers so that the frame content is seen before it.
+ */
+static inline uint32_t rx_ring_frame_status(struct tpacket_hdr *hdr)
+{
+	return atomic_get((atomic_t *)&hdr->tp_status);
+}
+
+/* Readable as long as the last written frame was not given back, as the
+ * application reads the frames in order.
+ */
+static bool rx_ring_is_readable(struct packet_rx_ring *ring)
+{
+	unsigned int prev = (ring->head + ring->frame_nr - 1) % ring->frame_nr;
+
+	return rx_ring_frame_status(rx_ring_frame(ring, prev)) &
+		TP_STATUS_USER;
+}
+
+#if CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE > 0
+/* Take the ring from the memory of the stack, and let a user mode caller
+ * access it until the socket is closed.
+ */
+static int rx_ring_alloc(struct packet_rx_ring *ring)
+{
+	uint8_t *mem = rx_rings_mem[ring - rx_rings];
+
+	(void)memset(mem, 0, CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE);
+
+#if defined(CONFIG_USERSPACE)
+	if (k_current_get()->base.user_options & K_USER) {
+		struct k_mem_domain *domain =
+			k_current_get()->mem_domain_info.mem_domain;
+
+		if (domain->num_partitions >=
+		    arch_mem_domain_max_partitions_get()) {
+			return -ENOSPC;
+		}
+
+		ring->part.start = POINTER_TO_UINT(mem);
+		ring->part.size = CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE;
+		ring->part.attr = K_MEM_PARTITION_P_RW_U_RW;
+
+		k_mem_domain_add_partition(domain, &ring->part);
+		ring->domain = domain;
+	}
+#endif
+
+	ring->frames = mem;
+
+	return 0;
+}
+#endif
+
+static void rx_ring_free(struct packet_rx_ring *ring)
+{
+#if defined(CONFIG_USERSPACE)
+	if (ring->domain) {
+		k_mem_domain_remove_partition(ring->domain, &ring->part);
+		ring->domain = NULL;
+	}
+#endif
+}
+
+static int rx_ring_set(struct net_context *ctx, const void *optval,
+		       socklen_t optlen)
+{
+	const struct tpacket_req *req = optval;
+	struct packet_rx_ring *ring;
+	unsigned int i;
+	int ret = 0;
+
+	if (!optval || optlen != sizeof(*req)) {
+		return -EINVAL;
+	}
+
+	if (POINTER_TO_UINT(req->tp_ring) % sizeof(uint32_t) ||
+	    req->tp_frame_nr == 0U ||
+	    req->tp_frame_size <= TPACKET_HDRLEN ||
+	    req->tp_frame_size % TPACKET_ALIGNMENT ||
+	    req->tp_frame_nr > UINT_MAX / req->tp_frame_size) {
+		return -EINVAL;
+	}
+
+	if (!req->tp_ring &&
+	    req->tp_frame_size * req->tp_frame_nr >
+	    CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+	if (rx_ring_find(ctx)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	ring = rx_ring_find(NULL);
+	if (!ring) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+#if CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE > 0
+	if (!req->tp_ring) {
+		ret = rx_ring_alloc(ring);
+		if (ret < 0) {
+			goto out;
+		}
+	} else
+#endif
+	{
+		ring->frames = req->tp_ring;
+	}
+
+	ring->frame_size = req->tp_frame_size;
+	ring->frame_nr = req->tp_frame_nr;
+	ring->head = 0U;
+	ring->losing = false;
+	(void)memset(&ring->stats, 0, sizeof(ring->stats));
+	k_poll_signal_init(&ring->signal);
+
+	for (i = 0U; i < ring->frame_nr; i++) {
+		rx_ring_frame(ring, i)->tp_status = TP_STATUS_KERNEL;
+	}
+
+	ring->ctx = ctx;
+
+	/* From now on, the frames are only delivered to the ring */
+	ctx->flags |= NET_CONTEXT_RX_COPY;
+
+out:
+	k_mutex_unlock(&rx_rings_lock);
+
+	return ret;
+}
+
+static void rx_ring_release(struct net_context *ctx)
+{
+	struct packet_rx_ring *ring;
+
+	k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+	ring = rx_ring_find(ctx);
+	if (ring) {
+		rx_ring_free(ring);
+		ring->ctx = NULL;
+	}
+
+	k_mutex_unlock(&rx_rings_lock);
+}
+
+static int rx_ring_get(struct net_context *ctx, void *optval,
+		       socklen_t *optlen)
+{
+	struct tpacket_req *req = optval;
+	struct packet_rx_ring *ring;
+	int ret = 0;
+
+	if (*optlen < sizeof(*req)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+	ring = rx_ring_find(ctx);
+	if (ring) {
+		req->tp_ring = ring->frames;
+		req->tp_frame_size = ring->frame_size;
+		req->tp_frame_nr = ring->frame_nr;
+		*optlen = sizeof(*req);
+	} else {
+		ret = -EINVAL;
+	}
+
+	k_mutex_unlock(&rx_rings_lock);
+
+	return ret;
+}
+
+static int rx_ring_get_stats(struct net_context *ctx, void *optval,
+			     socklen_t *optlen)
+{
+	struct packet_rx_ring *ring;
+	int ret = 0;
+
+	if (*optlen < sizeof(struct tpacket_stats)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+	ring = rx_ring_find(ctx);
+	if (ring) {
+		/* The statistics are reset once read */
+		memcpy(optval, &ring->stats, sizeof(ring->stats));
+		(void)memset(&ring->stats, 0, sizeof(ring->stats));
+		*optlen = sizeof(ring->stats);
+	} else {
+		ret = -EINVAL;
+	}
+
+	k_mutex_unlock(&rx_rings_lock);
+
+	return ret;
+}
+
+static void rx_ring_put(struct net_context *ctx, struct net_pkt *pkt)
+{
+	struct net_pkt_cursor backup;
+	struct packet_rx_ring *ring;
+	struct tpacket_hdr *hdr;
+	uint32_t status = TP_STATUS_USER;
+	uint64_t ns;
+	size_t len;
+
+	k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+	/* No ring when the socket is being closed */
+	ring = rx_ring_find(ctx);
+	if (!ring) {
+		goto out;
+	}
+
+	ring->stats.tp_packets++;
+
+	hdr = rx_ring_frame(ring, ring->head);
+	if (rx_ring_frame_status(hdr) != TP_STATUS_KERNEL) {
+		ring->stats.tp_drops++;
+		ring->losing = true;
+		goto out;
+	}
+
+	/* Like recv(), the packet starts at the cursor */
+	len = net_pkt_remaining_data(pkt);
+
+	hdr->tp_len = len;
+	hdr->tp_snaplen = MIN(len, ring->frame_size - TPACKET_HDRLEN);
+	hdr->tp_mac = TPACKET_HDRLEN;
+	hdr->tp_ifindex = net_if_get_by_iface(net_pkt_iface(pkt));
+
+#if defined(CONFIG_NET_PKT_TIMESTAMP)
+	if (net_pkt_timestamp(pkt)->second ||
+	    net_pkt_timestamp(pkt)->nanosecond) {
+		ns = net_pkt_timestamp(pkt)->second * NSEC_PER_SEC +
+			net_pkt_timestamp(pkt)->nanosecond;
+	} else
+#endif
+	{
+		ns = k_ticks_to_ns_floor64(k_uptime_ticks());
+	}
+
+	hdr->tp_sec = ns / NSEC_PER_SEC;
+	hdr->tp_nsec = ns % NSEC_PER_SEC;
+
+	/* The packet continues in the stack, leave its cursor as is */
+	net_pkt_cursor_backup(pkt, &backup);
+	(void)net_pkt_read(pkt, (uint8_t *)hdr + TPACKET_HDRLEN,
+			   hdr->tp_snaplen);
+	net_pkt_cursor_restore(pkt, &backup);
+
+	if (ring->losing) {
+		status |= TP_STATUS_LOSING;
+		ring->losing = false;
+	}
+
+	atomic_set((atomic_t *)&hdr->tp_status, status);
+
+	ring->head = (ring->head + 1) % ring->frame_nr;
+
+	k_poll_signal_raise(&ring->signal, 0);
+
+out:
+	k_mutex_unlock(&rx_rings_lock);
+}
+
+static int rx_ring_poll_prepare(struct net_context *ctx,
+				struct zsock_pollfd *pfd,
+				struct k_poll_event **pev,
+				struct k_poll_event *pev_end)
+{
+	struct packet_rx_ring *ring;
+	int ret = 0;
+
+	if (pfd->events & ZSOCK_POLLIN) {
+		if (*pev == pev_end) {
+			return -ENOMEM;
+		}
+
+		k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+		ring = rx_ring_find(ctx);
+		if (ring) {
+			/* Reset before checking, so that a frame written
+			 * meanwhile raises the signal again.
+			 */
+			k_poll_signal_reset(&ring->signal);
+
+			(*pev)->obj = &ring->signal;
+			(*pev)->type = K_POLL_TYPE_SIGNAL;
+			(*pev)->mode = K_POLL_MODE_NOTIFY_ONLY;
+			(*pev)->state = K_POLL_STATE_NOT_READY;
+			(*pev)++;
+
+			if (rx_ring_is_readable(ring)) {
+				ret = -EALREADY;
+			}
+		} else {
+			ret = -EBADF;
+		}
+
+		k_mutex_unlock(&rx_rings_lock);
+	}
+
+	if (pfd->events & ZSOCK_POLLOUT) {
+		return -EALREADY;
+	}
+
+	return ret;
+}
+
+static int rx_ring_poll_update(struct net_context *ctx,
+			       struct zsock_pollfd *pfd,
+			       struct k_poll_event **pev)
+{
+	struct packet_rx_ring *ring;
+
+	/* For now, assume that socket is always writable */
+	if (pfd->events & ZSOCK_POLLOUT) {
+		pfd->revents |= ZSOCK_POLLOUT;
+	}
+
+	if (pfd->events & ZSOCK_POLLIN) {
+		k_mutex_lock(&rx_rings_lock, K_FOREVER);
+
+		ring = rx_ring_find(ctx);
+		if (ring && rx_ring_is_readable(ring)) {
+			pfd->revents |= ZSOCK_POLLIN;
+		}
+
+		k_mutex_unlock(&rx_rings_lock);
+
+		(*pev)++;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_NET_SOCKETS_PACKET_RX_RING */
+
 static void zpacket_received_cb(struct net_context *ctx,
 				struct net_pkt *pkt,
 				union net_ip_header *ip_hdr,
@@ -105,6 +508,14 @@ static void zpacket_received_cb(struct net_context *ctx,
 		return;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+	if (ctx->flags & NET_CONTEXT_RX_COPY) {
+		rx_ring_put(ctx, pkt);
+		net_pkt_unref(pkt);
+		return;
+	}
+#endif
+
 	/* Normal packet */
 	net_pkt_set_eof(pkt, false);
 
@@ -266,6 +677,26 @@ int zpacket_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 		return -1;
 	}
 
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+	if (level == SOL_PACKET &&
+	    (optname == PACKET_RX_RING || optname == PACKET_STATISTICS)) {
+		int ret;
+
+		if (optname == PACKET_RX_RING) {
+			ret = rx_ring_get(ctx, optval, optlen);
+		} else {
+			ret = rx_ring_get_stats(ctx, optval, optlen);
+		}
+
+		if (ret < 0) {
+			errno = -ret;
+			return -1;
+		}
+
+		return 0;
+	}
+#endif
+
 	return sock_fd_op_vtable.getsockopt(ctx, level, optname,
 					    optval, optlen);
 }
@@ -273,6 +704,19 @@ int zpacket_getsockopt_ctx(struct net_context *ctx, int level, int optname,
 int zpacket_setsockopt_ctx(struct net_context *ctx, int level, int optname,
 			const void *optval, socklen_t optlen)
 {
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+	if (level == SOL_PACKET && optname == PACKET_RX_RING) {
+		int ret = rx_ring_set(ctx, optval, optlen);
+
+		if (ret < 0) {
+			errno = -ret;
+			return -1;
+		}
+
+		return 0;
+	}
+#endif
+
 	return sock_fd_op_vtable.setsockopt(ctx, level, optname,
 					    optval, optlen);
 }
@@ -291,6 +735,34 @@ static ssize_t packet_sock_write_vmeth(void *obj, const void *buffer,
 static int packet_sock_ioctl_vmeth(void *obj, unsigned int request,
 				   va_list args)
 {
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+	struct net_context *ctx = obj;
+
+	if (request == ZFD_IOCTL_POLL_PREPARE &&
+	    (ctx->flags & NET_CONTEXT_RX_COPY)) {
+		struct zsock_pollfd *pfd;
+		struct k_poll_event **pev;
+		struct k_poll_event *pev_end;
+
+		pfd = va_arg(args, struct zsock_pollfd *);
+		pev = va_arg(args, struct k_poll_event **);
+		pev_end = va_arg(args, struct k_poll_event *);
+
+		return rx_ring_poll_prepare(ctx, pfd, pev, pev_end);
+	}
+
+	if (request == ZFD_IOCTL_POLL_UPDATE &&
+	    (ctx->flags & NET_CONTEXT_RX_COPY)) {
+		struct zsock_pollfd *pfd;
+		struct k_poll_event **pev;
+
+		pfd = va_arg(args, struct zsock_pollfd *);
+		pev = va_arg(args, struct k_poll_event **);
+
+		return rx_ring_poll_update(ctx, pfd, pev);
+	}
+#endif
+
 	return sock_fd_op_vtable.fd_vtable.ioctl(obj, request, args);
 }
 
@@ -362,6 +834,13 @@ static int packet_sock_setsockopt_vmeth(void *obj, int level, int optname,
 
 static int packet_sock_close_vmeth(void *obj)
 {
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+	/* The application may reuse the ring memory once closed, and a user
+	 * mode thread loses access to a ring owned by the stack.
+	 */
+	rx_ring_release(obj);
+#endif
+
 	return zsock_close_ctx(obj);
 }
 
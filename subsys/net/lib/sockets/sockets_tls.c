@@ -34,6 +34,10 @@ LOG_MODULE_REGISTER(net_sock_tls, CONFIG_NET_SOCKETS_LOG_LEVEL);
 #include <mbedtls/ssl_cookie.h>
 #include <mbedtls/error.h>
 #include <mbedtls/debug.h>
+
+#if defined(MBEDTLS_SSL_CACHE_C)
+#include <mbedtls/ssl_cache.h>
+#endif
 #endif /* CONFIG_MBEDTLS */
 
 #include "sockets_internal.h"
@@ -45,6 +49,8 @@ LOG_MODULE_REGISTER(net_sock_tls, CONFIG_NET_SOCKETS_LOG_LEVEL);
 #define ALPN_MAX_PROTOCOLS 0
 #endif /* CONFIG_NET_SOCKETS_TLS_MAX_APP_PROTOCOLS */
 
+#define TLS_CLIENT_SESSION_COUNT CONFIG_NET_SOCKETS_TLS_MAX_CLIENT_SESSION_COUNT
+
 static const struct socket_op_vtable tls_sock_fd_op_vtable;
 
 /** A list of secure tags that TLS context should use. */
@@ -72,6 +78,28 @@ struct dtls_timing_context {
 	uint32_t fin_ms;
 };
 
+#if TLS_CLIENT_SESSION_COUNT > 0
+/** A stored TLS client session. */
+struct tls_session_cache {
+	/** Time the session was stored, the oldest one is replaced first. */
+	uint32_t timestamp;
+
+	/** Address and port of the peer. */
+	struct sockaddr peer_addr;
+
+	/** Hostname set on the socket (0-terminated, empty if not set),
+	 *  followed by the serialized session.
+	 */
+	uint8_t *data;
+
+	/** Length of the hostname, including the terminating 0. */
+	size_t hostname_len;
+
+	/** Length of the serialized session. */
+	size_t session_len;
+};
+#endif /* TLS_CLIENT_SESSION_COUNT > 0 */
+
 /** TLS context information. */
 __net_socket struct tls_context {
 	/** Information whether TLS context is used. */
@@ -98,6 +126,9 @@ __net_socket struct tls_context {
 	/** Information whether TLS handshake is complete or not. */
 	struct k_sem tls_established;
 
+	/** Time the handshake was started, for handshake statistics. */
+	uint32_t handshake_start;
+
 	/** TLS specific option values. */
 	struct {
 		/** Select which credentials to use with TLS. */
@@ -121,6 +152,9 @@ __net_socket struct tls_context {
 		/** DTLS role, client by default. */
 		int8_t role;
 
+		/** Information whether the client session cache is used. */
+		int8_t cache_enabled;
+
 		/** NULL-terminated list of allowed application layer
 		 * protocols.
 		 */
@@ -180,6 +214,20 @@ static struct tls_context tls_contexts[CONFIG_NET_SOCKETS_TLS_MAX_CONTEXTS];
 /* A mutex for protecting TLS context allocation. */
 static struct k_mutex context_lock;
 
+/* Statistics of the handshakes done on all the TLS contexts. */
+static struct tls_handshake_stats handshake_stats;
+
+#if TLS_CLIENT_SESSION_COUNT > 0
+/* Stored client sessions, protected by context_lock. */
+static struct tls_session_cache client_cache[TLS_CLIENT_SESSION_COUNT];
+#endif
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_CACHE)
+/* Sessions of the server sockets, protected by server_cache_lock. */
+static mbedtls_ssl_cache_context server_cache;
+static struct k_mutex server_cache_lock;
+#endif
+
 bool net_socket_is_tls(void *obj)
 {
 	return PART_OF_ARRAY(tls_contexts, (struct tls_context *)obj);
@@ -310,6 +358,13 @@ static int tls_init(const struct device *unused)
 
 	k_mutex_init(&context_lock);
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_CACHE)
+	k_mutex_init(&server_cache_lock);
+	mbedtls_ssl_cache_init(&server_cache);
+	mbedtls_ssl_cache_set_max_entries(
+		&server_cache, CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_COUNT);
+#endif
+
 	mbedtls_ctr_drbg_init(&tls_ctr_drbg);
 
 	ret = mbedtls_ctr_drbg_seed(&tls_ctr_drbg, tls_entropy_func, NULL,
@@ -395,6 +450,10 @@ static struct tls_context *tls_alloc(void)
 			(void)memset(tls, 0, sizeof(*tls));
 			tls->is_used = true;
 			tls->options.verify_level = -1;
+			tls->options.cache_enabled =
+				TLS_CLIENT_SESSION_COUNT > 0 ?
+				TLS_SESSION_CACHE_ENABLED :
+				TLS_SESSION_CACHE_DISABLED;
 			tls->sock = -1;
 
 			NET_DBG("Allocated TLS context, %p", tls);
@@ -488,6 +547,258 @@ static int tls_release(struct tls_context *tls)
 	return 0;
 }
 
+#if TLS_CLIENT_SESSION_COUNT > 0
+static const char *tls_session_hostname(struct tls_context *context)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	if (context->options.is_hostname_set && context->ssl.hostname) {
+		return context->ssl.hostname;
+	}
+#endif
+
+	return "";
+}
+
+static bool tls_session_match(struct tls_session_cache *entry,
+			      const char *hostname,
+			      const struct sockaddr *addr)
+{
+	if (entry->data == NULL || strcmp((char *)entry->data, hostname) != 0 ||
+	    entry->peer_addr.sa_family != addr->sa_family) {
+		return false;
+	}
+
+	/* With a hostname, the peer address is allowed to change. */
+	if (IS_ENABLED(CONFIG_NET_IPV4) && addr->sa_family == AF_INET) {
+		if (net_sin(&entry->peer_addr)->sin_port !=
+		    net_sin(addr)->sin_port) {
+			return false;
+		}
+
+		return hostname[0] != '\0' ||
+			net_ipv4_addr_cmp(&net_sin(&entry->peer_addr)->sin_addr,
+					  &net_sin(addr)->sin_addr);
+	}
+
+	if (IS_ENABLED(CONFIG_NET_IPV6) && addr->sa_family == AF_INET6) {
+		if (net_sin6(&entry->peer_addr)->sin6_port !=
+		    net_sin6(addr)->sin6_port) {
+			return false;
+		}
+
+		return hostname[0] != '\0' ||
+			net_ipv6_addr_cmp(&net_sin6(&entry->peer_addr)->sin6_addr,
+					  &net_sin6(addr)->sin6_addr);
+	}
+
+	return false;
+}
+
+/* Must be called with context_lock held. */
+static struct tls_session_cache *tls_session_find(const char *hostname,
+						  const struct sockaddr *addr)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+		if (tls_session_match(&client_cache[i], hostname, addr)) {
+			return &client_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with context_lock held. */
+static void tls_session_free(struct tls_session_cache *entry)
+{
+	k_free(entry->data);
+	(void)memset(entry, 0, sizeof(*entry));
+}
+
+/* Store the session established with the peer, replacing the previous
+ * session with the same peer or the oldest one.
+ */
+static void tls_session_store(struct tls_context *context,
+			      const struct sockaddr *addr, socklen_t addrlen)
+{
+	const char *hostname = tls_session_hostname(context);
+	size_t hostname_len = strlen(hostname) + 1;
+	struct tls_session_cache *entry;
+	mbedtls_ssl_session session;
+	size_t session_len;
+	uint8_t *data;
+	int ret, i;
+
+	if (context->options.cache_enabled != TLS_SESSION_CACHE_ENABLED ||
+	    addrlen > sizeof(entry->peer_addr)) {
+		return;
+	}
+
+	mbedtls_ssl_session_init(&session);
+
+	ret = mbedtls_ssl_get_session(&context->ssl, &session);
+	if (ret != 0) {
+		goto out;
+	}
+
+	ret = mbedtls_ssl_session_save(&session, NULL, 0, &session_len);
+	if (ret != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+		goto out;
+	}
+
+	data = k_malloc(hostname_len + session_len);
+	if (data == NULL) {
+		NET_WARN("No memory to store TLS session");
+		goto out;
+	}
+
+	memcpy(data, hostname, hostname_len);
+
+	ret = mbedtls_ssl_session_save(&session, data + hostname_len,
+				       session_len, &session_len);
+	if (ret != 0) {
+		k_free(data);
+		goto out;
+	}
+
+	k_mutex_lock(&context_lock, K_FOREVER);
+
+	entry = tls_session_find(hostname, addr);
+
+	for (i = 0; entry == NULL && i < ARRAY_SIZE(client_cache); i++) {
+		if (client_cache[i].data == NULL) {
+			entry = &client_cache[i];
+		}
+	}
+
+	if (entry == NULL) {
+		entry = &client_cache[0];
+
+		for (i = 1; i < ARRAY_SIZE(client_cache); i++) {
+			if ((int32_t)(client_cache[i].timestamp -
+				      entry->timestamp) < 0) {
+				entry = &client_cache[i];
+			}
+		}
+	}
+
+	tls_session_free(entry);
+
+	entry->data = data;
+	entry->hostname_len = hostname_len;
+	entry->session_len = session_len;
+	entry->timestamp = k_uptime_get_32();
+	memcpy(&entry->peer_addr, addr, addrlen);
+
+	k_mutex_unlock(&context_lock);
+
+out:
+	mbedtls_ssl_session_free(&session);
+}
+
+/* Offer the session stored for the peer, if any, in the next handshake.
+ * The ID of the offered session is returned in id.
+ */
+static void tls_session_restore(struct tls_context *context,
+				const struct sockaddr *addr,
+				uint8_t *id, size_t *id_len)
+{
+	struct tls_session_cache *entry;
+	mbedtls_ssl_session session;
+	int ret;
+
+	*id_len = 0;
+
+	if (context->options.cache_enabled != TLS_SESSION_CACHE_ENABLED) {
+		return;
+	}
+
+	mbedtls_ssl_session_init(&session);
+
+	k_mutex_lock(&context_lock, K_FOREVER);
+
+	entry = tls_session_find(tls_session_hostname(context), addr);
+	if (entry == NULL) {
+		goto out;
+	}
+
+	ret = mbedtls_ssl_session_load(&session,
+				       entry->data + entry->hostname_len,
+				       entry->session_len);
+	if (ret == 0) {
+		ret = mbedtls_ssl_set_session(&context->ssl, &session);
+	}
+
+	if (ret != 0) {
+		NET_DBG("Cannot restore TLS session: -%x", -ret);
+		tls_session_free(entry);
+		goto out;
+	}
+
+	*id_len = session.id_len;
+	memcpy(id, session.id, session.id_len);
+
+out:
+	k_mutex_unlock(&context_lock);
+
+	mbedtls_ssl_session_free(&session);
+}
+
+static void tls_session_purge(void)
+{
+	int i;
+
+	k_mutex_lock(&context_lock, K_FOREVER);
+
+	for (i = 0; i < ARRAY_SIZE(client_cache); i++) {
+		tls_session_free(&client_cache[i]);
+	}
+
+	k_mutex_unlock(&context_lock);
+}
+#else
+static void tls_session_purge(void) {}
+#endif /* TLS_CLIENT_SESSION_COUNT > 0 */
+
+#if defined(CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_CACHE)
+static int tls_server_cache_get(void *data, mbedtls_ssl_session *session)
+{
+	int ret;
+
+	k_mutex_lock(&server_cache_lock, K_FOREVER);
+	ret = mbedtls_ssl_cache_get(data, session);
+	k_mutex_unlock(&server_cache_lock);
+
+	return ret;
+}
+
+static int tls_server_cache_set(void *data, const mbedtls_ssl_session *session)
+{
+	int ret;
+
+	k_mutex_lock(&server_cache_lock, K_FOREVER);
+	ret = mbedtls_ssl_cache_set(data, session);
+	k_mutex_unlock(&server_cache_lock);
+
+	return ret;
+}
+
+static void tls_server_cache_purge(void)
+{
+	k_mutex_lock(&server_cache_lock, K_FOREVER);
+
+	mbedtls_ssl_cache_free(&server_cache);
+	mbedtls_ssl_cache_init(&server_cache);
+	mbedtls_ssl_cache_set_max_entries(
+		&server_cache, CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_COUNT);
+
+	k_mutex_unlock(&server_cache_lock);
+}
+#else
+static void tls_server_cache_purge(void) {}
+#endif /* CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_CACHE */
+
 static inline int time_left(uint32_t start, uint32_t timeout)
 {
 	uint32_t elapsed = k_uptime_get_32() - start;
@@ -903,6 +1214,7 @@ static int tls_mbedtls_reset(struct tls_context *context)
 	}
 
 	k_sem_init(&context->tls_established, 0, 1);
+	context->handshake_start = k_uptime_get_32();
 
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	(void)memset(&context->dtls_peer_addr, 0,
@@ -944,12 +1256,64 @@ static int tls_mbedtls_handshake(struct tls_context *context, bool block)
 	}
 
 	if (ret == 0) {
+		uint32_t duration = k_uptime_get_32() - context->handshake_start;
+
+		k_mutex_lock(&context_lock, K_FOREVER);
+		handshake_stats.count++;
+		handshake_stats.total_time += duration;
+		handshake_stats.max_time = MAX(handshake_stats.max_time,
+					       duration);
+		k_mutex_unlock(&context_lock);
+
+		NET_DBG("TLS handshake done in %u ms", duration);
+
 		k_sem_give(&context->tls_established);
+	} else if (ret != -EAGAIN) {
+		k_mutex_lock(&context_lock, K_FOREVER);
+		handshake_stats.failed++;
+		k_mutex_unlock(&context_lock);
 	}
 
 	return ret;
 }
 
+/* Do the client handshake, resuming the session stored for the peer if
+ * possible, and store the established session.
+ */
+static int tls_client_handshake(struct tls_context *context,
+				const struct sockaddr *addr, socklen_t addrlen)
+{
+#if TLS_CLIENT_SESSION_COUNT > 0
+	uint8_t id[sizeof(context->ssl.session_negotiate->id)];
+	size_t id_len;
+	int ret;
+
+	tls_session_restore(context, addr, id, &id_len);
+
+	ret = tls_mbedtls_handshake(context, true);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* The server sends back the offered ID if it resumes the session. */
+	if (id_len > 0 && context->ssl.session->id_len == id_len &&
+	    memcmp(context->ssl.session->id, id, id_len) == 0) {
+		k_mutex_lock(&context_lock, K_FOREVER);
+		handshake_stats.resumed++;
+		k_mutex_unlock(&context_lock);
+	}
+
+	tls_session_store(context, addr, addrlen);
+
+	return 0;
+#else
+	ARG_UNUSED(addr);
+	ARG_UNUSED(addrlen);
+
+	return tls_mbedtls_handshake(context, true);
+#endif /* TLS_CLIENT_SESSION_COUNT > 0 */
+}
+
 static int tls_mbedtls_init(struct tls_context *context, bool is_server)
 {
 	int role, type, ret;
@@ -1043,6 +1407,15 @@ static int tls_mbedtls_init(struct tls_context *context, bool is_server)
 			     mbedtls_ctr_drbg_random,
 			     &tls_ctr_drbg);
 
+#if defined(CONFIG_NET_SOCKETS_TLS_SERVER_SESSION_CACHE)
+	if (role == MBEDTLS_SSL_IS_SERVER) {
+		mbedtls_ssl_conf_session_cache(&context->config,
+					       &server_cache,
+					       tls_server_cache_get,
+					       tls_server_cache_set);
+	}
+#endif
+
 	ret = tls_mbedtls_set_credentials(context);
 	if (ret != 0) {
 		return ret;
@@ -1068,6 +1441,7 @@ static int tls_mbedtls_init(struct tls_context *context, bool is_server)
 	}
 
 	context->is_initialized = true;
+	context->handshake_start = k_uptime_get_32();
 
 	return 0;
 }
@@ -1411,6 +1785,78 @@ static int tls_opt_dtls_role_set(struct tls_context *context,
 	return 0;
 }
 
+static int tls_opt_session_cache_set(struct tls_context *context,
+				     const void *optval, socklen_t optlen)
+{
+	int *cache_enabled;
+
+	if (!optval) {
+		return -EINVAL;
+	}
+
+	if (optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	cache_enabled = (int *)optval;
+
+	if (*cache_enabled != TLS_SESSION_CACHE_DISABLED &&
+	    *cache_enabled != TLS_SESSION_CACHE_ENABLED) {
+		return -EINVAL;
+	}
+
+	if (*cache_enabled == TLS_SESSION_CACHE_ENABLED &&
+	    TLS_CLIENT_SESSION_COUNT == 0) {
+		return -ENOTSUP;
+	}
+
+	context->options.cache_enabled = *cache_enabled;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_get(struct tls_context *context,
+				     void *optval, socklen_t *optlen)
+{
+	if (*optlen != sizeof(int)) {
+		return -EINVAL;
+	}
+
+	*(int *)optval = context->options.cache_enabled;
+
+	return 0;
+}
+
+static int tls_opt_session_cache_purge_set(struct tls_context *context,
+					   const void *optval,
+					   socklen_t optlen)
+{
+	ARG_UNUSED(context);
+	ARG_UNUSED(optval);
+	ARG_UNUSED(optlen);
+
+	tls_session_purge();
+	tls_server_cache_purge();
+
+	return 0;
+}
+
+static int tls_opt_handshake_stats_get(struct tls_context *context,
+				       void *optval, socklen_t *optlen)
+{
+	ARG_UNUSED(context);
+
+	if (*optlen != sizeof(struct tls_handshake_stats)) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&context_lock, K_FOREVER);
+	memcpy(optval, &handshake_stats, sizeof(handshake_stats));
+	k_mutex_unlock(&context_lock);
+
+	return 0;
+}
+
 static int protocol_check(int family, int type, int *proto)
 {
 	if (family != AF_INET && family != AF_INET6) {
@@ -1534,7 +1980,7 @@ int ztls_connect_ctx(struct tls_context *ctx, const struct sockaddr *addr,
 		/* TODO For simplicity, TLS handshake blocks the socket
 		 * even for non-blocking socket.
 		 */
-		ret = tls_mbedtls_handshake(ctx, true);
+		ret = tls_client_handshake(ctx, addr, addrlen);
 		if (ret < 0) {
 			goto error;
 		}
@@ -1674,7 +2120,8 @@ static ssize_t sendto_dtls_client(struct tls_context *ctx, const void *buf,
 		/* TODO For simplicity, TLS handshake blocks the socket even for
 		 * non-blocking socket.
 		 */
-		ret = tls_mbedtls_handshake(ctx, true);
+		ret = tls_client_handshake(ctx, &ctx->dtls_peer_addr,
+					   ctx->dtls_peer_addrlen);
 		if (ret < 0) {
 			goto error;
 		}
@@ -2362,6 +2809,14 @@ int ztls_getsockopt_ctx(struct tls_context *ctx, int level, int optname,
 		err = tls_opt_alpn_list_get(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_get(ctx, optval, optlen);
+		break;
+
+	case TLS_HANDSHAKE_STATS:
+		err = tls_opt_handshake_stats_get(ctx, optval, optlen);
+		break;
+
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	case TLS_DTLS_HANDSHAKE_TIMEOUT_MIN:
 		err = tls_opt_dtls_handshake_timeout_get(ctx, optval,
@@ -2427,6 +2882,14 @@ int ztls_setsockopt_ctx(struct tls_context *ctx, int level, int optname,
 		err = tls_opt_alpn_list_set(ctx, optval, optlen);
 		break;
 
+	case TLS_SESSION_CACHE:
+		err = tls_opt_session_cache_set(ctx, optval, optlen);
+		break;
+
+	case TLS_SESSION_CACHE_PURGE:
+		err = tls_opt_session_cache_purge_set(ctx, optval, optlen);
+		break;
+
 #if defined(CONFIG_NET_SOCKETS_ENABLE_DTLS)
 	case TLS_DTLS_HANDSHAKE_TIMEOUT_MIN:
 		err = tls_opt_dtls_handshake_timeout_set(ctx, optval,
@@ -49,8 +49,11 @@ static struct k_sem contexts_lock;
 extern const struct socket_op_vtable sock_fd_op_vtable;
 static const struct socket_op_vtable websocket_fd_op_vtable;
 
+/* Header, and the payload vector entries sent with it in one call */
+#define WEBSOCKET_SEND_IOV_MAX 8
+
 #if defined(CONFIG_NET_TEST)
-int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg);
+ssize_t websocket_test_sendmsg(const struct msghdr *msg);
 #endif
 
 static const char *opcode2str(enum websocket_opcode opcode)
@@ -440,54 +443,188 @@ static int websocket_ioctl_vmeth(void *obj, unsigned int request, va_list args)
 	return sock_fd_op_vtable.fd_vtable.ioctl(obj, request, args);
 }
 
-static int websocket_prepare_and_send(struct websocket_context *ctx,
-				      uint8_t *header, size_t header_len,
-				      uint8_t *payload, size_t payload_len,
-				      int32_t timeout)
+/* Apply the masking key to the data, offset is the position of the data
+ * in the payload. The bulk of the data is handled a machine word at a time.
+ * The dst and src can point to the same buffer.
+ */
+static void websocket_mask(uint8_t *dst, const uint8_t *src, size_t len,
+			   uint32_t masking_value, uint64_t offset)
 {
-	struct iovec io_vector[2];
-	struct msghdr msg;
+	unsigned long mask_word;
+	uint8_t mask[sizeof(mask_word)];
+	size_t i = 0, start;
+	int j;
+
+	for (; i < len && ((uintptr_t)&dst[i] & (sizeof(mask_word) - 1));
+	     i++) {
+		dst[i] = src[i] ^ (uint8_t)(masking_value >>
+					    (8 * (3 - (i + offset) % 4)));
+	}
 
-	io_vector[0].iov_base = header;
-	io_vector[0].iov_len = header_len;
-	io_vector[1].iov_base = payload;
-	io_vector[1].iov_len = payload_len;
+	/* The word covers whole masking keys, so once rotated to start at
+	 * dst[i] it stays valid for the rest of the data.
+	 */
+	start = i;
 
-	memset(&msg, 0, sizeof(msg));
+	for (j = 0; j < sizeof(mask); j++) {
+		mask[j] = masking_value >> (8 * (3 - (i + j + offset) % 4));
+	}
 
-	msg.msg_iov = io_vector;
-	msg.msg_iovlen = ARRAY_SIZE(io_vector);
+	memcpy(&mask_word, mask, sizeof(mask_word));
 
-	if (HEXDUMP_SENT_PACKETS) {
-		LOG_HEXDUMP_DBG(header, header_len, "Header");
-		LOG_HEXDUMP_DBG(payload, payload_len, "Payload");
+	for (; i + sizeof(mask_word) <= len; i += sizeof(mask_word)) {
+		*(unsigned long *)&dst[i] =
+			UNALIGNED_GET((const unsigned long *)&src[i]) ^
+			mask_word;
 	}
 
+	for (; i < len; i++) {
+		dst[i] = src[i] ^ mask[(i - start) % sizeof(mask)];
+	}
+}
+
+static ssize_t websocket_sendmsg(struct websocket_context *ctx,
+				 struct iovec *iov, int iovcnt, int flags)
+{
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
 #if defined(CONFIG_NET_TEST)
-	/* Simulate a case where the payload is split to two. The unit test
-	 * does not set mask bit in this case.
-	 */
-	return verify_sent_and_received_msg(&msg, !(header[1] & BIT(7)));
+	/* The unit test collects the sent data instead of the socket layer */
+	ARG_UNUSED(flags);
+
+	return websocket_test_sendmsg(&msg);
 #else
-	k_timeout_t tout = K_FOREVER;
+	return sendmsg(ctx->real_sock, &msg, flags);
+#endif /* CONFIG_NET_TEST */
+}
 
-	if (timeout != SYS_FOREVER_MS) {
-		tout = K_MSEC(timeout);
+/* Send all of the vector, the vector is consumed. Once the first part of
+ * a frame has been sent, the rest of it is sent even if the caller did not
+ * want to wait, as the peer could not find the next frame otherwise.
+ */
+static int websocket_send_all(struct websocket_context *ctx,
+			      struct iovec *iov, int iovcnt, int *flags)
+{
+	ssize_t ret;
+
+	if (HEXDUMP_SENT_PACKETS) {
+		int i;
+
+		for (i = 0; i < iovcnt; i++) {
+			LOG_HEXDUMP_DBG(iov[i].iov_base, iov[i].iov_len,
+					"Data");
+		}
 	}
 
-	return sendmsg(ctx->real_sock, &msg,
-		       K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
-#endif /* CONFIG_NET_TEST */
+	while (iovcnt > 0) {
+		ret = websocket_sendmsg(ctx, iov, iovcnt, *flags);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		*flags &= ~MSG_DONTWAIT;
+
+		while (iovcnt > 0 && ret >= iov->iov_len) {
+			ret -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if (iovcnt > 0) {
+			iov->iov_base = (uint8_t *)iov->iov_base + ret;
+			iov->iov_len -= ret;
+		}
+	}
+
+	return 0;
 }
 
-int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
-		       enum websocket_opcode opcode, bool mask, bool final,
-		       int32_t timeout)
+/* Send the header followed by the payload. Masked data is processed in
+ * chunks that fit in a buffer on the stack, the masking is done while
+ * gathering the payload so that it is copied only once.
+ */
+static int websocket_send_payload(struct websocket_context *ctx,
+				  uint8_t *header, size_t header_len,
+				  const struct iovec *iov, int iovcnt,
+				  bool mask, int flags)
+{
+	struct iovec io_vector[WEBSOCKET_SEND_IOV_MAX];
+	uint64_t offset = 0;
+	size_t pos = 0;
+	int vec = 1;
+	int i = 0;
+	int ret;
+
+	io_vector[0].iov_base = header;
+	io_vector[0].iov_len = header_len;
+
+	if (!mask) {
+		do {
+			while (vec < ARRAY_SIZE(io_vector) && i < iovcnt) {
+				io_vector[vec++] = iov[i++];
+			}
+
+			ret = websocket_send_all(ctx, io_vector, vec, &flags);
+			if (ret < 0) {
+				return ret;
+			}
+
+			vec = 0;
+		} while (i < iovcnt);
+
+		return 0;
+	}
+
+	do {
+		uint8_t buf[CONFIG_WEBSOCKET_MASK_BUF_LEN];
+		size_t len = 0;
+		size_t count;
+
+		while (len < sizeof(buf) && i < iovcnt) {
+			count = MIN(sizeof(buf) - len, iov[i].iov_len - pos);
+
+			websocket_mask(&buf[len],
+				       (const uint8_t *)iov[i].iov_base + pos,
+				       count, ctx->masking_value, offset + len);
+
+			len += count;
+			pos += count;
+
+			if (pos == iov[i].iov_len) {
+				pos = 0;
+				i++;
+			}
+		}
+
+		io_vector[vec].iov_base = buf;
+		io_vector[vec].iov_len = len;
+
+		ret = websocket_send_all(ctx, io_vector, vec + 1, &flags);
+		if (ret < 0) {
+			return ret;
+		}
+
+		offset += len;
+		vec = 0;
+	} while (i < iovcnt);
+
+	return 0;
+}
+
+int websocket_send_msg_iov(int ws_sock, const struct iovec *iov, int iovcnt,
+			   enum websocket_opcode opcode, bool mask, bool final,
+			   int32_t timeout)
 {
 	struct websocket_context *ctx;
 	uint8_t header[MAX_HEADER_LEN], hdr_len = 2;
-	uint8_t *data_to_send = (uint8_t *)payload;
-	int ret;
+	size_t payload_len = 0;
+	int flags = 0;
+	int ret, i;
 
 	if (opcode != WEBSOCKET_OPCODE_DATA_TEXT &&
 	    opcode != WEBSOCKET_OPCODE_DATA_BINARY &&
@@ -498,6 +635,10 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 		return -EINVAL;
 	}
 
+	if (iovcnt < 0 || (iovcnt > 0 && !iov)) {
+		return -EINVAL;
+	}
+
 #if defined(CONFIG_NET_TEST)
 	/* Websocket unit test does not use socket layer but feeds
 	 * the data directly here when testing this function.
@@ -514,6 +655,10 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 	}
 #endif /* CONFIG_NET_TEST */
 
+	for (i = 0; i < iovcnt; i++) {
+		payload_len += iov[i].iov_len;
+	}
+
 	NET_DBG("[%p] Len %zd %s/%d/%s", ctx, payload_len, opcode2str(opcode),
 		mask, final ? "final" : "more");
 
@@ -550,41 +695,39 @@ int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
 
 	/* Add masking value if needed */
 	if (mask) {
-		int i;
-
 		ctx->masking_value = sys_rand32_get();
 
 		header[hdr_len++] |= ctx->masking_value >> 24;
 		header[hdr_len++] |= ctx->masking_value >> 16;
 		header[hdr_len++] |= ctx->masking_value >> 8;
 		header[hdr_len++] |= ctx->masking_value;
+	}
 
-		data_to_send = k_malloc(payload_len);
-		if (!data_to_send) {
-			return -ENOMEM;
-		}
-
-		memcpy(data_to_send, payload, payload_len);
-
-		for (i = 0; i < payload_len; i++) {
-			data_to_send[i] ^=
-				ctx->masking_value >> (8 * (3 - i % 4));
-		}
+	if (timeout == 0) {
+		flags = MSG_DONTWAIT;
 	}
 
-	ret = websocket_prepare_and_send(ctx, header, hdr_len,
-					 data_to_send, payload_len, timeout);
+	ret = websocket_send_payload(ctx, header, hdr_len, iov, iovcnt, mask,
+				     flags);
 	if (ret < 0) {
-		NET_DBG("Cannot send ws msg (%d)", -errno);
-		goto quit;
+		NET_DBG("Cannot send ws msg (%d)", ret);
+		return ret;
 	}
 
-quit:
-	if (data_to_send != payload) {
-		k_free(data_to_send);
-	}
+	return payload_len;
+}
 
-	return ret - hdr_len;
+int websocket_send_msg(int ws_sock, const uint8_t *payload, size_t payload_len,
+		       enum websocket_opcode opcode, bool mask, bool final,
+		       int32_t timeout)
+{
+	struct iovec iov = {
+		.iov_base = (void *)payload,
+		.iov_len = payload_len,
+	};
+
+	return websocket_send_msg_iov(ws_sock, &iov, 1, opcode, mask, final,
+				      timeout);
 }
 
 static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
@@ -651,6 +794,52 @@ static bool websocket_parse_header(uint8_t *buf, size_t buf_len, bool *masked,
 	return false;
 }
 
+/* Parse the header if all of it is in the temporary buffer */
+static int websocket_parse_buffered_header(struct websocket_context *ctx,
+					   size_t *header_len)
+{
+	bool masked;
+
+	/* Now we will be able to figure out what is the actual size of
+	 * the header.
+	 */
+	if (ctx->tmp_buf_pos < MIN_HEADER_LEN ||
+	    !websocket_parse_header(&ctx->tmp_buf[0], ctx->tmp_buf_pos,
+				    &masked, &ctx->masking_value,
+				    &ctx->message_len, &ctx->message_type,
+				    header_len) ||
+	    ctx->tmp_buf_pos < *header_len) {
+		return -EAGAIN;
+	}
+
+	ctx->masked = masked;
+
+	if (ctx->message_type & (WEBSOCKET_FLAG_TEXT |
+				 WEBSOCKET_FLAG_BINARY)) {
+		/* Start of a possibly fragmented message */
+		if (ctx->message_type & WEBSOCKET_FLAG_FINAL) {
+			ctx->fragment_type = 0;
+		} else {
+			ctx->fragment_type = ctx->message_type &
+				(WEBSOCKET_FLAG_TEXT | WEBSOCKET_FLAG_BINARY);
+		}
+	} else if (!(ctx->message_type & (WEBSOCKET_FLAG_CLOSE |
+					  WEBSOCKET_FLAG_PING |
+					  WEBSOCKET_FLAG_PONG))) {
+		/* A continuation frame does not tell the data type, report
+		 * the one of the first fragment so that the caller can
+		 * process the message as it arrives.
+		 */
+		ctx->message_type |= ctx->fragment_type;
+
+		if (ctx->message_type & WEBSOCKET_FLAG_FINAL) {
+			ctx->fragment_type = 0;
+		}
+	}
+
+	return 0;
+}
+
 int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 		       uint32_t *message_type, uint64_t *remaining, int32_t timeout)
 {
@@ -690,8 +879,11 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 	}
 #endif /* CONFIG_NET_TEST */
 
-	/* If we have not received the websocket header yet, read it first */
-	if (!ctx->header_received) {
+	/* If we have not received the websocket header yet, read it first.
+	 * The previous read might have fetched it already.
+	 */
+	if (!ctx->header_received &&
+	    websocket_parse_buffered_header(ctx, &header_len) < 0) {
 #if defined(CONFIG_NET_TEST)
 		size_t input_len = MIN(ctx->tmp_buf_len - ctx->tmp_buf_pos,
 				       test_data->input_len);
@@ -717,40 +909,22 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 
 		ctx->tmp_buf_pos += ret;
 
-		if (ctx->tmp_buf_pos >= MIN_HEADER_LEN) {
-			bool masked;
-
-			/* Now we will be able to figure out what is the
-			 * actual size of the header.
-			 */
-			if (websocket_parse_header(&ctx->tmp_buf[0],
-						   ctx->tmp_buf_pos,
-						   &masked,
-						   &ctx->masking_value,
-						   &ctx->message_len,
-						   &ctx->message_type,
-						   &header_len)) {
-				ctx->masked = masked;
-
-				if (message_type) {
-					*message_type = ctx->message_type;
-				}
-			} else {
-				return -EAGAIN;
-			}
-		} else {
-			return -EAGAIN;
-		}
-
-		if (ctx->tmp_buf_pos < header_len) {
-			return -EAGAIN;
+		ret = websocket_parse_buffered_header(ctx, &header_len);
+		if (ret < 0) {
+			return ret;
 		}
+	}
 
+	if (!ctx->header_received) {
 		/* All of the header is now received, we can read the payload
 		 * data next.
 		 */
 		ctx->header_received = true;
 
+		if (message_type) {
+			*message_type = ctx->message_type;
+		}
+
 		if (HEXDUMP_RECV_PACKETS) {
 			LOG_HEXDUMP_DBG(&ctx->tmp_buf[0], header_len,
 					"Header");
@@ -763,10 +937,10 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 		ctx->total_read = 0;
 
 		memmove(ctx->tmp_buf, &ctx->tmp_buf[header_len],
-			ctx->tmp_buf_len - header_len);
+			ctx->tmp_buf_pos - header_len);
 		ctx->tmp_buf_pos -= header_len;
 
-		if (ctx->tmp_buf_pos == 0) {
+		if (ctx->tmp_buf_pos == 0 && ctx->message_len > 0) {
 			/* No data after the header, let the caller call
 			 * this function again to get the payload.
 			 */
@@ -778,17 +952,25 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 
 	/* Now read the whole payload or parts of it */
 
-	if (ctx->tmp_buf_pos == 0) {
-		/* Read more data into temp buffer */
+	if (ctx->message_len == ctx->total_read) {
+		/* Frame without payload */
+		recv_len = 0;
+	} else if (ctx->tmp_buf_pos == 0) {
+		/* Nothing buffered, read the payload directly into the
+		 * caller's buffer. The read stops at the end of the frame
+		 * so that the next header is left in the socket.
+		 */
+		can_copy = MIN(ctx->message_len - ctx->total_read, buf_len);
+
 #if defined(CONFIG_NET_TEST)
-		size_t input_len = MIN(ctx->tmp_buf_len, test_data->input_len);
+		size_t input_len = MIN(can_copy, test_data->input_len);
 
-		memcpy(ctx->tmp_buf, test_data->input_buf, input_len);
+		memcpy(buf, test_data->input_buf, input_len);
 		test_data->input_buf += input_len;
 
 		ret = input_len;
 #else
-		ret = recv(ctx->real_sock, ctx->tmp_buf, ctx->tmp_buf_len,
+		ret = recv(ctx->real_sock, buf, can_copy,
 			   K_TIMEOUT_EQ(tout, K_NO_WAIT) ? MSG_DONTWAIT : 0);
 #endif /* CONFIG_NET_TEST */
 
@@ -800,55 +982,38 @@ int websocket_recv_msg(int ws_sock, uint8_t *buf, size_t buf_len,
 			return 0;
 		}
 
-		ctx->tmp_buf_pos = ret;
-	}
-
-	if (ctx->tmp_buf_pos <= buf_len) {
-		/* Is there already any data in the temp buffer? If yes,
-		 * just return it to the caller.
-		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read,
-			       ctx->tmp_buf_pos);
+		recv_len = ret;
 	} else {
-		/* We have more data in tmp buffer that will fit into
-		 * user buffer.
-		 */
-		can_copy = MIN(ctx->message_len - ctx->total_read, buf_len);
-	}
-
-	left = ctx->tmp_buf_pos - can_copy;
+		can_copy = MIN(ctx->message_len - ctx->total_read,
+			       MIN(ctx->tmp_buf_pos, buf_len));
+		left = ctx->tmp_buf_pos - can_copy;
 
-	NET_ASSERT(ctx->tmp_buf_pos >= can_copy);
+		memcpy(buf, ctx->tmp_buf, can_copy);
+		recv_len = can_copy;
 
-	memmove(buf, ctx->tmp_buf, can_copy);
-	recv_len = can_copy;
+		if (left > 0) {
+			memmove(ctx->tmp_buf, &ctx->tmp_buf[can_copy], left);
+		}
 
-	if (left > 0) {
-		memmove(ctx->tmp_buf, &ctx->tmp_buf[can_copy], left);
+		ctx->tmp_buf_pos = left;
 	}
 
-	ctx->tmp_buf_pos = left;
-	ctx->total_read += recv_len;
-
 	/* Unmask the data */
 	if (ctx->masked) {
-		/* As we might have less than 4 received bytes, we must select
-		 * which byte from masking value to take. The mask_shift will
-		 * tell that.
-		 */
-		int mask_shift = (ctx->total_read - recv_len) % sizeof(uint32_t);
-		int i;
-
-		for (i = 0; i < recv_len; i++) {
-			buf[i] ^= ctx->masking_value >>
-				(8 * (3 - (i + mask_shift) % 4));
-		}
+		websocket_mask(buf, buf, recv_len, ctx->masking_value,
+			       ctx->total_read);
 	}
 
+	ctx->total_read += recv_len;
+
 #if HEXDUMP_RECV_PACKETS
 	LOG_HEXDUMP_DBG(buf, recv_len, "Payload");
 #endif
 
+	if (message_type) {
+		*message_type = ctx->message_type;
+	}
+
 	if (remaining) {
 		*remaining = ctx->message_len - ctx->total_read;
 	}
@@ -89,6 +89,9 @@ __net_socket struct websocket_context {
 	/** Message type */
 	uint32_t message_type;
 
+	/** Data type of the fragmented message being received */
+	uint32_t fragment_type;
+
 	/** Is the message masked */
 	uint8_t masked : 1;
 
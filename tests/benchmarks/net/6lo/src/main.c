@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the 6LoWPAN IPHC compression and uncompression of IPv6/UDP
+ * headers. The "ll" flow uses link-local addresses derived from the link
+ * layer addresses, the "ctx" flow uses global addresses compressed with a
+ * context.
+ *
+ * The uncompression is measured with room in front of the compressed
+ * headers, where they are uncompressed in place, and without room, where
+ * the payload is moved to make room.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <net/net_pkt.h>
+#include <net/net_if.h>
+#include <net/dummy.h>
+
+#include "6lo.h"
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d frag=%-4d:%8u ops/s ,%6u ns/op\n"
+
+#define ROUNDS 200000
+#define MAX_PAYLOAD 64
+
+static const int payload_sizes[] = { 16, MAX_PAYLOAD };
+
+static uint8_t src_mac[] = { 0x00, 0x12, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static uint8_t dst_mac[] = { 0x00, 0x12, 0x4b, 0x00, 0x00, 0x00, 0x00, 0x02 };
+
+/* 2001:db8::/64, compression enabled, CID 1 */
+static struct net_icmpv6_nd_opt_6co ctx = {
+	.context_len = 0x40,
+	.flag = 0x11,
+	.lifetime = 0xffff,
+	.prefix = { { { 0x20, 0x01, 0x0d, 0xb8 } } },
+};
+
+struct flow {
+	const char *name;
+	struct in6_addr src;
+	struct in6_addr dst;
+};
+
+static struct flow flows[2];
+
+static uint8_t hdr[NET_IPV6UDPH_LEN + MAX_PAYLOAD];
+static uint8_t compressed[sizeof(hdr)];
+static size_t compressed_len;
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, src_mac, sizeof(src_mac),
+			     NET_LINK_IEEE802154);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_6lo_perf, "net_6lo_perf",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static void report(const char *op, const char *flow, int size,
+		   uint64_t elapsed, uint64_t cpu)
+{
+	char metric[24];
+
+	snprintk(metric, sizeof(metric), "6lo_%s_%s", op, flow);
+
+	printk(FORMAT, metric, size, 0,
+	       (uint32_t)((uint64_t)ROUNDS * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / ROUNDS));
+}
+
+static void build_hdr(struct flow *flow, int size)
+{
+	struct net_ipv6_hdr *ipv6 = (struct net_ipv6_hdr *)hdr;
+	struct net_udp_hdr *udp = (struct net_udp_hdr *)(hdr + NET_IPV6H_LEN);
+	int i;
+
+	memset(hdr, 0, NET_IPV6UDPH_LEN);
+
+	ipv6->vtc = 0x60;
+	ipv6->len = htons(NET_UDPH_LEN + size);
+	ipv6->nexthdr = IPPROTO_UDP;
+	ipv6->hop_limit = 64;
+	net_ipaddr_copy(&ipv6->src, &flow->src);
+	net_ipaddr_copy(&ipv6->dst, &flow->dst);
+
+	/* The ports compress to 4 bits each */
+	udp->src_port = htons(0xf0b1);
+	udp->dst_port = htons(0xf0b2);
+	udp->len = ipv6->len;
+	udp->chksum = htons(0x1234);
+
+	for (i = 0; i < size; i++) {
+		hdr[NET_IPV6UDPH_LEN + i] = i;
+	}
+}
+
+/* Puts the data at the given offset of the packet buffer */
+static void pkt_reset(struct net_pkt *pkt, size_t offset,
+		      const uint8_t *data, size_t len)
+{
+	net_buf_reset(pkt->buffer);
+	net_buf_reserve(pkt->buffer, offset);
+	net_buf_add_mem(pkt->buffer, data, len);
+	net_pkt_cursor_init(pkt);
+}
+
+static int run_compress(struct net_pkt *pkt, struct flow *flow, int size)
+{
+	uint64_t start, elapsed, cpu;
+	int i;
+
+	build_hdr(flow, size);
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < ROUNDS; i++) {
+		pkt_reset(pkt, 0, hdr, NET_IPV6UDPH_LEN + size);
+
+		if (net_6lo_compress(pkt, true) < 0) {
+			TC_PRINT("Compression failed\n");
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	report("compress", flow->name, size, elapsed, cpu);
+
+	compressed_len = pkt->buffer->len;
+	memcpy(compressed, pkt->buffer->data, compressed_len);
+
+	return 0;
+}
+
+static int run_uncompress(struct net_pkt *pkt, struct flow *flow, int size,
+			  bool headroom)
+{
+	uint64_t start, elapsed, cpu;
+	int i;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < ROUNDS; i++) {
+		pkt_reset(pkt, headroom ? NET_IPV6UDPH_LEN : 0, compressed,
+			  compressed_len);
+
+		if (!net_6lo_uncompress(pkt) || pkt->buffer->frags) {
+			TC_PRINT("Uncompression failed\n");
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	if (pkt->buffer->len != NET_IPV6UDPH_LEN + size ||
+	    memcmp(pkt->buffer->data, hdr, pkt->buffer->len)) {
+		TC_PRINT("Uncompressed packet differs\n");
+		return -1;
+	}
+
+	report(headroom ? "uncompress" : "uncompress_move", flow->name, size,
+	       elapsed, cpu);
+
+	return 0;
+}
+
+void main(void)
+{
+	struct net_if *iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	struct net_linkaddr src_ll = {
+		.addr = src_mac,
+		.len = sizeof(src_mac),
+		.type = NET_LINK_IEEE802154,
+	};
+	struct net_linkaddr dst_ll = {
+		.addr = dst_mac,
+		.len = sizeof(dst_mac),
+		.type = NET_LINK_IEEE802154,
+	};
+	struct net_pkt *pkt;
+	int i, j;
+
+	flows[0].name = "ll";
+	net_ipv6_addr_create_iid(&flows[0].src, &src_ll);
+	net_ipv6_addr_create_iid(&flows[0].dst, &dst_ll);
+
+	/* 2001:db8::ff:fe00:1 and 2001:db8::ff:fe00:2 */
+	flows[1].name = "ctx";
+	net_ipv6_addr_create(&flows[1].src, 0x2001, 0xdb8, 0, 0, 0, 0xff,
+			     0xfe00, 1);
+	net_ipv6_addr_create(&flows[1].dst, 0x2001, 0xdb8, 0, 0, 0, 0xff,
+			     0xfe00, 2);
+
+	net_6lo_set_context(iface, &ctx);
+
+	pkt = net_pkt_alloc_with_buffer(iface, sizeof(hdr) + NET_IPV6UDPH_LEN,
+					AF_UNSPEC, 0, K_NO_WAIT);
+	if (!pkt || pkt->buffer->frags) {
+		TC_PRINT("Cannot allocate the packet\n");
+		goto fail;
+	}
+
+	*net_pkt_lladdr_src(pkt) = src_ll;
+	*net_pkt_lladdr_dst(pkt) = dst_ll;
+
+	for (i = 0; i < ARRAY_SIZE(flows); i++) {
+		for (j = 0; j < ARRAY_SIZE(payload_sizes); j++) {
+			if (run_compress(pkt, &flows[i], payload_sizes[j]) ||
+			    run_uncompress(pkt, &flows[i], payload_sizes[j],
+					   true) ||
+			    run_uncompress(pkt, &flows[i], payload_sizes[j],
+					   false)) {
+				goto fail;
+			}
+		}
+	}
+
+	net_pkt_unref(pkt);
+
+	TC_END_REPORT(TC_PASS);
+	return;
+
+fail:
+	TC_END_REPORT(TC_FAIL);
+}
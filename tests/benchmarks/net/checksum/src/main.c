@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the cost of the Internet checksum for UDP/IPv6 payloads from 64 to
+ * 1500 bytes, spread over network buffers the way the stack stores them.
+ *
+ * "ref" is the classic 16 bits at a time loop over a flat buffer, kept here
+ * as a baseline. "update" is the RFC 1624 incremental update done after
+ * rewriting the destination address, compared to "full" which sums the
+ * whole packet again.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <timing/timing.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+
+#include "net_private.h"
+
+#define FORMAT "%-20s len=%-4d:%8u cycles , %8u ns\n"
+
+#define PRINT_STATS_AVG(name, len, cycles, counter)			\
+	printk(FORMAT, name, len, (uint32_t)((cycles) / (counter)),	\
+	       (uint32_t)timing_cycles_to_ns_avg(cycles, counter))
+
+#define MAX_PAYLOAD 1500
+#define N_ROUNDS 1000
+
+static const int lengths[] = { 64, 128, 256, 512, 1024, MAX_PAYLOAD };
+
+static uint8_t data[NET_IPV6H_LEN + MAX_PAYLOAD];
+static volatile uint16_t result;
+
+static int error_count;
+
+static uint16_t ref_chksum(const uint8_t *buf, size_t len)
+{
+	uint32_t sum = 0U;
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		sum += (buf[i] << 8) | buf[i + 1];
+	}
+
+	if (len % 2) {
+		sum += buf[len - 1] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return ~sum;
+}
+
+static struct net_pkt *build_pkt(int len)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(NULL, NET_IPV6H_LEN + len, AF_INET6,
+					IPPROTO_UDP, K_NO_WAIT);
+	if (!pkt) {
+		return NULL;
+	}
+
+	net_pkt_set_ip_hdr_len(pkt, NET_IPV6H_LEN);
+
+	if (net_pkt_write(pkt, data, NET_IPV6H_LEN + len)) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	return pkt;
+}
+
+static void bench_ref(int len)
+{
+	timing_t start, end;
+	int i;
+
+	start = timing_counter_get();
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		result = ref_chksum(data + NET_IPV6H_LEN, len);
+	}
+
+	end = timing_counter_get();
+
+	PRINT_STATS_AVG("ref", len, timing_cycles_get(&start, &end),
+			N_ROUNDS);
+}
+
+static void bench_full(int len)
+{
+	struct net_pkt *pkt;
+	timing_t start, end;
+	int i;
+
+	pkt = build_pkt(len);
+	if (!pkt) {
+		error_count++;
+		return;
+	}
+
+	start = timing_counter_get();
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		result = net_calc_chksum_udp(pkt);
+	}
+
+	end = timing_counter_get();
+
+	PRINT_STATS_AVG("full", len, timing_cycles_get(&start, &end),
+			N_ROUNDS);
+
+	net_pkt_unref(pkt);
+}
+
+static void bench_update(int len)
+{
+	struct in6_addr old_addr, new_addr;
+	struct net_pkt *pkt;
+	timing_t start, end;
+	uint16_t chksum;
+	int i;
+
+	pkt = build_pkt(len);
+	if (!pkt) {
+		error_count++;
+		return;
+	}
+
+	chksum = net_calc_chksum_udp(pkt);
+
+	/* Destination address of the IPv6 header */
+	memcpy(&old_addr, data + 24, sizeof(old_addr));
+	memcpy(&new_addr, &old_addr, sizeof(new_addr));
+	new_addr.s6_addr[15] ^= 0x5a;
+
+	start = timing_counter_get();
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		result = net_chksum_update(chksum, old_addr.s6_addr,
+					   new_addr.s6_addr,
+					   sizeof(struct in6_addr));
+	}
+
+	end = timing_counter_get();
+
+	net_pkt_unref(pkt);
+
+	/* Check the result against a full recomputation */
+	memcpy(data + 24, &new_addr, sizeof(new_addr));
+
+	pkt = build_pkt(len);
+	if (!pkt) {
+		error_count++;
+		return;
+	}
+
+	if (result != net_calc_chksum_udp(pkt)) {
+		TC_PRINT("Incremental update mismatch, len %d\n", len);
+		error_count++;
+	}
+
+	net_pkt_unref(pkt);
+
+	memcpy(data + 24, &old_addr, sizeof(old_addr));
+
+	PRINT_STATS_AVG("update", len, timing_cycles_get(&start, &end),
+			N_ROUNDS);
+}
+
+void main(void)
+{
+	int i;
+
+	for (i = 0; i < sizeof(data); i++) {
+		data[i] = i * 7U + 3U;
+	}
+
+	timing_init();
+
+	TC_START("Internet checksum");
+
+	timing_start();
+
+	for (i = 0; i < ARRAY_SIZE(lengths); i++) {
+		bench_ref(lengths[i]);
+		bench_full(lengths[i]);
+		bench_update(lengths[i]);
+	}
+
+	timing_stop();
+
+	TC_END_REPORT(error_count);
+}
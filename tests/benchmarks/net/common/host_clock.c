@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The simulated time does not advance while the application is running,
+ * so the rates are measured against the host clocks.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#include "host_clock.h"
+
+static uint64_t host_clock_get_ns(clockid_t clock)
+{
+	struct timespec tp;
+
+	clock_gettime(clock, &tp);
+
+	return (uint64_t)tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+uint64_t host_clock_ns(void)
+{
+	return host_clock_get_ns(CLOCK_MONOTONIC);
+}
+
+uint64_t host_clock_cpu_ns(void)
+{
+	return host_clock_get_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
@@ -0,0 +1,7 @@
+# SPDX-License-Identifier: Apache-2.0
+
+# The host clock is read with the host C library
+target_sources(app PRIVATE ${CMAKE_CURRENT_LIST_DIR}/host_clock.c)
+target_include_directories(app PRIVATE ${CMAKE_CURRENT_LIST_DIR})
+set_source_files_properties(${CMAKE_CURRENT_LIST_DIR}/host_clock.c PROPERTIES
+  COMPILE_DEFINITIONS "NO_POSIX_CHEATS;_DEFAULT_SOURCE")
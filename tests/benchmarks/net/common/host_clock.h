@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef HOST_CLOCK_H_
+#define HOST_CLOCK_H_
+
+#include <stdint.h>
+
+/* Host monotonic time */
+uint64_t host_clock_ns(void);
+
+/* CPU time used by the process, in the kernel and in user space */
+uint64_t host_clock_cpu_ns(void);
+
+#endif /* HOST_CLOCK_H_ */
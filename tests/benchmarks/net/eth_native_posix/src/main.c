@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the frame rate of the native_posix Ethernet driver. The two TAP
+ * interfaces it creates are bridged on the host by net_setup_bridge, raw
+ * frames sent on the first one with a packet socket are received on the
+ * second one with another packet socket. At most WINDOW frames are in
+ * flight, so that the rate is the one sustained without losses.
+ *
+ * The rate is bound by how often the driver polls the TAP device when it
+ * is idle. The host CPU time spent per frame, including the system calls,
+ * is the cost of the driver and of the stack.
+ *
+ * Needs root privileges to create the TAP interfaces and the bridge.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <net/net_if.h>
+#include <net/ethernet.h>
+#include <net/socket.h>
+
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d batch=%-3d:%8u pps ,%6u ns/frame ,%6u lost\n"
+
+/* IEEE 802 local experimental ethertype */
+#define ETH_P_TEST 0x88b5
+
+#define FRAMES 10000
+#define WINDOW 64
+#define WAIT_TIME K_MSEC(500)
+/* Lets the host bridge bring its ports to forwarding state */
+#define SETTLE_TIME K_MSEC(1000)
+
+#define RECV_STACK_SIZE 2048
+#define RECV_PRIORITY K_PRIO_PREEMPT(8)
+
+static const int frame_sizes[] = { 60, 512, 1514 };
+
+static uint8_t tx_frame[NET_ETH_MTU + sizeof(struct net_eth_hdr)];
+static uint8_t rx_frame[NET_ETH_MTU + sizeof(struct net_eth_hdr)];
+
+static int tx_sock = -1;
+static int rx_sock = -1;
+static struct net_if *tx_iface;
+static struct net_if *rx_iface;
+
+static K_SEM_DEFINE(credits, 0, WINDOW);
+static atomic_t received;
+
+K_THREAD_STACK_DEFINE(recv_stack, RECV_STACK_SIZE);
+static struct k_thread recv_thread;
+
+static void recv_fn(void *p1, void *p2, void *p3)
+{
+	struct net_eth_hdr *hdr = (struct net_eth_hdr *)rx_frame;
+	ssize_t len;
+
+	while (true) {
+		len = recv(rx_sock, rx_frame, sizeof(rx_frame), 0);
+		if (len < 0) {
+			return;
+		}
+
+		if (len < sizeof(*hdr) || hdr->type != htons(ETH_P_TEST)) {
+			continue;
+		}
+
+		atomic_inc(&received);
+		k_sem_give(&credits);
+	}
+}
+
+static int packet_socket(struct net_if *iface)
+{
+	struct sockaddr_ll addr = { 0 };
+	int sock;
+
+	sock = socket(AF_PACKET, SOCK_RAW, ETH_P_ALL);
+	if (sock < 0) {
+		return -errno;
+	}
+
+	addr.sll_family = AF_PACKET;
+	addr.sll_ifindex = net_if_get_by_iface(iface);
+
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		(void)close(sock);
+		return -errno;
+	}
+
+	return sock;
+}
+
+static void run(int size)
+{
+	struct sockaddr_ll dst = { 0 };
+	uint64_t start, elapsed, cpu;
+	uint32_t sent, rcvd;
+
+	dst.sll_family = AF_PACKET;
+	dst.sll_ifindex = net_if_get_by_iface(tx_iface);
+
+	k_sem_reset(&credits);
+	for (sent = 0; sent < WINDOW; sent++) {
+		k_sem_give(&credits);
+	}
+
+	atomic_clear(&received);
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (sent = 0; sent < FRAMES; sent++) {
+		/* A lost frame never gives its credit back */
+		(void)k_sem_take(&credits, WAIT_TIME);
+
+		if (sendto(tx_sock, tx_frame, size, 0,
+			   (struct sockaddr *)&dst, sizeof(dst)) < 0) {
+			TC_PRINT("Send failed (%d)\n", errno);
+			break;
+		}
+	}
+
+	while (atomic_get(&received) < sent &&
+	       k_sem_take(&credits, WAIT_TIME) == 0) {
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+	rcvd = MAX(atomic_get(&received), 1);
+
+	printk(FORMAT, "eth_native_posix", size,
+	       CONFIG_ETH_NATIVE_POSIX_RX_BATCH,
+	       (uint32_t)((uint64_t)rcvd * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / rcvd), sent - atomic_get(&received));
+}
+
+void main(void)
+{
+	struct net_eth_hdr *hdr = (struct net_eth_hdr *)tx_frame;
+	int i;
+
+	tx_iface = net_if_get_by_index(1);
+	rx_iface = net_if_get_by_index(2);
+	if (!tx_iface || !rx_iface) {
+		TC_PRINT("Needs two Ethernet interfaces\n");
+		goto fail;
+	}
+
+	tx_sock = packet_socket(tx_iface);
+	rx_sock = packet_socket(rx_iface);
+	if (tx_sock < 0 || rx_sock < 0) {
+		TC_PRINT("Cannot create the packet sockets\n");
+		goto fail;
+	}
+
+	memcpy(hdr->dst.addr, net_if_get_link_addr(rx_iface)->addr,
+	       sizeof(hdr->dst.addr));
+	memcpy(hdr->src.addr, net_if_get_link_addr(tx_iface)->addr,
+	       sizeof(hdr->src.addr));
+	hdr->type = htons(ETH_P_TEST);
+
+	for (i = sizeof(*hdr); i < sizeof(tx_frame); i++) {
+		tx_frame[i] = i;
+	}
+
+	k_thread_create(&recv_thread, recv_stack,
+			K_THREAD_STACK_SIZEOF(recv_stack), recv_fn,
+			NULL, NULL, NULL, RECV_PRIORITY, 0, K_NO_WAIT);
+
+	k_sleep(SETTLE_TIME);
+
+	for (i = 0; i < ARRAY_SIZE(frame_sizes); i++) {
+		run(frame_sizes[i]);
+	}
+
+	TC_END_REPORT(TC_PASS);
+	return;
+
+fail:
+	TC_END_REPORT(TC_FAIL);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the rate at which network management events are delivered, when
+ * notified from a thread and from an ISR. The event has one listener, and
+ * the other subscribers listen to events of other layer codes, like the
+ * L2, IP and connection manager listeners of a busy system.
+ *
+ * The events are notified in batches of the queue size, then the sender
+ * waits for the listener to get them all.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <irq_offload.h>
+#include <net/net_mgmt.h>
+
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d frag=%-4d:%8u ops/s ,%6u ns/op\n"
+
+#define ROUNDS 100000
+#define BATCH CONFIG_NET_MGMT_EVENT_QUEUE_SIZE
+#define MAX_SUBSCRIBERS 64
+
+#define TEST_EVENT (NET_MGMT_EVENT_BIT | NET_MGMT_LAYER(NET_MGMT_LAYER_L2) | \
+		    NET_MGMT_LAYER_CODE(0x7AB) | 0x0001)
+
+/* Same command, other layer codes */
+#define OTHER_EVENT(i) (NET_MGMT_EVENT_BIT |				\
+			NET_MGMT_LAYER((NET_MGMT_LAYER_L2 + (i) % 3)) |	\
+			NET_MGMT_LAYER_CODE((0x300 + (i))) | 0x0001)
+
+static const int subscriber_counts[] = { 1, 16, MAX_SUBSCRIBERS };
+
+static struct net_mgmt_event_callback listener;
+static struct net_mgmt_event_callback others[MAX_SUBSCRIBERS - 1];
+
+static K_SEM_DEFINE(all_received, 0, 1);
+static uint32_t received;
+static uint32_t expected;
+
+static void listener_handler(struct net_mgmt_event_callback *cb,
+			     uint32_t mgmt_event, struct net_if *iface)
+{
+	if (++received == expected) {
+		k_sem_give(&all_received);
+	}
+}
+
+static void other_handler(struct net_mgmt_event_callback *cb,
+			  uint32_t mgmt_event, struct net_if *iface)
+{
+	TC_PRINT("Unexpected event 0x%08x\n", mgmt_event);
+}
+
+static void isr_notify(const void *param)
+{
+	ARG_UNUSED(param);
+
+	net_mgmt_event_notify(TEST_EVENT, NULL);
+}
+
+static int run(const char *source, bool from_isr, int subscribers)
+{
+	uint64_t start, elapsed, cpu;
+	char metric[24];
+	int i;
+
+	received = 0U;
+	expected = 0U;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	while (expected < ROUNDS) {
+		expected += BATCH;
+
+		for (i = 0; i < BATCH; i++) {
+			if (from_isr) {
+				irq_offload(isr_notify, NULL);
+			} else {
+				net_mgmt_event_notify(TEST_EVENT, NULL);
+			}
+		}
+
+		if (k_sem_take(&all_received, K_SECONDS(1))) {
+			TC_PRINT("Received %u events out of %u\n", received,
+				 expected);
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	snprintk(metric, sizeof(metric), "mgmt_event_%s", source);
+
+	printk(FORMAT, metric, subscribers, BATCH,
+	       (uint32_t)((uint64_t)expected * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / expected));
+
+	return 0;
+}
+
+void main(void)
+{
+	int subscribers = 1;
+	int i;
+
+	net_mgmt_init_event_callback(&listener, listener_handler, TEST_EVENT);
+	net_mgmt_add_event_callback(&listener);
+
+	for (i = 0; i < ARRAY_SIZE(subscriber_counts); i++) {
+		for (; subscribers < subscriber_counts[i]; subscribers++) {
+			net_mgmt_init_event_callback(&others[subscribers - 1],
+						     other_handler,
+						     OTHER_EVENT(subscribers));
+			net_mgmt_add_event_callback(&others[subscribers - 1]);
+		}
+
+		if (run("thread", false, subscribers) ||
+		    run("isr", true, subscribers)) {
+			TC_END_REPORT(TC_FAIL);
+			return;
+		}
+	}
+
+	TC_END_REPORT(TC_PASS);
+}
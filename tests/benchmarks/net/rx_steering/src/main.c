@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the RX path throughput with UDP/IPv6 traffic spread over 1 to 16
+ * flows, from the driver handing the packets to net_recv_data() until the
+ * application callback got all of them. Run it on an SMP target with
+ * CONFIG_NET_RX_STEERING_QUEUES set to the number of CPUs and to 1 to see
+ * how the RX processing scales with the number of flows.
+ *
+ * "hash" is the cost of computing the flow hash in software, which a driver
+ * can avoid by passing the hardware one with net_pkt_set_rx_hash().
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <timing/timing.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/net_context.h>
+#include <net/dummy.h>
+
+#include "ipv6.h"
+#include "udp_internal.h"
+#include "net_private.h"
+
+#define FORMAT "%-20s queues=%d flows=%-2d:%8u cycles , %8u ns\n"
+
+#define PRINT_STATS_AVG(name, flows, cycles, counter)			\
+	printk(FORMAT, name, CONFIG_NET_RX_STEERING_QUEUES, flows,	\
+	       (uint32_t)((cycles) / (counter)),			\
+	       (uint32_t)timing_cycles_to_ns_avg(cycles, counter))
+
+#define TEST_PORT 4242
+#define PEER_PORT 5000
+
+/* Packets are queued in batches which fit in the RX packet pool */
+#define BATCH 32
+#define N_BATCHES 64
+#define PAYLOAD_LEN 256
+
+static const int flow_counts[] = { 1, 2, 4, 8, 16 };
+
+static struct in6_addr my_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static uint8_t payload[PAYLOAD_LEN];
+
+static struct net_if *iface;
+static struct net_context *udp_ctx;
+static K_SEM_DEFINE(batch_done, 0, 1);
+static atomic_t received;
+static volatile uint16_t result;
+
+static int error_count;
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static uint8_t mac[] = { 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_DUMMY);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_rx_steering_perf, "net_rx_steering_perf",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static struct net_pkt *build_pkt(uint16_t src_port)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, sizeof(payload), AF_INET6,
+					   IPPROTO_UDP, K_SECONDS(1));
+	if (!pkt) {
+		return NULL;
+	}
+
+	if (net_ipv6_create(pkt, &peer_addr, &my_addr) ||
+	    net_udp_create(pkt, htons(src_port), htons(TEST_PORT)) ||
+	    net_pkt_write(pkt, payload, sizeof(payload))) {
+		net_pkt_unref(pkt);
+		return NULL;
+	}
+
+	net_pkt_cursor_init(pkt);
+	net_ipv6_finalize(pkt, IPPROTO_UDP);
+
+	return pkt;
+}
+
+static void recv_cb(struct net_context *context, struct net_pkt *pkt,
+		    union net_ip_header *ip_hdr,
+		    union net_proto_header *proto_hdr,
+		    int status, void *user_data)
+{
+	/* Some per packet work for the application, done in the RX thread */
+	result = net_calc_chksum_udp(pkt);
+
+	net_pkt_unref(pkt);
+
+	if (atomic_inc(&received) == BATCH - 1) {
+		k_sem_give(&batch_done);
+	}
+}
+
+static void bench_hash(void)
+{
+	struct net_pkt *pkt;
+	timing_t start, end;
+	uint32_t hash = 0U;
+	int i;
+
+	pkt = build_pkt(PEER_PORT);
+	if (!pkt) {
+		error_count++;
+		return;
+	}
+
+	start = timing_counter_get();
+
+	for (i = 0; i < BATCH * N_BATCHES; i++) {
+		hash ^= net_rx_flow_hash(pkt);
+	}
+
+	end = timing_counter_get();
+
+	result = hash;
+
+	net_pkt_unref(pkt);
+
+	PRINT_STATS_AVG("hash", 1, timing_cycles_get(&start, &end),
+			BATCH * N_BATCHES);
+}
+
+static void bench_rx(int flows)
+{
+	struct net_pkt *pkts[BATCH];
+	uint64_t cycles = 0U;
+	timing_t start, end;
+	int i, j;
+
+	for (i = 0; i < N_BATCHES; i++) {
+		for (j = 0; j < BATCH; j++) {
+			pkts[j] = build_pkt(PEER_PORT + (j % flows));
+			if (!pkts[j]) {
+				error_count++;
+				return;
+			}
+		}
+
+		atomic_set(&received, 0);
+
+		start = timing_counter_get();
+
+		for (j = 0; j < BATCH; j++) {
+			if (net_recv_data(iface, pkts[j]) < 0) {
+				net_pkt_unref(pkts[j]);
+				error_count++;
+			}
+		}
+
+		if (k_sem_take(&batch_done, K_SECONDS(1))) {
+			TC_PRINT("Timeout, %d packets received\n",
+				 (int)atomic_get(&received));
+			error_count++;
+			return;
+		}
+
+		end = timing_counter_get();
+
+		cycles += timing_cycles_get(&start, &end);
+	}
+
+	PRINT_STATS_AVG("rx", flows, cycles, BATCH * N_BATCHES);
+}
+
+void main(void)
+{
+	struct sockaddr_in6 addr = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(TEST_PORT),
+	};
+	int i;
+
+	for (i = 0; i < sizeof(payload); i++) {
+		payload[i] = i * 7U + 3U;
+	}
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+
+	if (!net_if_ipv6_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0) ||
+	    net_context_get(AF_INET6, SOCK_DGRAM, IPPROTO_UDP, &udp_ctx)) {
+		TC_PRINT("Cannot setup the interface\n");
+		return;
+	}
+
+	net_ipaddr_copy(&addr.sin6_addr, &my_addr);
+
+	if (net_context_bind(udp_ctx, (struct sockaddr *)&addr,
+			     sizeof(addr)) ||
+	    net_context_recv(udp_ctx, recv_cb, K_NO_WAIT, NULL)) {
+		TC_PRINT("Cannot setup the UDP context\n");
+		return;
+	}
+
+	timing_init();
+
+	TC_START("RX flow steering");
+
+	timing_start();
+
+	bench_hash();
+
+	for (i = 0; i < ARRAY_SIZE(flow_counts); i++) {
+		bench_rx(flow_counts[i]);
+	}
+
+	timing_stop();
+
+	TC_END_REPORT(error_count);
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Compare the cost of zsock_poll() and zsock_epoll_wait() when one socket
+ * out of many mostly idle ones is ready. Only the readiness call itself is
+ * measured: the datagram is already queued on the ready socket (MSG_PEEK
+ * waits for it) before the timestamp is taken.
+ *
+ * The ready socket is the last one of the set, which is the worst case for
+ * the linear scan done by poll().
+ */
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <timing/timing.h>
+#include <net/socket.h>
+
+#define FORMAT "%-20s sockets=%-4d:%8u cycles , %8u ns\n"
+
+#define PRINT_STATS_AVG(name, sockets, cycles, counter)			\
+	printk(FORMAT, name, sockets, (uint32_t)((cycles) / (counter)),	\
+	       (uint32_t)timing_cycles_to_ns_avg(cycles, counter))
+
+#define MAX_SOCKETS 256
+#define N_ROUNDS 200
+#define BASE_PORT 10000
+
+static const int socket_counts[] = { 16, 64, MAX_SOCKETS };
+
+static int socks[MAX_SOCKETS];
+static int sender;
+static struct sockaddr_in6 ready_addr;
+
+static struct zsock_pollfd pollfds[MAX_SOCKETS];
+static struct zsock_epoll_event events[4];
+
+static int error_count;
+
+static int open_sockets(void)
+{
+	struct sockaddr_in6 addr = {
+		.sin6_family = AF_INET6,
+	};
+	int i;
+
+	zsock_inet_pton(AF_INET6, CONFIG_NET_CONFIG_MY_IPV6_ADDR,
+			&addr.sin6_addr);
+
+	for (i = 0; i < MAX_SOCKETS; i++) {
+		socks[i] = zsock_socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+		if (socks[i] < 0) {
+			TC_PRINT("socket %d: %d\n", i, errno);
+			return -1;
+		}
+
+		addr.sin6_port = htons(BASE_PORT + i);
+		if (zsock_bind(socks[i], (struct sockaddr *)&addr,
+			       sizeof(addr)) < 0) {
+			TC_PRINT("bind %d: %d\n", i, errno);
+			return -1;
+		}
+	}
+
+	sender = zsock_socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+	if (sender < 0) {
+		return -1;
+	}
+
+	ready_addr = addr;
+
+	return 0;
+}
+
+/* Queue a datagram on the ready socket and wait until it has arrived. */
+static int make_ready(int ready)
+{
+	char buf[1];
+
+	ready_addr.sin6_port = htons(BASE_PORT + ready);
+
+	if (zsock_sendto(sender, "x", 1, 0, (struct sockaddr *)&ready_addr,
+			 sizeof(ready_addr)) != 1) {
+		return -1;
+	}
+
+	if (zsock_recv(socks[ready], buf, sizeof(buf), ZSOCK_MSG_PEEK) != 1) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static int drain(int ready)
+{
+	char buf[1];
+
+	return zsock_recv(socks[ready], buf, sizeof(buf), 0) == 1 ? 0 : -1;
+}
+
+static void bench_poll(int count)
+{
+	timing_t start, end;
+	uint64_t total = 0;
+	int ready = count - 1;
+	int i, ret;
+
+	for (i = 0; i < count; i++) {
+		pollfds[i].fd = socks[i];
+		pollfds[i].events = ZSOCK_POLLIN;
+	}
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		if (make_ready(ready) < 0) {
+			error_count++;
+			return;
+		}
+
+		start = timing_counter_get();
+		ret = zsock_poll(pollfds, count, -1);
+		end = timing_counter_get();
+
+		if (ret != 1 || drain(ready) < 0) {
+			error_count++;
+			return;
+		}
+
+		total += timing_cycles_get(&start, &end);
+	}
+
+	PRINT_STATS_AVG("poll", count, total, N_ROUNDS);
+}
+
+static void bench_epoll(int count, uint32_t flags)
+{
+	struct zsock_epoll_event ev;
+	timing_t start, end;
+	uint64_t total = 0;
+	int ready = count - 1;
+	int epfd;
+	int i, ret;
+
+	epfd = zsock_epoll_create(1);
+	if (epfd < 0) {
+		error_count++;
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		ev.events = ZSOCK_EPOLLIN | flags;
+		ev.data.fd = socks[i];
+
+		if (zsock_epoll_ctl(epfd, ZSOCK_EPOLL_CTL_ADD, socks[i],
+				    &ev) < 0) {
+			error_count++;
+			goto out;
+		}
+	}
+
+	for (i = 0; i < N_ROUNDS; i++) {
+		if (make_ready(ready) < 0) {
+			error_count++;
+			goto out;
+		}
+
+		start = timing_counter_get();
+		ret = zsock_epoll_wait(epfd, events, ARRAY_SIZE(events), -1);
+		end = timing_counter_get();
+
+		if (ret != 1 || drain(ready) < 0) {
+			error_count++;
+			goto out;
+		}
+
+		total += timing_cycles_get(&start, &end);
+	}
+
+	PRINT_STATS_AVG(flags & ZSOCK_EPOLLET ? "epoll_wait (ET)" :
+			"epoll_wait (LT)", count, total, N_ROUNDS);
+
+out:
+	zsock_close(epfd);
+}
+
+void main(void)
+{
+	int i;
+
+	timing_init();
+
+	TC_START("Socket readiness with mostly idle sockets");
+
+	if (open_sockets() < 0) {
+		error_count++;
+		goto out;
+	}
+
+	timing_start();
+
+	for (i = 0; i < ARRAY_SIZE(socket_counts); i++) {
+		bench_poll(socket_counts[i]);
+		bench_epoll(socket_counts[i], 0);
+		bench_epoll(socket_counts[i], ZSOCK_EPOLLET);
+	}
+
+	timing_stop();
+
+out:
+	TC_END_REPORT(error_count);
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the socket API over the loopback interface:
+ *
+ * - udp_pps: datagrams sent to a receiver thread, with at most WINDOW of
+ *   them in flight so that none is dropped.
+ * - tcp_bulk: data sent on a TCP connection to a receiver thread, an
+ *   operation is one send() of the given size, so the goodput is the
+ *   rate times the size.
+ * - tcp_connect: connections opened, accepted and closed.
+ * - tcp_rr: requests echoed by the server thread on a TCP connection,
+ *   the request/response latency is the inverse of the rate. The UDP
+ *   one is measured by the udp_echo benchmark.
+ *
+ * Each result is one line, recorded by the console harness.
+ *
+ * The packets sent between two interfaces of the same instance are
+ * looped back by the IP layer, so a TAP pair would measure the same path.
+ * The native_posix Ethernet driver is measured by the eth_native_posix
+ * benchmark.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <net/socket.h>
+
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d frag=%-4d:%8u ops/s ,%6u ns/op\n"
+
+#define UDP_PORT 4242
+#define TCP_PORT 4243
+
+#define UDP_COUNT 20000
+#define WINDOW 16
+#define BULK_BYTES (4 * 1024 * 1024)
+#define CONNECTIONS 500
+#define ROUND_TRIPS 5000
+#define WAIT_TIME K_SECONDS(5)
+
+#define SERVER_STACK_SIZE 2048
+#define SERVER_PRIORITY K_PRIO_PREEMPT(8)
+
+/* Fits the loopback MTU */
+static const int udp_sizes[] = { 16, 256, 480 };
+static const int bulk_sizes[] = { 256, 1024, 4096 };
+static const int rr_sizes[] = { 16, 256 };
+
+static uint8_t tx_buf[4096];
+static uint8_t rx_buf[4096];
+static uint8_t udp_server_buf[480];
+static uint8_t tcp_server_buf[4096];
+
+K_THREAD_STACK_DEFINE(udp_server_stack, SERVER_STACK_SIZE);
+static struct k_thread udp_server_thread;
+
+K_THREAD_STACK_DEFINE(tcp_server_stack, SERVER_STACK_SIZE);
+static struct k_thread tcp_server_thread;
+
+static struct k_sem credits;
+static K_SEM_DEFINE(udp_done, 0, 1);
+static uint32_t udp_expected;
+
+/* The TCP server echoes the data back, or only reads it */
+static bool tcp_echo;
+static K_SEM_DEFINE(tcp_done, 0, 1);
+
+static void make_addr(struct sockaddr_in *addr, uint16_t port)
+{
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	inet_pton(AF_INET, "192.0.2.1", &addr->sin_addr);
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(sock, buf, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int recv_all(int sock, uint8_t *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = recv(sock, buf, len, 0);
+		if (ret <= 0) {
+			return ret < 0 ? -errno : -ECONNRESET;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void udp_server_fn(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+	uint32_t received = 0U;
+
+	while (true) {
+		if (recv(sock, udp_server_buf, sizeof(udp_server_buf), 0) < 0) {
+			return;
+		}
+
+		k_sem_give(&credits);
+
+		if (++received == udp_expected) {
+			received = 0U;
+			k_sem_give(&udp_done);
+		}
+	}
+}
+
+static void tcp_server_fn(void *p1, void *p2, void *p3)
+{
+	int listener = POINTER_TO_INT(p1);
+	ssize_t len;
+	int sock;
+
+	while (true) {
+		sock = accept(listener, NULL, NULL);
+		if (sock < 0) {
+			return;
+		}
+
+		while (true) {
+			len = recv(sock, tcp_server_buf, sizeof(tcp_server_buf),
+				   0);
+			if (len <= 0) {
+				break;
+			}
+
+			if (tcp_echo && send_all(sock, tcp_server_buf, len) < 0) {
+				break;
+			}
+		}
+
+		(void)close(sock);
+		k_sem_give(&tcp_done);
+	}
+}
+
+#if defined(CONFIG_NET_BUF_FIXED_DATA_SIZE)
+#define FRAG_SIZE CONFIG_NET_BUF_DATA_SIZE
+#else
+#define FRAG_SIZE 0
+#endif
+
+static void report(const char *metric, int size, uint32_t count,
+		   uint64_t elapsed, uint64_t cpu)
+{
+	printk(FORMAT, metric, size, FRAG_SIZE,
+	       (uint32_t)((uint64_t)count * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / count));
+}
+
+static int tcp_connect(struct sockaddr_in *server)
+{
+	int sock;
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0) {
+		return -errno;
+	}
+
+	if (connect(sock, (struct sockaddr *)server, sizeof(*server)) < 0) {
+		(void)close(sock);
+		return -errno;
+	}
+
+	return sock;
+}
+
+/* Closes the connection and waits for the server to close its side */
+static int tcp_close(int sock)
+{
+	(void)close(sock);
+
+	if (k_sem_take(&tcp_done, WAIT_TIME)) {
+		TC_PRINT("Server did not close the connection\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int run_udp_pps(int sock, struct sockaddr_in *server, int size)
+{
+	uint64_t start, elapsed, cpu;
+	int i;
+
+	k_sem_init(&credits, WINDOW, WINDOW);
+	udp_expected = UDP_COUNT;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < UDP_COUNT; i++) {
+		if (k_sem_take(&credits, WAIT_TIME)) {
+			TC_PRINT("Datagram lost\n");
+			return -1;
+		}
+
+		if (sendto(sock, tx_buf, size, 0, (struct sockaddr *)server,
+			   sizeof(*server)) != size) {
+			TC_PRINT("Send failed (%d)\n", errno);
+			return -1;
+		}
+	}
+
+	if (k_sem_take(&udp_done, WAIT_TIME)) {
+		TC_PRINT("Datagram lost\n");
+		return -1;
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	report("udp_pps", size, UDP_COUNT, elapsed, cpu);
+
+	return 0;
+}
+
+static int run_tcp_bulk(struct sockaddr_in *server, int size)
+{
+	uint32_t count = BULK_BYTES / size;
+	uint64_t start, elapsed, cpu;
+	int sock, i;
+
+	tcp_echo = false;
+
+	sock = tcp_connect(server);
+	if (sock < 0) {
+		TC_PRINT("Cannot connect (%d)\n", sock);
+		return -1;
+	}
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < count; i++) {
+		if (send_all(sock, tx_buf, size) < 0) {
+			TC_PRINT("Send failed (%d)\n", errno);
+			(void)close(sock);
+			return -1;
+		}
+	}
+
+	/* Until the receiver got all the data */
+	if (tcp_close(sock) < 0) {
+		return -1;
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	report("tcp_bulk", size, count, elapsed, cpu);
+
+	return 0;
+}
+
+static int run_tcp_connect(struct sockaddr_in *server)
+{
+	uint64_t start, elapsed, cpu;
+	int sock, i;
+
+	tcp_echo = false;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < CONNECTIONS; i++) {
+		sock = tcp_connect(server);
+		if (sock < 0) {
+			TC_PRINT("Cannot connect (%d)\n", sock);
+			return -1;
+		}
+
+		if (tcp_close(sock) < 0) {
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	report("tcp_connect", 0, CONNECTIONS, elapsed, cpu);
+
+	return 0;
+}
+
+static int run_tcp_rr(struct sockaddr_in *server, int size)
+{
+	uint64_t start, elapsed, cpu;
+	int sock, ret, i;
+
+	tcp_echo = true;
+
+	sock = tcp_connect(server);
+	if (sock < 0) {
+		TC_PRINT("Cannot connect (%d)\n", sock);
+		return -1;
+	}
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		ret = send_all(sock, tx_buf, size);
+		if (ret == 0) {
+			ret = recv_all(sock, rx_buf, size);
+		}
+
+		if (ret < 0) {
+			TC_PRINT("Round trip failed (%d)\n", ret);
+			(void)close(sock);
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	if (tcp_close(sock) < 0) {
+		return -1;
+	}
+
+	if (memcmp(rx_buf, tx_buf, size)) {
+		TC_PRINT("Data corrupted\n");
+		return -1;
+	}
+
+	report("tcp_rr", size, ROUND_TRIPS, elapsed, cpu);
+
+	return 0;
+}
+
+void main(void)
+{
+	struct sockaddr_in udp_addr, tcp_addr;
+	int udp_server, udp_client, listener;
+	int i;
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	make_addr(&udp_addr, UDP_PORT);
+	make_addr(&tcp_addr, TCP_PORT);
+
+	udp_server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	udp_client = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (udp_server < 0 || udp_client < 0 || listener < 0) {
+		TC_PRINT("Cannot create the sockets\n");
+		goto fail;
+	}
+
+	if (bind(udp_server, (struct sockaddr *)&udp_addr,
+		 sizeof(udp_addr)) < 0 ||
+	    bind(listener, (struct sockaddr *)&tcp_addr,
+		 sizeof(tcp_addr)) < 0 ||
+	    listen(listener, 1) < 0) {
+		TC_PRINT("Cannot set up the servers (%d)\n", errno);
+		goto fail;
+	}
+
+	k_thread_create(&udp_server_thread, udp_server_stack,
+			K_THREAD_STACK_SIZEOF(udp_server_stack), udp_server_fn,
+			INT_TO_POINTER(udp_server), NULL, NULL,
+			SERVER_PRIORITY, 0, K_NO_WAIT);
+
+	k_thread_create(&tcp_server_thread, tcp_server_stack,
+			K_THREAD_STACK_SIZEOF(tcp_server_stack), tcp_server_fn,
+			INT_TO_POINTER(listener), NULL, NULL,
+			SERVER_PRIORITY, 0, K_NO_WAIT);
+
+	for (i = 0; i < ARRAY_SIZE(udp_sizes); i++) {
+		if (run_udp_pps(udp_client, &udp_addr, udp_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bulk_sizes); i++) {
+		if (run_tcp_bulk(&tcp_addr, bulk_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	if (run_tcp_connect(&tcp_addr) < 0) {
+		goto fail;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(rr_sizes); i++) {
+		if (run_tcp_rr(&tcp_addr, rr_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	TC_END_REPORT(TC_PASS);
+	return;
+
+fail:
+	TC_END_REPORT(TC_FAIL);
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the cost of a UDP echo over the loopback interface. Each round
+ * trip goes twice through the socket layer, UDP, IPv4 and the net_pkt
+ * cursor, and through four thread switches.
+ *
+ * As the thread switches dominate on native_posix, the cost of building
+ * and parsing the same UDP packets with the net_pkt API alone is measured
+ * as well, without leaving the thread.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <net/socket.h>
+#include <net/net_pkt.h>
+#include <net/udp.h>
+
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d frag=%-4d:%8u ops/s ,%6u ns/op\n"
+
+#define SERVER_PORT 4242
+#define CLIENT_PORT 4243
+#define ROUND_TRIPS 5000
+#define PKT_COUNT 100000
+
+#define SERVER_STACK_SIZE 2048
+#define SERVER_PRIORITY K_PRIO_PREEMPT(8)
+
+/* Fits the loopback MTU */
+static const int payload_sizes[] = { 16, 256, 480 };
+
+static uint8_t tx_buf[480];
+static uint8_t rx_buf[480];
+static uint8_t echo_buf[480];
+
+K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static int udp_socket(struct sockaddr_in *addr, uint16_t port)
+{
+	int sock;
+
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	inet_pton(AF_INET, "192.0.2.1", &addr->sin_addr);
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		return -errno;
+	}
+
+	if (bind(sock, (struct sockaddr *)addr, sizeof(*addr)) < 0) {
+		(void)close(sock);
+		return -errno;
+	}
+
+	return sock;
+}
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	int sock = POINTER_TO_INT(p1);
+	struct sockaddr_in peer;
+	socklen_t peer_len;
+	ssize_t len;
+
+	while (true) {
+		peer_len = sizeof(peer);
+		len = recvfrom(sock, echo_buf, sizeof(echo_buf), 0,
+			       (struct sockaddr *)&peer, &peer_len);
+		if (len < 0) {
+			return;
+		}
+
+		(void)sendto(sock, echo_buf, len, 0,
+			     (struct sockaddr *)&peer, peer_len);
+	}
+}
+
+#if defined(CONFIG_NET_BUF_FIXED_DATA_SIZE)
+#define FRAG_SIZE CONFIG_NET_BUF_DATA_SIZE
+#else
+#define FRAG_SIZE 0
+#endif
+
+static void report(const char *metric, int size, uint32_t count,
+		   uint64_t elapsed, uint64_t cpu)
+{
+	printk(FORMAT, metric, size, FRAG_SIZE,
+	       (uint32_t)((uint64_t)count * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / count));
+}
+
+static int pkt_build(struct net_pkt *pkt, int size)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	NET_PKT_DATA_ACCESS_DEFINE(udp_access, struct net_udp_hdr);
+	struct net_ipv4_hdr *ipv4_hdr;
+	struct net_udp_hdr *udp_hdr;
+
+	ipv4_hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	if (!ipv4_hdr) {
+		return -ENOBUFS;
+	}
+
+	memset(ipv4_hdr, 0, sizeof(*ipv4_hdr));
+	ipv4_hdr->vhl = 0x45;
+	ipv4_hdr->ttl = 64;
+	ipv4_hdr->proto = IPPROTO_UDP;
+	ipv4_hdr->len = htons(NET_IPV4UDPH_LEN + size);
+
+	if (net_pkt_set_data(pkt, &ipv4_access)) {
+		return -ENOBUFS;
+	}
+
+	udp_hdr = (struct net_udp_hdr *)net_pkt_get_data(pkt, &udp_access);
+	if (!udp_hdr) {
+		return -ENOBUFS;
+	}
+
+	udp_hdr->src_port = htons(CLIENT_PORT);
+	udp_hdr->dst_port = htons(SERVER_PORT);
+	udp_hdr->len = htons(NET_UDPH_LEN + size);
+	udp_hdr->chksum = 0;
+
+	if (net_pkt_set_data(pkt, &udp_access)) {
+		return -ENOBUFS;
+	}
+
+	return net_pkt_write(pkt, tx_buf, size);
+}
+
+static int pkt_parse(struct net_pkt *pkt, int size)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	NET_PKT_DATA_ACCESS_DEFINE(udp_access, struct net_udp_hdr);
+	struct net_ipv4_hdr *ipv4_hdr;
+	struct net_udp_hdr *udp_hdr;
+
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	ipv4_hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	if (!ipv4_hdr || ipv4_hdr->proto != IPPROTO_UDP ||
+	    net_pkt_acknowledge_data(pkt, &ipv4_access)) {
+		return -EINVAL;
+	}
+
+	udp_hdr = (struct net_udp_hdr *)net_pkt_get_data(pkt, &udp_access);
+	if (!udp_hdr || ntohs(udp_hdr->len) != NET_UDPH_LEN + size ||
+	    net_pkt_acknowledge_data(pkt, &udp_access)) {
+		return -EINVAL;
+	}
+
+	return net_pkt_read(pkt, rx_buf, size);
+}
+
+static int run_pkt(struct net_if *iface, int size)
+{
+	uint64_t start, elapsed, cpu;
+	struct net_pkt *pkt;
+	int i;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < PKT_COUNT; i++) {
+		pkt = net_pkt_alloc_with_buffer(iface, size, AF_INET,
+						IPPROTO_UDP, K_NO_WAIT);
+		if (!pkt) {
+			TC_PRINT("Cannot allocate a packet\n");
+			return -1;
+		}
+
+		if (pkt_build(pkt, size) || pkt_parse(pkt, size)) {
+			TC_PRINT("Cannot build or parse the packet\n");
+			net_pkt_unref(pkt);
+			return -1;
+		}
+
+		net_pkt_unref(pkt);
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	if (memcmp(rx_buf, tx_buf, size)) {
+		TC_PRINT("Data corrupted\n");
+		return -1;
+	}
+
+	report("pkt_build_parse", size, PKT_COUNT, elapsed, cpu);
+
+	return 0;
+}
+
+static int run(int sock, struct sockaddr_in *server, int size)
+{
+	uint64_t start, elapsed, cpu;
+	int i;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		if (sendto(sock, tx_buf, size, 0, (struct sockaddr *)server,
+			   sizeof(*server)) != size) {
+			TC_PRINT("Send failed (%d)\n", errno);
+			return -1;
+		}
+
+		if (recv(sock, rx_buf, sizeof(rx_buf), 0) != size) {
+			TC_PRINT("Receive failed (%d)\n", errno);
+			return -1;
+		}
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	if (memcmp(rx_buf, tx_buf, size)) {
+		TC_PRINT("Data corrupted\n");
+		return -1;
+	}
+
+	report("udp_echo", size, ROUND_TRIPS, elapsed, cpu);
+
+	return 0;
+}
+
+void main(void)
+{
+	struct sockaddr_in server_addr, client_addr;
+	int server, client;
+	int i;
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	server = udp_socket(&server_addr, SERVER_PORT);
+	client = udp_socket(&client_addr, CLIENT_PORT);
+	if (server < 0 || client < 0) {
+		TC_PRINT("Cannot create the sockets\n");
+		goto fail;
+	}
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			INT_TO_POINTER(server), NULL, NULL, SERVER_PRIORITY, 0,
+			K_NO_WAIT);
+
+	for (i = 0; i < ARRAY_SIZE(payload_sizes); i++) {
+		if (run_pkt(net_if_get_default(), payload_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	for (i = 0; i < ARRAY_SIZE(payload_sizes); i++) {
+		if (run(client, &server_addr, payload_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	TC_END_REPORT(TC_PASS);
+	return;
+
+fail:
+	TC_END_REPORT(TC_FAIL);
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measure the websocket client throughput over a TCP connection on the
+ * loopback interface. A minimal server thread accepts the handshake, then
+ * for each message size it first drains the masked messages sent by the
+ * client, and then sends unmasked messages back to it. The server does not
+ * parse the client messages, it only counts their bytes.
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, LOG_LEVEL_NONE);
+
+#include <zephyr.h>
+#include <tc_util.h>
+#include <strings.h>
+#include <net/socket.h>
+#include <net/websocket.h>
+#include <sys/base64.h>
+#include <mbedtls/sha1.h>
+
+#include "host_clock.h"
+
+#define FORMAT "%-20s size=%-4d frag=%-4d:%8u ops/s ,%6u ns/op\n"
+
+#define SERVER_ADDR "192.0.2.1"
+#define SERVER_PORT 8080
+#define MESSAGES 2000
+
+#define SERVER_STACK_SIZE 4096
+#define SERVER_PRIORITY K_PRIO_PREEMPT(8)
+
+#define WS_MAGIC "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY_FIELD "Sec-WebSocket-Key:"
+
+static const int payload_sizes[] = { 16, 256, 1024, 4096 };
+
+static uint8_t tx_buf[4096];
+static uint8_t rx_buf[4096];
+static uint8_t ws_tmp_buf[512];
+static uint8_t server_buf[4096 + 4];
+
+static K_SEM_DEFINE(drained, 0, 1);
+
+K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static size_t frame_header_len(size_t len, bool masked)
+{
+	size_t hdr_len = 2;
+
+	if (len >= 65536) {
+		hdr_len += 8;
+	} else if (len >= 126) {
+		hdr_len += 2;
+	}
+
+	return hdr_len + (masked ? 4 : 0);
+}
+
+static int send_all(int sock, const uint8_t *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(sock, buf, len, 0);
+		if (ret < 0) {
+			return -errno;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int server_handshake(int sock)
+{
+	uint8_t sha1[20];
+	char accept[32];
+	char *key, *end;
+	size_t len = 0, olen;
+	ssize_t ret;
+
+	do {
+		ret = recv(sock, &server_buf[len], sizeof(server_buf) - len - 1,
+			   0);
+		if (ret <= 0) {
+			return -EIO;
+		}
+
+		len += ret;
+		server_buf[len] = '\0';
+	} while (!strstr((char *)server_buf, "\r\n\r\n"));
+
+	for (key = (char *)server_buf; key; key = strstr(key, "\r\n")) {
+		key += key == (char *)server_buf ? 0 : 2;
+
+		if (strncasecmp(key, WS_KEY_FIELD,
+				sizeof(WS_KEY_FIELD) - 1) == 0) {
+			break;
+		}
+	}
+
+	if (!key) {
+		return -EINVAL;
+	}
+
+	key += sizeof(WS_KEY_FIELD) - 1;
+	while (*key == ' ') {
+		key++;
+	}
+
+	end = strstr(key, "\r\n");
+
+	/* The accept key is built in place, after the request */
+	len = end - key;
+	memmove(server_buf, key, len);
+	memcpy(&server_buf[len], WS_MAGIC, sizeof(WS_MAGIC) - 1);
+
+	mbedtls_sha1_ret(server_buf, len + sizeof(WS_MAGIC) - 1, sha1);
+
+	if (base64_encode(accept, sizeof(accept) - 1, &olen, sha1,
+			  sizeof(sha1))) {
+		return -EINVAL;
+	}
+
+	accept[olen] = '\0';
+
+	len = snprintk((char *)server_buf, sizeof(server_buf),
+		       "HTTP/1.1 101 Switching Protocols\r\n"
+		       "Upgrade: websocket\r\n"
+		       "Connection: Upgrade\r\n"
+		       "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+
+	return send_all(sock, server_buf, len);
+}
+
+static int server_drain(int sock, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = recv(sock, server_buf, MIN(len, sizeof(server_buf)), 0);
+		if (ret <= 0) {
+			return -EIO;
+		}
+
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static int server_send(int sock, size_t size)
+{
+	size_t hdr_len = frame_header_len(size, false);
+	int i, ret;
+
+	/* Final binary frame, unmasked */
+	server_buf[0] = 0x82;
+
+	if (size < 126) {
+		server_buf[1] = size;
+	} else {
+		server_buf[1] = 126;
+		sys_put_be16(size, &server_buf[2]);
+	}
+
+	memcpy(&server_buf[hdr_len], tx_buf, size);
+
+	for (i = 0; i < MESSAGES; i++) {
+		ret = send_all(sock, server_buf, hdr_len + size);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	int listener = POINTER_TO_INT(p1);
+	int sock, i;
+
+	sock = accept(listener, NULL, NULL);
+	if (sock < 0) {
+		return;
+	}
+
+	if (server_handshake(sock) < 0) {
+		goto out;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(payload_sizes); i++) {
+		if (server_drain(sock, MESSAGES *
+				 (frame_header_len(payload_sizes[i], true) +
+				  payload_sizes[i])) < 0) {
+			break;
+		}
+
+		k_sem_give(&drained);
+
+		if (server_send(sock, payload_sizes[i]) < 0) {
+			break;
+		}
+	}
+
+out:
+	(void)close(sock);
+}
+
+static void report(const char *metric, int size, uint32_t count,
+		   uint64_t elapsed, uint64_t cpu)
+{
+	printk(FORMAT, metric, size, 0,
+	       (uint32_t)((uint64_t)count * NSEC_PER_SEC / elapsed),
+	       (uint32_t)(cpu / count));
+}
+
+static int run_send(int ws, int size)
+{
+	uint64_t start, elapsed, cpu;
+	int i, ret;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	for (i = 0; i < MESSAGES; i++) {
+		ret = websocket_send_msg(ws, tx_buf, size,
+					 WEBSOCKET_OPCODE_DATA_BINARY, true,
+					 true, SYS_FOREVER_MS);
+		if (ret != size) {
+			TC_PRINT("Send failed (%d)\n", ret);
+			return -1;
+		}
+	}
+
+	if (k_sem_take(&drained, K_SECONDS(10))) {
+		TC_PRINT("Server did not receive the messages\n");
+		return -1;
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	report("websocket_send", size, MESSAGES, elapsed, cpu);
+
+	return 0;
+}
+
+static int run_recv(int ws, int size)
+{
+	uint64_t start, elapsed, cpu;
+	uint32_t message_type;
+	uint64_t remaining;
+	size_t total = 0, pos = 0;
+	int ret;
+
+	start = host_clock_ns();
+	cpu = host_clock_cpu_ns();
+
+	while (total < (size_t)MESSAGES * size) {
+		ret = websocket_recv_msg(ws, &rx_buf[pos], sizeof(rx_buf) - pos,
+					 &message_type, &remaining,
+					 SYS_FOREVER_MS);
+		if (ret == -EAGAIN) {
+			continue;
+		}
+
+		if (ret <= 0) {
+			TC_PRINT("Receive failed (%d)\n", ret);
+			return -1;
+		}
+
+		total += ret;
+
+		/* Messages may be received in parts */
+		pos = remaining ? pos + ret : 0;
+	}
+
+	elapsed = host_clock_ns() - start;
+	cpu = host_clock_cpu_ns() - cpu;
+
+	if (memcmp(rx_buf, tx_buf, size)) {
+		TC_PRINT("Data corrupted\n");
+		return -1;
+	}
+
+	report("websocket_recv", size, MESSAGES, elapsed, cpu);
+
+	return 0;
+}
+
+void main(void)
+{
+	struct sockaddr_in addr;
+	struct websocket_request req;
+	int listener, sock, ws = -1;
+	int i;
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SERVER_PORT);
+	inet_pton(AF_INET, SERVER_ADDR, &addr.sin_addr);
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listener < 0 ||
+	    bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listener, 1) < 0) {
+		TC_PRINT("Cannot create the server socket (%d)\n", errno);
+		goto fail;
+	}
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			INT_TO_POINTER(listener), NULL, NULL, SERVER_PRIORITY,
+			0, K_NO_WAIT);
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (sock < 0 ||
+	    connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		TC_PRINT("Cannot connect (%d)\n", errno);
+		goto fail;
+	}
+
+	memset(&req, 0, sizeof(req));
+
+	req.host = SERVER_ADDR;
+	req.url = "/";
+	req.tmp_buf = ws_tmp_buf;
+	req.tmp_buf_len = sizeof(ws_tmp_buf);
+
+	ws = websocket_connect(sock, &req, 5 * MSEC_PER_SEC, NULL);
+	if (ws < 0) {
+		TC_PRINT("Websocket handshake failed (%d)\n", ws);
+		goto fail;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(payload_sizes); i++) {
+		if (run_send(ws, payload_sizes[i]) < 0 ||
+		    run_recv(ws, payload_sizes[i]) < 0) {
+			goto fail;
+		}
+	}
+
+	(void)websocket_disconnect(ws);
+
+	TC_END_REPORT(TC_PASS);
+	return;
+
+fail:
+	TC_END_REPORT(TC_FAIL);
+}
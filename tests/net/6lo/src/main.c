@@ -1065,7 +1065,18 @@ static struct net_6lo_data test_data_25 = {
 
 #endif
 
-static void test_6lo(struct net_6lo_data *data)
+/* Moves the compressed headers to the start of the buffer, so that there
+ * is no room in front of them to uncompress.
+ */
+static void remove_headroom(struct net_pkt *pkt)
+{
+	struct net_buf *buf = pkt->buffer;
+
+	memmove(buf->__buf, buf->data, buf->len);
+	buf->data = buf->__buf;
+}
+
+static void test_6lo_headroom(struct net_6lo_data *data, bool headroom)
 {
 	struct net_pkt *pkt;
 	int diff;
@@ -1092,6 +1103,10 @@ static void test_6lo(struct net_6lo_data *data)
 	diff = net_6lo_uncompress_hdr_diff(pkt);
 	zassert_true(diff == data->hdr_diff, "unexpected HDR diff");
 
+	if (!headroom) {
+		remove_headroom(pkt);
+	}
+
 	zassert_true(net_6lo_uncompress(pkt),
 		     "uncompression failed");
 #if DEBUG > 0
@@ -1105,6 +1120,11 @@ static void test_6lo(struct net_6lo_data *data)
 	net_pkt_unref(pkt);
 }
 
+static void test_6lo(struct net_6lo_data *data)
+{
+	test_6lo_headroom(data, true);
+}
+
 /* tests names are based on traffic class, flow label, source address mode
  * (sam), destination address mode (dam), based on udp source and destination
  * ports compressible type.
@@ -1168,9 +1188,61 @@ void test_loop(void)
 	net_pkt_print();
 }
 
+/* The headers are uncompressed in front of the compressed ones when there
+ * is room there, otherwise the data is moved or a new buffer is used.
+ */
+void test_loop_no_headroom(void)
+{
+	int count;
+
+	for (count = 0; count < ARRAY_SIZE(tests); count++) {
+		TC_START(tests[count].name);
+
+		test_6lo_headroom(tests[count].data, false);
+	}
+}
+
+/* With CONFIG_NET_6LO_COMPRESS_CACHE, the addresses of the flows seen before
+ * are compressed from the cache. The cache must be flushed when the contexts
+ * change.
+ */
+void test_context_change(void)
+{
+#if defined(CONFIG_NET_6LO_CONTEXT)
+	struct net_if *iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	struct net_icmpv6_nd_opt_6co removed = ctx1;
+	struct net_pkt *pkt;
+
+	/* The second packet of the flow is compressed from the cache */
+	test_6lo(&test_data_15);
+	test_6lo(&test_data_15);
+
+	removed.lifetime = 0U;
+	net_6lo_set_context(iface, &removed);
+
+	pkt = create_pkt(&test_data_15);
+	zassert_not_null(pkt, "failed to create buffer");
+
+	zassert_true((net_6lo_compress(pkt, true) >= 0),
+		     "compression failed");
+	zassert_not_equal(net_6lo_uncompress_hdr_diff(pkt),
+			  test_data_15.hdr_diff, "removed context used");
+
+	net_pkt_unref(pkt);
+
+	net_6lo_set_context(iface, &ctx1);
+
+	test_6lo(&test_data_15);
+#else
+	ztest_test_skip();
+#endif
+}
+
 /*test case main entry*/
 void test_main(void)
 {
-	ztest_test_suite(test_6lo, ztest_unit_test(test_loop));
+	ztest_test_suite(test_6lo, ztest_unit_test(test_loop),
+			 ztest_unit_test(test_loop_no_headroom),
+			 ztest_unit_test(test_context_change));
 	ztest_run_test_suite(test_6lo);
 }
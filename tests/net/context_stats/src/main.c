@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_STATISTICS_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/net_mgmt.h>
+#include <net/net_stats.h>
+
+#define UDP_PORT 4242
+#define TCP_PORT 4250
+#define TOP_COUNT 4
+
+static uint8_t buf[500];
+
+static void make_addr(struct sockaddr_in *addr, uint16_t port)
+{
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	inet_pton(AF_INET, "192.0.2.1", &addr->sin_addr);
+}
+
+static int udp_socket(struct sockaddr_in *addr, uint16_t port)
+{
+	int sock, ret;
+
+	make_addr(addr, port);
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Could not create the socket");
+	ret = bind(sock, (struct sockaddr *)addr, sizeof(*addr));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+
+	return sock;
+}
+
+static void get_top(struct net_stats_context_entry *top, size_t count)
+{
+	int ret;
+
+	ret = net_mgmt(NET_REQUEST_STATS_GET_CONTEXT_TOP, NULL, top,
+		       count * sizeof(*top));
+	zassert_equal(ret, 0, "Cannot get the top contexts (%d)", ret);
+}
+
+static struct net_stats_context_entry *find_entry(
+	struct net_stats_context_entry *top, size_t count, uint16_t port)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (top[i].local.sa_family == AF_INET &&
+		    ntohs(net_sin(&top[i].local)->sin_port) == port) {
+			return &top[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void test_udp(void)
+{
+	struct net_stats_context_entry top[TOP_COUNT];
+	struct sockaddr_in addr_a, addr_b, addr_c;
+	int a, b, c, ret, i;
+
+	a = udp_socket(&addr_a, UDP_PORT);
+	b = udp_socket(&addr_b, UDP_PORT + 1);
+	c = udp_socket(&addr_c, UDP_PORT + 2);
+
+	for (i = 0; i < 3; i++) {
+		ret = sendto(a, buf, 100, 0, (struct sockaddr *)&addr_b,
+			     sizeof(addr_b));
+		zassert_equal(ret, 100, "Send failed (%d)", errno);
+		ret = recv(b, buf, sizeof(buf), 0);
+		zassert_equal(ret, 100, "Receive failed (%d)", errno);
+	}
+
+	ret = sendto(c, buf, 10, 0, (struct sockaddr *)&addr_b,
+		     sizeof(addr_b));
+	zassert_equal(ret, 10, "Send failed (%d)", errno);
+	ret = recv(b, buf, sizeof(buf), 0);
+	zassert_equal(ret, 10, "Receive failed (%d)", errno);
+
+	get_top(top, ARRAY_SIZE(top));
+
+	/* The contexts are sorted by the amount of data */
+	zassert_equal(ntohs(net_sin(&top[0].local)->sin_port), UDP_PORT + 1,
+		      "Receiver not first");
+	zassert_equal(top[0].proto, IPPROTO_UDP, "Wrong protocol");
+	zassert_equal(top[0].stats.bytes.received, 310, "Received %u",
+		      top[0].stats.bytes.received);
+	zassert_equal(top[0].stats.pkts.rx, 4, "Received %u packets",
+		      top[0].stats.pkts.rx);
+	zassert_equal(top[0].stats.bytes.sent, 0, "Sent %u",
+		      top[0].stats.bytes.sent);
+
+	zassert_equal(ntohs(net_sin(&top[1].local)->sin_port), UDP_PORT,
+		      "Sender not second");
+	zassert_equal(top[1].stats.bytes.sent, 300, "Sent %u",
+		      top[1].stats.bytes.sent);
+	zassert_equal(top[1].stats.pkts.tx, 3, "Sent %u packets",
+		      top[1].stats.pkts.tx);
+
+	zassert_equal(ntohs(net_sin(&top[2].local)->sin_port), UDP_PORT + 2,
+		      "Small sender not third");
+	zassert_equal(top[2].stats.bytes.sent, 10, "Sent %u",
+		      top[2].stats.bytes.sent);
+
+	zassert_equal(top[3].local.sa_family, AF_UNSPEC,
+		      "Unexpected context");
+
+	/* Only the biggest one fits */
+	get_top(top, 1);
+	zassert_equal(ntohs(net_sin(&top[0].local)->sin_port), UDP_PORT + 1,
+		      "Receiver not first");
+
+	(void)close(a);
+	(void)close(b);
+	(void)close(c);
+}
+
+static void test_tcp(void)
+{
+	struct net_stats_context_entry top[TOP_COUNT];
+	struct net_stats_context_entry *entry;
+	struct sockaddr_in addr, client_addr;
+	socklen_t addrlen = sizeof(client_addr);
+	int listener, client, server, ret;
+	size_t len = 0;
+
+	make_addr(&addr, TCP_PORT);
+
+	listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listener >= 0, "Could not create the socket");
+	ret = bind(listener, (struct sockaddr *)&addr, sizeof(addr));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+	ret = listen(listener, 1);
+	zassert_equal(ret, 0, "Could not listen (%d)", errno);
+
+	client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(client >= 0, "Could not create the socket");
+	ret = connect(client, (struct sockaddr *)&addr, sizeof(addr));
+	zassert_equal(ret, 0, "Could not connect (%d)", errno);
+
+	server = accept(listener, (struct sockaddr *)&client_addr, &addrlen);
+	zassert_true(server >= 0, "Could not accept (%d)", errno);
+
+	while (len < sizeof(buf)) {
+		ret = send(client, buf, sizeof(buf) - len, 0);
+		zassert_true(ret > 0, "Send failed (%d)", errno);
+		len += ret;
+	}
+
+	len = 0;
+	while (len < sizeof(buf)) {
+		ret = recv(server, buf, sizeof(buf), 0);
+		zassert_true(ret > 0, "Receive failed (%d)", errno);
+		len += ret;
+	}
+
+	get_top(top, ARRAY_SIZE(top));
+
+	entry = find_entry(top, ARRAY_SIZE(top),
+			   ntohs(client_addr.sin_port));
+	zassert_not_null(entry, "Client not found");
+	zassert_equal(entry->proto, IPPROTO_TCP, "Wrong protocol");
+	zassert_equal(entry->stats.bytes.sent, sizeof(buf), "Sent %u",
+		      entry->stats.bytes.sent);
+	zassert_true(entry->stats.pkts.tx > 0, "No segment sent");
+	zassert_equal(entry->stats.resent, 0, "Resent %u",
+		      entry->stats.resent);
+
+	entry = find_entry(top, ARRAY_SIZE(top), TCP_PORT);
+	zassert_not_null(entry, "Server not found");
+	zassert_equal(entry->stats.bytes.received, sizeof(buf),
+		      "Received %u", entry->stats.bytes.received);
+	zassert_equal(ntohs(net_sin(&entry->remote)->sin_port),
+		      ntohs(client_addr.sin_port), "Wrong remote port");
+
+	(void)close(client);
+	(void)close(server);
+	(void)close(listener);
+}
+
+static void test_invalid_request(void)
+{
+	struct net_stats_context_entry top[2];
+	int ret;
+
+	ret = net_mgmt(NET_REQUEST_STATS_GET_CONTEXT_TOP, NULL, top,
+		       sizeof(top) - 1);
+	zassert_equal(ret, -EINVAL, "Accepted a partial entry");
+
+	ret = net_mgmt(NET_REQUEST_STATS_GET_CONTEXT_TOP, NULL, top, 0);
+	zassert_equal(ret, -EINVAL, "Accepted no entry");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(context_stats,
+			 ztest_unit_test(test_udp),
+			 ztest_unit_test(test_tcp),
+			 ztest_unit_test(test_invalid_request));
+
+	ztest_run_test_suite(context_stats);
+}
@@ -218,6 +218,11 @@ static int verify_echo_reply(struct net_pkt *pkt)
 		zassert_true(false, "echo_reply invalid opts len");
 	}
 
+	/* Checksum is updated from the one of the echo request */
+	if (net_calc_chksum_icmpv4(pkt) != 0U) {
+		zassert_true(false, "echo_reply invalid checksum");
+	}
+
 	return 0;
 }
 
@@ -283,6 +288,10 @@ static int verify_echo_reply_with_opts(struct net_pkt *pkt)
 		zassert_true(false, "echo_reply_opts wrong opts len");
 	}
 
+	if (net_calc_chksum_icmpv4(pkt) != 0U) {
+		zassert_true(false, "echo_reply_opts invalid checksum");
+	}
+
 	return 0;
 }
 
@@ -600,6 +600,98 @@ static void test_ipv6_mesh_addresses(void)
 		     "IPv6 removing address failed\n");
 }
 
+static void test_ip_addr_lookup(void)
+{
+	struct in6_addr addr6_1 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x11 } } };
+	struct in6_addr addr6_2 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x12 } } };
+	struct in6_addr addr6_3 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x13 } } };
+	struct in_addr addr4_1 = { { { 192, 0, 2, 11 } } };
+	struct in_addr addr4_2 = { { { 192, 0, 2, 12 } } };
+	struct in_addr addr4_3 = { { { 192, 0, 2, 13 } } };
+	struct net_if *if1 = net_if_get_by_index(1);
+	struct net_if *if2 = net_if_get_by_index(2);
+	struct net_if_addr *ifaddr, *ifaddr1, *ifaddr2;
+	struct net_if *iface;
+
+	ifaddr1 = net_if_ipv6_addr_add(if1, &addr6_1, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr1, "IPv6 addr add failed");
+	ifaddr2 = net_if_ipv6_addr_add(if2, &addr6_2, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr2, "IPv6 addr add failed");
+
+	ifaddr = net_if_ipv6_addr_lookup(&addr6_1, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr1, "IPv6 addr lookup failed");
+	zassert_equal_ptr(iface, if1, "IPv6 addr lookup wrong iface");
+
+	ifaddr = net_if_ipv6_addr_lookup(&addr6_2, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr2, "IPv6 addr lookup failed");
+	zassert_equal_ptr(iface, if2, "IPv6 addr lookup wrong iface");
+
+	zassert_is_null(net_if_ipv6_addr_lookup(&addr6_3, NULL),
+			"IPv6 addr lookup found unknown address");
+
+	/* The same address on both interfaces is found on the first one */
+	ifaddr = net_if_ipv6_addr_add(if2, &addr6_1, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "IPv6 addr add failed");
+
+	ifaddr = net_if_ipv6_addr_lookup(&addr6_1, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr1, "IPv6 addr lookup failed");
+	zassert_equal_ptr(iface, if1, "IPv6 addr lookup wrong iface");
+
+	zassert_true(net_if_ipv6_addr_rm(if1, &addr6_1),
+		     "IPv6 addr rm failed");
+
+	ifaddr = net_if_ipv6_addr_lookup(&addr6_1, &iface);
+	zassert_not_null(ifaddr, "IPv6 addr lookup failed");
+	zassert_equal_ptr(iface, if2, "IPv6 addr lookup wrong iface");
+
+	zassert_true(net_if_ipv6_addr_rm(if2, &addr6_1),
+		     "IPv6 addr rm failed");
+	zassert_is_null(net_if_ipv6_addr_lookup(&addr6_1, NULL),
+			"IPv6 addr lookup found removed address");
+
+	zassert_true(net_if_ipv6_addr_rm(if2, &addr6_2),
+		     "IPv6 addr rm failed");
+	zassert_is_null(net_if_ipv6_addr_lookup(&addr6_2, NULL),
+			"IPv6 addr lookup found removed address");
+
+	ifaddr1 = net_if_ipv4_addr_add(if2, &addr4_1, NET_ADDR_OVERRIDABLE, 0);
+	zassert_not_null(ifaddr1, "IPv4 addr add failed");
+	ifaddr2 = net_if_ipv4_addr_add(if2, &addr4_2, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr2, "IPv4 addr add failed");
+
+	ifaddr = net_if_ipv4_addr_lookup(&addr4_1, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr1, "IPv4 addr lookup failed");
+	zassert_equal_ptr(iface, if2, "IPv4 addr lookup wrong iface");
+
+	ifaddr = net_if_ipv4_addr_lookup(&addr4_2, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr2, "IPv4 addr lookup failed");
+	zassert_equal_ptr(iface, if2, "IPv4 addr lookup wrong iface");
+
+	/* A DHCP address replaces the overridable one */
+	ifaddr = net_if_ipv4_addr_add(if2, &addr4_3, NET_ADDR_DHCP, 0);
+	zassert_equal_ptr(ifaddr, ifaddr1, "IPv4 addr not overridden");
+
+	zassert_is_null(net_if_ipv4_addr_lookup(&addr4_1, NULL),
+			"IPv4 addr lookup found overridden address");
+
+	ifaddr = net_if_ipv4_addr_lookup(&addr4_3, &iface);
+	zassert_equal_ptr(ifaddr, ifaddr1, "IPv4 addr lookup failed");
+	zassert_equal_ptr(iface, if2, "IPv4 addr lookup wrong iface");
+
+	zassert_true(net_if_ipv4_addr_rm(if2, &addr4_3),
+		     "IPv4 addr rm failed");
+	zassert_true(net_if_ipv4_addr_rm(if2, &addr4_2),
+		     "IPv4 addr rm failed");
+
+	zassert_is_null(net_if_ipv4_addr_lookup(&addr4_2, NULL),
+			"IPv4 addr lookup found removed address");
+	zassert_is_null(net_if_ipv4_addr_lookup(&addr4_3, NULL),
+			"IPv4 addr lookup found removed address");
+}
+
 void test_main(void)
 {
 	default_iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
@@ -608,7 +700,8 @@ void test_main(void)
 			 ztest_unit_test(test_ip_addresses),
 			 ztest_unit_test(test_ipv6_addresses),
 			 ztest_unit_test(test_ipv4_addresses),
-			 ztest_unit_test(test_ipv6_mesh_addresses)
+			 ztest_unit_test(test_ipv6_mesh_addresses),
+			 ztest_unit_test(test_ip_addr_lookup)
 		);
 
 	ztest_run_test_suite(test_ip_addr_fn);
@@ -328,33 +328,21 @@ static void test_init(void)
 	struct net_if *iface = TEST_NET_IF;
 	struct net_if *iface2 = NULL;
 	struct net_if_ipv6 *ipv6;
-	int i;
 
 	zassert_not_null(iface, "Interface is NULL");
 
-	/* We cannot use net_if_ipv6_addr_add() to add the address to
-	 * network interface in this case as that would trigger DAD which
-	 * we are not prepared to handle here. So instead add the address
-	 * manually in this special case so that subsequent tests can
-	 * pass.
-	 */
 	zassert_false(net_if_config_ipv6_get(iface, &ipv6) < 0,
 			"IPv6 config is not valid");
 
-	for (i = 0; i < NET_IF_MAX_IPV6_ADDR; i++) {
-		if (iface->config.ip.ipv6->unicast[i].is_used) {
-			continue;
-		}
-
-		ifaddr = &iface->config.ip.ipv6->unicast[i];
+	/* The address must be added with net_if_ipv6_addr_add() so that it
+	 * can be looked up, but the DAD it starts is not what is tested here,
+	 * so mark the address usable right away so that subsequent tests can
+	 * pass.
+	 */
+	ifaddr = net_if_ipv6_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add IPv6 address");
 
-		ifaddr->is_used = true;
-		ifaddr->address.family = AF_INET6;
-		ifaddr->addr_type = NET_ADDR_MANUAL;
-		ifaddr->addr_state = NET_ADDR_PREFERRED;
-		net_ipaddr_copy(&ifaddr->address.in6_addr, &my_addr);
-		break;
-	}
+	ifaddr->addr_state = NET_ADDR_PREFERRED;
 
 	ifaddr2 = net_if_ipv6_addr_lookup(&my_addr, &iface2);
 	zassert_true(ifaddr2 == ifaddr, "Invalid ifaddr (%p vs %p)\n", ifaddr, ifaddr2);
@@ -502,6 +490,31 @@ static void test_nbr_lookup_ok(void)
 			 net_sprint_ipv6_addr(&peer_addr));
 }
 
+static void nbr_lookup_cb(struct net_nbr *nbr, void *user_data)
+{
+	int *count = user_data;
+
+	zassert_equal_ptr(net_ipv6_nbr_lookup(nbr->iface,
+					      &net_ipv6_nbr_data(nbr)->addr),
+			  nbr, "Neighbor %s not found in cache\n",
+			  net_sprint_ipv6_addr(&net_ipv6_nbr_data(nbr)->addr));
+
+	(*count)++;
+}
+
+/**
+ * @brief IPv6 neighbor lookup of every cached neighbor
+ */
+static void test_nbr_lookup_all(void)
+{
+	int count = 0;
+
+	net_ipv6_nbr_foreach(nbr_lookup_cb, &count);
+
+	zassert_equal(count, CONFIG_NET_IPV6_MAX_NEIGHBORS,
+		      "Neighbor cache not full (%d)", count);
+}
+
 /**
  * @brief IPv6 send NS extra options
  */
@@ -1497,6 +1510,7 @@ void test_main(void)
 			 ztest_unit_test(test_add_neighbor),
 			 ztest_unit_test(test_add_max_neighbors),
 			 ztest_unit_test(test_nbr_lookup_ok),
+			 ztest_unit_test(test_nbr_lookup_all),
 			 ztest_unit_test(test_send_ns_extra_options),
 			 ztest_unit_test(test_send_ns_no_options),
 			 ztest_unit_test(test_rs_message),
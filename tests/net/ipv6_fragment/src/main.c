@@ -40,6 +40,10 @@ static struct in6_addr my_addr1 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
 static struct in6_addr my_addr2 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
 					0, 0, 0, 0, 0, 0, 0, 0x2 } } };
 
+/* Another peer sending fragments */
+static struct in6_addr my_addr3 = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					0, 0, 0, 0, 0, 0, 0, 0x3 } } };
+
 /* Extra address is assigned to ll_addr */
 static struct in6_addr ll_addr = { { { 0xfe, 0x80, 0x43, 0xb8, 0, 0, 0, 0,
 				       0, 0, 0, 0xf2, 0xaa, 0x29, 0x02,
@@ -2043,6 +2047,152 @@ static void test_recv_ipv6_fragment(void)
 	zassert_true(ret == NET_OK, "IPv6 frag2 reassembly failed");
 }
 
+#define REASS_ID 0x12345678
+#define REASS_FIRST_LEN 1232U
+#define REASS_LAST_LEN 68U
+
+static enum net_verdict recv_fragment(const struct in6_addr *src, uint32_t id,
+				      uint16_t offset, uint16_t len, bool more)
+{
+	struct net_ipv6_frag_hdr frag_hdr;
+	struct net_ipv6_hdr ipv6_hdr;
+	struct net_pkt_cursor backup;
+	enum net_verdict verdict;
+	struct net_pkt *pkt;
+	uint16_t i;
+	int ret;
+
+	memcpy(&ipv6_hdr, ipv6_reass_frag1, sizeof(ipv6_hdr));
+	net_ipaddr_copy(&ipv6_hdr.src, src);
+	ipv6_hdr.len = htons(sizeof(frag_hdr) + len);
+
+	frag_hdr.nexthdr = IPPROTO_ICMPV6;
+	frag_hdr.reserved = 0U;
+	frag_hdr.offset = htons(offset | more);
+	frag_hdr.id = htonl(id);
+
+	pkt = net_pkt_alloc_with_buffer(iface1, sizeof(ipv6_hdr) +
+					sizeof(frag_hdr) + len, AF_UNSPEC,
+					0, ALLOC_TIMEOUT);
+	zassert_not_null(pkt, "packet");
+
+	net_pkt_set_family(pkt, AF_INET6);
+	net_pkt_set_ip_hdr_len(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_cursor_init(pkt);
+
+	ret = net_pkt_write(pkt, &ipv6_hdr, sizeof(ipv6_hdr));
+	zassert_true(ret == 0, "IPv6 header append failed");
+
+	ret = net_pkt_write_u8(pkt, frag_hdr.nexthdr);
+	zassert_true(ret == 0, "IPv6 fragment header append failed");
+
+	net_pkt_cursor_backup(pkt, &backup);
+
+	ret = net_pkt_write(pkt, (uint8_t *)&frag_hdr + 1,
+			    sizeof(frag_hdr) - 1);
+	zassert_true(ret == 0, "IPv6 fragment header append failed");
+
+	for (i = 0U; i < len; i++) {
+		ret = net_pkt_write_u8(pkt, offset + i);
+		zassert_true(ret == 0, "IPv6 payload append failed");
+	}
+
+	net_pkt_set_ipv6_fragment_start(pkt, sizeof(struct net_ipv6_hdr));
+	net_pkt_set_overwrite(pkt, true);
+
+	net_pkt_cursor_restore(pkt, &backup);
+
+	verdict = net_ipv6_handle_fragment_hdr(pkt, &ipv6_hdr,
+					       NET_IPV6_NEXTHDR_FRAG);
+	if (verdict == NET_DROP) {
+		net_pkt_unref(pkt);
+	}
+
+	return verdict;
+}
+
+static void reass_count_cb(struct net_ipv6_reassembly *reass,
+			   void *user_data)
+{
+	int *count = user_data;
+
+	(*count)++;
+}
+
+static int reass_count(void)
+{
+	int count = 0;
+
+	net_ipv6_frag_foreach(reass_count_cb, &count);
+
+	return count;
+}
+
+static void test_recv_ipv6_fragment_out_of_order(void)
+{
+	enum net_verdict verdict;
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, REASS_FIRST_LEN,
+				REASS_LAST_LEN, false);
+	zassert_equal(verdict, NET_OK, "Last fragment not accepted");
+	zassert_equal(reass_count(), 1, "Reassembly not pending");
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, 0, REASS_FIRST_LEN, true);
+	zassert_equal(verdict, NET_OK, "First fragment not accepted");
+	zassert_equal(reass_count(), 0, "Packet not reassembled");
+}
+
+static void test_recv_ipv6_fragment_overlap(void)
+{
+	enum net_verdict verdict;
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, 0, REASS_FIRST_LEN, true);
+	zassert_equal(verdict, NET_OK, "First fragment not accepted");
+
+	/* Overlapping fragments discard the whole packet (RFC 5722) */
+	verdict = recv_fragment(&my_addr2, REASS_ID, REASS_FIRST_LEN - 8,
+				REASS_LAST_LEN + 8, false);
+	zassert_equal(verdict, NET_DROP, "Overlapping fragment accepted");
+	zassert_equal(reass_count(), 0, "Reassembly not cancelled");
+
+	/* Same for a repeated fragment */
+	verdict = recv_fragment(&my_addr2, REASS_ID, 0, REASS_FIRST_LEN, true);
+	zassert_equal(verdict, NET_OK, "First fragment not accepted");
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, 0, REASS_FIRST_LEN, true);
+	zassert_equal(verdict, NET_DROP, "Duplicate fragment accepted");
+	zassert_equal(reass_count(), 0, "Reassembly not cancelled");
+}
+
+static void test_recv_ipv6_fragment_per_src_limit(void)
+{
+	enum net_verdict verdict;
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, 0, REASS_FIRST_LEN, true);
+	zassert_equal(verdict, NET_OK, "First fragment not accepted");
+
+	/* The only slot of this source is in use */
+	verdict = recv_fragment(&my_addr2, REASS_ID + 1, 0, REASS_FIRST_LEN,
+				true);
+	zassert_equal(verdict, NET_DROP, "Source slot limit not enforced");
+
+	/* But other sources can still use the remaining slot */
+	verdict = recv_fragment(&my_addr3, REASS_ID + 1, 0, REASS_FIRST_LEN,
+				true);
+	zassert_equal(verdict, NET_OK, "Other source fragment not accepted");
+	zassert_equal(reass_count(), 2, "Reassemblies not pending");
+
+	verdict = recv_fragment(&my_addr2, REASS_ID, REASS_FIRST_LEN,
+				REASS_LAST_LEN, false);
+	zassert_equal(verdict, NET_OK, "Last fragment not accepted");
+
+	verdict = recv_fragment(&my_addr3, REASS_ID + 1, REASS_FIRST_LEN,
+				REASS_LAST_LEN, false);
+	zassert_equal(verdict, NET_OK, "Last fragment not accepted");
+
+	zassert_equal(reass_count(), 0, "Packets not reassembled");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(net_ipv6_fragment_test,
@@ -2059,7 +2209,10 @@ void test_main(void)
 			 ztest_unit_test(test_send_ipv6_fragment),
 			 ztest_unit_test(test_send_ipv6_fragment_large_hbho),
 			 ztest_unit_test(test_send_ipv6_fragment_without_hbho),
-			 ztest_unit_test(test_recv_ipv6_fragment)
+			 ztest_unit_test(test_recv_ipv6_fragment),
+			 ztest_unit_test(test_recv_ipv6_fragment_out_of_order),
+			 ztest_unit_test(test_recv_ipv6_fragment_overlap),
+			 ztest_unit_test(test_recv_ipv6_fragment_per_src_limit)
 			 );
 
 	ztest_run_test_suite(net_ipv6_fragment_test);
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_CAPTURE_LOG_LEVEL);
+
+#include <ztest.h>
+#include <fs/fs.h>
+#include <fs/fs_sys.h>
+#include <net/socket.h>
+#include <net/net_pkt.h>
+#include <net/capture.h>
+
+#define MNT_POINT "/ram"
+#define CAPTURE_FILE MNT_POINT "/capture.pcapng"
+
+#define TEST_PORT 4242
+#define PAYLOAD_LEN 200
+#define UDP_PKT_LEN (PAYLOAD_LEN + 28)
+#define UDP_COUNT 16
+#define SNAPLEN 64
+#define FLOOD_COUNT 64
+
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define LINKTYPE_RAW 101
+
+/* Single file kept in RAM, so that the capture can be checked without
+ * any storage.
+ */
+static struct {
+	uint8_t data[16 * 1024];
+	size_t len;
+	bool exists;
+	bool open;
+} ram_file;
+
+static int ram_open(struct fs_file_t *filp, const char *fs_path,
+		    fs_mode_t flags)
+{
+	if (!ram_file.exists && !(flags & FS_O_CREATE)) {
+		return -ENOENT;
+	}
+
+	ram_file.exists = true;
+	ram_file.open = true;
+
+	return 0;
+}
+
+static ssize_t ram_write(struct fs_file_t *filp, const void *src,
+			 size_t nbytes)
+{
+	nbytes = MIN(nbytes, sizeof(ram_file.data) - ram_file.len);
+
+	memcpy(ram_file.data + ram_file.len, src, nbytes);
+	ram_file.len += nbytes;
+
+	return nbytes;
+}
+
+static int ram_sync(struct fs_file_t *filp)
+{
+	return 0;
+}
+
+static int ram_close(struct fs_file_t *filp)
+{
+	ram_file.open = false;
+
+	return 0;
+}
+
+static int ram_mount(struct fs_mount_t *mountp)
+{
+	return 0;
+}
+
+static int ram_unlink(struct fs_mount_t *mountp, const char *name)
+{
+	ram_file.exists = false;
+	ram_file.len = 0;
+
+	return 0;
+}
+
+static struct fs_file_system_t ram_fs = {
+	.open = ram_open,
+	.write = ram_write,
+	.sync = ram_sync,
+	.close = ram_close,
+	.mount = ram_mount,
+	.unlink = ram_unlink,
+};
+
+static struct fs_mount_t ram_mnt = {
+	.type = FS_TYPE_EXTERNAL_BASE,
+	.mnt_point = MNT_POINT,
+};
+
+static uint8_t payload[PAYLOAD_LEN];
+static struct net_if *iface;
+
+static uint32_t get_u32(size_t offset)
+{
+	return UNALIGNED_GET((uint32_t *)&ram_file.data[offset]);
+}
+
+/* Returns the number of packets in the capture file */
+static int check_file(uint32_t snaplen, uint32_t orig_len)
+{
+	size_t offset = 0;
+	int count = 0;
+
+	zassert_false(ram_file.open, "Capture file not closed");
+	zassert_true(ram_file.len > 0, "Capture file empty");
+
+	zassert_equal(get_u32(0), PCAPNG_BLOCK_SHB, "No section header");
+	zassert_equal(get_u32(8), 0x1A2B3C4D, "Wrong byte order magic");
+	offset += get_u32(4);
+
+	zassert_equal(get_u32(offset), PCAPNG_BLOCK_IDB, "No interface");
+	zassert_equal(UNALIGNED_GET((uint16_t *)&ram_file.data[offset + 8]),
+		      LINKTYPE_RAW, "Wrong link type");
+	zassert_equal(get_u32(offset + 12), snaplen, "Wrong snaplen");
+	offset += get_u32(offset + 4);
+
+	while (offset < ram_file.len) {
+		uint32_t len = get_u32(offset + 4);
+		uint32_t cap_len = get_u32(offset + 20);
+
+		zassert_equal(get_u32(offset), PCAPNG_BLOCK_EPB,
+			      "Not a packet block at %zd", offset);
+		zassert_equal(len, 32 + ROUND_UP(cap_len, 4),
+			      "Wrong block length");
+		zassert_equal(get_u32(offset + len - 4), len,
+			      "Wrong trailing block length");
+		zassert_equal(cap_len, MIN(orig_len, snaplen),
+			      "Wrong captured length");
+		zassert_equal(get_u32(offset + 24), orig_len,
+			      "Wrong original length");
+
+		offset += len;
+		count++;
+	}
+
+	zassert_equal(offset, ram_file.len, "Truncated block");
+
+	return count;
+}
+
+static void test_setup(void)
+{
+	int ret;
+
+	ret = fs_register(FS_TYPE_EXTERNAL_BASE, &ram_fs);
+	zassert_equal(ret, 0, "Could not register the file system");
+
+	ret = fs_mount(&ram_mnt);
+	zassert_equal(ret, 0, "Could not mount the file system");
+
+	iface = net_if_get_default();
+	zassert_not_null(iface, "No interface");
+}
+
+static void test_start_stop(void)
+{
+	int ret;
+
+	zassert_equal(net_capture_file_stop(), -EALREADY,
+		      "Stopped a capture not running");
+	zassert_equal(net_capture_file_start(iface, CAPTURE_FILE,
+					     CONFIG_NET_CAPTURE_FILE_SNAPLEN + 1),
+		      -EINVAL, "Accepted a too long snaplen");
+
+	ret = net_capture_file_start(iface, CAPTURE_FILE, SNAPLEN);
+	zassert_equal(ret, 0, "Could not start (%d)", ret);
+
+	zassert_equal(net_capture_file_start(iface, CAPTURE_FILE, SNAPLEN),
+		      -EALREADY, "Started a second capture");
+
+	ret = net_capture_file_stop();
+	zassert_equal(ret, 0, "Could not stop (%d)", ret);
+
+	zassert_equal(check_file(SNAPLEN, 0), 0, "Packets captured");
+}
+
+static int udp_socket(struct sockaddr_in *addr, uint16_t port)
+{
+	int sock, ret;
+
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons(port);
+	inet_pton(AF_INET, "192.0.2.1", &addr->sin_addr);
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Could not create the socket");
+	ret = bind(sock, (struct sockaddr *)addr, sizeof(*addr));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+
+	return sock;
+}
+
+static void test_capture_udp(void)
+{
+	struct net_capture_file_stats stats;
+	struct sockaddr_in addr_a, addr_b;
+	int a, b, ret, i;
+
+	a = udp_socket(&addr_a, TEST_PORT);
+	b = udp_socket(&addr_b, TEST_PORT + 1);
+
+	ret = net_capture_file_start(iface, CAPTURE_FILE, SNAPLEN);
+	zassert_equal(ret, 0, "Could not start (%d)", ret);
+
+	for (i = 0; i < UDP_COUNT; i++) {
+		ret = sendto(a, payload, sizeof(payload), 0,
+			     (struct sockaddr *)&addr_b, sizeof(addr_b));
+		zassert_equal(ret, sizeof(payload), "Send failed (%d)", errno);
+		ret = recv(b, payload, sizeof(payload), 0);
+		zassert_equal(ret, sizeof(payload), "Receive failed (%d)",
+			      errno);
+	}
+
+	ret = net_capture_file_stop();
+	zassert_equal(ret, 0, "Could not stop (%d)", ret);
+
+	(void)close(a);
+	(void)close(b);
+
+	net_capture_file_get_stats(&stats);
+
+	/* Each datagram is seen when sent and when received */
+	zassert_equal(stats.captured, 2 * UDP_COUNT, "Captured %u packets",
+		      stats.captured);
+	zassert_equal(stats.dropped, 0, "Dropped %u packets", stats.dropped);
+	zassert_equal(stats.written, ram_file.len, "Wrong written count");
+
+	zassert_equal(check_file(SNAPLEN, UDP_PKT_LEN), stats.captured,
+		      "Wrong packet count in the file");
+
+	/* The IPv4 header starts the packet */
+	zassert_equal(ram_file.data[28 + 20 + 28] >> 4, 4,
+		      "Not an IPv4 packet");
+}
+
+static void test_capture_full(void)
+{
+	struct net_capture_file_stats stats;
+	struct net_pkt *pkt;
+	int ret, i;
+
+	ret = net_capture_file_start(iface, CAPTURE_FILE, 0);
+	zassert_equal(ret, 0, "Could not start (%d)", ret);
+
+	/* The capture thread cannot run meanwhile, the ring fills up */
+	for (i = 0; i < FLOOD_COUNT; i++) {
+		pkt = net_pkt_alloc_with_buffer(iface, sizeof(payload),
+						AF_UNSPEC, 0, K_NO_WAIT);
+		zassert_not_null(pkt, "Could not allocate a packet");
+
+		ret = net_pkt_write(pkt, payload, sizeof(payload));
+		zassert_equal(ret, 0, "Could not write the packet");
+
+		net_capture_pkt(iface, pkt);
+		net_pkt_unref(pkt);
+	}
+
+	ret = net_capture_file_stop();
+	zassert_equal(ret, 0, "Could not stop (%d)", ret);
+
+	net_capture_file_get_stats(&stats);
+
+	zassert_true(stats.dropped > 0, "Nothing dropped");
+	zassert_equal(stats.captured + stats.dropped, FLOOD_COUNT,
+		      "Packets lost");
+	zassert_equal(check_file(CONFIG_NET_CAPTURE_FILE_SNAPLEN,
+				 sizeof(payload)),
+		      stats.captured, "Wrong packet count in the file");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(capture_file,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_start_stop),
+			 ztest_unit_test(test_capture_udp),
+			 ztest_unit_test(test_capture_full));
+
+	ztest_run_test_suite(capture_file);
+}
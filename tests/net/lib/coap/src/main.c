@@ -944,6 +944,171 @@ done:
 	return result;
 }
 
+#define BLOCK_STREAM_SIZE 200
+
+static uint8_t stream_received[BLOCK_STREAM_SIZE];
+
+static int stream_read(const struct coap_block_context *ctx, uint8_t *buf,
+		       uint16_t len, void *user_data)
+{
+	for (uint16_t i = 0U; i < len; i++) {
+		buf[i] = (uint8_t)(ctx->current + i);
+	}
+
+	return len;
+}
+
+static int stream_write(const struct coap_block_context *ctx,
+			const uint8_t *buf, uint16_t len, bool last,
+			void *user_data)
+{
+	bool *done = user_data;
+
+	if (ctx->current + len > sizeof(stream_received)) {
+		return -EFBIG;
+	}
+
+	memcpy(&stream_received[ctx->current], buf, len);
+	*done = last;
+
+	return 0;
+}
+
+static bool stream_check(void)
+{
+	for (int i = 0; i < sizeof(stream_received); i++) {
+		if (stream_received[i] != (uint8_t)i) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Block1 upload and Block2 download, streamed from and to callbacks. */
+static int test_block_stream(void)
+{
+	uint8_t req_data[COAP_BUF_SIZE], rsp_data[COAP_BUF_SIZE];
+	struct coap_block_context client_ctx, server_ctx;
+	struct coap_option options[4];
+	struct coap_packet req, rsp;
+	int result = TC_FAIL;
+	bool done = false;
+	int blocks = 0;
+	int r;
+
+	/* Upload, the payload is in the requests. */
+	memset(stream_received, 0, sizeof(stream_received));
+	coap_block_transfer_init(&client_ctx, COAP_BLOCK_64,
+				 BLOCK_STREAM_SIZE);
+	coap_block_transfer_init(&server_ctx, COAP_BLOCK_64, 0);
+
+	do {
+		r = coap_packet_init(&req, req_data, sizeof(req_data),
+				     COAP_VERSION_1, COAP_TYPE_CON, 0, NULL,
+				     COAP_METHOD_POST, coap_next_id());
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_append_block_payload(&req, &client_ctx, stream_read,
+					      NULL);
+		if (r < 0) {
+			TC_PRINT("Unable to append block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		r = coap_packet_parse(&req, req_data, req.offset, options,
+				      ARRAY_SIZE(options));
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_deliver_block_payload(&req, &server_ctx, stream_write,
+					       &done);
+		if (r < 0) {
+			TC_PRINT("Unable to deliver block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		blocks++;
+	} while (coap_next_block(&req, &client_ctx));
+
+	if (!done || blocks != 4 || !stream_check() ||
+	    server_ctx.total_size != BLOCK_STREAM_SIZE) {
+		TC_PRINT("Upload failed after %d blocks\n", blocks);
+		goto done;
+	}
+
+	/* Download, the payload is in the responses. */
+	memset(stream_received, 0, sizeof(stream_received));
+	coap_block_transfer_init(&client_ctx, COAP_BLOCK_64, 0);
+	coap_block_transfer_init(&server_ctx, COAP_BLOCK_64,
+				 BLOCK_STREAM_SIZE);
+	done = false;
+	blocks = 0;
+
+	do {
+		r = coap_packet_init(&req, req_data, sizeof(req_data),
+				     COAP_VERSION_1, COAP_TYPE_CON, 0, NULL,
+				     COAP_METHOD_GET, coap_next_id());
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_append_block2_option(&req, &client_ctx);
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_update_from_block(&req, &server_ctx);
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_ack_init(&rsp, &req, rsp_data, sizeof(rsp_data),
+				  COAP_RESPONSE_CODE_CONTENT);
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_append_block_payload(&rsp, &server_ctx, stream_read,
+					      NULL);
+		if (r < 0) {
+			TC_PRINT("Unable to append block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		r = coap_packet_parse(&rsp, rsp_data, rsp.offset, options,
+				      ARRAY_SIZE(options));
+		if (r < 0) {
+			goto done;
+		}
+
+		r = coap_deliver_block_payload(&rsp, &client_ctx, stream_write,
+					       &done);
+		if (r < 0) {
+			TC_PRINT("Unable to deliver block %d (%d)\n", blocks, r);
+			goto done;
+		}
+
+		blocks++;
+	} while (coap_next_block(&rsp, &client_ctx));
+
+	if (!done || blocks != 4 || !stream_check() ||
+	    client_ctx.total_size != BLOCK_STREAM_SIZE) {
+		TC_PRINT("Download failed after %d blocks\n", blocks);
+		goto done;
+	}
+
+	result = TC_PASS;
+
+done:
+	TC_END_RESULT(result);
+
+	return result;
+}
+
 #define BLOCK2_WISE_TRANSFER_SIZE_GET 256
 
 static int prepare_block2_request(struct coap_packet *req,
@@ -1595,6 +1760,7 @@ static const struct {
 	{ "Test match path uri", test_match_path_uri, },
 	{ "Test block sized 1 transfer", test_block1_size, },
 	{ "Test block sized 2 transfer", test_block2_size, },
+	{ "Test block streaming", test_block_stream, },
 	{ "Test retransmission", test_retransmit_second_round, },
 	{ "Test observer server", test_observer_server, },
 	{ "Test observer client", test_observer_client, },
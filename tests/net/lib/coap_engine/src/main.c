@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_COAP_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/coap.h>
+#include <net/coap_engine.h>
+
+#define COAP_BUF_SIZE 128
+#define MAX_SENT 8
+#define ACK_TIMEOUT CONFIG_COAP_INIT_ACK_TIMEOUT_MS
+
+static struct sockaddr_in6 peer_addr = {
+	.sin6_family = AF_INET6,
+	.sin6_port = htons(5683),
+	.sin6_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+			   0, 0, 0, 0, 0, 0, 0, 0x2 } } },
+};
+
+static struct {
+	uint8_t data[COAP_BUF_SIZE];
+	uint16_t len;
+	struct sockaddr addr;
+} sent[MAX_SENT];
+static int sent_count;
+
+static struct coap_pending *timed_out;
+static int timeout_count;
+
+static struct coap_engine engine;
+
+static int engine_send(struct coap_engine *e, const struct iovec *iov,
+		       size_t iovcnt, const struct sockaddr *addr)
+{
+	int i = sent_count % MAX_SENT;
+	uint16_t len = 0U;
+
+	for (size_t n = 0; n < iovcnt; n++) {
+		zassert_true(len + iov[n].iov_len <= COAP_BUF_SIZE,
+			     "Message too long");
+		memcpy(&sent[i].data[len], iov[n].iov_base, iov[n].iov_len);
+		len += iov[n].iov_len;
+	}
+
+	sent[i].len = len;
+	memcpy(&sent[i].addr, addr, sizeof(sent[i].addr));
+	sent_count++;
+
+	return 0;
+}
+
+static void engine_timeout(struct coap_engine *e,
+			   struct coap_pending *pending)
+{
+	timed_out = pending;
+	timeout_count++;
+}
+
+static void reset_counters(void)
+{
+	sent_count = 0;
+	timeout_count = 0;
+	timed_out = NULL;
+}
+
+static uint16_t last_sent_id(void)
+{
+	const uint8_t *data = sent[(sent_count - 1) % MAX_SENT].data;
+
+	return (data[2] << 8) | data[3];
+}
+
+static void build_message(struct coap_packet *cpkt, uint8_t *data,
+			  uint8_t type, uint8_t code, uint16_t id)
+{
+	zassert_equal(coap_packet_init(cpkt, data, COAP_BUF_SIZE,
+				       COAP_VERSION_1, type, 0, NULL, code,
+				       id), 0, "Cannot build message");
+}
+
+static void test_retransmit(void)
+{
+	static uint8_t data[COAP_BUF_SIZE];
+	struct coap_pending pending = { 0 };
+	struct coap_packet req, ack;
+	uint8_t ack_data[COAP_BUF_SIZE];
+	uint16_t id = coap_next_id();
+
+	reset_counters();
+
+	build_message(&req, data, COAP_TYPE_CON, COAP_METHOD_GET, id);
+	zassert_equal(coap_engine_send(&engine, &req,
+				       (struct sockaddr *)&peer_addr,
+				       &pending), 0, "Send failed");
+	zassert_equal(sent_count, 1, "Not sent");
+
+	zassert_equal(coap_engine_send(&engine, &req,
+				       (struct sockaddr *)&peer_addr,
+				       &pending), -EBUSY, "Pending reused");
+
+	k_msleep(ACK_TIMEOUT + 50);
+	zassert_equal(sent_count, 2, "Not retransmitted");
+	zassert_equal(last_sent_id(), id, "Wrong message retransmitted");
+
+	/* Exponential back-off. */
+	k_msleep(ACK_TIMEOUT);
+	zassert_equal(sent_count, 2, "Retransmitted too early");
+	k_msleep(ACK_TIMEOUT);
+	zassert_equal(sent_count, 3, "Not retransmitted");
+
+	build_message(&ack, ack_data, COAP_TYPE_ACK, COAP_RESPONSE_CODE_CONTENT,
+		      id);
+	zassert_equal_ptr(coap_engine_received(&engine, &ack), &pending,
+			  "Pending not found");
+	zassert_is_null(coap_engine_received(&engine, &ack),
+			"Pending found twice");
+
+	k_msleep(8 * ACK_TIMEOUT);
+	zassert_equal(sent_count, 3, "Retransmitted after ack");
+	zassert_equal(timeout_count, 0, "Timeout after ack");
+}
+
+static void test_timeout(void)
+{
+	static uint8_t data[COAP_BUF_SIZE];
+	struct coap_pending pending = { 0 };
+	struct coap_packet req;
+
+	reset_counters();
+
+	build_message(&req, data, COAP_TYPE_CON, COAP_METHOD_POST,
+		      coap_next_id());
+	zassert_equal(coap_engine_send(&engine, &req,
+				       (struct sockaddr *)&peer_addr,
+				       &pending), 0, "Send failed");
+
+	/* Retransmitted at 1, 3, 7 and 15 timeouts, given up at 31. */
+	k_msleep(30 * ACK_TIMEOUT);
+	zassert_equal(sent_count, 1 + COAP_DEFAULT_MAX_RETRANSMIT,
+		      "Wrong number of transmissions");
+	zassert_equal(timeout_count, 0, "Timed out too early");
+
+	k_msleep(2 * ACK_TIMEOUT);
+	zassert_equal(timeout_count, 1, "Not timed out");
+	zassert_equal_ptr(timed_out, &pending, "Wrong pending");
+	zassert_equal_ptr(pending.data, data, "Data pointer cleared");
+	zassert_equal(sent_count, 1 + COAP_DEFAULT_MAX_RETRANSMIT,
+		      "Retransmitted after timeout");
+}
+
+static void test_queue_order(void)
+{
+	static uint8_t data_a[COAP_BUF_SIZE], data_b[COAP_BUF_SIZE];
+	struct coap_pending pending_a = { 0 }, pending_b = { 0 };
+	struct coap_packet req_a, req_b, ack;
+	uint8_t ack_data[COAP_BUF_SIZE];
+	uint16_t id_a = coap_next_id();
+	uint16_t id_b = coap_next_id();
+
+	reset_counters();
+
+	build_message(&req_a, data_a, COAP_TYPE_CON, COAP_METHOD_GET, id_a);
+	build_message(&req_b, data_b, COAP_TYPE_CON, COAP_METHOD_GET, id_b);
+
+	zassert_equal(coap_engine_send(&engine, &req_a,
+				       (struct sockaddr *)&peer_addr,
+				       &pending_a), 0, "Send failed");
+	k_msleep(ACK_TIMEOUT / 2);
+	zassert_equal(coap_engine_send(&engine, &req_b,
+				       (struct sockaddr *)&peer_addr,
+				       &pending_b), 0, "Send failed");
+
+	/* Acknowledging the head moves the timer to the next message. */
+	build_message(&ack, ack_data, COAP_TYPE_ACK, COAP_RESPONSE_CODE_CONTENT,
+		      id_a);
+	zassert_equal_ptr(coap_engine_received(&engine, &ack), &pending_a,
+			  "Pending not found");
+
+	k_msleep(ACK_TIMEOUT / 2 + 100);
+	zassert_equal(sent_count, 2, "Acknowledged message retransmitted");
+
+	k_msleep(ACK_TIMEOUT / 2);
+	zassert_equal(sent_count, 3, "Not retransmitted");
+	zassert_equal(last_sent_id(), id_b, "Wrong message retransmitted");
+
+	coap_engine_cancel(&engine, &pending_b);
+	zassert_equal(pending_b.timeout, 0, "Pending still in use");
+
+	k_msleep(4 * ACK_TIMEOUT);
+	zassert_equal(sent_count, 3, "Retransmitted after cancel");
+}
+
+static void test_stop(void)
+{
+	static uint8_t data[2][COAP_BUF_SIZE];
+	struct coap_pending pendings[2] = { 0 };
+	struct coap_packet req;
+
+	reset_counters();
+
+	for (int i = 0; i < ARRAY_SIZE(pendings); i++) {
+		build_message(&req, data[i], COAP_TYPE_CON, COAP_METHOD_GET,
+			      coap_next_id());
+		zassert_equal(coap_engine_send(&engine, &req,
+					       (struct sockaddr *)&peer_addr,
+					       &pendings[i]), 0, "Send failed");
+	}
+
+	coap_engine_stop(&engine);
+
+	k_msleep(4 * ACK_TIMEOUT);
+	zassert_equal(sent_count, 2, "Retransmitted after stop");
+	zassert_equal(timeout_count, 0, "Timeout after stop");
+}
+
+static void test_non_confirmable(void)
+{
+	uint8_t data[COAP_BUF_SIZE];
+	struct coap_packet req;
+
+	reset_counters();
+
+	build_message(&req, data, COAP_TYPE_NON_CON, COAP_METHOD_GET,
+		      coap_next_id());
+	zassert_equal(coap_engine_send(&engine, &req,
+				       (struct sockaddr *)&peer_addr, NULL),
+		      0, "Send failed");
+
+	k_msleep(2 * ACK_TIMEOUT);
+	zassert_equal(sent_count, 1, "Non-confirmable retransmitted");
+}
+
+static void test_notify(void)
+{
+	static const uint8_t tokens[][COAP_TOKEN_MAX_LEN] = {
+		{ 0x11 },
+		{ 0x21, 0x22, 0x23, 0x24 },
+		{ 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38 },
+	};
+	static const uint8_t tkls[] = { 1, 4, 8 };
+	static const uint8_t payload[] = "notification";
+	static struct coap_observer observers[ARRAY_SIZE(tkls)];
+	static struct coap_resource resource;
+	uint8_t data[COAP_BUF_SIZE];
+	struct coap_packet cpkt;
+	uint16_t ids[ARRAY_SIZE(tkls)];
+
+	reset_counters();
+
+	for (int i = 0; i < ARRAY_SIZE(observers); i++) {
+		memcpy(observers[i].token, tokens[i], tkls[i]);
+		observers[i].tkl = tkls[i];
+		memcpy(&observers[i].addr, &peer_addr,
+		       sizeof(observers[i].addr));
+		coap_register_observer(&resource, &observers[i]);
+	}
+
+	/* Built once, for all the observers. */
+	build_message(&cpkt, data, COAP_TYPE_NON_CON,
+		      COAP_RESPONSE_CODE_CONTENT, 0);
+	zassert_equal(coap_append_option_int(&cpkt, COAP_OPTION_OBSERVE,
+					     ++resource.age), 0,
+		      "Cannot add observe option");
+	zassert_equal(coap_packet_append_payload_marker(&cpkt), 0,
+		      "Cannot add payload marker");
+	zassert_equal(coap_packet_append_payload(&cpkt, payload,
+						 sizeof(payload)), 0,
+		      "Cannot add payload");
+
+	zassert_equal(coap_engine_notify(&engine, &resource, &cpkt),
+		      ARRAY_SIZE(observers), "Wrong number of notifications");
+	zassert_equal(sent_count, ARRAY_SIZE(observers), "Not sent");
+
+	for (int i = 0; i < ARRAY_SIZE(observers); i++) {
+		struct coap_option options[4];
+		uint8_t token[COAP_TOKEN_MAX_LEN];
+		struct coap_packet rsp;
+		const uint8_t *rsp_payload;
+		uint16_t len;
+
+		zassert_equal(coap_packet_parse(&rsp, sent[i].data,
+						sent[i].len, options,
+						ARRAY_SIZE(options)), 0,
+			      "Cannot parse notification %d", i);
+		zassert_equal(coap_header_get_type(&rsp), COAP_TYPE_NON_CON,
+			      "Wrong type");
+		zassert_equal(coap_header_get_code(&rsp),
+			      COAP_RESPONSE_CODE_CONTENT, "Wrong code");
+		zassert_equal(coap_header_get_token(&rsp, token), tkls[i],
+			      "Wrong token length");
+		zassert_mem_equal(token, tokens[i], tkls[i], "Wrong token");
+		zassert_equal(coap_get_option_int(&rsp, COAP_OPTION_OBSERVE),
+			      resource.age, "Wrong observe sequence");
+
+		rsp_payload = coap_packet_get_payload(&rsp, &len);
+		zassert_equal(len, sizeof(payload), "Wrong payload length");
+		zassert_mem_equal(rsp_payload, payload, len, "Wrong payload");
+
+		ids[i] = coap_header_get_id(&rsp);
+		for (int j = 0; j < i; j++) {
+			zassert_not_equal(ids[i], ids[j], "Message ID reused");
+		}
+	}
+
+	/* Confirmable notifications would need to be tracked. */
+	build_message(&cpkt, data, COAP_TYPE_CON, COAP_RESPONSE_CODE_CONTENT,
+		      0);
+	zassert_equal(coap_engine_notify(&engine, &resource, &cpkt), -EINVAL,
+		      "Confirmable notification accepted");
+}
+
+void test_main(void)
+{
+	coap_engine_init(&engine, engine_send, engine_timeout, NULL);
+
+	ztest_test_suite(coap_engine,
+			 ztest_unit_test(test_retransmit),
+			 ztest_unit_test(test_timeout),
+			 ztest_unit_test(test_queue_order),
+			 ztest_unit_test(test_stop),
+			 ztest_unit_test(test_non_confirmable),
+			 ztest_unit_test(test_notify));
+
+	ztest_run_test_suite(coap_engine);
+}
@@ -0,0 +1,458 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_DNS_RESOLVER_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <ztest.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/dummy.h>
+#include <net/dns_resolve.h>
+
+#include "ipv4.h"
+#include "udp_internal.h"
+
+#define DNS_TIMEOUT 2000 /* ms */
+#define WAIT_TIME K_MSEC(DNS_TIMEOUT + 300)
+#define NO_QUERY_TIME K_MSEC(100)
+
+#define DNS_PORT 53
+#define MAX_MSG_SIZE 512
+
+/* Size of the answer record added to the query */
+#define ANSWER_LEN 16
+
+#define DNS_RR_TYPE_SOA 6
+
+#define RCODE_SERVFAIL 2
+#define RCODE_NXDOMAIN 3
+
+static struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static struct in_addr server_addr = { { { 192, 0, 2, 2 } } };
+static struct in_addr answer_addr = { { { 198, 51, 100, 7 } } };
+
+static struct net_if *iface;
+
+/* The last query sent by the resolver */
+static uint8_t query_msg[MAX_MSG_SIZE];
+static size_t query_len;
+static uint16_t query_port;
+static K_SEM_DEFINE(query_sent, 0, UINT_MAX);
+
+struct result {
+	struct in_addr addr;
+	int addr_count;
+	int status;
+	struct k_sem done;
+};
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static uint8_t mac[] = { 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_DUMMY);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(udp_access, struct net_udp_hdr);
+	struct net_udp_hdr *udp_hdr;
+
+	net_pkt_cursor_init(pkt);
+
+	if (net_pkt_skip(pkt, NET_IPV4H_LEN)) {
+		return -EINVAL;
+	}
+
+	udp_hdr = (struct net_udp_hdr *)net_pkt_get_data(pkt, &udp_access);
+	if (!udp_hdr || ntohs(udp_hdr->dst_port) != DNS_PORT) {
+		return 0;
+	}
+
+	query_port = udp_hdr->src_port;
+	net_pkt_acknowledge_data(pkt, &udp_access);
+
+	query_len = MIN(net_pkt_remaining_data(pkt), sizeof(query_msg));
+	if (net_pkt_read(pkt, query_msg, query_len)) {
+		return -EINVAL;
+	}
+
+	k_sem_give(&query_sent);
+
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_dns_cache_test, "net_dns_cache_test",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+/* Answer the last query. If ttl is 0, the answer has no address records
+ * but only the authority record that servers add to negative answers.
+ */
+static void reply(uint8_t rcode, uint32_t ttl)
+{
+	uint8_t msg[MAX_MSG_SIZE + ANSWER_LEN];
+	struct net_pkt *pkt;
+	size_t len = query_len;
+
+	memcpy(msg, query_msg, query_len);
+
+	/* Response with recursion available */
+	msg[2] |= 0x80;
+	msg[3] = 0x80 | rcode;
+
+	if (ttl) {
+		/* One answer, pointing to the name of the question */
+		msg[7] = 1U;
+
+		msg[len++] = 0xc0;
+		msg[len++] = 0x0c;
+		sys_put_be16(DNS_QUERY_TYPE_A, &msg[len]);
+		len += 2;
+		sys_put_be16(1, &msg[len]);
+		len += 2;
+		sys_put_be32(ttl, &msg[len]);
+		len += 4;
+		sys_put_be16(sizeof(answer_addr), &msg[len]);
+		len += 2;
+		memcpy(&msg[len], &answer_addr, sizeof(answer_addr));
+		len += sizeof(answer_addr);
+	} else {
+		/* Authority record with empty data */
+		msg[9] = 1U;
+
+		msg[len++] = 0xc0;
+		msg[len++] = 0x0c;
+		sys_put_be16(DNS_RR_TYPE_SOA, &msg[len]);
+		len += 2;
+		sys_put_be16(1, &msg[len]);
+		len += 2;
+		sys_put_be32(60, &msg[len]);
+		len += 4;
+		sys_put_be16(0, &msg[len]);
+		len += 2;
+	}
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, len, AF_INET, IPPROTO_UDP,
+					   K_SECONDS(1));
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv4_create(pkt, &server_addr, &my_addr), 0, "");
+	zassert_equal(net_udp_create(pkt, htons(DNS_PORT), query_port), 0,
+		      "");
+	zassert_equal(net_pkt_write(pkt, msg, len), 0, "");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv4_finalize(pkt, IPPROTO_UDP), 0, "");
+
+	zassert_true(net_recv_data(iface, pkt) >= 0, "Cannot receive reply");
+}
+
+static void result_cb(enum dns_resolve_status status,
+		      struct dns_addrinfo *info,
+		      void *user_data)
+{
+	struct result *result = user_data;
+
+	if (status == DNS_EAI_INPROGRESS) {
+		result->addr_count++;
+		result->addr = net_sin(&info->ai_addr)->sin_addr;
+		return;
+	}
+
+	result->status = status;
+	k_sem_give(&result->done);
+}
+
+static void result_init(struct result *result)
+{
+	memset(result, 0, sizeof(*result));
+	k_sem_init(&result->done, 0, 1);
+}
+
+static void resolve(const char *name, struct result *result, uint16_t *id)
+{
+	int ret;
+
+	result_init(result);
+
+	ret = dns_get_addr_info(name, DNS_QUERY_TYPE_A, id, result_cb,
+				result, DNS_TIMEOUT);
+	zassert_equal(ret, 0, "Cannot start query for %s (%d)", name, ret);
+}
+
+static void wait_query(void)
+{
+	zassert_equal(k_sem_take(&query_sent, WAIT_TIME), 0,
+		      "Query was not sent");
+}
+
+static void verify_no_query(void)
+{
+	zassert_not_equal(k_sem_take(&query_sent, NO_QUERY_TIME), 0,
+			  "Unexpected query sent");
+}
+
+static void verify_answer(struct result *result)
+{
+	zassert_equal(k_sem_take(&result->done, WAIT_TIME), 0,
+		      "No result");
+	zassert_equal(result->status, DNS_EAI_ALLDONE, "Invalid status %d",
+		      result->status);
+	zassert_equal(result->addr_count, 1, "Invalid address count %d",
+		      result->addr_count);
+	zassert_true(net_ipv4_addr_cmp(&result->addr, &answer_addr),
+		     "Invalid address");
+}
+
+static void verify_released(void)
+{
+	struct dns_resolve_context *ctx = dns_resolve_get_default();
+	int i;
+
+	for (i = 0; i < CONFIG_DNS_NUM_CONCUR_QUERIES; i++) {
+		zassert_false(ctx->queries[i].cb && ctx->queries[i].query,
+			      "Query %d still pending", i);
+	}
+}
+
+static void test_init(void)
+{
+	struct net_if_addr *ifaddr;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "No interface");
+
+	ifaddr = net_if_ipv4_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add address");
+
+	net_if_up(iface);
+
+	dns_cache_flush();
+}
+
+static void test_dns_cache_hit(void)
+{
+	struct dns_cache_stats stats;
+	struct result result;
+
+	resolve("hit.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 60);
+	verify_answer(&result);
+
+	/* The second query is answered before the call returns */
+	resolve("hit.zephyr.test", &result, NULL);
+	zassert_equal(k_sem_take(&result.done, K_NO_WAIT), 0,
+		      "Not answered from cache");
+	zassert_equal(result.status, DNS_EAI_ALLDONE, "Invalid status");
+	zassert_equal(result.addr_count, 1, "Invalid address count");
+	zassert_true(net_ipv4_addr_cmp(&result.addr, &answer_addr),
+		     "Invalid cached address");
+	verify_no_query();
+
+	dns_cache_stats_get(&stats);
+	zassert_equal(stats.hits, 1, "Invalid hits %u", stats.hits);
+	zassert_equal(stats.misses, 1, "Invalid misses %u", stats.misses);
+	zassert_equal(stats.entries, 1, "Invalid entries %u", stats.entries);
+}
+
+static void test_dns_cache_ttl(void)
+{
+	struct result result;
+
+	resolve("ttl.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 1);
+	verify_answer(&result);
+
+	k_msleep(MSEC_PER_SEC + 100);
+
+	/* The answer has expired, so the server is asked again */
+	resolve("ttl.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 1);
+	verify_answer(&result);
+}
+
+static void test_dns_cache_negative(void)
+{
+	struct dns_cache_stats stats;
+	struct result result;
+
+	resolve("missing.zephyr.test", &result, NULL);
+	wait_query();
+	reply(RCODE_NXDOMAIN, 0);
+	zassert_equal(k_sem_take(&result.done, WAIT_TIME), 0, "No result");
+	zassert_equal(result.status, DNS_EAI_NODATA, "Invalid status %d",
+		      result.status);
+
+	resolve("missing.zephyr.test", &result, NULL);
+	zassert_equal(k_sem_take(&result.done, K_NO_WAIT), 0,
+		      "Not answered from cache");
+	zassert_equal(result.status, DNS_EAI_NODATA, "Invalid status %d",
+		      result.status);
+	zassert_equal(result.addr_count, 0, "Invalid address count");
+	verify_no_query();
+
+	dns_cache_stats_get(&stats);
+	zassert_equal(stats.negative_hits, 1, "Invalid negative hits %u",
+		      stats.negative_hits);
+
+	/* Negative answers are cached only for a short time */
+	k_msleep(CONFIG_DNS_RESOLVER_CACHE_NEGATIVE_TTL * MSEC_PER_SEC + 100);
+
+	resolve("missing.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 60);
+	verify_answer(&result);
+}
+
+static void test_dns_cache_servfail(void)
+{
+	struct result result;
+
+	resolve("fail.zephyr.test", &result, NULL);
+	wait_query();
+	reply(RCODE_SERVFAIL, 0);
+	zassert_equal(k_sem_take(&result.done, WAIT_TIME), 0, "No result");
+	zassert_not_equal(result.status, DNS_EAI_ALLDONE, "Invalid status");
+
+	/* Server failures are not cached */
+	resolve("fail.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 60);
+	verify_answer(&result);
+}
+
+static void test_dns_query_coalesce(void)
+{
+	struct result result[CONFIG_DNS_NUM_CONCUR_QUERIES];
+	struct dns_cache_stats stats;
+	int i;
+
+	dns_cache_flush();
+
+	for (i = 0; i < ARRAY_SIZE(result); i++) {
+		resolve("shared.zephyr.test", &result[i], NULL);
+	}
+
+	/* Only the first query is sent */
+	wait_query();
+	verify_no_query();
+
+	dns_cache_stats_get(&stats);
+	zassert_equal(stats.coalesced, ARRAY_SIZE(result) - 1,
+		      "Invalid coalesced %u", stats.coalesced);
+
+	reply(0, 60);
+
+	for (i = 0; i < ARRAY_SIZE(result); i++) {
+		verify_answer(&result[i]);
+	}
+
+	verify_released();
+}
+
+static void test_dns_query_coalesce_cancel(void)
+{
+	struct result first, second;
+	uint16_t first_id, second_id;
+
+	resolve("cancel.zephyr.test", &first, &first_id);
+	resolve("cancel.zephyr.test", &second, &second_id);
+	wait_query();
+	zassert_equal(sys_get_be16(query_msg), first_id, "Invalid query id");
+
+	zassert_equal(dns_cancel_addr_info(first_id), 0, "Cannot cancel");
+	zassert_equal(k_sem_take(&first.done, WAIT_TIME), 0, "No result");
+	zassert_equal(first.status, DNS_EAI_CANCELED, "Invalid status %d",
+		      first.status);
+
+	/* The waiting query sends its own request */
+	wait_query();
+	zassert_equal(sys_get_be16(query_msg), second_id, "Invalid query id");
+
+	reply(0, 60);
+	verify_answer(&second);
+
+	verify_released();
+}
+
+static void test_dns_query_coalesce_timeout(void)
+{
+	struct result first, second;
+
+	resolve("timeout.zephyr.test", &first, NULL);
+	resolve("timeout.zephyr.test", &second, NULL);
+	wait_query();
+
+	/* Nobody answers, so both queries must time out even if the
+	 * waiting one had to send its own request.
+	 */
+	zassert_equal(k_sem_take(&first.done, K_MSEC(DNS_TIMEOUT * 2 + 300)),
+		      0, "No result");
+	zassert_equal(first.status, DNS_EAI_CANCELED, "Invalid status %d",
+		      first.status);
+	zassert_equal(k_sem_take(&second.done, K_MSEC(DNS_TIMEOUT * 2 + 300)),
+		      0, "No result");
+	zassert_equal(second.status, DNS_EAI_CANCELED, "Invalid status %d",
+		      second.status);
+
+	while (k_sem_take(&query_sent, K_NO_WAIT) == 0) {
+	}
+
+	k_msleep(100);
+	verify_released();
+}
+
+static void test_dns_cache_flush(void)
+{
+	struct dns_cache_stats stats;
+	struct result result;
+
+	dns_cache_flush();
+
+	dns_cache_stats_get(&stats);
+	zassert_equal(stats.entries, 0, "Cache not empty");
+
+	resolve("hit.zephyr.test", &result, NULL);
+	wait_query();
+	reply(0, 60);
+	verify_answer(&result);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(dns_cache,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_dns_cache_hit),
+			 ztest_unit_test(test_dns_cache_ttl),
+			 ztest_unit_test(test_dns_cache_negative),
+			 ztest_unit_test(test_dns_cache_servfail),
+			 ztest_unit_test(test_dns_query_coalesce),
+			 ztest_unit_test(test_dns_query_coalesce_cancel),
+			 ztest_unit_test(test_dns_query_coalesce_timeout),
+			 ztest_unit_test(test_dns_cache_flush));
+
+	ztest_run_test_suite(dns_cache);
+}
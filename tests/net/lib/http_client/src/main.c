@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_HTTP_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/http_client.h>
+
+#define SERVER_ADDR "192.0.2.1"
+#define SERVER_PORT 8080
+#define SERVER_PORT_STR "8080"
+
+#define PIPELINE_COUNT 3
+#define BUF_SIZE 256
+#define WAIT_TIME_MS 2000
+
+#define SERVER_STACK_SIZE 2048
+#define SERVER_PRIORITY K_PRIO_PREEMPT(8)
+
+/* Minimal server stand-in. The body of each response is the path of its
+ * request, so that the order of pipelined responses can be checked.
+ */
+static struct {
+	int listen_sock;
+	/* Requests to receive before sending their responses together */
+	int batch;
+	bool chunked;
+	bool close;
+	atomic_t accepts;
+	atomic_t requests;
+} server;
+
+struct result {
+	char body[64];
+	size_t len;
+	bool frag_outside;
+};
+
+static uint8_t recv_buf[BUF_SIZE];
+static struct result results[PIPELINE_COUNT];
+static struct http_request reqs[PIPELINE_COUNT];
+
+K_THREAD_STACK_DEFINE(server_stack, SERVER_STACK_SIZE);
+static struct k_thread server_thread;
+
+static int server_response(char *buf, size_t len, const char *path)
+{
+	if (server.chunked) {
+		return snprintk(buf, len, "HTTP/1.1 200 OK\r\n"
+				"Transfer-Encoding: chunked\r\n\r\n"
+				"%x\r\n%s\r\n6\r\n-chunk\r\n0\r\n\r\n",
+				(unsigned int)strlen(path), path);
+	}
+
+	return snprintk(buf, len, "HTTP/1.1 200 OK\r\n"
+			"%sContent-Length: %zd\r\n\r\n%s",
+			server.close ? "Connection: close\r\n" : "",
+			strlen(path), path);
+}
+
+static void server_serve(int sock)
+{
+	char req[BUF_SIZE + 1];
+	char rsp[BUF_SIZE * 2];
+	size_t req_len = 0, rsp_len = 0;
+	bool close_conn = false;
+	int pending = 0;
+	ssize_t ret;
+	char *end;
+
+	while (true) {
+		ret = recv(sock, req + req_len, BUF_SIZE - req_len, 0);
+		if (ret <= 0) {
+			return;
+		}
+
+		req_len += ret;
+		req[req_len] = '\0';
+
+		while ((end = strstr(req, "\r\n\r\n")) != NULL) {
+			char path[32] = "";
+
+			(void)sscanf(req, "GET %31s", path);
+			rsp_len += server_response(rsp + rsp_len,
+						   sizeof(rsp) - rsp_len,
+						   path);
+			close_conn = server.close;
+			pending++;
+			atomic_inc(&server.requests);
+
+			end += 4;
+			req_len -= end - req;
+			memmove(req, end, req_len + 1);
+		}
+
+		if (pending < server.batch) {
+			continue;
+		}
+
+		(void)send(sock, rsp, rsp_len, 0);
+		rsp_len = 0;
+		pending = 0;
+
+		if (close_conn) {
+			/* Let the response go out before closing */
+			k_msleep(10);
+			return;
+		}
+	}
+}
+
+static void server_fn(void *p1, void *p2, void *p3)
+{
+	int sock;
+
+	while (true) {
+		sock = accept(server.listen_sock, NULL, NULL);
+		if (sock < 0) {
+			return;
+		}
+
+		atomic_inc(&server.accepts);
+		server_serve(sock);
+		(void)close(sock);
+	}
+}
+
+static int client_connect(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+	};
+	int sock, ret;
+
+	inet_pton(AF_INET, SERVER_ADDR, &addr.sin_addr);
+
+	sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(sock >= 0, "Could not create the client socket");
+
+	ret = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
+	zassert_equal(ret, 0, "Could not connect (%d)", errno);
+
+	return sock;
+}
+
+static void response_cb(struct http_response *rsp,
+			enum http_final_call final_data,
+			void *user_data)
+{
+	struct http_request *req = CONTAINER_OF(rsp, struct http_request,
+						internal.response);
+	struct result *result = &results[req - reqs];
+
+	if (rsp->body_frag_start == NULL) {
+		return;
+	}
+
+	if (rsp->body_frag_start < rsp->recv_buf ||
+	    rsp->body_frag_start + rsp->body_frag_len >
+	    rsp->recv_buf + rsp->recv_buf_len) {
+		result->frag_outside = true;
+	}
+
+	if (result->len + rsp->body_frag_len < sizeof(result->body)) {
+		memcpy(result->body + result->len, rsp->body_frag_start,
+		       rsp->body_frag_len);
+		result->len += rsp->body_frag_len;
+	}
+}
+
+static void request_init(int i, const char *url)
+{
+	memset(&reqs[i], 0, sizeof(reqs[i]));
+	memset(&results[i], 0, sizeof(results[i]));
+
+	reqs[i].method = HTTP_GET;
+	reqs[i].url = url;
+	reqs[i].host = SERVER_ADDR;
+	reqs[i].protocol = "HTTP/1.1";
+	reqs[i].response = response_cb;
+	reqs[i].recv_buf = recv_buf;
+	reqs[i].recv_buf_len = sizeof(recv_buf);
+}
+
+static void check_result(int i, const char *body)
+{
+	zassert_true(reqs[i].internal.response.message_complete,
+		     "Response %d not complete", i);
+	zassert_equal(reqs[i].internal.response.http_status_code, 200,
+		      "Wrong status");
+	zassert_equal(results[i].len, strlen(body), "Wrong body length");
+	zassert_mem_equal(results[i].body, body, results[i].len,
+			  "Wrong body");
+	zassert_false(results[i].frag_outside,
+		      "Fragment outside of the receive buffer");
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+	};
+	int ret;
+
+	inet_pton(AF_INET, SERVER_ADDR, &addr.sin_addr);
+
+	server.listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(server.listen_sock >= 0, "Could not create the socket");
+
+	ret = bind(server.listen_sock, (struct sockaddr *)&addr, sizeof(addr));
+	zassert_equal(ret, 0, "Could not bind the server socket");
+
+	ret = listen(server.listen_sock, 1);
+	zassert_equal(ret, 0, "Could not listen");
+
+	server.batch = 1;
+
+	k_thread_create(&server_thread, server_stack,
+			K_THREAD_STACK_SIZEOF(server_stack), server_fn,
+			NULL, NULL, NULL, SERVER_PRIORITY, 0, K_NO_WAIT);
+}
+
+static void test_keep_alive(void)
+{
+	int sock, ret;
+
+	atomic_clear(&server.accepts);
+	sock = client_connect();
+
+	request_init(0, "/one");
+	ret = http_client_req(sock, &reqs[0], WAIT_TIME_MS, NULL);
+	zassert_true(ret > 0, "Send failed (%d)", ret);
+	check_result(0, "/one");
+	zassert_true(reqs[0].internal.response.keep_alive,
+		     "Connection not kept alive");
+
+	ret = http_client_pool_put(sock, SERVER_ADDR, SERVER_PORT_STR);
+	zassert_equal(ret, 0, "Could not put the connection in the pool");
+
+	zassert_equal(http_client_pool_get(SERVER_ADDR, "80"), -ENOENT,
+		      "Got a connection to the wrong port");
+	zassert_equal(http_client_pool_get(SERVER_ADDR, SERVER_PORT_STR), sock,
+		      "Connection not reused");
+
+	request_init(0, "/two");
+	ret = http_client_req(sock, &reqs[0], WAIT_TIME_MS, NULL);
+	zassert_true(ret > 0, "Send failed (%d)", ret);
+	check_result(0, "/two");
+
+	zassert_equal(atomic_get(&server.accepts), 1,
+		      "A new connection was made");
+
+	ret = http_client_pool_put(sock, SERVER_ADDR, SERVER_PORT_STR);
+	zassert_equal(ret, 0, "Could not put the connection in the pool");
+}
+
+static void test_body_fragments(void)
+{
+	int sock, ret;
+
+	sock = http_client_pool_get(SERVER_ADDR, SERVER_PORT_STR);
+	zassert_true(sock >= 0, "No connection in the pool");
+
+	server.chunked = true;
+
+	request_init(0, "/chunked");
+	ret = http_client_req(sock, &reqs[0], WAIT_TIME_MS, NULL);
+	zassert_true(ret > 0, "Send failed (%d)", ret);
+	check_result(0, "/chunked-chunk");
+
+	server.chunked = false;
+
+	ret = http_client_pool_put(sock, SERVER_ADDR, SERVER_PORT_STR);
+	zassert_equal(ret, 0, "Could not put the connection in the pool");
+}
+
+static void test_pipelined(void)
+{
+	static const char * const urls[] = { "/a", "/bb", "/ccc" };
+	struct http_request *req_list[PIPELINE_COUNT];
+	int sock, ret, i;
+
+	sock = http_client_pool_get(SERVER_ADDR, SERVER_PORT_STR);
+	zassert_true(sock >= 0, "No connection in the pool");
+
+	/* The responses come back to back in a single segment, and
+	 * share the same receive buffer.
+	 */
+	server.batch = PIPELINE_COUNT;
+	atomic_clear(&server.requests);
+
+	for (i = 0; i < PIPELINE_COUNT; i++) {
+		request_init(i, urls[i]);
+		req_list[i] = &reqs[i];
+	}
+
+	ret = http_client_req_pipelined(sock, req_list, PIPELINE_COUNT,
+					WAIT_TIME_MS, NULL);
+	zassert_true(ret > 0, "Send failed (%d)", ret);
+
+	for (i = 0; i < PIPELINE_COUNT; i++) {
+		check_result(i, urls[i]);
+	}
+
+	zassert_equal(atomic_get(&server.requests), PIPELINE_COUNT,
+		      "Wrong request count");
+	zassert_equal(atomic_get(&server.accepts), 1,
+		      "A new connection was made");
+
+	server.batch = 1;
+
+	ret = http_client_pool_put(sock, SERVER_ADDR, SERVER_PORT_STR);
+	zassert_equal(ret, 0, "Could not put the connection in the pool");
+}
+
+static void test_pool_closed(void)
+{
+	int sock, ret;
+
+	sock = http_client_pool_get(SERVER_ADDR, SERVER_PORT_STR);
+	zassert_true(sock >= 0, "No connection in the pool");
+
+	server.close = true;
+
+	request_init(0, "/close");
+	ret = http_client_req(sock, &reqs[0], WAIT_TIME_MS, NULL);
+	zassert_true(ret > 0, "Send failed (%d)", ret);
+	check_result(0, "/close");
+	zassert_false(reqs[0].internal.response.keep_alive,
+		      "Connection kept alive");
+
+	/* The server closed the connection, the pool must notice it */
+	ret = http_client_pool_put(sock, SERVER_ADDR, SERVER_PORT_STR);
+	zassert_equal(ret, 0, "Could not put the connection in the pool");
+	k_sleep(K_MSEC(100));
+
+	zassert_equal(http_client_pool_get(SERVER_ADDR, SERVER_PORT_STR),
+		      -ENOENT, "Closed connection reused");
+
+	server.close = false;
+	http_client_pool_flush();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(http_client,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_keep_alive),
+			 ztest_unit_test(test_body_fragments),
+			 ztest_unit_test(test_pipelined),
+			 ztest_unit_test(test_pool_closed));
+
+	ztest_run_test_suite(http_client);
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_LWM2M_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#include "lwm2m_engine.h"
+
+#define SERVER_ADDR "192.0.2.1"
+#define SERVER_PORT 5683
+
+#define BUF_SIZE 256
+#define WAIT_TIME_MS 1000
+#define QUIET_TIME_MS 700
+
+static struct lwm2m_ctx client_ctx;
+static struct sockaddr_in client_addr;
+static int server_sock = -1;
+static uint16_t next_mid = 1000;
+
+static uint8_t battery_level;
+static int32_t memory_free;
+
+static const uint8_t token_battery[] = { 'b', 'a', 't' };
+static const uint8_t token_memory[] = { 'm', 'e', 'm' };
+
+struct reply {
+	struct coap_packet cpkt;
+	uint8_t data[BUF_SIZE];
+	uint8_t token[8];
+	uint8_t tkl;
+};
+
+static void server_send(uint8_t method, const char *res, const char *query,
+			int observe, const uint8_t *token, uint8_t tkl)
+{
+	static const char * const obj_path[] = { "3", "0" };
+	struct coap_packet cpkt;
+	uint8_t data[BUF_SIZE];
+	ssize_t ret;
+	int i, r;
+
+	r = coap_packet_init(&cpkt, data, sizeof(data), 1, COAP_TYPE_CON,
+			     tkl, (uint8_t *)token, method, next_mid++);
+	zassert_equal(r, 0, "Could not init the request");
+
+	if (observe >= 0) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_OBSERVE,
+					   observe);
+		zassert_equal(r, 0, "Could not add observe");
+	}
+
+	for (i = 0; i < ARRAY_SIZE(obj_path); i++) {
+		r = coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH,
+					      obj_path[i],
+					      strlen(obj_path[i]));
+		zassert_equal(r, 0, "Could not add path");
+	}
+
+	r = coap_packet_append_option(&cpkt, COAP_OPTION_URI_PATH, res,
+				      strlen(res));
+	zassert_equal(r, 0, "Could not add path");
+
+	if (method == COAP_METHOD_GET) {
+		r = coap_append_option_int(&cpkt, COAP_OPTION_ACCEPT,
+					   LWM2M_FORMAT_PLAIN_TEXT);
+		zassert_equal(r, 0, "Could not add accept");
+	}
+
+	if (query) {
+		r = coap_packet_append_option(&cpkt, COAP_OPTION_URI_QUERY,
+					      query, strlen(query));
+		zassert_equal(r, 0, "Could not add query");
+	}
+
+	ret = sendto(server_sock, data, cpkt.offset, 0,
+		     (struct sockaddr *)&client_addr, sizeof(client_addr));
+	zassert_equal(ret, cpkt.offset, "Send failed (%d)", errno);
+}
+
+/* Receive a message from the client, returns false on timeout */
+static bool server_recv(struct reply *reply, int timeout_ms)
+{
+	struct pollfd fds = {
+		.fd = server_sock,
+		.events = POLLIN,
+	};
+	ssize_t len;
+	int r;
+
+	if (poll(&fds, 1, timeout_ms) <= 0) {
+		return false;
+	}
+
+	len = recv(server_sock, reply->data, sizeof(reply->data), 0);
+	zassert_true(len > 0, "Receive failed (%d)", errno);
+
+	r = coap_packet_parse(&reply->cpkt, reply->data, len, NULL, 0);
+	zassert_equal(r, 0, "Invalid message from the client");
+
+	reply->tkl = coap_header_get_token(&reply->cpkt, reply->token);
+
+	return true;
+}
+
+/* Receive a response, or a notification which is then acknowledged */
+static void server_expect(struct reply *reply, uint8_t code,
+			  const uint8_t *token, uint8_t tkl)
+{
+	struct coap_packet ack;
+	uint8_t data[8];
+	int r;
+
+	zassert_true(server_recv(reply, WAIT_TIME_MS), "Nothing received");
+	zassert_equal(coap_header_get_code(&reply->cpkt), code,
+		      "Unexpected code %02x",
+		      coap_header_get_code(&reply->cpkt));
+	zassert_equal(reply->tkl, tkl, "Wrong token length");
+	zassert_mem_equal(reply->token, token, tkl, "Wrong token");
+
+	if (coap_header_get_type(&reply->cpkt) != COAP_TYPE_CON) {
+		return;
+	}
+
+	r = coap_packet_init(&ack, data, sizeof(data), 1, COAP_TYPE_ACK, 0,
+			     NULL, COAP_CODE_EMPTY,
+			     coap_header_get_id(&reply->cpkt));
+	zassert_equal(r, 0, "Could not init the ACK");
+
+	(void)sendto(server_sock, data, ack.offset, 0,
+		     (struct sockaddr *)&client_addr, sizeof(client_addr));
+}
+
+static void server_expect_nothing(void)
+{
+	struct reply reply;
+
+	zassert_false(server_recv(&reply, QUIET_TIME_MS),
+		      "Unexpected message from the client");
+}
+
+static void test_setup(void)
+{
+	struct sockaddr_in server_addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(SERVER_PORT),
+	};
+	socklen_t addr_len = sizeof(client_addr);
+	int r;
+
+	lwm2m_engine_set_res_data("3/0/9", &battery_level,
+				  sizeof(battery_level), 0);
+	lwm2m_engine_set_res_data("3/0/10", &memory_free,
+				  sizeof(memory_free), 0);
+
+	inet_pton(AF_INET, SERVER_ADDR, &server_addr.sin_addr);
+
+	server_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(server_sock >= 0, "Could not create the server socket");
+
+	r = bind(server_sock, (struct sockaddr *)&server_addr,
+		 sizeof(server_addr));
+	zassert_equal(r, 0, "Could not bind the server socket");
+
+	memcpy(&client_ctx.remote_addr, &server_addr, sizeof(server_addr));
+	lwm2m_engine_context_init(&client_ctx);
+	r = lwm2m_socket_start(&client_ctx);
+	zassert_equal(r, 0, "Could not start the client socket");
+
+	r = getsockname(client_ctx.sock_fd, (struct sockaddr *)&client_addr,
+			&addr_len);
+	zassert_equal(r, 0, "Could not get the client address");
+	client_addr.sin_addr = server_addr.sin_addr;
+
+	lwm2m_engine_reset_notify_stats();
+}
+
+static void test_notify_on_change(void)
+{
+	struct lwm2m_notify_stats stats;
+	struct reply reply;
+	uint16_t len;
+
+	server_send(COAP_METHOD_GET, "9", NULL, 0, token_battery,
+		    sizeof(token_battery));
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_battery,
+		      sizeof(token_battery));
+
+	lwm2m_engine_set_u8("3/0/9", 42);
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_battery,
+		      sizeof(token_battery));
+	zassert_equal(coap_header_get_type(&reply.cpkt), COAP_TYPE_CON,
+		      "Notification is not confirmable");
+	zassert_mem_equal(coap_packet_get_payload(&reply.cpkt, &len), "42",
+			  2, "Wrong notification payload");
+
+	lwm2m_engine_get_notify_stats(&stats);
+	zassert_equal(stats.events, 1, "Wrong event count");
+	zassert_equal(stats.triggered, 1, "Wrong notification count");
+	zassert_true(stats.latency_max_ms < WAIT_TIME_MS, "Latency too high");
+
+	TC_PRINT("notification latency %u ms\n", stats.latency_max_ms);
+}
+
+static void test_unobserved_change(void)
+{
+	struct lwm2m_notify_stats stats;
+
+	/* not observed: the index has no observer for it */
+	lwm2m_engine_set_s32("3/0/10", 1024);
+	server_expect_nothing();
+
+	lwm2m_engine_get_notify_stats(&stats);
+	zassert_equal(stats.events, 1, "Unobserved change matched");
+}
+
+static void test_coalesce_periodic(void)
+{
+	struct lwm2m_notify_stats stats;
+	struct reply reply;
+	int64_t start;
+
+	server_send(COAP_METHOD_PUT, "10", "pmax=3", -1, token_memory,
+		    sizeof(token_memory));
+	server_expect(&reply, COAP_RESPONSE_CODE_CHANGED, token_memory,
+		      sizeof(token_memory));
+
+	server_send(COAP_METHOD_GET, "10", NULL, 0, token_memory,
+		    sizeof(token_memory));
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_memory,
+		      sizeof(token_memory));
+	start = k_uptime_get();
+
+	/* the pmax notification would be due in about 500 ms */
+	k_sleep(K_MSEC(2500));
+	lwm2m_engine_set_u8("3/0/9", 43);
+
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_battery,
+		      sizeof(token_battery));
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_memory,
+		      sizeof(token_memory));
+	zassert_true(k_uptime_get() - start < 3 * MSEC_PER_SEC,
+		     "Periodic notification not sent early");
+
+	lwm2m_engine_get_notify_stats(&stats);
+	zassert_equal(stats.triggered, 2, "Wrong triggered count");
+	zassert_equal(stats.periodic, 1, "Wrong periodic count");
+	zassert_equal(stats.coalesced, 1, "Wrong coalesced count");
+}
+
+static void test_cancel(void)
+{
+	struct reply reply;
+
+	server_send(COAP_METHOD_GET, "9", NULL, 1, token_battery,
+		    sizeof(token_battery));
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_battery,
+		      sizeof(token_battery));
+
+	server_send(COAP_METHOD_GET, "10", NULL, 1, token_memory,
+		    sizeof(token_memory));
+	server_expect(&reply, COAP_RESPONSE_CODE_CONTENT, token_memory,
+		      sizeof(token_memory));
+
+	lwm2m_engine_set_u8("3/0/9", 44);
+	server_expect_nothing();
+
+	(void)lwm2m_engine_context_close(&client_ctx);
+	(void)close(server_sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lwm2m_observe,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_notify_on_change),
+			 ztest_unit_test(test_unobserved_change),
+			 ztest_unit_test(test_coalesce_periodic),
+			 ztest_unit_test(test_cancel));
+
+	ztest_run_test_suite(lwm2m_observe);
+}
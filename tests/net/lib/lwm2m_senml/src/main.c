@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_LWM2M_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/coap.h>
+#include <net/lwm2m.h>
+
+#include "lwm2m_engine.h"
+#include "lwm2m_rw_json.h"
+#include "lwm2m_rw_oma_tlv.h"
+#include "lwm2m_rw_plain_text.h"
+#include "lwm2m_rw_senml_cbor.h"
+#include "lwm2m_rw_senml_json.h"
+
+#define BUF_SIZE 1024
+#define ENCODE_RUNS 200
+
+typedef int (*read_op_t)(struct lwm2m_message *msg, int content_format);
+
+static struct lwm2m_ctx client_ctx;
+static struct lwm2m_message msg;
+static uint8_t out_buf[BUF_SIZE];
+static uint8_t in_buf[BUF_SIZE];
+static struct coap_packet in_cpkt;
+
+static char utc_offset[8] = "+01:00";
+
+static void set_path(struct lwm2m_obj_path *path, uint8_t level,
+		     uint16_t obj_id, uint16_t obj_inst_id, uint16_t res_id)
+{
+	(void)memset(path, 0, sizeof(*path));
+	path->level = level;
+	path->obj_id = obj_id;
+	path->obj_inst_id = obj_inst_id;
+	path->res_id = res_id;
+}
+
+static void init_out(const struct lwm2m_writer *writer)
+{
+	int r;
+
+	(void)memset(&msg, 0, sizeof(msg));
+	msg.ctx = &client_ctx;
+	msg.out.writer = writer;
+	msg.out.out_cpkt = &msg.cpkt;
+
+	r = coap_packet_init(&msg.cpkt, out_buf, sizeof(out_buf), 1,
+			     COAP_TYPE_ACK, 0, NULL,
+			     COAP_RESPONSE_CODE_CONTENT, 1);
+	zassert_equal(r, 0, "Could not init the output packet");
+}
+
+/* Returns the payload of the message built in out_buf */
+static const uint8_t *out_payload(uint16_t *len)
+{
+	static struct coap_packet cpkt;
+	int r;
+
+	r = coap_packet_parse(&cpkt, out_buf, msg.cpkt.offset, NULL, 0);
+	zassert_equal(r, 0, "Could not parse the output packet");
+
+	return coap_packet_get_payload(&cpkt, len);
+}
+
+static uint16_t encode(read_op_t read_op, const struct lwm2m_writer *writer,
+		       uint16_t format, struct lwm2m_obj_path *path,
+		       uint32_t *cycles)
+{
+	uint16_t len;
+	uint32_t start;
+	int i, r;
+
+	*cycles = 0U;
+	for (i = 0; i < ENCODE_RUNS; i++) {
+		init_out(writer);
+		memcpy(&msg.path, path, sizeof(msg.path));
+
+		start = k_cycle_get_32();
+		r = read_op(&msg, format);
+		*cycles += k_cycle_get_32() - start;
+		zassert_equal(r, 0, "Read of format %u failed: %d", format, r);
+	}
+
+	zassert_not_null(out_payload(&len), "No payload");
+	return len;
+}
+
+/* Build a request carrying payload and point the input context at it */
+static void init_in(uint16_t format, const uint8_t *payload, uint16_t len)
+{
+	struct coap_packet cpkt;
+	int r;
+
+	r = coap_packet_init(&cpkt, in_buf, sizeof(in_buf), 1,
+			     COAP_TYPE_CON, 0, NULL, COAP_METHOD_FETCH, 2);
+	zassert_equal(r, 0, "Could not init the request");
+
+	r = coap_append_option_int(&cpkt, COAP_OPTION_CONTENT_FORMAT, format);
+	zassert_equal(r, 0, "Could not add content-format");
+
+	r = coap_packet_append_payload_marker(&cpkt);
+	zassert_equal(r, 0, "Could not add payload marker");
+
+	r = coap_packet_append_payload(&cpkt, (uint8_t *)payload, len);
+	zassert_equal(r, 0, "Could not add payload");
+
+	r = coap_packet_parse(&in_cpkt, in_buf, cpkt.offset, NULL, 0);
+	zassert_equal(r, 0, "Could not parse the request");
+
+	msg.in.in_cpkt = &in_cpkt;
+	msg.in.offset = in_cpkt.hdr_len + in_cpkt.opt_len;
+}
+
+static void test_size_and_speed(void)
+{
+	struct lwm2m_obj_path path;
+	uint16_t tlv, json, senml_json, senml_cbor;
+	uint32_t t_tlv, t_json, t_senml_json, t_senml_cbor;
+
+	/* the whole device object instance */
+	set_path(&path, 2U, LWM2M_OBJECT_DEVICE_ID, 0, 0);
+
+	tlv = encode(do_read_op_tlv, &oma_tlv_writer,
+		     LWM2M_FORMAT_OMA_TLV, &path, &t_tlv);
+	json = encode(do_read_op_json, &json_writer,
+		      LWM2M_FORMAT_OMA_JSON, &path, &t_json);
+	senml_json = encode(do_read_op_senml_json, &senml_json_writer,
+			    LWM2M_FORMAT_APP_SENML_JSON, &path,
+			    &t_senml_json);
+	senml_cbor = encode(do_read_op_senml_cbor, &senml_cbor_writer,
+			    LWM2M_FORMAT_APP_SENML_CBOR, &path,
+			    &t_senml_cbor);
+
+	TC_PRINT("/3/0 payload bytes / cycles for %d encodes:\n",
+		 ENCODE_RUNS);
+	TC_PRINT("  OMA TLV    %4u / %u\n", tlv, t_tlv);
+	TC_PRINT("  OMA JSON   %4u / %u\n", json, t_json);
+	TC_PRINT("  SenML JSON %4u / %u\n", senml_json, t_senml_json);
+	TC_PRINT("  SenML CBOR %4u / %u\n", senml_cbor, t_senml_cbor);
+
+	zassert_true(senml_cbor < json, "SenML CBOR larger than OMA JSON");
+	zassert_true(senml_cbor < senml_json,
+		     "SenML CBOR larger than SenML JSON");
+	zassert_true(senml_json < json, "SenML JSON larger than OMA JSON");
+}
+
+static void test_senml_json_record(void)
+{
+	static const char expected[] =
+		"[{\"bn\":\"/3/0/\",\"n\":\"14\",\"vs\":\"+01:00\"}]";
+	struct lwm2m_obj_path path;
+	const uint8_t *payload;
+	uint32_t cycles;
+	uint16_t len;
+
+	set_path(&path, 3U, LWM2M_OBJECT_DEVICE_ID, 0, 14);
+	len = encode(do_read_op_senml_json, &senml_json_writer,
+		     LWM2M_FORMAT_APP_SENML_JSON, &path, &cycles);
+
+	payload = out_payload(&len);
+	zassert_equal(len, sizeof(expected) - 1, "Wrong length %u", len);
+	zassert_mem_equal(payload, expected, len, "Wrong SenML JSON");
+}
+
+static void test_senml_cbor_record(void)
+{
+	/* [{-2: "/3/0/", 0: "14", 3: "+01:00"}] */
+	static const uint8_t expected[] = {
+		0x81, 0xa3,
+		0x21, 0x65, '/', '3', '/', '0', '/',
+		0x00, 0x62, '1', '4',
+		0x03, 0x66, '+', '0', '1', ':', '0', '0',
+	};
+	struct lwm2m_obj_path path;
+	const uint8_t *payload;
+	uint32_t cycles;
+	uint16_t len;
+
+	set_path(&path, 3U, LWM2M_OBJECT_DEVICE_ID, 0, 14);
+	len = encode(do_read_op_senml_cbor, &senml_cbor_writer,
+		     LWM2M_FORMAT_APP_SENML_CBOR, &path, &cycles);
+
+	payload = out_payload(&len);
+	zassert_equal(len, sizeof(expected), "Wrong length %u", len);
+	zassert_mem_equal(payload, expected, len, "Wrong SenML CBOR");
+}
+
+static void test_senml_cbor_write(void)
+{
+	/* [{-2: "/3/0/", 0: "14", 3: "-05:00"}] */
+	static const uint8_t payload[] = {
+		0x81, 0xa3,
+		0x21, 0x65, '/', '3', '/', '0', '/',
+		0x00, 0x62, '1', '4',
+		0x03, 0x66, '-', '0', '5', ':', '0', '0',
+	};
+	char value[sizeof(utc_offset)];
+	int r;
+
+	init_out(&plain_text_writer);
+	set_path(&msg.path, 2U, LWM2M_OBJECT_DEVICE_ID, 0, 0);
+	msg.in.reader = &senml_cbor_reader;
+	init_in(LWM2M_FORMAT_APP_SENML_CBOR, payload, sizeof(payload));
+
+	r = do_write_op_senml_cbor(&msg);
+	zassert_equal(r, 0, "Write failed: %d", r);
+	zassert_equal(msg.path.level, 2U, "Path not restored");
+
+	r = lwm2m_engine_get_string("3/0/14", value, sizeof(value));
+	zassert_equal(r, 0, "Could not read back the value");
+	zassert_true(strcmp(value, "-05:00") == 0, "Wrong value %s", value);
+
+	/* records outside of the request path are rejected */
+	init_out(&plain_text_writer);
+	set_path(&msg.path, 2U, LWM2M_OBJECT_DEVICE_ID, 1, 0);
+	msg.in.reader = &senml_cbor_reader;
+	init_in(LWM2M_FORMAT_APP_SENML_CBOR, payload, sizeof(payload));
+
+	r = do_write_op_senml_cbor(&msg);
+	zassert_true(r < 0, "Write outside of the path accepted");
+
+	(void)lwm2m_engine_set_string("3/0/14", "+01:00");
+}
+
+static void test_composite_read(void)
+{
+	/* [{0: "/3/0/14"}, {0: "/3/0/0"}, {0: "/42/0/0"}] */
+	static const uint8_t request[] = {
+		0x83,
+		0xa1, 0x00, 0x67, '/', '3', '/', '0', '/', '1', '4',
+		0xa1, 0x00, 0x66, '/', '3', '/', '0', '/', '0',
+		0xa1, 0x00, 0x67, '/', '4', '2', '/', '0', '/', '0',
+	};
+	/* [{-2: "/3/0/", 0: "14", 3: "+01:00"}, {0: "0", 3: "Zephyr"}] */
+	static const uint8_t expected[] = {
+		0x82,
+		0xa3, 0x21, 0x65, '/', '3', '/', '0', '/',
+		0x00, 0x62, '1', '4',
+		0x03, 0x66, '+', '0', '1', ':', '0', '0',
+		0xa2, 0x00, 0x61, '0',
+		0x03, 0x66, 'Z', 'e', 'p', 'h', 'y', 'r',
+	};
+	struct lwm2m_obj_path paths[CONFIG_LWM2M_COMPOSITE_PATH_MAX];
+	const uint8_t *payload;
+	uint16_t len;
+	int r;
+
+	init_out(&senml_cbor_writer);
+	msg.in.reader = &senml_cbor_reader;
+	init_in(LWM2M_FORMAT_APP_SENML_CBOR, request, sizeof(request));
+
+	r = senml_cbor_parse_paths(&msg.in, paths, ARRAY_SIZE(paths));
+	zassert_equal(r, 3, "Wrong path count %d", r);
+	zassert_equal(paths[0].level, 3U, "Wrong level");
+	zassert_equal(paths[0].res_id, 14, "Wrong resource");
+	zassert_equal(paths[2].obj_id, 42, "Wrong object");
+
+	/* the unknown object is left out of the result */
+	r = do_composite_read_op_senml_cbor(&msg, paths, r);
+	zassert_equal(r, 0, "Composite read failed: %d", r);
+
+	payload = out_payload(&len);
+	zassert_equal(len, sizeof(expected), "Wrong length %u", len);
+	zassert_mem_equal(payload, expected, len, "Wrong composite result");
+
+	/* too many paths */
+	msg.in.offset = in_cpkt.hdr_len + in_cpkt.opt_len;
+	r = senml_cbor_parse_paths(&msg.in, paths, 2);
+	zassert_equal(r, -EFBIG, "Path overflow not detected");
+
+	/* truncated request */
+	init_in(LWM2M_FORMAT_APP_SENML_CBOR, request, sizeof(request) - 3);
+	r = senml_cbor_parse_paths(&msg.in, paths, ARRAY_SIZE(paths));
+	zassert_true(r < 0, "Truncated request accepted");
+}
+
+void test_main(void)
+{
+	lwm2m_engine_set_res_data("3/0/0", "Zephyr", sizeof("Zephyr"),
+				  LWM2M_RES_DATA_FLAG_RO);
+	lwm2m_engine_set_res_data("3/0/1", "OMA-LWM2M Sample Client",
+				  sizeof("OMA-LWM2M Sample Client"),
+				  LWM2M_RES_DATA_FLAG_RO);
+	lwm2m_engine_set_res_data("3/0/2", "345000123",
+				  sizeof("345000123"),
+				  LWM2M_RES_DATA_FLAG_RO);
+	lwm2m_engine_set_res_data("3/0/3", "1.0", sizeof("1.0"),
+				  LWM2M_RES_DATA_FLAG_RO);
+	lwm2m_engine_set_res_data("3/0/14", utc_offset, sizeof(utc_offset),
+				  0);
+
+	ztest_test_suite(lwm2m_senml,
+			 ztest_unit_test(test_size_and_speed),
+			 ztest_unit_test(test_senml_json_record),
+			 ztest_unit_test(test_senml_cbor_record),
+			 ztest_unit_test(test_senml_cbor_write),
+			 ztest_unit_test(test_composite_read));
+
+	ztest_run_test_suite(lwm2m_senml);
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_MQTT_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/mqtt.h>
+
+#define BROKER_ADDR "192.0.2.1"
+#define BROKER_PORT 1883
+
+#define TOPIC "sensors"
+#define PAYLOAD_LEN 32
+#define THROUGHPUT_COUNT 256
+
+#define WAIT_TIME_MS 2000
+
+#define BROKER_STACK_SIZE 2048
+#define BROKER_PRIORITY K_PRIO_PREEMPT(8)
+
+/* Minimal broker stand-in, answering CONNECT, PUBLISH, PUBREL and
+ * PINGREQ. PUBACK and PUBREC can be held back to let the client window
+ * fill up.
+ */
+static struct {
+	int listen_sock;
+	int sock;
+	bool hold;
+	uint16_t held[CONFIG_MQTT_INFLIGHT_COUNT * 2];
+	int held_count;
+	atomic_t publishes;
+	atomic_t dups;
+	atomic_t pubrels;
+} broker;
+
+static uint8_t rx_buffer[256];
+static uint8_t tx_buffer[256];
+static uint8_t payload[PAYLOAD_LEN];
+static struct mqtt_client client;
+static struct sockaddr_storage broker_addr;
+
+static bool connected;
+static int pubacks;
+static int pubrecs;
+static int pubcomps;
+
+K_THREAD_STACK_DEFINE(broker_stack, BROKER_STACK_SIZE);
+static struct k_thread broker_thread;
+
+static int broker_recv_all(uint8_t *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t ret = recv(broker.sock, buf, len, 0);
+
+		if (ret <= 0) {
+			return -ENOTCONN;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void broker_send_id(uint8_t type, uint16_t message_id)
+{
+	uint8_t packet[] = { type, 2, message_id >> 8, message_id & 0xff };
+
+	(void)send(broker.sock, packet, sizeof(packet), 0);
+}
+
+static void broker_publish(uint8_t flags, const uint8_t *body, size_t len)
+{
+	uint8_t qos = (flags >> 1) & 0x03;
+	size_t topic_len = (body[0] << 8) | body[1];
+	uint16_t message_id;
+
+	atomic_inc(&broker.publishes);
+
+	if (qos == 0U) {
+		return;
+	}
+
+	if (len < topic_len + 4) {
+		return;
+	}
+
+	message_id = (body[topic_len + 2] << 8) | body[topic_len + 3];
+
+	if (flags & 0x08) {
+		atomic_inc(&broker.dups);
+	}
+
+	if (broker.hold) {
+		if (broker.held_count < ARRAY_SIZE(broker.held)) {
+			broker.held[broker.held_count++] = message_id;
+		}
+
+		return;
+	}
+
+	broker_send_id(qos == 1U ? 0x40 : 0x50, message_id);
+}
+
+static void broker_release(void)
+{
+	broker.hold = false;
+
+	for (int i = 0; i < broker.held_count; i++) {
+		broker_send_id(0x40, broker.held[i]);
+	}
+
+	broker.held_count = 0;
+}
+
+static void broker_run(void *p1, void *p2, void *p3)
+{
+	static const uint8_t connack[] = { 0x20, 0x02, 0x00, 0x00 };
+	static const uint8_t pingresp[] = { 0xd0, 0x00 };
+	uint8_t body[128];
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	broker.sock = accept(broker.listen_sock, NULL, NULL);
+	if (broker.sock < 0) {
+		return;
+	}
+
+	while (true) {
+		uint8_t type;
+		uint32_t len = 0;
+		uint8_t byte;
+		int shift = 0;
+
+		if (broker_recv_all(&type, 1) < 0) {
+			break;
+		}
+
+		do {
+			if (broker_recv_all(&byte, 1) < 0) {
+				goto out;
+			}
+
+			len |= (byte & 0x7f) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+
+		if (len > sizeof(body) || broker_recv_all(body, len) < 0) {
+			break;
+		}
+
+		switch (type & 0xf0) {
+		case 0x10:
+			send(broker.sock, connack, sizeof(connack), 0);
+			break;
+		case 0x30:
+			broker_publish(type & 0x0f, body, len);
+			break;
+		case 0x60:
+			atomic_inc(&broker.pubrels);
+			broker_send_id(0x70, (body[0] << 8) | body[1]);
+			break;
+		case 0xc0:
+			send(broker.sock, pingresp, sizeof(pingresp), 0);
+			break;
+		default:
+			break;
+		}
+	}
+
+out:
+	close(broker.sock);
+}
+
+static void mqtt_evt_handler(struct mqtt_client *const c,
+			     const struct mqtt_evt *evt)
+{
+	switch (evt->type) {
+	case MQTT_EVT_CONNACK:
+		connected = (evt->result == 0);
+		break;
+	case MQTT_EVT_DISCONNECT:
+		connected = false;
+		break;
+	case MQTT_EVT_PUBACK:
+		pubacks++;
+		break;
+	case MQTT_EVT_PUBREC: {
+		const struct mqtt_pubrel_param rel = {
+			.message_id = evt->param.pubrec.message_id,
+		};
+
+		/* Already done by the library, must not send a second one. */
+		zassert_equal(mqtt_publish_qos2_release(c, &rel), 0,
+			      "Release failed");
+		pubrecs++;
+		break;
+	}
+	case MQTT_EVT_PUBCOMP:
+		pubcomps++;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Process client input until the condition is met or time runs out. */
+#define PROCESS_UNTIL(cond)						\
+	do {								\
+		int64_t end = k_uptime_get() + WAIT_TIME_MS;		\
+									\
+		while (!(cond) && k_uptime_get() < end) {		\
+			process_input(10);				\
+		}							\
+		zassert_true(cond, "Timeout waiting for " #cond);	\
+	} while (0)
+
+static void process_input(int timeout)
+{
+	struct pollfd fds = {
+		.fd = client.transport.tcp.sock,
+		.events = POLLIN,
+	};
+
+	if (poll(&fds, 1, timeout) > 0) {
+		zassert_equal(mqtt_input(&client), 0, "Input failed");
+	}
+}
+
+static void set_publish(struct mqtt_publish_param *param, uint8_t qos,
+			uint16_t message_id)
+{
+	memset(param, 0, sizeof(*param));
+
+	param->message.topic.qos = qos;
+	param->message.topic.topic.utf8 = (uint8_t *)TOPIC;
+	param->message.topic.topic.size = strlen(TOPIC);
+	param->message.payload.data = payload;
+	param->message.payload.len = sizeof(payload);
+	param->message_id = message_id;
+}
+
+static void test_connect(void)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons(BROKER_PORT),
+	};
+	struct sockaddr_in *broker4 = (struct sockaddr_in *)&broker_addr;
+
+	inet_pton(AF_INET, BROKER_ADDR, &addr.sin_addr);
+	memcpy(broker4, &addr, sizeof(addr));
+
+	broker.listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(broker.listen_sock >= 0, "Cannot create socket");
+	zassert_equal(bind(broker.listen_sock, (struct sockaddr *)&addr,
+			   sizeof(addr)), 0, "Cannot bind");
+	zassert_equal(listen(broker.listen_sock, 1), 0, "Cannot listen");
+
+	k_thread_create(&broker_thread, broker_stack,
+			K_THREAD_STACK_SIZEOF(broker_stack), broker_run,
+			NULL, NULL, NULL, BROKER_PRIORITY, 0, K_NO_WAIT);
+
+	mqtt_client_init(&client);
+
+	client.broker = &broker_addr;
+	client.evt_cb = mqtt_evt_handler;
+	client.client_id.utf8 = (uint8_t *)"zephyr_inflight";
+	client.client_id.size = strlen("zephyr_inflight");
+	client.protocol_version = MQTT_VERSION_3_1_1;
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.rx_buf = rx_buffer;
+	client.rx_buf_size = sizeof(rx_buffer);
+	client.tx_buf = tx_buffer;
+	client.tx_buf_size = sizeof(tx_buffer);
+
+	zassert_equal(mqtt_connect(&client), 0, "Connect failed");
+	PROCESS_UNTIL(connected);
+
+	zassert_equal(mqtt_inflight_count(&client), 0, "Window not empty");
+}
+
+static void test_window(void)
+{
+	struct mqtt_publish_param param;
+
+	broker.hold = true;
+	pubacks = 0;
+
+	for (int i = 1; i <= CONFIG_MQTT_INFLIGHT_COUNT; i++) {
+		set_publish(&param, MQTT_QOS_1_AT_LEAST_ONCE, i);
+		zassert_equal(mqtt_publish(&client, &param), 0,
+			      "Publish %d failed", i);
+	}
+
+	zassert_equal(mqtt_inflight_count(&client), CONFIG_MQTT_INFLIGHT_COUNT,
+		      "Messages not tracked");
+
+	set_publish(&param, MQTT_QOS_1_AT_LEAST_ONCE,
+		    CONFIG_MQTT_INFLIGHT_COUNT + 1);
+	zassert_equal(mqtt_publish(&client, &param), -EAGAIN,
+		      "Publish allowed with full window");
+
+	/* QoS 0 messages are not limited by the window. */
+	set_publish(&param, MQTT_QOS_0_AT_MOST_ONCE, 0);
+	zassert_equal(mqtt_publish(&client, &param), 0, "QoS 0 blocked");
+
+	PROCESS_UNTIL(atomic_get(&broker.publishes) ==
+		      CONFIG_MQTT_INFLIGHT_COUNT + 1);
+
+	broker_release();
+
+	PROCESS_UNTIL(mqtt_inflight_count(&client) == 0);
+	zassert_equal(pubacks, CONFIG_MQTT_INFLIGHT_COUNT, "Acks lost");
+}
+
+static void test_retransmit(void)
+{
+	struct mqtt_publish_param param;
+
+	broker.hold = true;
+	atomic_set(&broker.publishes, 0);
+	atomic_set(&broker.dups, 0);
+
+	set_publish(&param, MQTT_QOS_1_AT_LEAST_ONCE, 10);
+	zassert_equal(mqtt_publish(&client, &param), 0, "Publish failed");
+
+	PROCESS_UNTIL(atomic_get(&broker.publishes) == 1);
+
+	/* Not acknowledged in time, sent again with the DUP flag. */
+	k_msleep(CONFIG_MQTT_INFLIGHT_RETRANSMIT_TIMEOUT + 10);
+	(void)mqtt_live(&client);
+
+	PROCESS_UNTIL(atomic_get(&broker.dups) == 1);
+	zassert_equal(atomic_get(&broker.publishes), 2, "Not retransmitted");
+	zassert_equal(mqtt_inflight_count(&client), 1, "Message dropped");
+
+	broker_release();
+
+	PROCESS_UNTIL(mqtt_inflight_count(&client) == 0);
+}
+
+static void test_qos2(void)
+{
+	struct mqtt_publish_param param;
+
+	pubrecs = 0;
+	pubcomps = 0;
+	atomic_set(&broker.pubrels, 0);
+
+	set_publish(&param, MQTT_QOS_2_EXACTLY_ONCE, 20);
+	zassert_equal(mqtt_publish(&client, &param), 0, "Publish failed");
+
+	PROCESS_UNTIL(pubcomps == 1);
+	zassert_equal(pubrecs, 1, "No PUBREC");
+	zassert_equal(atomic_get(&broker.pubrels), 1, "Wrong PUBREL count");
+	zassert_equal(mqtt_inflight_count(&client), 0, "Message not released");
+}
+
+static void test_batch(void)
+{
+	struct mqtt_publish_param params[CONFIG_MQTT_INFLIGHT_COUNT * 2];
+	int ret;
+
+	atomic_set(&broker.publishes, 0);
+	pubacks = 0;
+
+	for (int i = 0; i < ARRAY_SIZE(params); i++) {
+		set_publish(&params[i], MQTT_QOS_1_AT_LEAST_ONCE, 100 + i);
+	}
+
+	/* Window is not large enough for all the messages. */
+	ret = mqtt_publish_batch(&client, params, ARRAY_SIZE(params));
+	zassert_equal(ret, CONFIG_MQTT_INFLIGHT_COUNT, "Wrong count %d", ret);
+
+	PROCESS_UNTIL(mqtt_inflight_count(&client) == 0);
+
+	ret = mqtt_publish_batch(&client, &params[ret],
+				 ARRAY_SIZE(params) - ret);
+	zassert_equal(ret, ARRAY_SIZE(params) - CONFIG_MQTT_INFLIGHT_COUNT,
+		      "Wrong count %d", ret);
+
+	PROCESS_UNTIL(pubacks == ARRAY_SIZE(params));
+	zassert_equal(atomic_get(&broker.publishes), ARRAY_SIZE(params),
+		      "Messages lost");
+
+	/* More QoS 0 messages than fit in one batch. */
+	for (int i = 0; i < ARRAY_SIZE(params); i++) {
+		set_publish(&params[i], MQTT_QOS_0_AT_MOST_ONCE, 0);
+	}
+
+	ret = mqtt_publish_batch(&client, params, ARRAY_SIZE(params));
+	zassert_equal(ret, ARRAY_SIZE(params), "Wrong count %d", ret);
+
+	PROCESS_UNTIL(atomic_get(&broker.publishes) ==
+		      2 * ARRAY_SIZE(params));
+}
+
+static void test_throughput(void)
+{
+	struct mqtt_publish_param params[CONFIG_MQTT_INFLIGHT_COUNT];
+	uint16_t message_id = 1000;
+	int64_t start;
+	int64_t stop_and_wait;
+	int64_t windowed;
+	int sent;
+
+	atomic_set(&broker.publishes, 0);
+
+	/* One message at a time, waiting for each acknowledgment. */
+	start = k_uptime_get();
+
+	for (sent = 0; sent < THROUGHPUT_COUNT; sent++) {
+		set_publish(&params[0], MQTT_QOS_1_AT_LEAST_ONCE,
+			    message_id++);
+		zassert_equal(mqtt_publish(&client, &params[0]), 0,
+			      "Publish failed");
+		PROCESS_UNTIL(mqtt_inflight_count(&client) == 0);
+	}
+
+	stop_and_wait = k_uptime_get() - start;
+
+	/* Fill the window in batches, and refill it as acks arrive. */
+	start = k_uptime_get();
+
+	for (sent = 0; sent < THROUGHPUT_COUNT; ) {
+		int count = MIN(ARRAY_SIZE(params), THROUGHPUT_COUNT - sent);
+		int ret;
+
+		for (int i = 0; i < count; i++) {
+			set_publish(&params[i], MQTT_QOS_1_AT_LEAST_ONCE,
+				    message_id + i);
+		}
+
+		ret = mqtt_publish_batch(&client, params, count);
+		if (ret > 0) {
+			sent += ret;
+			message_id += ret;
+		} else {
+			zassert_equal(ret, -EAGAIN, "Publish failed %d", ret);
+		}
+
+		process_input(10);
+	}
+
+	PROCESS_UNTIL(mqtt_inflight_count(&client) == 0);
+
+	windowed = k_uptime_get() - start;
+
+	zassert_equal(atomic_get(&broker.publishes), 2 * THROUGHPUT_COUNT,
+		      "Messages lost");
+
+	TC_PRINT("%d messages: %u ms one by one, %u ms with a window "
+		 "of %d\n", THROUGHPUT_COUNT, (uint32_t)stop_and_wait,
+		 (uint32_t)windowed, CONFIG_MQTT_INFLIGHT_COUNT);
+}
+
+static void test_disconnect(void)
+{
+	zassert_equal(mqtt_disconnect(&client), 0, "Disconnect failed");
+	zassert_false(connected, "Still connected");
+
+	close(broker.listen_sock);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_inflight,
+			 ztest_unit_test(test_connect),
+			 ztest_unit_test(test_window),
+			 ztest_unit_test(test_retransmit),
+			 ztest_unit_test(test_qos2),
+			 ztest_unit_test(test_batch),
+			 ztest_unit_test(test_throughput),
+			 ztest_unit_test(test_disconnect));
+
+	ztest_run_test_suite(mqtt_inflight);
+}
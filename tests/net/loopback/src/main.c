@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_LOOPBACK_LOG_LEVEL);
+
+#include <ztest.h>
+#include <net/socket.h>
+#include <net/dummy.h>
+#include <net/net_pkt.h>
+
+#define TEST_PORT 4242
+/* Fits the loopback MTU */
+#define PAYLOAD_MAX 480
+
+#define ROUND_TRIPS 500
+#define TCP_CHUNK PAYLOAD_MAX
+#define TCP_TOTAL (64 * 1024)
+
+static uint8_t tx_buf[PAYLOAD_MAX];
+static uint8_t rx_buf[PAYLOAD_MAX];
+
+/* A second DUMMY interface, that only records the UDP checksum it sends */
+static uint16_t sent_chksum;
+static K_SEM_DEFINE(sent_sem, 0, 1);
+
+static int dummy_dev_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return 0;
+}
+
+static void dummy_iface_init(struct net_if *iface)
+{
+	net_if_set_link_addr(iface, "\x00\x00\x5e\x00\x53\x01", 6,
+			     NET_LINK_DUMMY);
+}
+
+static int dummy_send(const struct device *dev, struct net_pkt *pkt)
+{
+	ARG_UNUSED(dev);
+
+	if (net_pkt_family(pkt) != AF_INET ||
+	    NET_IPV4_HDR(pkt)->proto != IPPROTO_UDP) {
+		return 0;
+	}
+
+	/* UDP checksum, after the IPv4 header and the ports and length */
+	net_pkt_cursor_init(pkt);
+	if (net_pkt_skip(pkt, net_pkt_ip_hdr_len(pkt) + 6) ||
+	    net_pkt_read_be16(pkt, &sent_chksum)) {
+		return -EINVAL;
+	}
+
+	k_sem_give(&sent_sem);
+
+	return 0;
+}
+
+static struct dummy_api dummy_api = {
+	.iface_api.init = dummy_iface_init,
+
+	.send = dummy_send,
+};
+
+NET_DEVICE_INIT(test_dummy, "test_dummy",
+		dummy_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&dummy_api, DUMMY_L2,
+		NET_L2_GET_CTX_TYPE(DUMMY_L2), 536);
+
+static uint8_t pattern(size_t offset)
+{
+	return offset % 251;
+}
+
+static void fill_pattern(uint8_t *buf, size_t len, size_t offset)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = pattern(offset + i);
+	}
+}
+
+static void make_addr(int family, struct sockaddr *addr, uint16_t port)
+{
+	memset(addr, 0, sizeof(struct sockaddr_in6));
+
+	if (family == AF_INET) {
+		struct sockaddr_in *addr4 = (struct sockaddr_in *)addr;
+
+		addr4->sin_family = AF_INET;
+		addr4->sin_port = htons(port);
+		inet_pton(AF_INET, "192.0.2.1", &addr4->sin_addr);
+	} else {
+		struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)addr;
+
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_port = htons(port);
+		inet_pton(AF_INET6, "2001:db8::1", &addr6->sin6_addr);
+	}
+}
+
+static socklen_t addr_len(int family)
+{
+	return family == AF_INET ? sizeof(struct sockaddr_in) :
+				   sizeof(struct sockaddr_in6);
+}
+
+static void udp_pair(int family, int *a, int *b, struct sockaddr *addr_a,
+		     struct sockaddr *addr_b)
+{
+	int ret;
+
+	make_addr(family, addr_a, TEST_PORT);
+	make_addr(family, addr_b, TEST_PORT + 1);
+
+	*a = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+	*b = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(*a >= 0 && *b >= 0, "Could not create the sockets");
+
+	ret = bind(*a, addr_a, addr_len(family));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+	ret = bind(*b, addr_b, addr_len(family));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+}
+
+static void udp_integrity(int family)
+{
+	static const size_t sizes[] = { 1, 7, 64, 255, 256, PAYLOAD_MAX };
+	struct sockaddr_in6 addr_a, addr_b;
+	ssize_t ret;
+	int a, b, i;
+
+	udp_pair(family, &a, &b, (struct sockaddr *)&addr_a,
+		 (struct sockaddr *)&addr_b);
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		size_t len = sizes[i];
+
+		fill_pattern(tx_buf, len, len);
+
+		ret = sendto(a, tx_buf, len, 0, (struct sockaddr *)&addr_b,
+			     addr_len(family));
+		zassert_equal(ret, len, "Send failed (%d)", errno);
+
+		ret = recv(b, rx_buf, sizeof(rx_buf), 0);
+		zassert_equal(ret, len, "Wrong length received");
+		zassert_mem_equal(rx_buf, tx_buf, len, "Data corrupted");
+	}
+
+	(void)close(a);
+	(void)close(b);
+}
+
+static void test_udp_ipv4(void)
+{
+	udp_integrity(AF_INET);
+}
+
+static void test_udp_ipv6(void)
+{
+	udp_integrity(AF_INET6);
+}
+
+static void test_tcp_stream(void)
+{
+	struct sockaddr_in6 addr;
+	int listen_sock, client, server;
+	size_t sent = 0, received = 0;
+	uint32_t start, cycles;
+	ssize_t ret;
+
+	make_addr(AF_INET, (struct sockaddr *)&addr, TEST_PORT);
+
+	listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(listen_sock >= 0, "Could not create the socket");
+	ret = bind(listen_sock, (struct sockaddr *)&addr,
+		   addr_len(AF_INET));
+	zassert_equal(ret, 0, "Could not bind (%d)", errno);
+	ret = listen(listen_sock, 1);
+	zassert_equal(ret, 0, "Could not listen (%d)", errno);
+
+	client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	zassert_true(client >= 0, "Could not create the socket");
+	ret = connect(client, (struct sockaddr *)&addr, addr_len(AF_INET));
+	zassert_equal(ret, 0, "Could not connect (%d)", errno);
+
+	server = accept(listen_sock, NULL, NULL);
+	zassert_true(server >= 0, "Could not accept (%d)", errno);
+
+	start = k_cycle_get_32();
+
+	while (received < TCP_TOTAL) {
+		size_t len;
+
+		if (sent < TCP_TOTAL) {
+			fill_pattern(tx_buf, TCP_CHUNK, sent);
+			ret = send(client, tx_buf, TCP_CHUNK, 0);
+			zassert_true(ret > 0, "Send failed (%d)", errno);
+			sent += ret;
+		}
+
+		ret = recv(server, rx_buf, TCP_CHUNK, 0);
+		zassert_true(ret > 0, "Receive failed (%d)", errno);
+
+		for (len = 0; len < ret; len++) {
+			zassert_equal(rx_buf[len], pattern(received + len),
+				      "Data corrupted at %zd", received + len);
+		}
+
+		received += ret;
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("tcp: %d bytes in %u cycles\n", TCP_TOTAL, cycles);
+
+	(void)close(client);
+	(void)close(server);
+	(void)close(listen_sock);
+}
+
+static void test_udp_round_trip(void)
+{
+	struct sockaddr_in6 addr_a, addr_b;
+	uint32_t start, cycles;
+	ssize_t ret;
+	int a, b, i;
+
+	udp_pair(AF_INET, &a, &b, (struct sockaddr *)&addr_a,
+		 (struct sockaddr *)&addr_b);
+
+	fill_pattern(tx_buf, 64, 0);
+	start = k_cycle_get_32();
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		ret = sendto(a, tx_buf, 64, 0, (struct sockaddr *)&addr_b,
+			     addr_len(AF_INET));
+		zassert_equal(ret, 64, "Send failed (%d)", errno);
+		ret = recv(b, rx_buf, sizeof(rx_buf), 0);
+		zassert_equal(ret, 64, "Receive failed (%d)", errno);
+
+		ret = sendto(b, rx_buf, 64, 0, (struct sockaddr *)&addr_a,
+			     addr_len(AF_INET));
+		zassert_equal(ret, 64, "Send failed (%d)", errno);
+		ret = recv(a, rx_buf, sizeof(rx_buf), 0);
+		zassert_equal(ret, 64, "Receive failed (%d)", errno);
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	zassert_mem_equal(rx_buf, tx_buf, 64, "Data corrupted");
+
+	TC_PRINT("udp: %d round trips in %u cycles (%u per round trip)\n",
+		 ROUND_TRIPS, cycles, cycles / ROUND_TRIPS);
+
+	(void)close(a);
+	(void)close(b);
+}
+
+/* Datagrams nobody reads must not keep the TX pool for themselves */
+static void test_unread_tx_pool(void)
+{
+	struct sockaddr_in6 addr_a, addr_b;
+	struct k_mem_slab *tx;
+	ssize_t ret;
+	int a, b, i;
+
+	if (!IS_ENABLED(CONFIG_NET_LOOPBACK_ZERO_COPY)) {
+		ztest_test_skip();
+	}
+
+	net_pkt_get_info(NULL, &tx, NULL, NULL);
+
+	udp_pair(AF_INET, &a, &b, (struct sockaddr *)&addr_a,
+		 (struct sockaddr *)&addr_b);
+
+	fill_pattern(tx_buf, 64, 0);
+
+	for (i = 0; i < CONFIG_NET_PKT_TX_COUNT; i++) {
+		ret = sendto(a, tx_buf, 64, 0, (struct sockaddr *)&addr_b,
+			     addr_len(AF_INET));
+		zassert_equal(ret, 64, "Send %d failed (%d)", i, errno);
+	}
+
+	zassert_true(k_mem_slab_num_free_get(tx) > 0, "TX pool exhausted");
+
+	/* the other direction still works */
+	ret = sendto(b, tx_buf, 64, 0, (struct sockaddr *)&addr_a,
+		     addr_len(AF_INET));
+	zassert_equal(ret, 64, "Send failed (%d)", errno);
+	ret = recv(a, rx_buf, sizeof(rx_buf), 0);
+	zassert_equal(ret, 64, "Receive failed (%d)", errno);
+
+	(void)close(a);
+	(void)close(b);
+}
+
+/* Only the loopback interface may skip the checksums */
+static void test_checksum_ifaces(void)
+{
+	struct in_addr addr = { { { 198, 51, 100, 1 } } };
+	struct in_addr netmask = { { { 255, 255, 255, 0 } } };
+	struct sockaddr_in dst = {
+		.sin_family = AF_INET,
+		.sin_port = htons(TEST_PORT),
+		.sin_addr = { { { 198, 51, 100, 2 } } },
+	};
+	struct net_if *lo, *iface;
+	ssize_t ret;
+	int sock;
+
+	lo = net_if_lookup_by_dev(device_get_binding("lo"));
+	iface = net_if_lookup_by_dev(device_get_binding("test_dummy"));
+	zassert_not_null(lo, "No loopback interface");
+	zassert_not_null(iface, "No test interface");
+
+	zassert_equal(net_if_need_calc_tx_checksum(lo),
+		      !IS_ENABLED(CONFIG_NET_LOOPBACK_SKIP_CHECKSUM),
+		      "Wrong loopback TX checksum");
+	zassert_equal(net_if_need_calc_rx_checksum(lo),
+		      !IS_ENABLED(CONFIG_NET_LOOPBACK_SKIP_CHECKSUM),
+		      "Wrong loopback RX checksum");
+	zassert_true(net_if_need_calc_tx_checksum(iface),
+		     "TX checksum skipped on another DUMMY interface");
+	zassert_true(net_if_need_calc_rx_checksum(iface),
+		     "RX checksum skipped on another DUMMY interface");
+
+	zassert_not_null(net_if_ipv4_addr_add(iface, &addr, NET_ADDR_MANUAL,
+					      0),
+			 "Could not add the address");
+	net_if_ipv4_set_netmask(iface, &netmask);
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	zassert_true(sock >= 0, "Could not create the socket");
+
+	fill_pattern(tx_buf, 64, 0);
+	ret = sendto(sock, tx_buf, 64, 0, (struct sockaddr *)&dst,
+		     sizeof(dst));
+	zassert_equal(ret, 64, "Send failed (%d)", errno);
+
+	zassert_equal(k_sem_take(&sent_sem, K_SECONDS(1)), 0,
+		      "Nothing sent on the test interface");
+	zassert_not_equal(sent_chksum, 0, "UDP checksum not calculated");
+
+	(void)close(sock);
+	(void)net_if_ipv4_addr_rm(iface, &addr);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(loopback,
+			 ztest_unit_test(test_udp_ipv4),
+			 ztest_unit_test(test_udp_ipv6),
+			 ztest_unit_test(test_tcp_stream),
+			 ztest_unit_test(test_udp_round_trip),
+			 ztest_unit_test(test_unread_tx_pool),
+			 ztest_unit_test(test_checksum_ifaces));
+
+	ztest_run_test_suite(loopback);
+}
@@ -16,6 +16,7 @@ LOG_MODULE_REGISTER(net_test, CONFIG_NET_MGMT_EVENT_LOG_LEVEL);
 #include <net/dummy.h>
 #include <net/net_mgmt.h>
 #include <net/net_pkt.h>
+#include <irq_offload.h>
 #include <ztest.h>
 
 #define THREAD_SLEEP 50 /* ms */
@@ -24,6 +25,7 @@ LOG_MODULE_REGISTER(net_test, CONFIG_NET_MGMT_EVENT_LOG_LEVEL);
 #define TEST_MGMT_REQUEST		0x17AB1234
 #define TEST_MGMT_EVENT			0x97AB1234
 #define TEST_MGMT_EVENT_UNHANDLED	0x97AB4321
+#define TEST_MGMT_EVENT_OTHER_CODE	0x97AC1234
 #define TEST_MGMT_EVENT_INFO_SIZE	\
 	MAX(sizeof(TEST_INFO_STRING), sizeof(struct in6_addr))
 
@@ -234,6 +236,72 @@ static int test_synchronous_event_listener(uint32_t times, bool on_iface)
 	return TC_PASS;
 }
 
+static void isr_notify(const void *param)
+{
+	ARG_UNUSED(param);
+
+	net_mgmt_event_notify(TEST_MGMT_EVENT, NULL);
+}
+
+static int test_sending_event_isr(uint32_t times, uint32_t expected)
+{
+	uint32_t i;
+
+	TC_PRINT("- Sending event %u times from ISR\n", times);
+
+	with_info = false;
+
+	net_mgmt_add_event_callback(&rx_cb);
+
+	/* The events are all queued before the net_mgmt thread runs */
+	for (i = 0U; i < times; i++) {
+		irq_offload(isr_notify, NULL);
+	}
+
+	k_msleep(THREAD_SLEEP);
+
+	zassert_equal(rx_event, TEST_MGMT_EVENT, "rx_event check failed");
+	zassert_equal(rx_calls, expected, "rx_calls check failed");
+
+	net_mgmt_del_event_callback(&rx_cb);
+	rx_event = rx_calls = 0U;
+
+	return TC_PASS;
+}
+
+static int test_other_layer_code(void)
+{
+	struct net_mgmt_event_callback other_cb;
+
+	TC_PRINT("- Sending events of two layer codes\n");
+
+	with_info = false;
+
+	net_mgmt_init_event_callback(&other_cb, receiver_cb,
+				     TEST_MGMT_EVENT_OTHER_CODE);
+	net_mgmt_add_event_callback(&other_cb);
+	net_mgmt_add_event_callback(&rx_cb);
+
+	net_mgmt_event_notify(TEST_MGMT_EVENT, NULL);
+	k_msleep(THREAD_SLEEP);
+
+	zassert_equal(rx_event, TEST_MGMT_EVENT, "rx_event check failed");
+	zassert_equal(rx_calls, 1, "rx_calls check failed");
+
+	net_mgmt_event_notify(TEST_MGMT_EVENT_OTHER_CODE, NULL);
+	k_msleep(THREAD_SLEEP);
+
+	zassert_equal(rx_event, TEST_MGMT_EVENT_OTHER_CODE,
+		      "rx_event check failed");
+	zassert_equal(rx_calls, 2, "rx_calls check failed");
+
+	net_mgmt_del_event_callback(&other_cb);
+	net_mgmt_del_event_callback(&rx_cb);
+	rx_event = rx_calls = 0U;
+
+	return TC_PASS;
+}
+
 static void initialize_event_tests(void)
 {
 	event2throw = 0U;
@@ -341,6 +409,17 @@ void test_mgmt(void)
 	zassert_false(test_sending_event_info(2, true),
 		      "test_sending_event failed");
 
+	zassert_false(test_sending_event_isr(1, 1),
+		      "test_sending_event_isr failed");
+
+	/* The events that do not fit in the queue are dropped */
+	zassert_false(test_sending_event_isr(CONFIG_NET_MGMT_EVENT_QUEUE_SIZE + 2,
+					     CONFIG_NET_MGMT_EVENT_QUEUE_SIZE),
+		      "test_sending_event_isr failed");
+
+	zassert_false(test_other_layer_code(),
+		      "test_other_layer_code failed");
+
 	zassert_false(test_core_event(NET_EVENT_IPV6_ADDR_ADD, _iface_ip6_add),
 		      "test_core_event failed");
 
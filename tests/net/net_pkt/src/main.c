@@ -974,6 +974,79 @@ static void test_net_pkt_get_contiguous_len(void)
 	net_pkt_unref(pkt);
 }
 
+static void test_net_pkt_get_iovec(void)
+{
+	struct iovec iov[4];
+	struct net_pkt *pkt;
+	int count;
+
+	/* Allocate pkt with 3 fragments */
+	pkt = net_pkt_rx_alloc_with_buffer(NULL, CONFIG_NET_BUF_DATA_SIZE * 3,
+					   AF_UNSPEC, 0, K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_pkt_get_iovec(pkt, iov, ARRAY_SIZE(iov)), 0,
+		      "Empty packet has data");
+
+	zassert_equal(net_pkt_write(pkt, small_buffer,
+				    CONFIG_NET_BUF_DATA_SIZE * 2 + 10), 0,
+		      "Write packet failed");
+
+	net_pkt_cursor_init(pkt);
+	count = net_pkt_get_iovec(pkt, iov, ARRAY_SIZE(iov));
+	zassert_equal(count, 3, "Expected one entry per fragment");
+	zassert_equal(iov[0].iov_base, pkt->buffer->data, "Wrong base");
+	zassert_equal(iov[0].iov_len, CONFIG_NET_BUF_DATA_SIZE, "Wrong length");
+	zassert_equal(iov[2].iov_base, pkt->buffer->frags->frags->data,
+		      "Wrong base");
+	zassert_equal(iov[2].iov_len, 10, "Wrong length");
+
+	/* The view starts at the cursor, which is not moved */
+	net_pkt_set_overwrite(pkt, true);
+	zassert_equal(net_pkt_skip(pkt, CONFIG_NET_BUF_DATA_SIZE + 4), 0,
+		      "Skip failed");
+	count = net_pkt_get_iovec(pkt, iov, ARRAY_SIZE(iov));
+	zassert_equal(count, 2, "Expected the remaining fragments");
+	zassert_equal(iov[0].iov_base, pkt->cursor.pos, "Wrong base");
+	zassert_equal(iov[0].iov_len, CONFIG_NET_BUF_DATA_SIZE - 4,
+		      "Wrong length");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_pkt_get_iovec(pkt, iov, 2), -E2BIG,
+		      "Too small vector accepted");
+
+	net_pkt_unref(pkt);
+}
+
+static void test_net_pkt_l2_headroom(void)
+{
+	NET_PKT_DATA_ACCESS_DEFINE(ipv4_access, struct net_ipv4_hdr);
+	struct net_ipv4_hdr *hdr;
+	struct net_pkt *pkt;
+
+	if (!IS_ENABLED(CONFIG_NET_PKT_L2_HEADROOM)) {
+		ztest_test_skip();
+		return;
+	}
+
+	pkt = net_pkt_alloc_with_buffer(eth_if, 32, AF_INET, IPPROTO_UDP,
+					K_NO_WAIT);
+	zassert_not_null(pkt, "Pkt not allocated");
+
+	zassert_true(net_buf_headroom(pkt->buffer) >= L2_HDR_SIZE,
+		     "No room for the L2 header");
+	zassert_true(pkt_is_of_size(pkt, 32 + NET_IPV4H_LEN + NET_UDPH_LEN),
+		     "Headroom taken from the requested size");
+
+	/* The IP header is accessed in place */
+	hdr = (struct net_ipv4_hdr *)net_pkt_get_data(pkt, &ipv4_access);
+	zassert_equal_ptr(hdr, pkt->buffer->data, "IP header copied");
+	zassert_equal((uintptr_t)hdr % 4, 0, "IP header not aligned");
+
+	net_pkt_unref(pkt);
+}
+
 void test_main(void)
 {
 	eth_if = net_if_get_default();
@@ -989,7 +1062,9 @@ void test_main(void)
 			 ztest_unit_test(test_net_pkt_clone),
 			 ztest_unit_test(test_net_pkt_headroom),
 			 ztest_unit_test(test_net_pkt_headroom_copy),
-			 ztest_unit_test(test_net_pkt_get_contiguous_len)
+			 ztest_unit_test(test_net_pkt_get_contiguous_len),
+			 ztest_unit_test(test_net_pkt_get_iovec),
+			 ztest_unit_test(test_net_pkt_l2_headroom)
 		);
 
 	ztest_run_test_suite(net_pkt_tests);
@@ -473,6 +473,72 @@ static void test_route_del_many(void)
 	}
 }
 
+static void check_route_lookup(const char *dst_str,
+			       struct net_route_entry *expected)
+{
+	struct net_route_entry *route;
+	struct in6_addr dst;
+	int i;
+
+	zassert_equal(net_addr_pton(AF_INET6, dst_str, &dst), 0, NULL);
+
+	/* Second round is served from the lookup cache */
+	for (i = 0; i < 2; i++) {
+		route = net_route_lookup(my_iface, &dst);
+		zassert_equal_ptr(route, expected, "Wrong route for %s",
+				  dst_str);
+	}
+}
+
+static struct net_route_entry *add_prefix_route(const char *prefix_str,
+						uint8_t prefix_len)
+{
+	struct net_route_entry *route;
+	struct in6_addr prefix;
+
+	zassert_equal(net_addr_pton(AF_INET6, prefix_str, &prefix), 0, NULL);
+
+	route = net_route_add(my_iface, &prefix, prefix_len, &peer_addr);
+	zassert_not_null(route, "Route add failed");
+
+	return route;
+}
+
+static void test_route_longest_prefix_match(void)
+{
+	struct net_route_entry *r3, *r48, *r64, *r128;
+
+	r128 = add_prefix_route("2001:db8::beef:0", 128);
+	r64 = add_prefix_route("2001:db8::", 64);
+	r48 = add_prefix_route("2001:db8:0:1::", 48);
+	r3 = add_prefix_route("2000::", 3);
+
+	check_route_lookup("2001:db8::beef:0", r128);
+	check_route_lookup("2001:db8::beef:1", r64);
+	check_route_lookup("2001:db8::1", r64);
+	check_route_lookup("2001:db8:0:5::1", r48);
+	check_route_lookup("2001:db9::1", r3);
+	check_route_lookup("4001::1", NULL);
+
+	zassert_false(net_route_del(r64), "Route del failed");
+
+	check_route_lookup("2001:db8::beef:0", r128);
+	check_route_lookup("2001:db8::1", r48);
+
+	zassert_false(net_route_del(r48), "Route del failed");
+
+	check_route_lookup("2001:db8::1", r3);
+	check_route_lookup("2001:db8::beef:0", r128);
+
+	zassert_false(net_route_del(r128), "Route del failed");
+
+	check_route_lookup("2001:db8::beef:0", r3);
+
+	zassert_false(net_route_del(r3), "Route del failed");
+
+	check_route_lookup("2001:db8::beef:0", NULL);
+}
+
 /*test case main entry*/
 void test_main(void)
 {
@@ -492,6 +558,7 @@ void test_main(void)
 			ztest_unit_test(test_route_del_nexthop_again),
 			ztest_unit_test(test_populate_nbr_cache),
 			ztest_unit_test(test_route_add_many),
-			ztest_unit_test(test_route_del_many));
+			ztest_unit_test(test_route_del_many),
+			ztest_unit_test(test_route_longest_prefix_match));
 	ztest_run_test_suite(test_route);
 }
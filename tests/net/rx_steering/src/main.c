@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_TC_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <ztest.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/net_context.h>
+#include <net/dummy.h>
+
+#include "ipv6.h"
+#include "udp_internal.h"
+#include "net_private.h"
+
+#define TEST_PORT 4242
+#define PEER_PORT 5000
+
+#define FLOWS 8
+#define PKTS_PER_FLOW 8
+
+#define WAIT_TIME K_SECONDS(1)
+
+static struct in6_addr my_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+struct test_payload {
+	uint8_t flow;
+	uint8_t seq;
+};
+
+static struct net_if *iface;
+static struct net_context *udp_ctx;
+static struct k_sem recv_sem;
+
+static uint8_t next_seq[FLOWS];
+static k_tid_t flow_thread[FLOWS];
+static uint32_t flow_hash[FLOWS];
+static bool order_failed;
+static bool thread_failed;
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static uint8_t mac[] = { 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_DUMMY);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_rx_steering_test, "net_rx_steering_test",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static struct net_pkt *build_pkt(uint16_t src_port, uint8_t flow, uint8_t seq)
+{
+	struct test_payload payload = {
+		.flow = flow,
+		.seq = seq,
+	};
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_with_buffer(iface, sizeof(payload), AF_INET6,
+					IPPROTO_UDP, K_SECONDS(1));
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv6_create(pkt, &peer_addr, &my_addr), 0, "");
+	zassert_equal(net_udp_create(pkt, htons(src_port), htons(TEST_PORT)),
+		      0, "");
+	zassert_equal(net_pkt_write(pkt, &payload, sizeof(payload)), 0, "");
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv6_finalize(pkt, IPPROTO_UDP), 0, "");
+
+	return pkt;
+}
+
+static void recv_cb(struct net_context *context, struct net_pkt *pkt,
+		    union net_ip_header *ip_hdr,
+		    union net_proto_header *proto_hdr,
+		    int status, void *user_data)
+{
+	struct test_payload payload;
+
+	net_pkt_cursor_init(pkt);
+
+	if (net_pkt_skip(pkt, NET_IPV6H_LEN + NET_UDPH_LEN) ||
+	    net_pkt_read(pkt, &payload, sizeof(payload)) ||
+	    payload.flow >= FLOWS) {
+		order_failed = true;
+		goto out;
+	}
+
+	if (payload.seq != next_seq[payload.flow]) {
+		order_failed = true;
+	}
+
+	next_seq[payload.flow] = payload.seq + 1;
+
+	if (flow_thread[payload.flow] == NULL) {
+		flow_thread[payload.flow] = k_current_get();
+		flow_hash[payload.flow] = net_pkt_rx_hash(pkt);
+	} else if (flow_thread[payload.flow] != k_current_get() ||
+		   flow_hash[payload.flow] != net_pkt_rx_hash(pkt)) {
+		thread_failed = true;
+	}
+
+out:
+	net_pkt_unref(pkt);
+	k_sem_give(&recv_sem);
+}
+
+static void test_init(void)
+{
+	struct sockaddr_in6 addr = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(TEST_PORT),
+	};
+	struct net_if_addr *ifaddr;
+	int ret;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "No test interface");
+
+	ifaddr = net_if_ipv6_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add address");
+
+	k_sem_init(&recv_sem, 0, UINT_MAX);
+
+	ret = net_context_get(AF_INET6, SOCK_DGRAM, IPPROTO_UDP, &udp_ctx);
+	zassert_equal(ret, 0, "Cannot get context");
+
+	net_ipaddr_copy(&addr.sin6_addr, &my_addr);
+
+	ret = net_context_bind(udp_ctx, (struct sockaddr *)&addr,
+			       sizeof(addr));
+	zassert_equal(ret, 0, "Cannot bind context");
+
+	ret = net_context_recv(udp_ctx, recv_cb, K_NO_WAIT, NULL);
+	zassert_equal(ret, 0, "Cannot set receive callback");
+}
+
+static void test_flow_hash(void)
+{
+	bool queue_used[CONFIG_NET_RX_STEERING_QUEUES] = { false };
+	struct net_pkt *pkt1, *pkt2;
+	uint32_t hash;
+	int i, used = 0;
+
+	for (i = 0; i < 32; i++) {
+		pkt1 = build_pkt(PEER_PORT + i, 0, 0);
+		pkt2 = build_pkt(PEER_PORT + i, 1, 1);
+
+		hash = net_rx_flow_hash(pkt1);
+
+		zassert_not_equal(hash, 0, "Hash must not be 0");
+		zassert_equal(net_pkt_get_current_offset(pkt1), 0,
+			      "Cursor not reset");
+
+		/* The payload is not part of the flow */
+		zassert_equal(hash, net_rx_flow_hash(pkt2),
+			      "Same flow, different hash");
+
+		queue_used[hash % CONFIG_NET_RX_STEERING_QUEUES] = true;
+
+		net_pkt_unref(pkt1);
+		net_pkt_unref(pkt2);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(queue_used); i++) {
+		used += queue_used[i];
+	}
+
+	zassert_equal(used, CONFIG_NET_RX_STEERING_QUEUES,
+		      "Flows not spread over all the queues (%d)", used);
+}
+
+static void test_flow_order(void)
+{
+	k_tid_t first = NULL;
+	bool spread = false;
+	int flow, seq;
+
+	for (seq = 0; seq < PKTS_PER_FLOW; seq++) {
+		for (flow = 0; flow < FLOWS; flow++) {
+			struct net_pkt *pkt;
+
+			pkt = build_pkt(PEER_PORT + flow, flow, seq);
+			zassert_true(net_recv_data(iface, pkt) >= 0,
+				     "Cannot receive pkt");
+		}
+	}
+
+	for (seq = 0; seq < FLOWS * PKTS_PER_FLOW; seq++) {
+		zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+			      "Timeout while waiting for pkt %d", seq);
+	}
+
+	zassert_false(order_failed, "Packets of a flow were reordered");
+	zassert_false(thread_failed, "A flow was handled by several threads");
+
+	for (flow = 0; flow < FLOWS; flow++) {
+		zassert_equal(next_seq[flow], PKTS_PER_FLOW,
+			      "Flow %d lost packets", flow);
+
+		if (first == NULL) {
+			first = flow_thread[flow];
+		} else if (first != flow_thread[flow]) {
+			spread = true;
+		}
+	}
+
+	zassert_true(spread, "All the flows were handled by one thread");
+}
+
+static void test_driver_hash(void)
+{
+	struct net_pkt *pkt;
+	int seq;
+
+	/* A hash given by the driver overrides the computed one, so the
+	 * flow must stay on the same queue while it is set.
+	 */
+	memset(flow_thread, 0, sizeof(flow_thread));
+	next_seq[0] = 0;
+
+	for (seq = 0; seq < PKTS_PER_FLOW; seq++) {
+		pkt = build_pkt(PEER_PORT + seq, 0, seq);
+		net_pkt_set_rx_hash(pkt, 0x12345678U);
+
+		zassert_true(net_recv_data(iface, pkt) >= 0,
+			     "Cannot receive pkt");
+	}
+
+	for (seq = 0; seq < PKTS_PER_FLOW; seq++) {
+		zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+			      "Timeout while waiting for pkt %d", seq);
+	}
+
+	zassert_false(order_failed, "Packets were reordered");
+	zassert_false(thread_failed, "Flow was handled by several threads");
+	zassert_equal(flow_hash[0], 0x12345678U, "Driver hash overwritten");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_rx_steering_test,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_flow_hash),
+			 ztest_unit_test(test_flow_order),
+			 ztest_unit_test(test_driver_hash));
+
+	ztest_run_test_suite(net_rx_steering_test);
+}
@@ -180,6 +180,9 @@ static int prepare_udp_socket(struct sockaddr_in *sockaddr, uint16_t local_port)
 	return sock;
 }
 
+/* Interface of the 1st packet socket, for the user mode test */
+static ZTEST_BMEM int packet_ifindex;
+
 static void __test_packet_sockets(int *sock1, int *sock2)
 {
 	struct user_data ud = { 0 };
@@ -190,6 +193,8 @@ static void __test_packet_sockets(int *sock1, int *sock2)
 	zassert_not_null(ud.first, "1st Ethernet interface not found");
 	zassert_not_null(ud.second, "2nd Ethernet interface not found");
 
+	packet_ifindex = net_if_get_by_iface(ud.first);
+
 	*sock1 = setup_socket(ud.first, SOCK_RAW, ETH_P_ALL);
 	zassert_true(*sock1 >= 0, "Cannot create 1st socket (%d)", *sock1);
 
@@ -370,11 +375,253 @@ static void test_packet_sockets_dgram(void)
 	close(sock2);
 }
 
+#if defined(CONFIG_NET_SOCKETS_PACKET_RX_RING)
+#define RING_FRAME_SIZE 96
+#define RING_FRAME_NR 4
+
+static uint8_t ring[RING_FRAME_SIZE * RING_FRAME_NR]
+	__aligned(TPACKET_ALIGNMENT);
+
+static struct tpacket_hdr *ring_frame(int idx)
+{
+	return (struct tpacket_hdr *)&ring[idx * RING_FRAME_SIZE];
+}
+
+static void get_ring_stats(int sock, struct tpacket_stats *stats)
+{
+	socklen_t optlen = sizeof(*stats);
+	int ret;
+
+	ret = getsockopt(sock, SOL_PACKET, PACKET_STATISTICS, stats, &optlen);
+	zassert_equal(ret, 0, "Cannot get the statistics (%d)", -errno);
+	zassert_equal(optlen, sizeof(*stats), "Invalid statistics length");
+}
+
+static void test_packet_rx_ring(void)
+{
+	uint8_t data_to_send[] = { 0, 21, 22, 23, 24, 25, 26, 27, 28, 29 };
+	uint8_t large_data[RING_FRAME_SIZE] = { 0 };
+	struct tpacket_req req = {
+		.tp_ring = ring,
+		.tp_frame_size = RING_FRAME_SIZE + 1,
+		.tp_frame_nr = RING_FRAME_NR,
+	};
+	struct tpacket_stats stats;
+	struct sockaddr_in sockaddr;
+	struct tpacket_hdr *hdr;
+	struct pollfd pfd;
+	int ret, sock1, sock2, sock3, sock4, i;
+	uint8_t *data;
+
+	__test_packet_sockets(&sock1, &sock2);
+
+	/* Receiver, so that no ICMP error ends up in the ring */
+	sock4 = prepare_udp_socket(&sockaddr, DST_PORT);
+
+	sock3 = prepare_udp_socket(&sockaddr, SRC_PORT);
+	sockaddr.sin_port = htons(DST_PORT);
+
+	ret = setsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	zassert_equal(ret, -1, "Unaligned frame size accepted");
+	zassert_equal(errno, EINVAL, "Invalid errno (%d)", errno);
+
+	req.tp_frame_size = RING_FRAME_SIZE;
+	ret = setsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	zassert_equal(ret, 0, "Cannot set the ring (%d)", -errno);
+
+	ret = setsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	zassert_equal(ret, -1, "Ring set twice");
+	zassert_equal(errno, EBUSY, "Invalid errno (%d)", errno);
+
+	pfd.fd = sock1;
+	pfd.events = POLLIN;
+	ret = poll(&pfd, 1, 0);
+	zassert_equal(ret, 0, "Empty ring is readable");
+
+	/* Two packets more than the ring can hold */
+	for (i = 0; i < RING_FRAME_NR + 2; i++) {
+		data_to_send[0] = i;
+		ret = sendto(sock3, data_to_send, sizeof(data_to_send), 0,
+			     (struct sockaddr *)&sockaddr, sizeof(sockaddr));
+		zassert_equal(ret, sizeof(data_to_send), "sendto failed");
+	}
+
+	k_msleep(10);
+
+	ret = poll(&pfd, 1, 0);
+	zassert_equal(ret, 1, "Ring is not readable");
+	zassert_true(pfd.revents & POLLIN, "No POLLIN");
+
+	for (i = 0; i < RING_FRAME_NR; i++) {
+		hdr = ring_frame(i);
+		data = (uint8_t *)hdr + hdr->tp_mac + HDR_SIZE;
+
+		zassert_equal(hdr->tp_status, TP_STATUS_USER,
+			      "Invalid status %u", hdr->tp_status);
+		zassert_equal(hdr->tp_len, sizeof(data_to_send) + HDR_SIZE,
+			      "Invalid length %u", hdr->tp_len);
+		zassert_equal(hdr->tp_snaplen, hdr->tp_len,
+			      "Invalid snap length %u", hdr->tp_snaplen);
+		zassert_equal(data[0], i, "Frames out of order");
+		zassert_mem_equal(&data[1], &data_to_send[1],
+				  sizeof(data_to_send) - 1,
+				  "Sent and received buffers do not match");
+
+		hdr->tp_status = TP_STATUS_KERNEL;
+	}
+
+	ret = poll(&pfd, 1, 0);
+	zassert_equal(ret, 0, "Empty ring is readable");
+
+	get_ring_stats(sock1, &stats);
+	zassert_equal(stats.tp_packets, RING_FRAME_NR + 2,
+		      "Invalid packet count %u", stats.tp_packets);
+	zassert_equal(stats.tp_drops, 2, "Invalid drop count %u",
+		      stats.tp_drops);
+
+	get_ring_stats(sock1, &stats);
+	zassert_equal(stats.tp_packets, 0, "Statistics not reset");
+
+	/* The drops are flagged on the next frame, which is truncated */
+	ret = sendto(sock3, large_data, sizeof(large_data), 0,
+		     (struct sockaddr *)&sockaddr, sizeof(sockaddr));
+	zassert_equal(ret, sizeof(large_data), "sendto failed");
+
+	k_msleep(10);
+
+	hdr = ring_frame(0);
+	zassert_equal(hdr->tp_status, TP_STATUS_USER | TP_STATUS_LOSING,
+		      "Invalid status %u", hdr->tp_status);
+	zassert_equal(hdr->tp_len, sizeof(large_data) + HDR_SIZE,
+		      "Invalid length %u", hdr->tp_len);
+	zassert_equal(hdr->tp_snaplen, RING_FRAME_SIZE - TPACKET_HDRLEN,
+		      "Invalid snap length %u", hdr->tp_snaplen);
+
+	close(sock1);
+	close(sock2);
+	close(sock3);
+	close(sock4);
+}
+
+/* User mode threads get a ring owned by the stack, which they read
+ * without system calls.
+ */
+static void test_packet_rx_ring_user(void)
+{
+#if CONFIG_NET_SOCKETS_PACKET_RX_RING_SIZE > 0
+	uint8_t data_to_send[] = { 0, 31, 32, 33, 34, 35, 36, 37, 38, 39 };
+	struct tpacket_req req = {
+		.tp_frame_size = RING_FRAME_SIZE,
+		.tp_frame_nr = RING_FRAME_NR,
+	};
+	socklen_t optlen = sizeof(req);
+	struct sockaddr_in sockaddr;
+	struct sockaddr_ll addr;
+	struct tpacket_hdr *hdr;
+	struct pollfd pfd;
+	int ret, sock1, sock2, sock3, i;
+	uint8_t *data;
+
+	sock1 = socket(AF_PACKET, SOCK_RAW, ETH_P_ALL);
+	zassert_true(sock1 >= 0, "Cannot create packet socket (%d)", -errno);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sll_ifindex = packet_ifindex;
+	addr.sll_family = AF_PACKET;
+
+	ret = bind(sock1, (struct sockaddr *)&addr, sizeof(addr));
+	zassert_equal(ret, 0, "Cannot bind packet socket (%d)", -errno);
+
+	/* Receiver, so that no ICMP error ends up in the ring */
+	sock2 = prepare_udp_socket(&sockaddr, DST_PORT);
+
+	sock3 = prepare_udp_socket(&sockaddr, SRC_PORT);
+	sockaddr.sin_port = htons(DST_PORT);
+
+#if defined(CONFIG_USERSPACE)
+	zassert_true(k_is_user_context(), "Not in user mode");
+
+	req.tp_ring = data_to_send;
+	ret = setsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	zassert_equal(ret, -1, "User memory accepted for the ring");
+	zassert_equal(errno, EPERM, "Invalid errno (%d)", errno);
+#endif
+
+	req.tp_ring = NULL;
+	ret = setsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+	zassert_equal(ret, 0, "Cannot set the ring (%d)", -errno);
+
+	(void)memset(&req, 0, sizeof(req));
+	ret = getsockopt(sock1, SOL_PACKET, PACKET_RX_RING, &req, &optlen);
+	zassert_equal(ret, 0, "Cannot get the ring (%d)", -errno);
+	zassert_equal(optlen, sizeof(req), "Invalid ring length");
+	zassert_not_null(req.tp_ring, "No ring");
+	zassert_equal(req.tp_frame_size, RING_FRAME_SIZE,
+		      "Invalid frame size %u", req.tp_frame_size);
+	zassert_equal(req.tp_frame_nr, RING_FRAME_NR,
+		      "Invalid frame count %u", req.tp_frame_nr);
+
+	for (i = 0; i < RING_FRAME_NR; i++) {
+		data_to_send[0] = i;
+		ret = sendto(sock3, data_to_send, sizeof(data_to_send), 0,
+			     (struct sockaddr *)&sockaddr, sizeof(sockaddr));
+		zassert_equal(ret, sizeof(data_to_send), "sendto failed");
+	}
+
+	k_msleep(10);
+
+	pfd.fd = sock1;
+	pfd.events = POLLIN;
+	ret = poll(&pfd, 1, 0);
+	zassert_equal(ret, 1, "Ring is not readable");
+
+	/* The frames are read in place, without a system call */
+	for (i = 0; i < RING_FRAME_NR; i++) {
+		hdr = (struct tpacket_hdr *)((uint8_t *)req.tp_ring +
+					     i * RING_FRAME_SIZE);
+		data = (uint8_t *)hdr + hdr->tp_mac + HDR_SIZE;
+
+		zassert_equal(hdr->tp_status, TP_STATUS_USER,
+			      "Invalid status %u", hdr->tp_status);
+		zassert_equal(hdr->tp_len, sizeof(data_to_send) + HDR_SIZE,
+			      "Invalid length %u", hdr->tp_len);
+		zassert_equal(data[0], i, "Frames out of order");
+		zassert_mem_equal(&data[1], &data_to_send[1],
+				  sizeof(data_to_send) - 1,
+				  "Sent and received buffers do not match");
+
+		hdr->tp_status = TP_STATUS_KERNEL;
+	}
+
+	ret = poll(&pfd, 1, 0);
+	zassert_equal(ret, 0, "Empty ring is readable");
+
+	close(sock1);
+	close(sock2);
+	close(sock3);
+#else
+	ztest_test_skip();
+#endif
+}
+#else
+static void test_packet_rx_ring(void)
+{
+	ztest_test_skip();
+}
+
+static void test_packet_rx_ring_user(void)
+{
+	ztest_test_skip();
+}
+#endif
+
 void test_main(void)
 {
 	ztest_test_suite(socket_packet,
 			 ztest_unit_test(test_packet_sockets),
 			 ztest_unit_test(test_raw_packet_sockets),
-			 ztest_unit_test(test_packet_sockets_dgram));
+			 ztest_unit_test(test_packet_sockets_dgram),
+			 ztest_unit_test(test_packet_rx_ring),
+			 ztest_user_unit_test(test_packet_rx_ring_user));
 	ztest_run_test_suite(socket_packet);
 }
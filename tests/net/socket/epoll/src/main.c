@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <stdio.h>
+#include <ztest_assert.h>
+
+#include <net/socket.h>
+
+#include "../../socket_helpers.h"
+
+#define BUF_AND_SIZE(buf) buf, sizeof(buf) - 1
+#define STRLEN(buf) (sizeof(buf) - 1)
+
+#define TEST_STR_SMALL "test"
+
+#define CLIENT_PORT 9898
+#define SERVER_PORT 4242
+
+/* On QEMU, a poll which waits takes +10ms from the requested time. */
+#define FUZZ 10
+
+#define WAITER_STACK_SIZE 1024
+
+static int c_sock;
+static int s_sock;
+static struct sockaddr_in6 c_addr;
+static struct sockaddr_in6 s_addr;
+
+static void setup_udp_pair(void)
+{
+	int res;
+
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, CLIENT_PORT,
+			    &c_sock, &c_addr);
+	prepare_sock_udp_v6(CONFIG_NET_CONFIG_MY_IPV6_ADDR, SERVER_PORT,
+			    &s_sock, &s_addr);
+
+	res = bind(s_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "bind failed");
+
+	res = connect(c_sock, (struct sockaddr *)&s_addr, sizeof(s_addr));
+	zassert_equal(res, 0, "connect failed");
+}
+
+static void teardown_udp_pair(void)
+{
+	zassert_equal(close(c_sock), 0, "close failed");
+	zassert_equal(close(s_sock), 0, "close failed");
+}
+
+static int epoll_add(int epfd, int fd, uint32_t events)
+{
+	struct epoll_event ev = {
+		.events = events,
+		.data.fd = fd,
+	};
+
+	return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static void send_small(void)
+{
+	ssize_t len;
+
+	len = send(c_sock, BUF_AND_SIZE(TEST_STR_SMALL), 0);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "invalid send len");
+
+	/* Let the loopback deliver the datagram */
+	k_msleep(10);
+}
+
+static void recv_small(void)
+{
+	char buf[10];
+	ssize_t len;
+
+	len = recv(s_sock, BUF_AND_SIZE(buf), 0);
+	zassert_equal(len, STRLEN(TEST_STR_SMALL), "invalid recv len");
+}
+
+void test_epoll_ctl(void)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+	int epfd;
+	int res;
+
+	zassert_equal(epoll_create(0), -1, "size 0 accepted");
+	zassert_equal(errno, EINVAL, "");
+
+	setup_udp_pair();
+
+	epfd = epoll_create(1);
+	zassert_true(epfd >= 0, "epoll_create failed");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_ADD, s_sock, &ev);
+	zassert_equal(res, 0, "add failed");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_ADD, s_sock, &ev);
+	zassert_equal(res, -1, "double add succeeded");
+	zassert_equal(errno, EEXIST, "");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_MOD, c_sock, &ev);
+	zassert_equal(res, -1, "mod of unknown fd succeeded");
+	zassert_equal(errno, ENOENT, "");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_ADD, epfd, &ev);
+	zassert_equal(res, -1, "self add succeeded");
+	zassert_equal(errno, EINVAL, "");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_ADD, CONFIG_POSIX_MAX_FDS - 1, &ev);
+	zassert_equal(res, -1, "add of closed fd succeeded");
+	zassert_equal(errno, EBADF, "");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_DEL, s_sock, NULL);
+	zassert_equal(res, 0, "del failed");
+
+	res = epoll_ctl(epfd, EPOLL_CTL_DEL, s_sock, NULL);
+	zassert_equal(res, -1, "double del succeeded");
+	zassert_equal(errno, ENOENT, "");
+
+	res = epoll_wait(epfd, &ev, 0, 0);
+	zassert_equal(res, -1, "zero maxevents accepted");
+	zassert_equal(errno, EINVAL, "");
+
+	zassert_equal(close(epfd), 0, "close failed");
+
+	teardown_udp_pair();
+}
+
+void test_epoll_level_triggered(void)
+{
+	struct epoll_event events[2];
+	uint32_t tstamp;
+	int epfd;
+	int res;
+
+	setup_udp_pair();
+
+	epfd = epoll_create(1);
+	zassert_true(epfd >= 0, "epoll_create failed");
+
+	zassert_equal(epoll_add(epfd, c_sock, EPOLLIN), 0, "add failed");
+	zassert_equal(epoll_add(epfd, s_sock, EPOLLIN), 0, "add failed");
+
+	/* Nothing ready, zero timeout */
+	tstamp = k_uptime_get_32();
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_true(k_uptime_get_32() - tstamp <= FUZZ, "");
+	zassert_equal(res, 0, "");
+
+	/* Nothing ready, wait for 30 ms */
+	tstamp = k_uptime_get_32();
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 30);
+	tstamp = k_uptime_get_32() - tstamp;
+	zassert_true(tstamp >= 30U && tstamp <= 30 + FUZZ * 2, "tstamp %d",
+		     tstamp);
+	zassert_equal(res, 0, "");
+
+	send_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 30);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, s_sock, "");
+	zassert_equal(events[0].events, EPOLLIN, "");
+
+	/* Level-triggered: reported again while data is pending */
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, s_sock, "");
+
+	recv_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 0, "");
+
+	/* Writable sockets are reported without waiting */
+	zassert_equal(epoll_add(epfd, CONFIG_POSIX_MAX_FDS - 1, EPOLLOUT), -1,
+		      "");
+	events[0].events = EPOLLIN | EPOLLOUT;
+	events[0].data.fd = c_sock;
+	res = epoll_ctl(epfd, EPOLL_CTL_MOD, c_sock, &events[0]);
+	zassert_equal(res, 0, "mod failed");
+
+	tstamp = k_uptime_get_32();
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 200);
+	zassert_true(k_uptime_get_32() - tstamp < 100, "");
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, c_sock, "");
+	zassert_equal(events[0].events, EPOLLOUT, "");
+
+	zassert_equal(close(epfd), 0, "close failed");
+
+	teardown_udp_pair();
+}
+
+void test_epoll_edge_triggered(void)
+{
+	struct epoll_event events[2];
+	uint32_t tstamp;
+	int epfd;
+	int res;
+
+	setup_udp_pair();
+
+	epfd = epoll_create(1);
+	zassert_true(epfd >= 0, "epoll_create failed");
+
+	zassert_equal(epoll_add(epfd, s_sock, EPOLLIN | EPOLLET), 0,
+		      "add failed");
+
+	send_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, s_sock, "");
+	zassert_equal(events[0].events, EPOLLIN, "");
+
+	/* Still readable, but the edge was already reported, so the wait
+	 * must block for the whole timeout instead of spinning.
+	 */
+	tstamp = k_uptime_get_32();
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 30);
+	tstamp = k_uptime_get_32() - tstamp;
+	zassert_equal(res, 0, "");
+	zassert_true(tstamp >= 30U && tstamp <= 30 + FUZZ * 2, "tstamp %d",
+		     tstamp);
+
+	recv_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 0, "");
+
+	/* Drained, so new data is a new edge */
+	send_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, s_sock, "");
+
+	/* Drained and refilled between two waits is a new edge as well */
+	recv_small();
+	send_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.fd, s_sock, "");
+
+	recv_small();
+
+	zassert_equal(close(epfd), 0, "close failed");
+
+	teardown_udp_pair();
+}
+
+void test_epoll_oneshot(void)
+{
+	struct epoll_event events[2];
+	struct epoll_event ev;
+	int epfd;
+	int res;
+
+	setup_udp_pair();
+
+	epfd = epoll_create(1);
+	zassert_true(epfd >= 0, "epoll_create failed");
+
+	zassert_equal(epoll_add(epfd, s_sock, EPOLLIN | EPOLLONESHOT), 0,
+		      "add failed");
+
+	send_small();
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 0, "one-shot descriptor reported twice");
+
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.u32 = 0x1234;
+	res = epoll_ctl(epfd, EPOLL_CTL_MOD, s_sock, &ev);
+	zassert_equal(res, 0, "mod failed");
+
+	res = epoll_wait(epfd, events, ARRAY_SIZE(events), 0);
+	zassert_equal(res, 1, "");
+	zassert_equal(events[0].data.u32, 0x1234, "");
+
+	recv_small();
+
+	zassert_equal(close(epfd), 0, "close failed");
+
+	teardown_udp_pair();
+}
+
+static K_THREAD_STACK_DEFINE(waiter_stack, WAITER_STACK_SIZE);
+static struct k_thread waiter_thread;
+static struct epoll_event waiter_event;
+static int waiter_res;
+
+static void waiter(void *p1, void *p2, void *p3)
+{
+	int epfd = POINTER_TO_INT(p1);
+
+	waiter_res = epoll_wait(epfd, &waiter_event, 1, 1000);
+}
+
+void test_epoll_ctl_during_wait(void)
+{
+	uint32_t tstamp;
+	int epfd;
+
+	setup_udp_pair();
+
+	epfd = epoll_create(1);
+	zassert_true(epfd >= 0, "epoll_create failed");
+
+	send_small();
+
+	tstamp = k_uptime_get_32();
+
+	k_thread_create(&waiter_thread, waiter_stack,
+			K_THREAD_STACK_SIZEOF(waiter_stack), waiter,
+			INT_TO_POINTER(epfd), NULL, NULL,
+			K_PRIO_PREEMPT(8), 0, K_NO_WAIT);
+
+	/* Let the waiter block on the empty interest list */
+	k_msleep(20);
+
+	/* Adding a ready socket must wake up the blocked wait */
+	zassert_equal(epoll_add(epfd, s_sock, EPOLLIN), 0, "add failed");
+
+	k_thread_join(&waiter_thread, K_FOREVER);
+
+	zassert_true(k_uptime_get_32() - tstamp < 200, "waiter not woken");
+	zassert_equal(waiter_res, 1, "");
+	zassert_equal(waiter_event.data.fd, s_sock, "");
+
+	recv_small();
+
+	zassert_equal(close(epfd), 0, "close failed");
+
+	teardown_udp_pair();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(socket_epoll,
+			 ztest_unit_test(test_epoll_ctl),
+			 ztest_unit_test(test_epoll_level_triggered),
+			 ztest_unit_test(test_epoll_edge_triggered),
+			 ztest_unit_test(test_epoll_oneshot),
+			 ztest_unit_test(test_epoll_ctl_during_wait));
+
+	ztest_run_test_suite(socket_epoll);
+}
@@ -44,6 +44,10 @@ extern void test_socketpair_poll_delayed_data(void);
 extern void test_socketpair_poll_close_remote_end_POLLIN(void);
 extern void test_socketpair_poll_close_remote_end_POLLOUT(void);
 
+/* in test_socketpair_handoff.c */
+extern void test_socketpair_handoff(void);
+extern void test_socketpair_round_trip(void);
+
 void test_main(void)
 {
 	k_thread_system_pool_assign(k_current_get());
@@ -77,7 +81,10 @@ void test_main(void)
 		ztest_unit_test(test_socketpair_poll_delayed_data),
 
 		ztest_unit_test(test_socketpair_poll_close_remote_end_POLLIN),
-		ztest_unit_test(test_socketpair_poll_close_remote_end_POLLOUT)
+		ztest_unit_test(test_socketpair_poll_close_remote_end_POLLOUT),
+
+		ztest_unit_test(test_socketpair_handoff),
+		ztest_unit_test(test_socketpair_round_trip)
 	);
 
 	ztest_run_test_suite(socketpair);
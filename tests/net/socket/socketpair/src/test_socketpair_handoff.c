@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <logging/log.h>
+LOG_MODULE_DECLARE(net_test, CONFIG_NET_SOCKETS_LOG_LEVEL);
+
+#include <net/socket.h>
+#include <sys/util.h>
+#include <posix/unistd.h>
+
+#include <ztest_assert.h>
+
+#undef read
+#define read(fd, buf, len) zsock_recv(fd, buf, len, 0)
+
+#undef write
+#define write(fd, buf, len) zsock_send(fd, buf, len, 0)
+
+#define XFER_SIZE (CONFIG_NET_SOCKETPAIR_BUFFER_SIZE * 3)
+#define ROUND_TRIPS 1000
+
+#define PEER_STACK_SIZE 1024
+#define PEER_PRIORITY K_PRIO_PREEMPT(8)
+
+K_THREAD_STACK_DEFINE(peer_stack, PEER_STACK_SIZE);
+static struct k_thread peer_thread;
+
+static uint8_t tx_buf[XFER_SIZE];
+static uint8_t rx_buf[XFER_SIZE];
+static ssize_t peer_res;
+
+static void reader_fn(void *p1, void *p2, void *p3)
+{
+	int fd = POINTER_TO_INT(p1);
+
+	peer_res = read(fd, rx_buf, sizeof(rx_buf));
+}
+
+static void echo_fn(void *p1, void *p2, void *p3)
+{
+	int fd = POINTER_TO_INT(p1);
+	uint8_t c;
+	int i;
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		if (read(fd, &c, 1) != 1 || write(fd, &c, 1) != 1) {
+			peer_res = -1;
+			return;
+		}
+	}
+
+	peer_res = ROUND_TRIPS;
+}
+
+void test_socketpair_handoff(void)
+{
+	int sv[2] = {-1, -1};
+	ssize_t res;
+	size_t i;
+
+	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+	zassert_equal(res, 0, "socketpair(2) failed: %d", errno);
+
+	for (i = 0; i < sizeof(tx_buf); i++) {
+		tx_buf[i] = i;
+	}
+
+	k_thread_create(&peer_thread, peer_stack,
+			K_THREAD_STACK_SIZEOF(peer_stack), reader_fn,
+			INT_TO_POINTER(sv[1]), NULL, NULL, PEER_PRIORITY, 0,
+			K_NO_WAIT);
+
+	/* let the reader block on the empty endpoint */
+	k_sleep(K_MSEC(10));
+
+	res = write(sv[0], tx_buf, sizeof(tx_buf));
+	zassert_true(res > 0, "write(2) failed: %d", errno);
+
+	k_thread_join(&peer_thread, K_FOREVER);
+
+	if (IS_ENABLED(CONFIG_NET_SOCKETPAIR_HANDOFF)) {
+		/* more than the intermediate buffer can hold */
+		zassert_equal(res, sizeof(tx_buf), "wrote %zd bytes", res);
+	} else {
+		zassert_equal(res, CONFIG_NET_SOCKETPAIR_BUFFER_SIZE,
+			      "wrote %zd bytes", res);
+	}
+
+	zassert_equal(peer_res, res, "read %zd bytes", peer_res);
+	zassert_mem_equal(rx_buf, tx_buf, res, "data corrupted");
+
+	close(sv[0]);
+	close(sv[1]);
+}
+
+void test_socketpair_round_trip(void)
+{
+	int sv[2] = {-1, -1};
+	uint32_t start, cycles;
+	uint8_t c = 'x';
+	ssize_t res;
+	int i;
+
+	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+	zassert_equal(res, 0, "socketpair(2) failed: %d", errno);
+
+	k_thread_create(&peer_thread, peer_stack,
+			K_THREAD_STACK_SIZEOF(peer_stack), echo_fn,
+			INT_TO_POINTER(sv[1]), NULL, NULL, PEER_PRIORITY, 0,
+			K_NO_WAIT);
+
+	start = k_cycle_get_32();
+
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		res = write(sv[0], &c, 1);
+		zassert_equal(res, 1, "write(2) failed: %d", errno);
+		res = read(sv[0], &c, 1);
+		zassert_equal(res, 1, "read(2) failed: %d", errno);
+	}
+
+	cycles = k_cycle_get_32() - start;
+
+	k_thread_join(&peer_thread, K_FOREVER);
+	zassert_equal(peer_res, ROUND_TRIPS, "echo failed");
+
+	TC_PRINT("%d round trips in %u cycles (%u per round trip)\n",
+		 ROUND_TRIPS, cycles, cycles / ROUND_TRIPS);
+
+	close(sv[0]);
+	close(sv[1]);
+}
@@ -468,6 +468,120 @@ void test_v6_msg_trunc(void)
 		       (struct sockaddr *)&server_addr, sizeof(server_addr));
 }
 
+static void get_handshake_stats(int sock, struct tls_handshake_stats *stats)
+{
+	socklen_t optlen = sizeof(*stats);
+
+	zassert_equal(getsockopt(sock, SOL_TLS, TLS_HANDSHAKE_STATS, stats,
+				 &optlen),
+		      0, "getsockopt failed (%d)", errno);
+	zassert_equal(optlen, sizeof(*stats), "getsockopt got invalid size");
+}
+
+static void purge_sessions(int sock)
+{
+	int optval = 0;
+
+	zassert_equal(setsockopt(sock, SOL_TLS, TLS_SESSION_CACHE_PURGE,
+				 &optval, sizeof(optval)),
+		      0, "setsockopt failed (%d)", errno);
+}
+
+/* Connects a new client to the server, with the session cache of the
+ * client enabled or not, and returns the number of handshakes resumed.
+ */
+static uint32_t session_connect(int s_sock, struct sockaddr_in *s_saddr,
+				int cache)
+{
+	struct tls_handshake_stats before, after;
+	struct sockaddr_in c_saddr;
+	struct sockaddr addr;
+	socklen_t addrlen = sizeof(addr);
+	int c_sock, new_sock;
+
+	prepare_sock_tls_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, ANY_PORT,
+			    &c_sock, &c_saddr, IPPROTO_TLS_1_2);
+
+	test_config_psk(s_sock, c_sock);
+
+	zassert_equal(setsockopt(c_sock, SOL_TLS, TLS_SESSION_CACHE, &cache,
+				 sizeof(cache)),
+		      0, "setsockopt failed (%d)", errno);
+
+	get_handshake_stats(c_sock, &before);
+
+	spawn_client_connect_thread(c_sock, (struct sockaddr *)s_saddr);
+
+	test_accept(s_sock, &new_sock, &addr, &addrlen);
+
+	k_thread_join(&client_connect_thread, K_FOREVER);
+
+	get_handshake_stats(c_sock, &after);
+
+	/* The client and the server handshakes */
+	zassert_equal(after.count, before.count + 2,
+		      "Invalid handshake count");
+	zassert_equal(after.failed, before.failed, "Handshake failed");
+	zassert_true(after.max_time >= before.max_time,
+		     "Longest handshake decreased");
+	zassert_true(after.total_time >= after.max_time,
+		     "Invalid total handshake time");
+
+	test_close(new_sock);
+	test_close(c_sock);
+
+	return after.resumed - before.resumed;
+}
+
+void test_v4_session_cache(void)
+{
+	struct sockaddr_in s_saddr;
+	int s_sock, optval;
+	socklen_t optlen = sizeof(optval);
+
+	prepare_sock_tls_v4(CONFIG_NET_CONFIG_MY_IPV4_ADDR, SERVER_PORT,
+			    &s_sock, &s_saddr, IPPROTO_TLS_1_2);
+
+	test_bind(s_sock, (struct sockaddr *)&s_saddr, sizeof(s_saddr));
+	test_listen(s_sock);
+
+	zassert_equal(getsockopt(s_sock, SOL_TLS, TLS_SESSION_CACHE, &optval,
+				 &optlen),
+		      0, "getsockopt failed (%d)", errno);
+	zassert_equal(optval, TLS_SESSION_CACHE_ENABLED,
+		      "Session cache not enabled by default");
+
+	optval = 2;
+	zassert_equal(setsockopt(s_sock, SOL_TLS, TLS_SESSION_CACHE, &optval,
+				 sizeof(optval)),
+		      -1, "Invalid cache value accepted");
+	zassert_equal(errno, EINVAL, "Invalid errno (%d)", errno);
+
+	purge_sessions(s_sock);
+
+	zassert_equal(session_connect(s_sock, &s_saddr,
+				      TLS_SESSION_CACHE_ENABLED),
+		      0, "Session resumed from an empty cache");
+	zassert_equal(session_connect(s_sock, &s_saddr,
+				      TLS_SESSION_CACHE_ENABLED),
+		      1, "Stored session not resumed");
+	zassert_equal(session_connect(s_sock, &s_saddr,
+				      TLS_SESSION_CACHE_DISABLED),
+		      0, "Session resumed with the cache disabled");
+
+	purge_sessions(s_sock);
+
+	zassert_equal(session_connect(s_sock, &s_saddr,
+				      TLS_SESSION_CACHE_ENABLED),
+		      0, "Session resumed after a purge");
+	zassert_equal(session_connect(s_sock, &s_saddr,
+				      TLS_SESSION_CACHE_ENABLED),
+		      1, "Stored session not resumed");
+
+	test_close(s_sock);
+	k_sleep(TCP_TEARDOWN_TIMEOUT);
+}
+
 void test_main(void)
 {
 	if (IS_ENABLED(CONFIG_NET_TC_THREAD_COOPERATIVE)) {
@@ -484,7 +598,8 @@ void test_main(void)
 		ztest_unit_test(test_v4_msg_waitall),
 		ztest_unit_test(test_v6_msg_waitall),
 		ztest_unit_test(test_v4_msg_trunc),
-		ztest_unit_test(test_v6_msg_trunc)
+		ztest_unit_test(test_v6_msg_trunc),
+		ztest_unit_test(test_v4_session_cache)
 		);
 
 	ztest_run_test_suite(socket_tls);
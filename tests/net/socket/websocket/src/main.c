@@ -269,12 +269,54 @@ static void test_recv_two_msg(void)
 	test_recv_2(sizeof(frame1) + FRAME1_HDR_SIZE / 2);
 }
 
-int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
+/* The data sent by the websocket library is collected here */
+static uint8_t sent_buf[sizeof(lorem_ipsum) + MAX_HEADER_LEN];
+static size_t sent_len;
+
+ssize_t websocket_test_sendmsg(const struct msghdr *msg)
 {
-	static struct websocket_context ctx;
+	size_t total = 0;
+	int i;
+
+	for (i = 0; i < msg->msg_iovlen; i++) {
+		zassert_true(sent_len + msg->msg_iov[i].iov_len <=
+			     sizeof(sent_buf), "Too much data sent");
+
+		memcpy(&sent_buf[sent_len], msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		sent_len += msg->msg_iov[i].iov_len;
+		total += msg->msg_iov[i].iov_len;
+	}
+
+	return total;
+}
+
+static size_t sent_header_len(void)
+{
+	size_t len = MIN_HEADER_LEN;
+
+	if ((sent_buf[1] & 0x7f) == 126) {
+		len += 2;
+	} else if ((sent_buf[1] & 0x7f) == 127) {
+		len += 8;
+	}
+
+	if (sent_buf[1] & BIT(7)) {
+		len += 4;
+	}
+
+	return len;
+}
+
+static int verify_sent_and_received_msg(const char *expected, bool split_msg)
+{
+	struct websocket_context ctx;
 	uint32_t msg_type = -1;
 	uint64_t remaining = -1;
-	size_t split_len = 0, total_read = 0;
+	size_t header_len = sent_header_len();
+	uint8_t *payload = &sent_buf[header_len];
+	size_t payload_len = sent_len - header_len;
+	int split_len = 0, total_read = 0;
 	int ret;
 
 	memset(&ctx, 0, sizeof(ctx));
@@ -283,18 +325,16 @@ int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	/* Read first the header */
-	ret = test_recv_buf(msg->msg_iov[0].iov_base,
-			    msg->msg_iov[0].iov_len,
+	ret = test_recv_buf(sent_buf, header_len,
 			    &ctx, &msg_type, &remaining,
 			    recv_buf, sizeof(recv_buf));
 	zassert_equal(ret, -EAGAIN, "Msg header not found");
 
 	/* Then the first split if it is enabled */
 	if (split_msg) {
-		split_len = msg->msg_iov[1].iov_len / 2;
+		split_len = payload_len / 2;
 
-		ret = test_recv_buf(msg->msg_iov[1].iov_base,
-				    split_len,
+		ret = test_recv_buf(payload, split_len,
 				    &ctx, &msg_type, &remaining,
 				    recv_buf, sizeof(recv_buf));
 		zassert_true(ret > 0, "Cannot read data (%d)", ret);
@@ -304,15 +344,14 @@ int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
 
 	/* Then the data */
 	while (remaining > 0) {
-		ret = test_recv_buf((uint8_t *)msg->msg_iov[1].iov_base +
-								total_read,
-				    msg->msg_iov[1].iov_len - total_read,
+		ret = test_recv_buf(payload + total_read,
+				    payload_len - total_read,
 				    &ctx, &msg_type, &remaining,
 				    recv_buf, sizeof(recv_buf));
 		zassert_true(ret > 0, "Cannot read data (%d)", ret);
 
-		if (memcmp(recv_buf, lorem_ipsum + total_read, ret) != 0) {
-			LOG_HEXDUMP_ERR(lorem_ipsum + total_read, ret,
+		if (memcmp(recv_buf, expected + total_read, ret) != 0) {
+			LOG_HEXDUMP_ERR(expected + total_read, ret,
 					"Received message should be");
 			LOG_HEXDUMP_ERR(recv_buf, ret, "but it was instead");
 			zassert_true(false, "Invalid received message "
@@ -326,10 +365,9 @@ int verify_sent_and_received_msg(struct msghdr *msg, bool split_msg)
 		      "Msg body not valid, received %d instead of %zd",
 		      total_read, test_msg_len);
 
-	NET_DBG("Received %zd header and %zd body",
-		msg->msg_iov[0].iov_len, total_read);
+	NET_DBG("Received %zd header and %d body", header_len, total_read);
 
-	return msg->msg_iov[0].iov_len + total_read;
+	return header_len + total_read;
 }
 
 static void test_send_and_recv_lorem_ipsum(void)
@@ -343,6 +381,7 @@ static void test_send_and_recv_lorem_ipsum(void)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	test_msg_len = sizeof(lorem_ipsum) - 1;
+	sent_len = 0;
 
 	ret = websocket_send_msg(POINTER_TO_INT(&ctx),
 				 lorem_ipsum, test_msg_len,
@@ -351,6 +390,8 @@ static void test_send_and_recv_lorem_ipsum(void)
 	zassert_equal(ret, test_msg_len,
 		      "Should have sent %zd bytes but sent %d instead",
 		      test_msg_len, ret);
+
+	verify_sent_and_received_msg(lorem_ipsum, false);
 }
 
 static void test_recv_two_large_split_msg(void)
@@ -364,6 +405,7 @@ static void test_recv_two_large_split_msg(void)
 	ctx.tmp_buf_len = sizeof(temp_recv_buf);
 
 	test_msg_len = sizeof(lorem_ipsum) - 1;
+	sent_len = 0;
 
 	ret = websocket_send_msg(POINTER_TO_INT(&ctx), lorem_ipsum,
 				 test_msg_len, WEBSOCKET_OPCODE_DATA_TEXT,
@@ -371,6 +413,128 @@ static void test_recv_two_large_split_msg(void)
 	zassert_equal(ret, test_msg_len,
 		      "1st should have sent %zd bytes but sent %d instead",
 		      test_msg_len, ret);
+
+	verify_sent_and_received_msg(lorem_ipsum, true);
+}
+
+static void test_send_iov(bool mask)
+{
+	static struct websocket_context ctx;
+	struct iovec iov[12];
+	size_t offset = 0;
+	int ret, i;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	/* Pieces of odd lengths, so that the masking key is applied at
+	 * every alignment.
+	 */
+	for (i = 0; i < ARRAY_SIZE(iov) - 1; i++) {
+		iov[i].iov_base = (void *)&lorem_ipsum[offset];
+		iov[i].iov_len = 2 * i + 1;
+		offset += iov[i].iov_len;
+	}
+
+	iov[i].iov_base = (void *)&lorem_ipsum[offset];
+	iov[i].iov_len = sizeof(lorem_ipsum) - 1 - offset;
+
+	test_msg_len = sizeof(lorem_ipsum) - 1;
+	sent_len = 0;
+
+	ret = websocket_send_msg_iov(POINTER_TO_INT(&ctx), iov,
+				     ARRAY_SIZE(iov),
+				     WEBSOCKET_OPCODE_DATA_TEXT, mask, true,
+				     SYS_FOREVER_MS);
+	zassert_equal(ret, test_msg_len,
+		      "Should have sent %zd bytes but sent %d instead",
+		      test_msg_len, ret);
+
+	verify_sent_and_received_msg(lorem_ipsum, false);
+}
+
+static void test_send_iov_masked(void)
+{
+	test_send_iov(true);
+}
+
+static void test_send_iov_unmasked(void)
+{
+	test_send_iov(false);
+}
+
+static void test_send_unaligned(void)
+{
+	static struct websocket_context ctx;
+	int ret, i;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	for (i = 1; i < sizeof(long); i++) {
+		test_msg_len = sizeof(lorem_ipsum) - 1 - i;
+		sent_len = 0;
+
+		ret = websocket_send_msg(POINTER_TO_INT(&ctx), lorem_ipsum + i,
+					 test_msg_len,
+					 WEBSOCKET_OPCODE_DATA_BINARY, true,
+					 true, SYS_FOREVER_MS);
+		zassert_equal(ret, test_msg_len, "Send failed (%d)", ret);
+
+		verify_sent_and_received_msg(lorem_ipsum + i, i % 2);
+	}
+}
+
+/* "test " as text frame without FIN, then "message" as continuation frame,
+ * both masked with key e17e8eb9.
+ */
+static const unsigned char fragmented_frames[] = {
+	0x01, 0x85, 0xe1, 0x7e, 0x8e, 0xb9, 0x95, 0x1b,
+	0xfd, 0xcd, 0xc1,
+	0x80, 0x87, 0xe1, 0x7e, 0x8e, 0xb9, 0x8c, 0x1b,
+	0xfd, 0xca, 0x80, 0x19, 0xeb
+};
+
+static void test_recv_fragmented(void)
+{
+	struct websocket_context ctx;
+	uint32_t msg_type = 0;
+	uint64_t remaining = -1;
+	int total_read = 0;
+	int ret;
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	ctx.tmp_buf = temp_recv_buf;
+	ctx.tmp_buf_len = sizeof(temp_recv_buf);
+
+	memcpy(feed_buf, fragmented_frames, sizeof(fragmented_frames));
+
+	/* Both frames arrive at once and are read 4 bytes at a time */
+	ret = test_recv_buf(feed_buf, sizeof(fragmented_frames), &ctx,
+			    &msg_type, &remaining, recv_buf, 4);
+	zassert_equal(ret, 4, "First read failed (%d)", ret);
+	zassert_equal(msg_type, WEBSOCKET_FLAG_TEXT, "Wrong type 0x%x",
+		      msg_type);
+	zassert_equal(remaining, 1, "Wrong remaining %d", (int)remaining);
+	total_read += ret;
+
+	while (total_read < sizeof(frame1_msg) - 1) {
+		ret = test_recv_buf(feed_buf, 0, &ctx, &msg_type,
+				    &remaining, recv_buf + total_read, 4);
+		zassert_true(ret > 0, "Read failed (%d)", ret);
+		zassert_true(msg_type & WEBSOCKET_FLAG_TEXT,
+			     "Text type lost");
+
+		total_read += ret;
+
+		zassert_equal(!!(msg_type & WEBSOCKET_FLAG_FINAL),
+			      total_read > 5, "Wrong final flag");
+	}
+
+	zassert_equal(remaining, 0, "Msg not empty");
+	zassert_mem_equal(recv_buf, frame1_msg, sizeof(frame1_msg) - 1,
+			  "Invalid message, should be '%s' was '%s'",
+			  frame1_msg, recv_buf);
+	zassert_equal(ctx.tmp_buf_pos, 0, "Data left in the buffer");
 }
 
 void test_main(void)
@@ -390,7 +554,11 @@ void test_main(void)
 			 ztest_unit_test(test_recv_whole_msg),
 			 ztest_unit_test(test_recv_two_msg),
 			 ztest_unit_test(test_send_and_recv_lorem_ipsum),
-			 ztest_unit_test(test_recv_two_large_split_msg)
+			 ztest_unit_test(test_recv_two_large_split_msg),
+			 ztest_unit_test(test_send_iov_masked),
+			 ztest_unit_test(test_send_iov_unmasked),
+			 ztest_unit_test(test_send_unaligned),
+			 ztest_unit_test(test_recv_fragmented)
 		);
 
 	ztest_run_test_suite(websocket);
@@ -0,0 +1,446 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_TCP_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <ztest.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/dummy.h>
+
+#include "ipv6.h"
+#include "connection.h"
+#include "tcp_internal.h"
+#include "net_private.h"
+
+#define TEST_PORT 4242
+#define PEER_PORT 5000
+
+#define MSS 536
+#define SEQ 1000
+#define WIN 8192
+
+#define TCP_FLAG_PSH 0x08
+#define TCP_FLAG_ACK 0x10
+
+#define MAX_SEGS 8
+#define MAX_DELIVERED 8
+
+#define WAIT_TIME K_SECONDS(1)
+
+static struct in6_addr my_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+				       0, 0, 0, 0, 0, 0, 0, 0x1 } } };
+static struct in6_addr peer_addr = { { { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0,
+					 0, 0, 0, 0, 0, 0, 0, 0x2 } } };
+
+static struct net_if *iface;
+static struct net_conn_handle *conn_handle;
+static struct k_sem recv_sem;
+
+/* Segments given to the L2 send function by net_tcp_gso_send() */
+static struct net_pkt *segs[MAX_SEGS];
+static int seg_count;
+static int fail_at;
+
+/* Payload length and sequence number of the packets given to TCP */
+static size_t delivered_len[MAX_DELIVERED];
+static uint32_t delivered_seq[MAX_DELIVERED];
+static int delivered;
+static bool payload_failed;
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static uint8_t mac[] = { 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_DUMMY);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	net_pkt_unref(pkt);
+
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_tcp_gso_test, "net_tcp_gso_test",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+static uint8_t pattern(uint32_t seq)
+{
+	return (uint8_t)(seq * 7U);
+}
+
+static void write_tcp(struct net_pkt *pkt, uint32_t seq, uint8_t flags,
+		      size_t len)
+{
+	struct net_tcp_hdr hdr = {
+		.src_port = htons(PEER_PORT),
+		.dst_port = htons(TEST_PORT),
+		.offset = (sizeof(hdr) / 4U) << 4,
+		.flags = flags,
+	};
+	size_t i;
+
+	UNALIGNED_PUT(htonl(seq), (uint32_t *)hdr.seq);
+	UNALIGNED_PUT(htonl(1), (uint32_t *)hdr.ack);
+	UNALIGNED_PUT(htons(WIN), (uint16_t *)hdr.wnd);
+
+	zassert_equal(net_pkt_write(pkt, &hdr, sizeof(hdr)), 0, "");
+
+	for (i = 0; i < len; i++) {
+		zassert_equal(net_pkt_write_u8(pkt, pattern(seq + i)), 0, "");
+	}
+
+	net_pkt_cursor_init(pkt);
+	zassert_equal(net_ipv6_finalize(pkt, IPPROTO_TCP), 0, "");
+}
+
+static bool check_payload(struct net_pkt *pkt, uint32_t seq, size_t len)
+{
+	uint8_t byte;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if (net_pkt_read_u8(pkt, &byte) || byte != pattern(seq + i)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void read_hdrs(struct net_pkt *pkt, struct net_ipv6_hdr *ip,
+		      struct net_tcp_hdr *tcp)
+{
+	net_pkt_cursor_init(pkt);
+	net_pkt_set_overwrite(pkt, true);
+
+	zassert_equal(net_pkt_read(pkt, ip, sizeof(*ip)), 0, "");
+	zassert_equal(net_pkt_read(pkt, tcp, sizeof(*tcp)), 0, "");
+}
+
+static enum net_verdict tcp_input(struct net_conn *conn, struct net_pkt *pkt,
+				  union net_ip_header *ip_hdr,
+				  union net_proto_header *proto_hdr,
+				  void *user_data)
+{
+	struct net_ipv6_hdr ip;
+	struct net_tcp_hdr tcp;
+	size_t len;
+	uint32_t seq;
+
+	read_hdrs(pkt, &ip, &tcp);
+
+	len = net_pkt_get_len(pkt) - NET_IPV6H_LEN - NET_TCPH_LEN;
+	seq = ntohl(UNALIGNED_GET((uint32_t *)tcp.seq));
+
+	if (ntohs(ip.len) != len + NET_TCPH_LEN ||
+	    !check_payload(pkt, seq, len)) {
+		payload_failed = true;
+	}
+
+	if (delivered < MAX_DELIVERED) {
+		delivered_len[delivered] = len;
+		delivered_seq[delivered] = seq;
+		delivered++;
+	}
+
+	net_pkt_unref(pkt);
+	k_sem_give(&recv_sem);
+
+	return NET_OK;
+}
+
+static void test_init(void)
+{
+	struct sockaddr_in6 local = {
+		.sin6_family = AF_INET6,
+		.sin6_port = htons(TEST_PORT),
+	};
+	struct net_if_addr *ifaddr;
+	int ret;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "No test interface");
+
+	zassert_true(net_if_flag_is_set(iface, NET_IF_GSO), "GSO not set");
+	zassert_true(net_if_flag_is_set(iface, NET_IF_GRO), "GRO not set");
+
+	ifaddr = net_if_ipv6_addr_add(iface, &my_addr, NET_ADDR_MANUAL, 0);
+	zassert_not_null(ifaddr, "Cannot add address");
+
+	k_sem_init(&recv_sem, 0, UINT_MAX);
+
+	net_ipaddr_copy(&local.sin6_addr, &my_addr);
+
+	ret = net_conn_register(IPPROTO_TCP, AF_INET6, NULL,
+				(struct sockaddr *)&local, PEER_PORT,
+				TEST_PORT, NULL, tcp_input, NULL,
+				&conn_handle);
+	zassert_equal(ret, 0, "Cannot register connection (%d)", ret);
+}
+
+static int seg_send(struct net_if *iface, struct net_pkt *pkt)
+{
+	if (seg_count == fail_at || seg_count >= MAX_SEGS) {
+		return -EIO;
+	}
+
+	segs[seg_count++] = pkt;
+
+	return net_pkt_get_len(pkt);
+}
+
+static struct net_pkt *build_gso_pkt(size_t len)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_alloc_on_iface(iface, WAIT_TIME);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	/* Not limited by the MTU */
+	net_pkt_set_family(pkt, AF_INET6);
+	net_pkt_set_gso_size(pkt, MSS);
+
+	zassert_equal(net_pkt_alloc_buffer(pkt, NET_TCPH_LEN + len,
+					   IPPROTO_TCP, WAIT_TIME), 0,
+		      "Cannot allocate buffer");
+
+	zassert_equal(net_ipv6_create(pkt, &my_addr, &peer_addr), 0, "");
+
+	write_tcp(pkt, SEQ, TCP_FLAG_PSH | TCP_FLAG_ACK, len);
+
+	return pkt;
+}
+
+static void test_gso_segments(void)
+{
+	size_t len = 3 * MSS + 100;
+	struct net_ipv6_hdr ip;
+	struct net_tcp_hdr tcp;
+	struct net_pkt *pkt;
+	size_t seg_len;
+	uint8_t flags;
+	int ret, i;
+
+	pkt = build_gso_pkt(len);
+
+	seg_count = 0;
+	fail_at = -1;
+
+	ret = net_tcp_gso_send(pkt, seg_send);
+	zassert_equal(ret, len + 4 * (NET_IPV6H_LEN + NET_TCPH_LEN),
+		      "Invalid sent length %d", ret);
+	zassert_equal(seg_count, 4, "Invalid segment count %d", seg_count);
+
+	for (i = 0; i < seg_count; i++) {
+		seg_len = MIN(MSS, len - i * MSS);
+		flags = i == seg_count - 1 ? TCP_FLAG_PSH | TCP_FLAG_ACK :
+			TCP_FLAG_ACK;
+
+		zassert_equal(net_pkt_gso_size(segs[i]), 0, "");
+		zassert_equal(net_pkt_get_len(segs[i]),
+			      NET_IPV6H_LEN + NET_TCPH_LEN + seg_len,
+			      "Invalid length of segment %d", i);
+
+		net_pkt_cursor_init(segs[i]);
+		zassert_equal(net_calc_chksum_tcp(segs[i]), 0,
+			      "Invalid checksum in segment %d", i);
+
+		read_hdrs(segs[i], &ip, &tcp);
+
+		zassert_equal(ntohs(ip.len), NET_TCPH_LEN + seg_len, "");
+		zassert_equal(ntohl(UNALIGNED_GET((uint32_t *)tcp.seq)),
+			      SEQ + i * MSS, "Invalid seq in segment %d", i);
+		zassert_equal(tcp.flags, flags, "Invalid flags in segment %d",
+			      i);
+		zassert_true(check_payload(segs[i], SEQ + i * MSS, seg_len),
+			     "Invalid payload in segment %d", i);
+
+		net_pkt_unref(segs[i]);
+	}
+}
+
+static void test_gso_send_error(void)
+{
+	struct net_pkt *pkt;
+	int ret, i;
+
+	/* Nothing sent, the caller still owns the packet */
+	pkt = build_gso_pkt(2 * MSS);
+
+	seg_count = 0;
+	fail_at = 0;
+
+	ret = net_tcp_gso_send(pkt, seg_send);
+	zassert_equal(ret, -EIO, "Unexpected result %d", ret);
+	net_pkt_unref(pkt);
+
+	/* The segments which were sent are kept, the rest is dropped */
+	pkt = build_gso_pkt(3 * MSS);
+
+	seg_count = 0;
+	fail_at = 1;
+
+	ret = net_tcp_gso_send(pkt, seg_send);
+	zassert_equal(ret, NET_IPV6H_LEN + NET_TCPH_LEN + MSS,
+		      "Unexpected result %d", ret);
+	zassert_equal(seg_count, 1, "Invalid segment count %d", seg_count);
+
+	for (i = 0; i < seg_count; i++) {
+		net_pkt_unref(segs[i]);
+	}
+}
+
+static struct net_pkt *build_rx_pkt(uint32_t seq, uint8_t flags, size_t len)
+{
+	struct net_pkt *pkt;
+
+	pkt = net_pkt_rx_alloc_with_buffer(iface, NET_TCPH_LEN + len,
+					   AF_INET6, IPPROTO_TCP, WAIT_TIME);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	zassert_equal(net_ipv6_create(pkt, &peer_addr, &my_addr), 0, "");
+	write_tcp(pkt, seq, flags, len);
+
+	return pkt;
+}
+
+struct rx_seg {
+	uint32_t seq;
+	uint8_t flags;
+	size_t len;
+};
+
+/* Queue all the segments before the RX thread gets to run */
+static void recv_segs(const struct rx_seg *rx, int count, int expected)
+{
+	int i;
+
+	delivered = 0;
+	payload_failed = false;
+
+	k_sched_lock();
+
+	for (i = 0; i < count; i++) {
+		zassert_equal(net_recv_data(iface, build_rx_pkt(rx[i].seq,
+								rx[i].flags,
+								rx[i].len)),
+			      0, "Cannot receive pkt %d", i);
+	}
+
+	k_sched_unlock();
+
+	for (i = 0; i < expected; i++) {
+		zassert_equal(k_sem_take(&recv_sem, WAIT_TIME), 0,
+			      "Only %d packets delivered", i);
+	}
+
+	zassert_not_equal(k_sem_take(&recv_sem, K_MSEC(100)), 0,
+			  "Too many packets delivered");
+	zassert_false(payload_failed, "Invalid packet delivered");
+}
+
+static void test_gro_merge(void)
+{
+	static const struct rx_seg rx[] = {
+		{ SEQ, TCP_FLAG_ACK, 100 },
+		{ SEQ + 100, TCP_FLAG_ACK, 200 },
+		{ SEQ + 300, TCP_FLAG_ACK, 100 },
+	};
+
+	/* Flushed when the RX queue is empty */
+	recv_segs(rx, ARRAY_SIZE(rx), 1);
+
+	zassert_equal(delivered_seq[0], SEQ, "");
+	zassert_equal(delivered_len[0], 400, "");
+}
+
+static void test_gro_max_segs(void)
+{
+	static const struct rx_seg rx[] = {
+		{ SEQ, TCP_FLAG_ACK, 100 },
+		{ SEQ + 100, TCP_FLAG_ACK, 100 },
+		{ SEQ + 200, TCP_FLAG_ACK, 100 },
+		{ SEQ + 300, TCP_FLAG_ACK, 100 },
+		{ SEQ + 400, TCP_FLAG_ACK, 100 },
+		{ SEQ + 500, TCP_FLAG_PSH | TCP_FLAG_ACK, 100 },
+	};
+
+	recv_segs(rx, ARRAY_SIZE(rx), 2);
+
+	zassert_equal(delivered_seq[0], SEQ, "");
+	zassert_equal(delivered_len[0],
+		      CONFIG_NET_TCP_GRO_MAX_SEGS * 100, "");
+	zassert_equal(delivered_seq[1], SEQ + CONFIG_NET_TCP_GRO_MAX_SEGS * 100,
+		      "");
+	zassert_equal(delivered_len[1],
+		      (6 - CONFIG_NET_TCP_GRO_MAX_SEGS) * 100, "");
+}
+
+static void test_gro_out_of_order(void)
+{
+	static const struct rx_seg rx[] = {
+		{ SEQ, TCP_FLAG_ACK, 100 },
+		{ SEQ + 200, TCP_FLAG_ACK, 100 },
+		{ SEQ + 100, TCP_FLAG_ACK, 100 },
+		{ SEQ + 300, TCP_FLAG_ACK, 0 },
+	};
+
+	/* Nothing is merged and the order is kept */
+	recv_segs(rx, ARRAY_SIZE(rx), 4);
+
+	zassert_equal(delivered_seq[0], SEQ, "");
+	zassert_equal(delivered_seq[1], SEQ + 200, "");
+	zassert_equal(delivered_seq[2], SEQ + 100, "");
+	zassert_equal(delivered_seq[3], SEQ + 300, "");
+	zassert_equal(delivered_len[3], 0, "");
+}
+
+static void test_gro_disabled(void)
+{
+	static const struct rx_seg rx[] = {
+		{ SEQ, TCP_FLAG_ACK, 100 },
+		{ SEQ + 100, TCP_FLAG_ACK, 100 },
+	};
+
+	net_if_flag_clear(iface, NET_IF_GRO);
+
+	recv_segs(rx, ARRAY_SIZE(rx), 2);
+
+	net_if_flag_set(iface, NET_IF_GRO);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_tcp_gso,
+			 ztest_unit_test(test_init),
+			 ztest_unit_test(test_gso_segments),
+			 ztest_unit_test(test_gso_send_error),
+			 ztest_unit_test(test_gro_merge),
+			 ztest_unit_test(test_gro_max_segs),
+			 ztest_unit_test(test_gro_out_of_order),
+			 ztest_unit_test(test_gro_disabled));
+
+	ztest_run_test_suite(net_tcp_gso);
+}
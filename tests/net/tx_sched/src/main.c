@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2021 Linaro Limited
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(net_test, CONFIG_NET_TC_LOG_LEVEL);
+
+#include <zephyr/types.h>
+#include <ztest.h>
+
+#include <net/net_core.h>
+#include <net/net_pkt.h>
+#include <net/net_ip.h>
+#include <net/net_if.h>
+#include <net/dummy.h>
+
+#include "net_private.h"
+
+#define PKT_LEN 100
+#define MAX_SENT 64
+
+#define WAIT_TIME K_SECONDS(1)
+
+/* A priority mapped to each of the 4 traffic classes */
+static const enum net_priority tc_prio[] = {
+	NET_PRIORITY_BE, NET_PRIORITY_EE, NET_PRIORITY_VI, NET_PRIORITY_NC,
+};
+
+static struct net_if *iface;
+static struct k_sem sent_sem;
+
+static uint8_t sent_tc[MAX_SENT];
+static int sent_count;
+
+static int net_iface_dev_init(const struct device *dev)
+{
+	return 0;
+}
+
+static void net_iface_init(struct net_if *iface)
+{
+	static uint8_t mac[] = { 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01 };
+
+	net_if_set_link_addr(iface, mac, sizeof(mac), NET_LINK_DUMMY);
+}
+
+static int sender_iface(const struct device *dev, struct net_pkt *pkt)
+{
+	if (sent_count < MAX_SENT) {
+		sent_tc[sent_count++] =
+			net_tx_priority2tc(net_pkt_priority(pkt));
+	}
+
+	k_sem_give(&sent_sem);
+
+	return 0;
+}
+
+static struct dummy_api net_iface_api = {
+	.iface_api.init = net_iface_init,
+	.send = sender_iface,
+};
+
+NET_DEVICE_INIT(net_tx_sched_test, "net_tx_sched_test",
+		net_iface_dev_init, NULL, NULL, NULL,
+		CONFIG_KERNEL_INIT_PRIORITY_DEFAULT,
+		&net_iface_api, DUMMY_L2, NET_L2_GET_CTX_TYPE(DUMMY_L2), 127);
+
+/* The test thread is cooperative, so the TX thread only runs once all the
+ * packets are queued.
+ */
+static void queue_pkts(uint8_t tc, int count)
+{
+	static uint8_t data[PKT_LEN];
+	struct net_pkt *pkt;
+
+	while (count--) {
+		pkt = net_pkt_alloc_with_buffer(iface, sizeof(data), AF_UNSPEC,
+						0, K_NO_WAIT);
+		zassert_not_null(pkt, "Cannot allocate pkt");
+		zassert_equal(net_pkt_write(pkt, data, sizeof(data)), 0, "");
+
+		net_pkt_set_priority(pkt, tc_prio[tc]);
+		net_if_queue_tx(iface, pkt);
+	}
+}
+
+static void wait_sent(int count)
+{
+	while (count--) {
+		zassert_equal(k_sem_take(&sent_sem, WAIT_TIME), 0,
+			      "Packet not sent");
+	}
+
+	zassert_equal(k_sem_take(&sent_sem, K_MSEC(10)), -EAGAIN,
+		      "Unexpected packet sent");
+}
+
+static void test_setup(void)
+{
+	int i;
+
+	iface = net_if_get_first_by_type(&NET_L2_GET_NAME(DUMMY));
+	zassert_not_null(iface, "No interface");
+
+	for (i = 0; i < ARRAY_SIZE(tc_prio); i++) {
+		zassert_equal(net_tx_priority2tc(tc_prio[i]), i,
+			      "Unexpected traffic class mapping");
+	}
+
+	k_sem_init(&sent_sem, 0, UINT_MAX);
+}
+
+static void test_strict_first(void)
+{
+	int i;
+
+	sent_count = 0;
+
+	queue_pkts(0, 4);
+	queue_pkts(1, 4);
+	queue_pkts(2, 4);
+	queue_pkts(3, 2);
+
+	wait_sent(14);
+
+	for (i = 0; i < 2; i++) {
+		zassert_equal(sent_tc[i], 3, "Strict class not sent first");
+	}
+}
+
+static void test_drr_weights(void)
+{
+	int count[3] = { 0 };
+	int i;
+
+	sent_count = 0;
+
+	queue_pkts(0, 12);
+	queue_pkts(1, 12);
+	queue_pkts(2, 12);
+
+	wait_sent(36);
+
+	/* With a quantum of one packet, a round sends 1, 2 and 3 packets of
+	 * the classes 0, 1 and 2. All the classes are busy for two rounds.
+	 */
+	for (i = 0; i < 12; i++) {
+		count[sent_tc[i]]++;
+	}
+
+	zassert_equal(count[0], 2, "Class 0 sent %d", count[0]);
+	zassert_equal(count[1], 4, "Class 1 sent %d", count[1]);
+	zassert_equal(count[2], 6, "Class 2 sent %d", count[2]);
+}
+
+static void test_queue_limit(void)
+{
+	struct net_tc_tx_sched_stats stats;
+	int ret;
+
+	queue_pkts(0, CONFIG_NET_TC_TX_DRR_QUEUE_LEN + 4);
+
+	ret = net_tc_tx_get_sched_stats(0, &stats);
+	zassert_equal(ret, 0, "Cannot get stats");
+	zassert_equal(stats.queued, CONFIG_NET_TC_TX_DRR_QUEUE_LEN,
+		      "Queued %u", stats.queued);
+	zassert_equal(stats.max_queued, CONFIG_NET_TC_TX_DRR_QUEUE_LEN,
+		      "Max queued %u", stats.max_queued);
+	zassert_equal(stats.dropped, 4, "Dropped %u", stats.dropped);
+
+	wait_sent(CONFIG_NET_TC_TX_DRR_QUEUE_LEN);
+
+	ret = net_tc_tx_get_sched_stats(0, &stats);
+	zassert_equal(ret, 0, "Cannot get stats");
+	zassert_equal(stats.queued, 0, "Queued %u", stats.queued);
+	zassert_equal(stats.sent_bytes, (uint64_t)stats.sent_pkts * PKT_LEN,
+		      "Wrong sent bytes");
+
+	zassert_equal(net_tc_tx_get_sched_stats(NET_TC_TX_COUNT, &stats),
+		      -EINVAL, "Invalid class accepted");
+}
+
+static void test_rate_limit(void)
+{
+	struct net_tc_tx_sched_stats stats;
+	int64_t start;
+	int ret, i;
+
+	/* One packet every 10 ms */
+	ret = net_tc_tx_set_rate(1, 100 * PKT_LEN, PKT_LEN);
+	zassert_equal(ret, 0, "Cannot set rate");
+
+	sent_count = 0;
+	start = k_uptime_get();
+
+	queue_pkts(1, 5);
+	queue_pkts(0, 5);
+
+	wait_sent(10);
+
+	zassert_true(k_uptime_get() - start >= 40, "Rate not limited");
+
+	/* The bucket holds one packet, the others wait for the rate while
+	 * the other class is sent.
+	 */
+	for (i = 0; i < 4; i++) {
+		zassert_equal(sent_tc[sent_count - 1 - i], 1,
+			      "Limited class not sent last");
+	}
+
+	ret = net_tc_tx_get_sched_stats(1, &stats);
+	zassert_equal(ret, 0, "Cannot get stats");
+	zassert_true(stats.throttled > 0, "Not throttled");
+
+	ret = net_tc_tx_set_rate(1, 0, 0);
+	zassert_equal(ret, 0, "Cannot remove rate");
+
+	zassert_equal(net_tc_tx_set_rate(1, 1000, 0), -EINVAL,
+		      "Empty bucket accepted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(net_tx_sched_test,
+			 ztest_unit_test(test_setup),
+			 ztest_unit_test(test_strict_first),
+			 ztest_unit_test(test_drr_weights),
+			 ztest_unit_test(test_queue_limit),
+			 ztest_unit_test(test_rate_limit));
+
+	ztest_run_test_suite(net_tx_sched_test);
+}
@@ -848,11 +848,171 @@ void test_addr_parse(void)
 #endif
 }
 
+/* Straightforward 16 bits at a time one's complement sum, used as the
+ * reference for the optimized checksum code.
+ */
+static uint16_t ref_chksum(const uint8_t *data, size_t len)
+{
+	uint32_t sum = 0U;
+	size_t i;
+
+	for (i = 0; i + 1 < len; i += 2) {
+		sum += (data[i] << 8) | data[i + 1];
+	}
+
+	if (len % 2) {
+		sum += data[len - 1] << 8;
+	}
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	sum = (sum == 0U) ? 0xffff : sum;
+
+	return htons(~sum & 0xffff);
+}
+
+#define CHKSUM_PAYLOAD_MAX 255
+
+static uint8_t chksum_data[NET_IPV6H_LEN + CHKSUM_PAYLOAD_MAX];
+static uint8_t chksum_ref_data[NET_IPV6H_LEN + CHKSUM_PAYLOAD_MAX];
+static uint32_t chksum_seed = 12345U;
+
+static uint8_t chksum_rand(void)
+{
+	chksum_seed = chksum_seed * 1103515245U + 12345U;
+
+	return chksum_seed >> 16;
+}
+
+/* Put the IPv6 header and the payload in fragments of odd sizes, with the
+ * first one starting at the given offset, to exercise unaligned access and
+ * odd fragment boundaries.
+ */
+static struct net_pkt *chksum_pkt(size_t len, size_t headroom)
+{
+	static const size_t chunks[] = { 17, 50, 128 };
+	struct net_pkt *pkt;
+	struct net_buf *frag;
+	size_t pos = 0;
+	int i = 0;
+
+	pkt = net_pkt_alloc(K_NO_WAIT);
+	zassert_not_null(pkt, "Cannot allocate pkt");
+
+	net_pkt_set_family(pkt, AF_INET6);
+	net_pkt_set_ip_hdr_len(pkt, NET_IPV6H_LEN);
+
+	while (pos < NET_IPV6H_LEN + len) {
+		size_t chunk;
+
+		frag = net_pkt_get_reserve_tx_data(K_NO_WAIT);
+		zassert_not_null(frag, "Cannot allocate frag");
+
+		if (!pos) {
+			net_buf_reserve(frag, headroom);
+		}
+
+		chunk = MIN(chunks[i++ % ARRAY_SIZE(chunks)],
+			    net_buf_tailroom(frag));
+		chunk = MIN(chunk, NET_IPV6H_LEN + len - pos);
+
+		net_buf_add_mem(frag, chksum_data + pos, chunk);
+		net_pkt_frag_add(pkt, frag);
+
+		pos += chunk;
+	}
+
+	return pkt;
+}
+
+void test_chksum(void)
+{
+	static const size_t lengths[] = {
+		0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 64, 65, 127, 200,
+		CHKSUM_PAYLOAD_MAX
+	};
+	struct net_pkt *pkt;
+	size_t headroom;
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(lengths); i++) {
+		size_t len = lengths[i];
+
+		for (j = 0; j < sizeof(chksum_data); j++) {
+			chksum_data[j] = chksum_rand();
+		}
+
+		/* Reference: pseudo header followed by the payload */
+		memcpy(chksum_ref_data, chksum_data + 8,
+		       2 * sizeof(struct in6_addr));
+		UNALIGNED_PUT(htonl(len), (uint32_t *)(chksum_ref_data + 32));
+		UNALIGNED_PUT(htonl(IPPROTO_UDP),
+			      (uint32_t *)(chksum_ref_data + 36));
+		memcpy(chksum_ref_data + NET_IPV6H_LEN,
+		       chksum_data + NET_IPV6H_LEN, len);
+
+		for (headroom = 0; headroom < 4; headroom++) {
+			pkt = chksum_pkt(len, headroom);
+
+			zassert_equal(net_calc_chksum(pkt, IPPROTO_UDP),
+				      ref_chksum(chksum_ref_data,
+						 NET_IPV6H_LEN + len),
+				      "Invalid checksum, len %zu offset %zu",
+				      len, headroom);
+
+			net_pkt_unref(pkt);
+		}
+	}
+}
+
+void test_chksum_update(void)
+{
+	uint8_t old_addr[sizeof(struct in6_addr)];
+	uint16_t old_word, new_word;
+	uint16_t chksum;
+	int i, j;
+
+	for (i = 0; i < 32; i++) {
+		for (j = 0; j < 64; j++) {
+			chksum_data[j] = chksum_rand();
+		}
+
+		chksum = ref_chksum(chksum_data, 64);
+
+		/* Single 16-bit word, including the all ones/zeros cases
+		 * which are special for one's complement arithmetic.
+		 */
+		memcpy(&old_word, chksum_data + 10, sizeof(old_word));
+		new_word = (i == 0) ? 0x0000 : (i == 1) ? 0xffff :
+			   chksum_rand() << 8 | chksum_rand();
+		memcpy(chksum_data + 10, &new_word, sizeof(new_word));
+
+		chksum = net_chksum_update_u16(chksum, old_word, new_word);
+		zassert_equal(chksum, ref_chksum(chksum_data, 64),
+			      "Invalid 16-bit update (%d)", i);
+
+		/* Address sized field */
+		memcpy(old_addr, chksum_data + 24, sizeof(old_addr));
+		for (j = 0; j < sizeof(old_addr); j++) {
+			chksum_data[24 + j] = (i == 2) ? 0U : chksum_rand();
+		}
+
+		chksum = net_chksum_update(chksum, old_addr, chksum_data + 24,
+					   sizeof(old_addr));
+		zassert_equal(chksum, ref_chksum(chksum_data, 64),
+			      "Invalid range update (%d)", i);
+	}
+}
+
 void test_main(void)
 {
 	ztest_test_suite(test_utils_fn,
 			 ztest_user_unit_test(test_net_addr),
-			 ztest_unit_test(test_addr_parse));
+			 ztest_unit_test(test_addr_parse),
+			 ztest_unit_test(test_chksum),
+			 ztest_unit_test(test_chksum_update));
 
 	ztest_run_test_suite(test_utils_fn);
 }